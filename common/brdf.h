@@ -0,0 +1,1403 @@
+/**********************************************************************************************
+*
+*   brdf - Batched CPU evaluation of the lighting models implemented by the .fs files
+*
+*   Single header module, define BRDF_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   Every model returns the direct light term of its shader for a white light, i.e. what the
+*   .fs adds up before ambient, IBL and exposure (NdotL included where the shader has it):
+*
+*       BRDF_MODEL_LAMBERT                  diffuse_lambert.fs
+*       BRDF_MODEL_OREN_NAYAR               diffuse_oren_nayar.fs
+*       BRDF_MODEL_BURLEY                   diffuse_burley.fs
+*       BRDF_MODEL_ASHIKHMIN_SHIRLEY_DIFFUSE diffuse_ashikhmin_shirley.fs
+*       BRDF_MODEL_PHONG                    specular_phong.fs (Lambert + Phong)
+*       BRDF_MODEL_BLINN_PHONG              specular_blinn_phong.fs (Lambert + Blinn-Phong)
+*       BRDF_MODEL_ASHIKHMIN_SHIRLEY        specular_ashikhmin_shirley.fs
+*       BRDF_MODEL_COOK_TORRANCE            specular_cook_torrance.fs (Burley + D*G*F + multiscatter)
+*       BRDF_MODEL_SHEEN                    sheen.fs
+*       BRDF_MODEL_CLEARCOAT                clearcoat.fs (the coat's IBL term is not part of it)
+*
+*   The D/G/F/multiscatter/conductor enums share their values with the NDF_TYPE, GSF_TYPE,
+*   FRESNEL_TYPE, MULTISCATTER_TYPE and CONDUCTOR_PRESET shader defines, so a demo's dropdown
+*   index can be passed straight through
+*
+*   Inputs and outputs are structure-of-arrays (one float array per component). EvalBrdf()
+*   runs 8 (AVX2) or 4 (SSE2) samples per instruction, depending on what the compiler targets,
+*   and splits large batches over ParallelFor(). EvalBrdfReference() is a plain scalar
+*   transcription of the shaders, kept as the ground truth the SIMD path is checked against
+*
+*   Where a shader produces NaN or inf (H of opposite L and V, the Neubelt sheen term with
+*   both angles at 90 degrees) the result is 0 instead, bakers accumulate these values
+*
+**********************************************************************************************/
+
+#ifndef BRDF_H
+#define BRDF_H
+
+#include "raylib.h"
+
+// Lighting models, one per shader
+typedef enum {
+    BRDF_MODEL_LAMBERT = 0,
+    BRDF_MODEL_OREN_NAYAR,
+    BRDF_MODEL_BURLEY,
+    BRDF_MODEL_ASHIKHMIN_SHIRLEY_DIFFUSE,
+    BRDF_MODEL_PHONG,
+    BRDF_MODEL_BLINN_PHONG,
+    BRDF_MODEL_ASHIKHMIN_SHIRLEY,
+    BRDF_MODEL_COOK_TORRANCE,
+    BRDF_MODEL_SHEEN,
+    BRDF_MODEL_CLEARCOAT
+} BrdfModel;
+
+// Normal distribution functions, NDF_TYPE define
+typedef enum {
+    BRDF_NDF_BECKMANN = 0,
+    BRDF_NDF_GGX,
+    BRDF_NDF_GGX_ANISOTROPIC,
+    BRDF_NDF_DISABLED
+} BrdfNdfType;
+
+// Geometry shadowing functions, GSF_TYPE define
+typedef enum {
+    BRDF_GSF_KELEMEN = 0,
+    BRDF_GSF_NEUMANN,
+    BRDF_GSF_SCHLICK_DISNEY,
+    BRDF_GSF_SCHLICK_EPIC,
+    BRDF_GSF_SMITH_BECKMANN,
+    BRDF_GSF_SMITH_GGX,
+    BRDF_GSF_SMITH_GGX_ANISOTROPIC,
+    BRDF_GSF_DISABLED
+} BrdfGsfType;
+
+// Fresnel functions, FRESNEL_TYPE define
+typedef enum {
+    BRDF_FRESNEL_SCHLICK = 0,
+    BRDF_FRESNEL_DIELECTRIC,
+    BRDF_FRESNEL_CONDUCTOR,
+    BRDF_FRESNEL_DISABLED
+} BrdfFresnelType;
+
+// Multiscatter energy compensation, MULTISCATTER_TYPE define
+typedef enum {
+    BRDF_MULTISCATTER_ACCURATE = 0,
+    BRDF_MULTISCATTER_APPROXIMATE,
+    BRDF_MULTISCATTER_DISABLED
+} BrdfMultiScatterType;
+
+// Conductor eta/kappa presets, CONDUCTOR_PRESET define
+typedef enum {
+    BRDF_CONDUCTOR_GOLD = 0,
+    BRDF_CONDUCTOR_COPPER,
+    BRDF_CONDUCTOR_ALUMINIUM,
+    BRDF_CONDUCTOR_SILVER,
+    BRDF_CONDUCTOR_IRON
+} BrdfConductorPreset;
+
+// Split-sum DFG table on the CPU (resources/dfg_lut.bin, see env_dfg.h)
+typedef struct BrdfDFG {
+    int size;
+    float *data;                // size*size*3 floats, rgb = A, B, Eavg
+} BrdfDFG;
+
+// Material, one per batch, field names follow the shader uniforms
+typedef struct BrdfMaterial {
+    BrdfModel model;
+    Vector3 color;              // objectColor
+    float roughness;            // roughnessValue
+    float roughnessU;           // Ashikhmin-Shirley only
+    float roughnessV;
+    float metallic;
+    float anisotropy;
+    float ior;
+    int ndfType;                // Cook-Torrance only, sheen and clearcoat are fixed to GGX/Smith-GGX/Schlick
+    int gsfType;
+    int fresnelType;
+    int multiScatterType;
+    int conductorPreset;
+    float sheenWeight;
+    float sheenRoughness;
+    Vector3 sheenTint;
+    float clearcoatWeight;
+    float clearcoatRoughness;
+    float clearcoatIor;
+    Vector3 clearcoatTint;
+    const BrdfDFG *dfg;         // Accurate multiscatter (Cook-Torrance, sheen, clearcoat), the term is skipped when NULL
+} BrdfMaterial;
+
+// One float array per vector component
+typedef struct BrdfVectors {
+    const float *x;
+    const float *y;
+    const float *z;
+} BrdfVectors;
+
+// Batch of shading samples, all directions unit length and pointing away from the surface
+typedef struct BrdfSamples {
+    int count;
+    BrdfVectors normal;
+    BrdfVectors light;
+    BrdfVectors view;
+    BrdfVectors tangent;        // Anisotropic NDF/GSF and Ashikhmin-Shirley only, unused otherwise
+    BrdfVectors bitangent;
+    const float *roughness;     // Per sample override of material roughness, NULL for none
+    const float *metallic;      // Per sample override of material metallic, NULL for none
+} BrdfSamples;
+
+// Reflected radiance per sample for a white light
+typedef struct BrdfResult {
+    float *r;
+    float *g;
+    float *b;
+} BrdfResult;
+
+BrdfMaterial GetBrdfMaterialDefault(BrdfModel model);      // Startup slider values of the model's demo
+BrdfDFG LoadBrdfDFG(const char *fileName);                  // Load resources/dfg_lut.bin as floats
+void UnloadBrdfDFG(BrdfDFG dfg);
+void SampleBrdfDFG(const BrdfDFG *dfg, float NdotV, float roughness, float *rgb);  // Bilinear, clamped, same as the GL sampler
+
+void EvalBrdf(const BrdfMaterial *material, BrdfSamples samples, BrdfResult result);            // SIMD and multithreaded
+void EvalBrdfReference(const BrdfMaterial *material, BrdfSamples samples, BrdfResult result);   // Scalar transcription of the shaders
+
+#endif // BRDF_H
+
+#if defined(BRDF_IMPLEMENTATION) && !defined(BRDF_IMPLEMENTED)
+#define BRDF_IMPLEMENTED
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define BRDF_BACKEND "AVX2"
+    #define BRDF_LANES 8
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+    #define BRDF_BACKEND "SSE2"
+    #define BRDF_LANES 4
+#else
+    #define BRDF_BACKEND "scalar"
+    #define BRDF_LANES 1
+#endif
+
+#include "env_dfg.h"                // DFGLutHeader
+
+#define ENV_MAP_IMPLEMENTATION
+#include "env_map.h"                // HalfToFloat(), ParallelFor()
+
+#define BRDF_CHUNK_SIZE     4096    // Samples per ParallelFor() task
+
+// Eta/kappa of the conductor presets, same values as specular_cook_torrance.fs
+static const float brdfConductorEta[5][3] = {
+    { 0.17f, 0.35f, 1.50f }, { 0.20f, 1.10f, 1.30f }, { 1.44f, 0.96f, 0.61f }, { 0.14f, 0.16f, 0.13f }, { 2.90f, 2.90f, 2.90f }
+};
+static const float brdfConductorKappa[5][3] = {
+    { 3.10f, 2.70f, 1.90f }, { 3.90f, 2.60f, 2.30f }, { 7.30f, 6.50f, 5.40f }, { 4.10f, 3.10f, 2.30f }, { 3.30f, 3.30f, 3.30f }
+};
+
+//----------------------------------------------------------------------------------
+// Material and DFG table
+//----------------------------------------------------------------------------------
+
+BrdfMaterial GetBrdfMaterialDefault(BrdfModel model)
+{
+    BrdfMaterial material = { 0 };
+
+    material.model = model;
+    material.color = (Vector3){ 0.5f, 0.0f, 0.0f };
+    material.roughness = 0.5f;
+    material.roughnessU = 0.5f;
+    material.roughnessV = 0.5f;
+    material.metallic = 0.5f;
+    material.anisotropy = 0.0f;
+    material.ior = 1.5f;
+    material.sheenWeight = 0.0f;
+    material.sheenRoughness = 0.5f;
+    material.sheenTint = (Vector3){ 1.0f, 1.0f, 1.0f };
+    material.clearcoatWeight = 0.0f;
+    material.clearcoatRoughness = 0.025f;
+    material.clearcoatIor = 1.5f;
+    material.clearcoatTint = (Vector3){ 1.0f, 1.0f, 1.0f };
+
+    return material;
+}
+
+BrdfDFG LoadBrdfDFG(const char *fileName)
+{
+    BrdfDFG dfg = { 0 };
+
+    int fileSize = 0;
+    unsigned char *fileData = LoadFileData(fileName, &fileSize);
+    if (fileData == NULL) return dfg;
+
+    DFGLutHeader header = { 0 };
+    if (fileSize >= (int)sizeof(header)) memcpy(&header, fileData, sizeof(header));
+
+    int count = header.size*header.size*ENV_DFG_CHANNELS;
+
+    if ((header.magic != ENV_DFG_MAGIC) || (header.version != ENV_DFG_VERSION) || (header.size <= 0) ||
+        (fileSize != (int)sizeof(header) + count*(int)sizeof(unsigned short)))
+    {
+        TraceLog(LOG_WARNING, "BRDF: [%s] Invalid or outdated DFG LUT, rebake it with tools/dfg_lut", fileName);
+        UnloadFileData(fileData);
+        return dfg;
+    }
+
+    dfg.size = header.size;
+    dfg.data = (float *)RL_MALLOC((size_t)count*sizeof(float));
+
+    const unsigned char *halfs = fileData + sizeof(header);
+    for (int i = 0; i < count; i++)
+    {
+        unsigned short value = 0;
+        memcpy(&value, halfs + i*sizeof(unsigned short), sizeof(value));
+        dfg.data[i] = HalfToFloat(value);
+    }
+
+    UnloadFileData(fileData);
+
+    return dfg;
+}
+
+void UnloadBrdfDFG(BrdfDFG dfg)
+{
+    RL_FREE(dfg.data);
+}
+
+void SampleBrdfDFG(const BrdfDFG *dfg, float NdotV, float roughness, float *rgb)
+{
+    const int size = dfg->size;
+
+    // Texel centers at (i + 0.5)/size, GL_CLAMP_TO_EDGE
+    float fx = fminf(fmaxf(NdotV*size - 0.5f, 0.0f), (float)(size - 1));
+    float fy = fminf(fmaxf(roughness*size - 0.5f, 0.0f), (float)(size - 1));
+    if (!(fx == fx)) fx = 0.0f;
+    if (!(fy == fy)) fy = 0.0f;
+
+    int x0 = (int)fx;
+    int y0 = (int)fy;
+    int x1 = (x0 + 1 < size)? x0 + 1 : x0;
+    int y1 = (y0 + 1 < size)? y0 + 1 : y0;
+    float tx = fx - x0;
+    float ty = fy - y0;
+
+    const float *a = dfg->data + ((size_t)y0*size + x0)*3;
+    const float *b = dfg->data + ((size_t)y0*size + x1)*3;
+    const float *c = dfg->data + ((size_t)y1*size + x0)*3;
+    const float *d = dfg->data + ((size_t)y1*size + x1)*3;
+
+    for (int i = 0; i < 3; i++)
+    {
+        float top = a[i] + (b[i] - a[i])*tx;
+        float bottom = c[i] + (d[i] - c[i])*tx;
+        rgb[i] = top + (bottom - top)*ty;
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Scalar reference, one sample at a time, written to be diffed against the .fs files
+//----------------------------------------------------------------------------------
+
+typedef struct BrdfFrame {
+    Vector3 N, L, V, H, T, B;
+    float roughness;
+    float metallic;
+} BrdfFrame;
+
+static inline float BrdfDot(Vector3 a, Vector3 b) { return a.x*b.x + a.y*b.y + a.z*b.z; }
+static inline float BrdfClamp(float x, float lo, float hi) { return fminf(fmaxf(x, lo), hi); }
+static inline float BrdfPow5(float x) { float x2 = x*x; return x2*x2*x; }
+static inline float BrdfMix(float a, float b, float t) { return a + (b - a)*t; }
+
+static float BrdfReflectivity(float ior)
+{
+    float r = (1.0f - ior)/(1.0f + ior);
+    return r*r;
+}
+
+// D: Normal Distribution Functions
+static float BrdfDistribution(int ndfType, float roughness, float anisotropy, const BrdfFrame *f)
+{
+    if (ndfType == BRDF_NDF_BECKMANN)
+    {
+        float alpha2 = fmaxf(roughness*roughness, 0.0001f);
+        float NdotH = fmaxf(BrdfDot(f->N, f->H), 0.0001f);
+        float NdotH2 = NdotH*NdotH;
+        float tanThetaH2 = (1.0f - NdotH2)/NdotH2;
+
+        return expf(-tanThetaH2/alpha2)/(PI*alpha2*NdotH2*NdotH2);
+    }
+
+    if (ndfType == BRDF_NDF_GGX)
+    {
+        float alpha2 = fmaxf(roughness*roughness, 0.0001f);
+        float NdotH = fmaxf(BrdfDot(f->N, f->H), 0.0001f);
+        float denomPart = (alpha2 - 1.0f)*NdotH*NdotH + 1.0f;
+
+        return alpha2/(PI*denomPart*denomPart);
+    }
+
+    if (ndfType == BRDF_NDF_GGX_ANISOTROPIC)
+    {
+        float aspect = sqrtf(1.0f - anisotropy*0.75f);
+        float alphaX = fmaxf(0.0001f, roughness/aspect);
+        float alphaY = fmaxf(0.0001f, roughness*aspect);
+        float TdotH = BrdfDot(f->T, f->H);
+        float BdotH = BrdfDot(f->B, f->H);
+        float NdotH = fmaxf(BrdfDot(f->N, f->H), 0.0001f);
+        float denomPart = (TdotH*TdotH)/(alphaX*alphaX) + (BdotH*BdotH)/(alphaY*alphaY) + NdotH*NdotH;
+
+        return 1.0f/(PI*alphaX*alphaY*denomPart*denomPart);
+    }
+
+    return 1.0f;
+}
+
+static float BrdfLambdaBeckmann(float NdotX, float alpha)
+{
+    float sinTheta = sqrtf(fmaxf(1.0f - NdotX*NdotX, 0.0f));
+    float tanTheta = sinTheta/fmaxf(NdotX, 0.0001f);
+    float a = 1.0f/(alpha*tanTheta);
+
+    return (a < 1.6f)? (1.0f - 1.259f*a + 0.396f*a*a)/(3.535f*a + 2.181f*a*a) : 0.0f;
+}
+
+// G: Geometry Shadowing Functions
+static float BrdfGeometry(int gsfType, float roughness, float anisotropy, const BrdfFrame *f)
+{
+    if (gsfType == BRDF_GSF_KELEMEN)
+    {
+        float NdotL = fmaxf(BrdfDot(f->N, f->L), 0.0f);
+        float NdotV = fmaxf(BrdfDot(f->N, f->V), 0.0f);
+        float VdotH = fmaxf(BrdfDot(f->V, f->H), 0.0001f);
+
+        return (NdotL*NdotV)/(VdotH*VdotH);
+    }
+
+    if (gsfType == BRDF_GSF_NEUMANN)
+    {
+        return fminf(fmaxf(BrdfDot(f->N, f->L), 0.0f), fmaxf(BrdfDot(f->N, f->V), 0.0f));
+    }
+
+    if ((gsfType == BRDF_GSF_SCHLICK_DISNEY) || (gsfType == BRDF_GSF_SCHLICK_EPIC))
+    {
+        float k = (gsfType == BRDF_GSF_SCHLICK_DISNEY)? fmaxf(roughness*0.5f, 0.0001f) : (roughness + 1.0f)*(roughness + 1.0f)/8.0f;
+        float NdotL = fmaxf(BrdfDot(f->N, f->L), 0.0f);
+        float NdotV = fmaxf(BrdfDot(f->N, f->V), 0.0f);
+
+        return (NdotV/(NdotV*(1.0f - k) + k))*(NdotL/(NdotL*(1.0f - k) + k));
+    }
+
+    if (gsfType == BRDF_GSF_SMITH_BECKMANN)
+    {
+        float alpha = fmaxf(roughness, 0.0001f);
+        float NdotL = fmaxf(BrdfDot(f->N, f->L), 0.0f);
+        float NdotV = fmaxf(BrdfDot(f->N, f->V), 0.0f);
+
+        return (NdotV/(1.0f + BrdfLambdaBeckmann(NdotV, alpha)))*(NdotL/(1.0f + BrdfLambdaBeckmann(NdotL, alpha)));
+    }
+
+    if (gsfType == BRDF_GSF_SMITH_GGX)
+    {
+        float alpha = fmaxf(roughness, 0.0001f);
+        float alpha2 = alpha*alpha;
+        float NdotL = fmaxf(BrdfDot(f->N, f->L), 0.0001f);
+        float NdotV = fmaxf(BrdfDot(f->N, f->V), 0.0001f);
+        float lambdaV = (-1.0f + sqrtf(1.0f + alpha2*(1.0f - NdotV*NdotV)/(NdotV*NdotV)))*0.5f;
+        float lambdaL = (-1.0f + sqrtf(1.0f + alpha2*(1.0f - NdotL*NdotL)/(NdotL*NdotL)))*0.5f;
+
+        return (NdotV*NdotL)/(1.0f + lambdaV + lambdaL);
+    }
+
+    if (gsfType == BRDF_GSF_SMITH_GGX_ANISOTROPIC)
+    {
+        float aspect = sqrtf(1.0f - anisotropy*0.75f);
+        float alphaX = fmaxf(0.0001f, roughness/aspect);
+        float alphaY = fmaxf(0.0001f, roughness*aspect);
+        float NdotL = fmaxf(BrdfDot(f->N, f->L), 0.0001f);
+        float NdotV = fmaxf(BrdfDot(f->N, f->V), 0.0001f);
+        float TdotV = BrdfDot(f->T, f->V);
+        float BdotV = BrdfDot(f->B, f->V);
+        float TdotL = BrdfDot(f->T, f->L);
+        float BdotL = BrdfDot(f->B, f->L);
+
+        float tan2ThetaV = (TdotV*TdotV)/(alphaX*alphaX*NdotV*NdotV) + (BdotV*BdotV)/(alphaY*alphaY*NdotV*NdotV);
+        float tan2ThetaL = (TdotL*TdotL)/(alphaX*alphaX*NdotL*NdotL) + (BdotL*BdotL)/(alphaY*alphaY*NdotL*NdotL);
+        float lambdaV = (-1.0f + sqrtf(1.0f + tan2ThetaV))*0.5f;
+        float lambdaL = (-1.0f + sqrtf(1.0f + tan2ThetaL))*0.5f;
+
+        return (NdotV*NdotL)/(1.0f + lambdaV + lambdaL);
+    }
+
+    return 1.0f;
+}
+
+// F: Fresnel Functions
+static void BrdfFresnel(const BrdfMaterial *m, float metallic, const BrdfFrame *f, float *F)
+{
+    if (m->fresnelType == BRDF_FRESNEL_SCHLICK)
+    {
+        float reflectivity = BrdfReflectivity(m->ior);
+        float VdotH = fmaxf(BrdfDot(f->V, f->H), 0.0f);
+        float weight = BrdfPow5(BrdfClamp(1.0f - VdotH, 0.0f, 1.0f));
+        const float color[3] = { m->color.x, m->color.y, m->color.z };
+
+        for (int i = 0; i < 3; i++)
+        {
+            float F0 = BrdfMix(reflectivity, color[i], metallic);
+            F[i] = F0 + (1.0f - F0)*weight;
+        }
+        return;
+    }
+
+    if (m->fresnelType == BRDF_FRESNEL_DIELECTRIC)
+    {
+        float etaI = 1.0f;
+        float etaT = m->ior;
+        float cosTheta = BrdfClamp(BrdfDot(f->V, f->H), -1.0f, 1.0f);
+
+        if (cosTheta < 0.0f)
+        {
+            etaI = m->ior;
+            etaT = 1.0f;
+            cosTheta = fabsf(cosTheta);
+        }
+
+        float eta = etaI/etaT;
+        float sinThetaT2 = eta*eta*(1.0f - cosTheta*cosTheta);
+        float value = 1.0f;
+
+        // Total internal reflection otherwise
+        if (sinThetaT2 < 1.0f)
+        {
+            float cosThetaT = sqrtf(1.0f - sinThetaT2);
+            float Rs = (etaT*cosTheta - etaI*cosThetaT)/(etaT*cosTheta + etaI*cosThetaT);
+            float Rp = (etaI*cosTheta - etaT*cosThetaT)/(etaI*cosTheta + etaT*cosThetaT);
+            value = 0.5f*(Rs*Rs + Rp*Rp);
+        }
+
+        F[0] = F[1] = F[2] = value;
+        return;
+    }
+
+    if (m->fresnelType == BRDF_FRESNEL_CONDUCTOR)
+    {
+        int preset = ((m->conductorPreset >= 0) && (m->conductorPreset < 5))? m->conductorPreset : 0;
+        float cosTheta = BrdfClamp(BrdfDot(f->V, f->H), 0.0f, 1.0f);
+
+        for (int i = 0; i < 3; i++)
+        {
+            float eta = brdfConductorEta[preset][i];
+            float kappa = brdfConductorKappa[preset][i];
+            float eta2Kappa2 = eta*eta + kappa*kappa;
+
+            F[i] = (eta2Kappa2 - 2.0f*eta*cosTheta + cosTheta*cosTheta)/fmaxf(eta2Kappa2 + 2.0f*eta*cosTheta + cosTheta*cosTheta, 0.0001f);
+        }
+        return;
+    }
+
+    F[0] = F[1] = F[2] = 1.0f;
+}
+
+// Burley diffuse without the albedo, clamped dot products as passed in
+static float BrdfBurley(float roughness, float NdotL, float NdotV, float LdotH)
+{
+    float FD90 = 0.5f + 2.0f*roughness*LdotH*LdotH;
+
+    return NdotL*(1.0f + (FD90 - 1.0f)*BrdfPow5(1.0f - NdotV))*(1.0f + (FD90 - 1.0f)*BrdfPow5(1.0f - NdotL))/PI;
+}
+
+// Kulla-Conty lobe from the DFG table, added to the specular without NdotL
+static void BrdfMultiScatter(const BrdfMaterial *m, float roughness, float metallic, float NdotL, float NdotV, float *specular)
+{
+    float F0[3] = { m->color.x, m->color.y, m->color.z };
+    float reflectivity = BrdfReflectivity(m->ior);
+    for (int i = 0; i < 3; i++) F0[i] = BrdfMix(reflectivity, F0[i], metallic);
+
+    if (m->multiScatterType == BRDF_MULTISCATTER_ACCURATE)
+    {
+        if (m->dfg == NULL) return;
+
+        float dfgV[3], dfgL[3];
+        SampleBrdfDFG(m->dfg, NdotV, roughness, dfgV);
+        SampleBrdfDFG(m->dfg, NdotL, roughness, dfgL);
+
+        float Eavg = dfgV[2];
+        float EmsV = 1.0f - (dfgV[0] + dfgV[1]);
+        float EmsL = 1.0f - (dfgL[0] + dfgL[1]);
+
+        for (int i = 0; i < 3; i++)
+        {
+            float Favg = F0[i] + (1.0f - F0[i])/21.0f;
+            float energyTerm = (Favg*Eavg)/(1.0f - Favg*(1.0f - Eavg));
+            specular[i] += (EmsV*EmsL/(PI*fmaxf(1.0f - Eavg, 0.001f)))*energyTerm;
+        }
+    }
+    else if (m->multiScatterType == BRDF_MULTISCATTER_APPROXIMATE)
+    {
+        float Ems = 1.0f - (1.0f - 0.28f*roughness*roughness);
+
+        for (int i = 0; i < 3; i++) specular[i] += Ems*(F0[i] + (1.0f - F0[i])/21.0f);
+    }
+}
+
+// Cook-Torrance base layer shared by the PBR models, kD*diffuse and specular kept apart for the layers
+static void BrdfBaseLayer(const BrdfMaterial *m, int ndfType, int gsfType, const BrdfFrame *f, float *diffuse, float *specular, float *F)
+{
+    BrdfMaterial base = *m;
+    if (m->model != BRDF_MODEL_COOK_TORRANCE)
+    {
+        base.fresnelType = BRDF_FRESNEL_SCHLICK;
+        base.multiScatterType = BRDF_MULTISCATTER_ACCURATE;
+    }
+
+    float NdotV = fmaxf(BrdfDot(f->N, f->V), 0.0f);
+    float NdotL = fmaxf(BrdfDot(f->N, f->L), 0.0f);
+    float LdotH = fmaxf(BrdfDot(f->L, f->H), 0.0f);
+
+    float burley = BrdfBurley(f->roughness, NdotL, NdotV, LdotH);
+    const float color[3] = { m->color.x, m->color.y, m->color.z };
+
+    float D = BrdfDistribution(ndfType, f->roughness, m->anisotropy, f);
+    float G = BrdfGeometry(gsfType, f->roughness, m->anisotropy, f);
+    BrdfFresnel(&base, f->metallic, f, F);
+
+    float scale = D*G/fmaxf(4.0f*NdotL*NdotV, 0.0001f)*NdotL;
+    for (int i = 0; i < 3; i++)
+    {
+        diffuse[i] = color[i]*burley;
+        specular[i] = F[i]*scale;
+    }
+
+    BrdfMultiScatter(&base, f->roughness, f->metallic, NdotL, NdotV, specular);
+}
+
+static void BrdfEvalSample(const BrdfMaterial *m, const BrdfFrame *f, float *out)
+{
+    const float color[3] = { m->color.x, m->color.y, m->color.z };
+    const float rawNdotL = fmaxf(BrdfDot(f->N, f->L), 0.0f);
+    const float rawNdotV = fmaxf(BrdfDot(f->N, f->V), 0.0f);
+    const float NdotL = fmaxf(rawNdotL, 0.0001f);
+    const float NdotV = fmaxf(rawNdotV, 0.0001f);
+
+    switch (m->model)
+    {
+        case BRDF_MODEL_LAMBERT:
+        {
+            float NdotLLambert = fmaxf(BrdfDot(f->N, f->L), 0.0001f);
+            for (int i = 0; i < 3; i++) out[i] = color[i]/PI*NdotLLambert;
+        } break;
+        case BRDF_MODEL_OREN_NAYAR:
+        {
+            float sigma2 = f->roughness*f->roughness;
+            float A = 1.0f - 0.5f*(sigma2/(sigma2 + 0.33f));
+            float B = 0.45f*(sigma2/(sigma2 + 0.09f));
+
+            float thetaL = acosf(BrdfClamp(NdotL, 0.0f, 1.0f));
+            float thetaV = acosf(BrdfClamp(NdotV, 0.0f, 1.0f));
+            float alpha = fmaxf(thetaL, thetaV);
+            float beta = fminf(thetaL, thetaV);
+
+            Vector3 Lp = { f->L.x - NdotL*f->N.x, f->L.y - NdotL*f->N.y, f->L.z - NdotL*f->N.z };
+            Vector3 Vp = { f->V.x - NdotV*f->N.x, f->V.y - NdotV*f->N.y, f->V.z - NdotV*f->N.z };
+            float LpLength = sqrtf(BrdfDot(Lp, Lp));
+            float VpLength = sqrtf(BrdfDot(Vp, Vp));
+
+            float cosPhiDiff = 0.0f;
+            if ((LpLength > 0.001f) && (VpLength > 0.001f)) cosPhiDiff = BrdfClamp(BrdfDot(Lp, Vp)/(LpLength*VpLength), -1.0f, 1.0f);
+
+            float term = A + B*fmaxf(0.0f, cosPhiDiff)*sinf(alpha)*tanf(beta);
+            for (int i = 0; i < 3; i++) out[i] = color[i]/PI*NdotL*term;
+        } break;
+        case BRDF_MODEL_BURLEY:
+        {
+            float LdotH = fmaxf(fmaxf(BrdfDot(f->L, f->H), 0.0f), 0.0001f);
+            float burley = BrdfBurley(f->roughness, NdotL, NdotV, LdotH);
+            for (int i = 0; i < 3; i++) out[i] = color[i]*burley;
+        } break;
+        case BRDF_MODEL_ASHIKHMIN_SHIRLEY_DIFFUSE:
+        case BRDF_MODEL_ASHIKHMIN_SHIRLEY:
+        {
+            float terms = (1.0f - BrdfPow5(1.0f - NdotL*0.5f))*(1.0f - BrdfPow5(1.0f - NdotV*0.5f));
+            float F0[3];
+            for (int i = 0; i < 3; i++)
+            {
+                F0[i] = BrdfMix(0.04f, color[i], f->metallic);
+                out[i] = (28.0f/(23.0f*PI))*color[i]*(1.0f - F0[i])*terms*NdotL;
+            }
+
+            if (m->model == BRDF_MODEL_ASHIKHMIN_SHIRLEY_DIFFUSE) break;
+
+            float NdotH = fmaxf(fmaxf(BrdfDot(f->N, f->H), 0.0f), 0.0001f);
+            float HdotL = fmaxf(fmaxf(BrdfDot(f->H, f->L), 0.0f), 0.0001f);
+            float HdotT = BrdfDot(f->H, f->T);
+            float HdotB = BrdfDot(f->H, f->B);
+            float nu = powf(2.0f, 13.0f*(1.0f - BrdfClamp(m->roughnessU, 0.01f, 0.99f)));
+            float nv = powf(2.0f, 13.0f*(1.0f - BrdfClamp(m->roughnessV, 0.01f, 0.99f)));
+
+            float p = (nu*HdotT*HdotT + nv*HdotB*HdotB)/fmaxf(1.0f - NdotH*NdotH, 0.0001f);
+            float normalization = sqrtf((nu + 1.0f)*(nv + 1.0f))/(8.0f*PI);
+            float lobe = normalization*powf(NdotH, p)/(HdotL*fmaxf(NdotL, NdotV));
+            float weight = BrdfPow5(BrdfClamp(1.0f - HdotL, 0.0f, 1.0f));
+
+            for (int i = 0; i < 3; i++) out[i] += lobe*(F0[i] + (1.0f - F0[i])*weight)*NdotL;
+        } break;
+        case BRDF_MODEL_PHONG:
+        case BRDF_MODEL_BLINN_PHONG:
+        {
+            float specular = 0.0f;
+
+            if (rawNdotL > 0.0f)
+            {
+                float shininess = 0.0f;
+                float specDot = 0.0f;
+
+                if (m->model == BRDF_MODEL_PHONG)
+                {
+                    // R = reflect(-L, N)
+                    float NdotLRaw = BrdfDot(f->N, f->L);
+                    Vector3 R = { 2.0f*NdotLRaw*f->N.x - f->L.x, 2.0f*NdotLRaw*f->N.y - f->L.y, 2.0f*NdotLRaw*f->N.z - f->L.z };
+                    shininess = powf(2.0f, (1.0f - f->roughness)*8.0f);
+                    specDot = fmaxf(BrdfDot(R, f->V), 0.0f);
+                }
+                else
+                {
+                    shininess = powf(2.0f, (1.0f - f->roughness)*9.0f);
+                    specDot = fmaxf(BrdfDot(f->N, f->H), 0.0f);
+                }
+
+                specular = 0.15f*powf(specDot, shininess)*(shininess + 2.0f)/(8.0f*PI);
+            }
+
+            for (int i = 0; i < 3; i++) out[i] = color[i]/PI*NdotL + specular;
+        } break;
+        case BRDF_MODEL_COOK_TORRANCE:
+        case BRDF_MODEL_SHEEN:
+        case BRDF_MODEL_CLEARCOAT:
+        {
+            bool cookTorrance = (m->model == BRDF_MODEL_COOK_TORRANCE);
+            float diffuse[3], specular[3], F[3];
+            BrdfBaseLayer(m, cookTorrance? m->ndfType : BRDF_NDF_GGX, cookTorrance? m->gsfType : BRDF_GSF_SMITH_GGX, f, diffuse, specular, F);
+
+            float layer[3] = { 0.0f, 0.0f, 0.0f };
+
+            if (m->model == BRDF_MODEL_SHEEN)
+            {
+                float NdotH = fmaxf(BrdfDot(f->N, f->H), 0.0f);
+                float invR = 1.0f/fmaxf(m->sheenRoughness, 0.0001f);
+                float sin2h = fmaxf(1.0f - NdotH*NdotH, 0.0078125f);
+                float Dsheen = (2.0f + invR)*powf(sin2h, invR*0.5f)/(2.0f*PI);
+                float Vsheen = 1.0f/fmaxf(4.0f*(rawNdotL + rawNdotV - rawNdotL*rawNdotV), 0.0001f);
+                float sheenFresnel = BrdfPow5(1.0f - fmaxf(BrdfDot(f->V, f->H), 0.0f));
+                float attenuation = 1.0f - m->sheenWeight*sheenFresnel;
+                const float tint[3] = { m->sheenTint.x, m->sheenTint.y, m->sheenTint.z };
+
+                for (int i = 0; i < 3; i++)
+                {
+                    layer[i] = m->sheenWeight*tint[i]*Dsheen*Vsheen*rawNdotL;
+                    diffuse[i] *= attenuation;
+                    specular[i] *= attenuation;
+                }
+            }
+            else if (m->model == BRDF_MODEL_CLEARCOAT)
+            {
+                float coatF0 = BrdfReflectivity(m->clearcoatIor);
+                float coatFresnel = coatF0 + (1.0f - coatF0)*BrdfPow5(1.0f - fmaxf(BrdfDot(f->V, f->H), 0.0f));
+                float Dcoat = BrdfDistribution(BRDF_NDF_GGX, m->clearcoatRoughness, 0.0f, f);
+                float Gcoat = BrdfGeometry(BRDF_GSF_SMITH_GGX, m->clearcoatRoughness, 0.0f, f);
+                float coat = Dcoat*Gcoat*coatFresnel/fmaxf(4.0f*rawNdotL*rawNdotV, 0.0001f)*rawNdotL*m->clearcoatWeight;
+                float energyLoss = coatFresnel*m->clearcoatWeight;
+                const float tint[3] = { m->clearcoatTint.x, m->clearcoatTint.y, m->clearcoatTint.z };
+
+                for (int i = 0; i < 3; i++)
+                {
+                    float baseAttenuation = (1.0f - energyLoss)*tint[i]*tint[i];
+                    layer[i] = coat;
+                    diffuse[i] *= baseAttenuation;
+                    specular[i] *= baseAttenuation;
+                }
+            }
+
+            for (int i = 0; i < 3; i++) out[i] = (1.0f - F[i])*(1.0f - f->metallic)*diffuse[i] + specular[i] + layer[i];
+        } break;
+        default: out[0] = out[1] = out[2] = 0.0f; break;
+    }
+
+    for (int i = 0; i < 3; i++) if (!isfinite(out[i])) out[i] = 0.0f;
+}
+
+static void BrdfEvalReferenceRange(const BrdfMaterial *material, BrdfSamples s, BrdfResult result, int start, int end)
+{
+    for (int i = start; i < end; i++)
+    {
+        BrdfFrame f = { 0 };
+        f.N = (Vector3){ s.normal.x[i], s.normal.y[i], s.normal.z[i] };
+        f.L = (Vector3){ s.light.x[i], s.light.y[i], s.light.z[i] };
+        f.V = (Vector3){ s.view.x[i], s.view.y[i], s.view.z[i] };
+        if (s.tangent.x != NULL) f.T = (Vector3){ s.tangent.x[i], s.tangent.y[i], s.tangent.z[i] };
+        if (s.bitangent.x != NULL) f.B = (Vector3){ s.bitangent.x[i], s.bitangent.y[i], s.bitangent.z[i] };
+        f.roughness = (s.roughness != NULL)? s.roughness[i] : material->roughness;
+        f.metallic = (s.metallic != NULL)? s.metallic[i] : material->metallic;
+
+        // H = normalize(L + V), N for opposite L and V where the shaders get NaN
+        Vector3 H = { f.L.x + f.V.x, f.L.y + f.V.y, f.L.z + f.V.z };
+        float length = sqrtf(BrdfDot(H, H));
+        f.H = (length > 0.0f)? (Vector3){ H.x/length, H.y/length, H.z/length } : f.N;
+
+        float out[3];
+        BrdfEvalSample(material, &f, out);
+
+        result.r[i] = out[0];
+        result.g[i] = out[1];
+        result.b[i] = out[2];
+    }
+}
+
+void EvalBrdfReference(const BrdfMaterial *material, BrdfSamples samples, BrdfResult result)
+{
+    BrdfEvalReferenceRange(material, samples, result, 0, samples.count);
+}
+
+//----------------------------------------------------------------------------------
+// SIMD path, same math on BRDF_LANES samples at once
+//----------------------------------------------------------------------------------
+#if (BRDF_LANES > 1)
+
+#if defined(__AVX2__)
+typedef __m256 BrdfV;
+typedef __m256i BrdfVi;
+
+static inline BrdfV VSet(float x) { return _mm256_set1_ps(x); }
+static inline BrdfV VLoad(const float *p) { return _mm256_loadu_ps(p); }
+static inline void VStore(float *p, BrdfV a) { _mm256_storeu_ps(p, a); }
+static inline BrdfV VAdd(BrdfV a, BrdfV b) { return _mm256_add_ps(a, b); }
+static inline BrdfV VSub(BrdfV a, BrdfV b) { return _mm256_sub_ps(a, b); }
+static inline BrdfV VMul(BrdfV a, BrdfV b) { return _mm256_mul_ps(a, b); }
+static inline BrdfV VDiv(BrdfV a, BrdfV b) { return _mm256_div_ps(a, b); }
+static inline BrdfV VMin(BrdfV a, BrdfV b) { return _mm256_min_ps(a, b); }
+static inline BrdfV VMax(BrdfV a, BrdfV b) { return _mm256_max_ps(a, b); }
+static inline BrdfV VSqrt(BrdfV a) { return _mm256_sqrt_ps(a); }
+static inline BrdfV VLess(BrdfV a, BrdfV b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline BrdfV VGreater(BrdfV a, BrdfV b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline BrdfV VFinite(BrdfV a) { return _mm256_cmp_ps(_mm256_sub_ps(a, a), _mm256_setzero_ps(), _CMP_EQ_OQ); }
+static inline BrdfV VAnd(BrdfV a, BrdfV b) { return _mm256_and_ps(a, b); }
+static inline BrdfV VSelect(BrdfV mask, BrdfV a, BrdfV b) { return _mm256_blendv_ps(b, a, mask); }
+static inline BrdfVi VToInt(BrdfV a) { return _mm256_cvtps_epi32(a); }
+static inline BrdfVi VTruncate(BrdfV a) { return _mm256_cvttps_epi32(a); }
+static inline BrdfV VGather(const float *base, BrdfVi index) { return _mm256_i32gather_ps(base, index, 4); }
+static inline BrdfV VFromInt(BrdfVi a) { return _mm256_cvtepi32_ps(a); }
+static inline BrdfV VPow2i(BrdfVi e) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(e, _mm256_set1_epi32(127)), 23)); }
+static inline BrdfVi VExponent(BrdfV a) { return _mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(a), 23), _mm256_set1_epi32(127)); }
+static inline BrdfV VMantissa(BrdfV a) { return _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(_mm256_castps_si256(a), _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000))); }
+#else
+typedef __m128 BrdfV;
+typedef __m128i BrdfVi;
+
+static inline BrdfV VSet(float x) { return _mm_set1_ps(x); }
+static inline BrdfV VLoad(const float *p) { return _mm_loadu_ps(p); }
+static inline void VStore(float *p, BrdfV a) { _mm_storeu_ps(p, a); }
+static inline BrdfV VAdd(BrdfV a, BrdfV b) { return _mm_add_ps(a, b); }
+static inline BrdfV VSub(BrdfV a, BrdfV b) { return _mm_sub_ps(a, b); }
+static inline BrdfV VMul(BrdfV a, BrdfV b) { return _mm_mul_ps(a, b); }
+static inline BrdfV VDiv(BrdfV a, BrdfV b) { return _mm_div_ps(a, b); }
+static inline BrdfV VMin(BrdfV a, BrdfV b) { return _mm_min_ps(a, b); }
+static inline BrdfV VMax(BrdfV a, BrdfV b) { return _mm_max_ps(a, b); }
+static inline BrdfV VSqrt(BrdfV a) { return _mm_sqrt_ps(a); }
+static inline BrdfV VLess(BrdfV a, BrdfV b) { return _mm_cmplt_ps(a, b); }
+static inline BrdfV VGreater(BrdfV a, BrdfV b) { return _mm_cmpgt_ps(a, b); }
+static inline BrdfV VFinite(BrdfV a) { return _mm_cmpeq_ps(_mm_sub_ps(a, a), _mm_setzero_ps()); }
+static inline BrdfV VAnd(BrdfV a, BrdfV b) { return _mm_and_ps(a, b); }
+static inline BrdfV VSelect(BrdfV mask, BrdfV a, BrdfV b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline BrdfVi VToInt(BrdfV a) { return _mm_cvtps_epi32(a); }
+static inline BrdfVi VTruncate(BrdfV a) { return _mm_cvttps_epi32(a); }
+static inline BrdfV VGather(const float *base, BrdfVi index)
+{
+    int i[4];
+    _mm_storeu_si128((__m128i *)i, index);
+
+    return _mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]]);
+}
+static inline BrdfV VFromInt(BrdfVi a) { return _mm_cvtepi32_ps(a); }
+static inline BrdfV VPow2i(BrdfVi e) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127)), 23)); }
+static inline BrdfVi VExponent(BrdfV a) { return _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(a), 23), _mm_set1_epi32(127)); }
+static inline BrdfV VMantissa(BrdfV a) { return _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(_mm_castps_si128(a), _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000))); }
+#endif
+
+static inline BrdfV VClamp(BrdfV x, float lo, float hi) { return VMin(VMax(x, VSet(lo)), VSet(hi)); }
+static inline BrdfV VMix(BrdfV a, BrdfV b, BrdfV t) { return VAdd(a, VMul(VSub(b, a), t)); }
+static inline BrdfV VPow5(BrdfV x) { BrdfV x2 = VMul(x, x); return VMul(VMul(x2, x2), x); }
+
+// 2^x, round to nearest keeps the fraction in [-0.5, 0.5] where the degree 6 series is ~1e-7 accurate
+static inline BrdfV VExp2(BrdfV x)
+{
+    BrdfV clamped = VClamp(x, -126.0f, 126.0f);
+    BrdfVi xi = VToInt(clamped);
+    BrdfV t = VSub(clamped, VFromInt(xi));
+
+    BrdfV p = VSet(1.540353e-4f);
+    p = VAdd(VMul(p, t), VSet(1.333355e-3f));
+    p = VAdd(VMul(p, t), VSet(9.618129e-3f));
+    p = VAdd(VMul(p, t), VSet(5.550411e-2f));
+    p = VAdd(VMul(p, t), VSet(2.402265e-1f));
+    p = VAdd(VMul(p, t), VSet(6.931472e-1f));
+    p = VAdd(VMul(p, t), VSet(1.0f));
+
+    // Below the normal range the shaders' pow() results are 0 for all practical purposes
+    return VAnd(VMul(p, VPow2i(xi)), VGreater(x, VSet(-126.0f)));
+}
+
+// log2(x) for x > 0, -1000 for x <= 0 so that VPow(0, y > 0) is 0
+static inline BrdfV VLog2(BrdfV x)
+{
+    BrdfV positive = VGreater(x, VSet(1.17549435e-38f));
+    BrdfV safe = VMax(x, VSet(1.17549435e-38f));
+
+    // x = m*2^e with m in [sqrt(1/2), sqrt(2))
+    BrdfV e = VFromInt(VExponent(safe));
+    BrdfV m = VMantissa(safe);
+    BrdfV big = VGreater(m, VSet(1.41421356f));
+    m = VSelect(big, VMul(m, VSet(0.5f)), m);
+    e = VSelect(big, VAdd(e, VSet(1.0f)), e);
+
+    // ln(m) = 2*atanh(t), t = (m - 1)/(m + 1), |t| < 0.172
+    BrdfV t = VDiv(VSub(m, VSet(1.0f)), VAdd(m, VSet(1.0f)));
+    BrdfV t2 = VMul(t, t);
+    BrdfV p = VSet(1.0f/9.0f);
+    p = VAdd(VMul(p, t2), VSet(1.0f/7.0f));
+    p = VAdd(VMul(p, t2), VSet(1.0f/5.0f));
+    p = VAdd(VMul(p, t2), VSet(1.0f/3.0f));
+    p = VAdd(VMul(p, t2), VSet(1.0f));
+
+    BrdfV result = VAdd(e, VMul(VMul(t, p), VSet(2.0f*1.44269504f)));
+
+    return VSelect(positive, result, VSet(-1000.0f));
+}
+
+static inline BrdfV VPow(BrdfV x, BrdfV y) { return VExp2(VMul(y, VLog2(x))); }
+
+typedef struct BrdfV3 {
+    BrdfV x, y, z;
+} BrdfV3;
+
+static inline BrdfV VDot(BrdfV3 a, BrdfV3 b) { return VAdd(VAdd(VMul(a.x, b.x), VMul(a.y, b.y)), VMul(a.z, b.z)); }
+
+static inline BrdfV3 VLoad3(BrdfVectors v, int i)
+{
+    BrdfV3 r = { VSet(0.0f), VSet(0.0f), VSet(0.0f) };
+    if (v.x != NULL) r = (BrdfV3){ VLoad(v.x + i), VLoad(v.y + i), VLoad(v.z + i) };
+    return r;
+}
+
+typedef struct BrdfFrameV {
+    BrdfV3 N, L, V, H, T, B;
+    BrdfV roughness;
+    BrdfV metallic;
+} BrdfFrameV;
+
+// Bilinear DFG fetch, same addressing as SampleBrdfDFG(), the texel loads are gathers
+static void VSampleDFG(const BrdfDFG *dfg, BrdfV NdotV, BrdfV roughness, BrdfV *rgb)
+{
+    const float size = (float)dfg->size;
+    BrdfV fx = VMin(VMax(VSub(VMul(NdotV, VSet(size)), VSet(0.5f)), VSet(0.0f)), VSet(size - 1.0f));
+    BrdfV fy = VMin(VMax(VSub(VMul(roughness, VSet(size)), VSet(0.5f)), VSet(0.0f)), VSet(size - 1.0f));
+
+    // Truncation is floor for the clamped coordinates, the +1 neighbour is clamped to the last texel
+    BrdfV x0 = VFromInt(VTruncate(fx));
+    BrdfV y0 = VFromInt(VTruncate(fy));
+    BrdfV tx = VSub(fx, x0);
+    BrdfV ty = VSub(fy, y0);
+    BrdfV dx = VSelect(VLess(x0, VSet(size - 1.0f)), VSet(3.0f), VSet(0.0f));
+    BrdfV dy = VSelect(VLess(y0, VSet(size - 1.0f)), VSet(3.0f*size), VSet(0.0f));
+
+    BrdfV base = VMul(VAdd(VMul(y0, VSet(size)), x0), VSet(3.0f));
+    BrdfVi offsets[4] = {
+        VTruncate(base), VTruncate(VAdd(base, dx)), VTruncate(VAdd(base, dy)), VTruncate(VAdd(VAdd(base, dx), dy))
+    };
+
+    for (int c = 0; c < 3; c++)
+    {
+        BrdfV a = VGather(dfg->data + c, offsets[0]);
+        BrdfV b = VGather(dfg->data + c, offsets[1]);
+        BrdfV d = VGather(dfg->data + c, offsets[2]);
+        BrdfV e = VGather(dfg->data + c, offsets[3]);
+        BrdfV top = VAdd(a, VMul(VSub(b, a), tx));
+        BrdfV bottom = VAdd(d, VMul(VSub(e, d), tx));
+
+        rgb[c] = VAdd(top, VMul(VSub(bottom, top), ty));
+    }
+}
+
+static BrdfV VDistribution(int ndfType, BrdfV roughness, float anisotropy, const BrdfFrameV *f)
+{
+    if (ndfType == BRDF_NDF_BECKMANN)
+    {
+        BrdfV alpha2 = VMax(VMul(roughness, roughness), VSet(0.0001f));
+        BrdfV NdotH = VMax(VDot(f->N, f->H), VSet(0.0001f));
+        BrdfV NdotH2 = VMul(NdotH, NdotH);
+        BrdfV tanThetaH2 = VDiv(VSub(VSet(1.0f), NdotH2), NdotH2);
+        BrdfV e = VExp2(VMul(VDiv(tanThetaH2, alpha2), VSet(-1.44269504f)));
+
+        return VDiv(e, VMul(VMul(VSet(PI), alpha2), VMul(NdotH2, NdotH2)));
+    }
+
+    if (ndfType == BRDF_NDF_GGX)
+    {
+        BrdfV alpha2 = VMax(VMul(roughness, roughness), VSet(0.0001f));
+        BrdfV NdotH = VMax(VDot(f->N, f->H), VSet(0.0001f));
+        BrdfV denomPart = VAdd(VMul(VSub(alpha2, VSet(1.0f)), VMul(NdotH, NdotH)), VSet(1.0f));
+
+        return VDiv(alpha2, VMul(VSet(PI), VMul(denomPart, denomPart)));
+    }
+
+    if (ndfType == BRDF_NDF_GGX_ANISOTROPIC)
+    {
+        BrdfV aspect = VSet(sqrtf(1.0f - anisotropy*0.75f));
+        BrdfV alphaX = VMax(VSet(0.0001f), VDiv(roughness, aspect));
+        BrdfV alphaY = VMax(VSet(0.0001f), VMul(roughness, aspect));
+        BrdfV TdotH = VDot(f->T, f->H);
+        BrdfV BdotH = VDot(f->B, f->H);
+        BrdfV NdotH = VMax(VDot(f->N, f->H), VSet(0.0001f));
+        BrdfV denomPart = VAdd(VAdd(VDiv(VMul(TdotH, TdotH), VMul(alphaX, alphaX)), VDiv(VMul(BdotH, BdotH), VMul(alphaY, alphaY))), VMul(NdotH, NdotH));
+
+        return VDiv(VSet(1.0f), VMul(VMul(VSet(PI), VMul(alphaX, alphaY)), VMul(denomPart, denomPart)));
+    }
+
+    return VSet(1.0f);
+}
+
+static BrdfV VLambdaBeckmann(BrdfV NdotX, BrdfV alpha)
+{
+    BrdfV sinTheta = VSqrt(VMax(VSub(VSet(1.0f), VMul(NdotX, NdotX)), VSet(0.0f)));
+    BrdfV tanTheta = VDiv(sinTheta, VMax(NdotX, VSet(0.0001f)));
+    BrdfV a = VDiv(VSet(1.0f), VMul(alpha, tanTheta));
+    BrdfV lambda = VDiv(VAdd(VSub(VSet(1.0f), VMul(VSet(1.259f), a)), VMul(VSet(0.396f), VMul(a, a))),
+                        VAdd(VMul(VSet(3.535f), a), VMul(VSet(2.181f), VMul(a, a))));
+
+    return VSelect(VLess(a, VSet(1.6f)), lambda, VSet(0.0f));
+}
+
+static BrdfV VGeometry(int gsfType, BrdfV roughness, float anisotropy, const BrdfFrameV *f)
+{
+    const BrdfV one = VSet(1.0f);
+
+    if (gsfType == BRDF_GSF_KELEMEN)
+    {
+        BrdfV NdotL = VMax(VDot(f->N, f->L), VSet(0.0f));
+        BrdfV NdotV = VMax(VDot(f->N, f->V), VSet(0.0f));
+        BrdfV VdotH = VMax(VDot(f->V, f->H), VSet(0.0001f));
+
+        return VDiv(VMul(NdotL, NdotV), VMul(VdotH, VdotH));
+    }
+
+    if (gsfType == BRDF_GSF_NEUMANN)
+    {
+        return VMin(VMax(VDot(f->N, f->L), VSet(0.0f)), VMax(VDot(f->N, f->V), VSet(0.0f)));
+    }
+
+    if ((gsfType == BRDF_GSF_SCHLICK_DISNEY) || (gsfType == BRDF_GSF_SCHLICK_EPIC))
+    {
+        BrdfV r1 = VAdd(roughness, one);
+        BrdfV k = (gsfType == BRDF_GSF_SCHLICK_DISNEY)? VMax(VMul(roughness, VSet(0.5f)), VSet(0.0001f)) : VMul(VMul(r1, r1), VSet(1.0f/8.0f));
+        BrdfV NdotL = VMax(VDot(f->N, f->L), VSet(0.0f));
+        BrdfV NdotV = VMax(VDot(f->N, f->V), VSet(0.0f));
+        BrdfV GV = VDiv(NdotV, VAdd(VMul(NdotV, VSub(one, k)), k));
+        BrdfV GL = VDiv(NdotL, VAdd(VMul(NdotL, VSub(one, k)), k));
+
+        return VMul(GV, GL);
+    }
+
+    if (gsfType == BRDF_GSF_SMITH_BECKMANN)
+    {
+        BrdfV alpha = VMax(roughness, VSet(0.0001f));
+        BrdfV NdotL = VMax(VDot(f->N, f->L), VSet(0.0f));
+        BrdfV NdotV = VMax(VDot(f->N, f->V), VSet(0.0f));
+
+        return VMul(VDiv(NdotV, VAdd(one, VLambdaBeckmann(NdotV, alpha))), VDiv(NdotL, VAdd(one, VLambdaBeckmann(NdotL, alpha))));
+    }
+
+    if (gsfType == BRDF_GSF_SMITH_GGX)
+    {
+        BrdfV alpha = VMax(roughness, VSet(0.0001f));
+        BrdfV alpha2 = VMul(alpha, alpha);
+        BrdfV NdotL = VMax(VDot(f->N, f->L), VSet(0.0001f));
+        BrdfV NdotV = VMax(VDot(f->N, f->V), VSet(0.0001f));
+        BrdfV NdotV2 = VMul(NdotV, NdotV);
+        BrdfV NdotL2 = VMul(NdotL, NdotL);
+        BrdfV lambdaV = VMul(VSub(VSqrt(VAdd(one, VDiv(VMul(alpha2, VSub(one, NdotV2)), NdotV2))), one), VSet(0.5f));
+        BrdfV lambdaL = VMul(VSub(VSqrt(VAdd(one, VDiv(VMul(alpha2, VSub(one, NdotL2)), NdotL2))), one), VSet(0.5f));
+
+        return VDiv(VMul(NdotV, NdotL), VAdd(VAdd(one, lambdaV), lambdaL));
+    }
+
+    if (gsfType == BRDF_GSF_SMITH_GGX_ANISOTROPIC)
+    {
+        BrdfV aspect = VSet(sqrtf(1.0f - anisotropy*0.75f));
+        BrdfV alphaX = VMax(VSet(0.0001f), VDiv(roughness, aspect));
+        BrdfV alphaY = VMax(VSet(0.0001f), VMul(roughness, aspect));
+        BrdfV alphaX2 = VMul(alphaX, alphaX);
+        BrdfV alphaY2 = VMul(alphaY, alphaY);
+        BrdfV NdotL = VMax(VDot(f->N, f->L), VSet(0.0001f));
+        BrdfV NdotV = VMax(VDot(f->N, f->V), VSet(0.0001f));
+        BrdfV NdotV2 = VMul(NdotV, NdotV);
+        BrdfV NdotL2 = VMul(NdotL, NdotL);
+        BrdfV TdotV = VDot(f->T, f->V);
+        BrdfV BdotV = VDot(f->B, f->V);
+        BrdfV TdotL = VDot(f->T, f->L);
+        BrdfV BdotL = VDot(f->B, f->L);
+
+        BrdfV tan2ThetaV = VAdd(VDiv(VMul(TdotV, TdotV), VMul(alphaX2, NdotV2)), VDiv(VMul(BdotV, BdotV), VMul(alphaY2, NdotV2)));
+        BrdfV tan2ThetaL = VAdd(VDiv(VMul(TdotL, TdotL), VMul(alphaX2, NdotL2)), VDiv(VMul(BdotL, BdotL), VMul(alphaY2, NdotL2)));
+        BrdfV lambdaV = VMul(VSub(VSqrt(VAdd(one, tan2ThetaV)), one), VSet(0.5f));
+        BrdfV lambdaL = VMul(VSub(VSqrt(VAdd(one, tan2ThetaL)), one), VSet(0.5f));
+
+        return VDiv(VMul(NdotV, NdotL), VAdd(VAdd(one, lambdaV), lambdaL));
+    }
+
+    return one;
+}
+
+static void VFresnel(const BrdfMaterial *m, int fresnelType, const BrdfFrameV *f, BrdfV *F)
+{
+    const BrdfV one = VSet(1.0f);
+
+    if (fresnelType == BRDF_FRESNEL_SCHLICK)
+    {
+        BrdfV reflectivity = VSet(BrdfReflectivity(m->ior));
+        BrdfV VdotH = VMax(VDot(f->V, f->H), VSet(0.0f));
+        BrdfV weight = VPow5(VClamp(VSub(one, VdotH), 0.0f, 1.0f));
+        const float color[3] = { m->color.x, m->color.y, m->color.z };
+
+        for (int i = 0; i < 3; i++)
+        {
+            BrdfV F0 = VMix(reflectivity, VSet(color[i]), f->metallic);
+            F[i] = VAdd(F0, VMul(VSub(one, F0), weight));
+        }
+        return;
+    }
+
+    if (fresnelType == BRDF_FRESNEL_DIELECTRIC)
+    {
+        BrdfV cosTheta = VClamp(VDot(f->V, f->H), -1.0f, 1.0f);
+
+        // Exiting lanes swap the media
+        BrdfV exiting = VLess(cosTheta, VSet(0.0f));
+        BrdfV etaI = VSelect(exiting, VSet(m->ior), one);
+        BrdfV etaT = VSelect(exiting, one, VSet(m->ior));
+        cosTheta = VSelect(exiting, VSub(VSet(0.0f), cosTheta), cosTheta);
+
+        BrdfV eta = VDiv(etaI, etaT);
+        BrdfV sinThetaT2 = VMul(VMul(eta, eta), VSub(one, VMul(cosTheta, cosTheta)));
+        BrdfV cosThetaT = VSqrt(VMax(VSub(one, sinThetaT2), VSet(0.0f)));
+
+        BrdfV Rs = VDiv(VSub(VMul(etaT, cosTheta), VMul(etaI, cosThetaT)), VAdd(VMul(etaT, cosTheta), VMul(etaI, cosThetaT)));
+        BrdfV Rp = VDiv(VSub(VMul(etaI, cosTheta), VMul(etaT, cosThetaT)), VAdd(VMul(etaI, cosTheta), VMul(etaT, cosThetaT)));
+        BrdfV value = VMul(VSet(0.5f), VAdd(VMul(Rs, Rs), VMul(Rp, Rp)));
+
+        F[0] = F[1] = F[2] = VSelect(VLess(sinThetaT2, one), value, one);
+        return;
+    }
+
+    if (fresnelType == BRDF_FRESNEL_CONDUCTOR)
+    {
+        int preset = ((m->conductorPreset >= 0) && (m->conductorPreset < 5))? m->conductorPreset : 0;
+        BrdfV cosTheta = VClamp(VDot(f->V, f->H), 0.0f, 1.0f);
+        BrdfV cosTheta2 = VMul(cosTheta, cosTheta);
+
+        for (int i = 0; i < 3; i++)
+        {
+            float eta = brdfConductorEta[preset][i];
+            float kappa = brdfConductorKappa[preset][i];
+            BrdfV eta2Kappa2 = VSet(eta*eta + kappa*kappa);
+            BrdfV etaCosTheta = VMul(VSet(2.0f*eta), cosTheta);
+
+            F[i] = VDiv(VAdd(VSub(eta2Kappa2, etaCosTheta), cosTheta2), VMax(VAdd(VAdd(eta2Kappa2, etaCosTheta), cosTheta2), VSet(0.0001f)));
+        }
+        return;
+    }
+
+    F[0] = F[1] = F[2] = one;
+}
+
+static inline BrdfV VBurley(BrdfV roughness, BrdfV NdotL, BrdfV NdotV, BrdfV LdotH)
+{
+    const BrdfV one = VSet(1.0f);
+    BrdfV FD90m1 = VSub(VAdd(VSet(0.5f), VMul(VMul(VSet(2.0f), roughness), VMul(LdotH, LdotH))), one);
+    BrdfV viewScatter = VAdd(one, VMul(FD90m1, VPow5(VSub(one, NdotV))));
+    BrdfV lightScatter = VAdd(one, VMul(FD90m1, VPow5(VSub(one, NdotL))));
+
+    return VMul(VMul(NdotL, VMul(viewScatter, lightScatter)), VSet(1.0f/PI));
+}
+
+static void VMultiScatter(const BrdfMaterial *m, int multiScatterType, BrdfV roughness, BrdfV metallic, BrdfV NdotL, BrdfV NdotV, BrdfV *specular)
+{
+    const BrdfV one = VSet(1.0f);
+    const float color[3] = { m->color.x, m->color.y, m->color.z };
+    BrdfV reflectivity = VSet(BrdfReflectivity(m->ior));
+    BrdfV F0[3];
+    for (int i = 0; i < 3; i++) F0[i] = VMix(reflectivity, VSet(color[i]), metallic);
+
+    if (multiScatterType == BRDF_MULTISCATTER_ACCURATE)
+    {
+        if (m->dfg == NULL) return;
+
+        BrdfV dfgV[3], dfgL[3];
+        VSampleDFG(m->dfg, NdotV, roughness, dfgV);
+        VSampleDFG(m->dfg, NdotL, roughness, dfgL);
+
+        BrdfV Eavg = dfgV[2];
+        BrdfV EmsV = VSub(one, VAdd(dfgV[0], dfgV[1]));
+        BrdfV EmsL = VSub(one, VAdd(dfgL[0], dfgL[1]));
+        BrdfV lobe = VDiv(VMul(EmsV, EmsL), VMul(VSet(PI), VMax(VSub(one, Eavg), VSet(0.001f))));
+
+        for (int i = 0; i < 3; i++)
+        {
+            BrdfV Favg = VAdd(F0[i], VMul(VSub(one, F0[i]), VSet(1.0f/21.0f)));
+            BrdfV energyTerm = VDiv(VMul(Favg, Eavg), VSub(one, VMul(Favg, VSub(one, Eavg))));
+            specular[i] = VAdd(specular[i], VMul(lobe, energyTerm));
+        }
+    }
+    else if (multiScatterType == BRDF_MULTISCATTER_APPROXIMATE)
+    {
+        BrdfV Ems = VSub(one, VSub(one, VMul(VSet(0.28f), VMul(roughness, roughness))));
+
+        for (int i = 0; i < 3; i++) specular[i] = VAdd(specular[i], VMul(Ems, VAdd(F0[i], VMul(VSub(one, F0[i]), VSet(1.0f/21.0f)))));
+    }
+}
+
+static void VEvalSamples(const BrdfMaterial *m, const BrdfFrameV *f, BrdfV *out)
+{
+    const BrdfV one = VSet(1.0f);
+    const BrdfV zero = VSet(0.0f);
+    const float color[3] = { m->color.x, m->color.y, m->color.z };
+    const BrdfV rawNdotL = VMax(VDot(f->N, f->L), zero);
+    const BrdfV rawNdotV = VMax(VDot(f->N, f->V), zero);
+    const BrdfV NdotL = VMax(rawNdotL, VSet(0.0001f));
+    const BrdfV NdotV = VMax(rawNdotV, VSet(0.0001f));
+
+    switch (m->model)
+    {
+        case BRDF_MODEL_LAMBERT:
+        {
+            BrdfV NdotLLambert = VMax(VDot(f->N, f->L), VSet(0.0001f));
+            for (int i = 0; i < 3; i++) out[i] = VMul(VSet(color[i]/PI), NdotLLambert);
+        } break;
+        case BRDF_MODEL_OREN_NAYAR:
+        {
+            BrdfV sigma2 = VMul(f->roughness, f->roughness);
+            BrdfV A = VSub(one, VMul(VSet(0.5f), VDiv(sigma2, VAdd(sigma2, VSet(0.33f)))));
+            BrdfV B = VMul(VSet(0.45f), VDiv(sigma2, VAdd(sigma2, VSet(0.09f))));
+
+            // alpha = max(thetaL, thetaV) has the smaller cosine, sin(acos(c)) = sqrt(1 - c^2), tan(acos(c)) = sqrt(1 - c^2)/c
+            BrdfV cosL = VMin(NdotL, one);
+            BrdfV cosV = VMin(NdotV, one);
+            BrdfV cosAlpha = VMin(cosL, cosV);
+            BrdfV cosBeta = VMax(cosL, cosV);
+            BrdfV sinAlpha = VSqrt(VMax(VSub(one, VMul(cosAlpha, cosAlpha)), zero));
+            BrdfV tanBeta = VDiv(VSqrt(VMax(VSub(one, VMul(cosBeta, cosBeta)), zero)), cosBeta);
+
+            BrdfV3 Lp = { VSub(f->L.x, VMul(NdotL, f->N.x)), VSub(f->L.y, VMul(NdotL, f->N.y)), VSub(f->L.z, VMul(NdotL, f->N.z)) };
+            BrdfV3 Vp = { VSub(f->V.x, VMul(NdotV, f->N.x)), VSub(f->V.y, VMul(NdotV, f->N.y)), VSub(f->V.z, VMul(NdotV, f->N.z)) };
+            BrdfV LpLength = VSqrt(VDot(Lp, Lp));
+            BrdfV VpLength = VSqrt(VDot(Vp, Vp));
+
+            BrdfV valid = VAnd(VGreater(LpLength, VSet(0.001f)), VGreater(VpLength, VSet(0.001f)));
+            BrdfV cosPhiDiff = VClamp(VDiv(VDot(Lp, Vp), VMul(LpLength, VpLength)), -1.0f, 1.0f);
+            cosPhiDiff = VSelect(valid, cosPhiDiff, zero);
+
+            BrdfV term = VAdd(A, VMul(VMul(B, VMax(zero, cosPhiDiff)), VMul(sinAlpha, tanBeta)));
+            for (int i = 0; i < 3; i++) out[i] = VMul(VMul(VSet(color[i]/PI), NdotL), term);
+        } break;
+        case BRDF_MODEL_BURLEY:
+        {
+            BrdfV LdotH = VMax(VDot(f->L, f->H), VSet(0.0001f));
+            BrdfV burley = VBurley(f->roughness, NdotL, NdotV, LdotH);
+            for (int i = 0; i < 3; i++) out[i] = VMul(VSet(color[i]), burley);
+        } break;
+        case BRDF_MODEL_ASHIKHMIN_SHIRLEY_DIFFUSE:
+        case BRDF_MODEL_ASHIKHMIN_SHIRLEY:
+        {
+            BrdfV terms = VMul(VSub(one, VPow5(VSub(one, VMul(NdotL, VSet(0.5f))))), VSub(one, VPow5(VSub(one, VMul(NdotV, VSet(0.5f))))));
+            BrdfV F0[3];
+            for (int i = 0; i < 3; i++)
+            {
+                F0[i] = VMix(VSet(0.04f), VSet(color[i]), f->metallic);
+                out[i] = VMul(VMul(VSet((28.0f/(23.0f*PI))*color[i]), VSub(one, F0[i])), VMul(terms, NdotL));
+            }
+
+            if (m->model == BRDF_MODEL_ASHIKHMIN_SHIRLEY_DIFFUSE) break;
+
+            BrdfV NdotH = VMax(VDot(f->N, f->H), VSet(0.0001f));
+            BrdfV HdotL = VMax(VDot(f->H, f->L), VSet(0.0001f));
+            BrdfV HdotT = VDot(f->H, f->T);
+            BrdfV HdotB = VDot(f->H, f->B);
+            float nu = powf(2.0f, 13.0f*(1.0f - BrdfClamp(m->roughnessU, 0.01f, 0.99f)));
+            float nv = powf(2.0f, 13.0f*(1.0f - BrdfClamp(m->roughnessV, 0.01f, 0.99f)));
+
+            BrdfV p = VDiv(VAdd(VMul(VSet(nu), VMul(HdotT, HdotT)), VMul(VSet(nv), VMul(HdotB, HdotB))), VMax(VSub(one, VMul(NdotH, NdotH)), VSet(0.0001f)));
+            BrdfV lobe = VDiv(VMul(VSet(sqrtf((nu + 1.0f)*(nv + 1.0f))/(8.0f*PI)), VPow(NdotH, p)), VMul(HdotL, VMax(NdotL, NdotV)));
+            BrdfV weight = VPow5(VClamp(VSub(one, HdotL), 0.0f, 1.0f));
+
+            for (int i = 0; i < 3; i++) out[i] = VAdd(out[i], VMul(VMul(lobe, VAdd(F0[i], VMul(VSub(one, F0[i]), weight))), NdotL));
+        } break;
+        case BRDF_MODEL_PHONG:
+        case BRDF_MODEL_BLINN_PHONG:
+        {
+            BrdfV shininess, specDot;
+
+            if (m->model == BRDF_MODEL_PHONG)
+            {
+                BrdfV twoNdotL = VMul(VSet(2.0f), VDot(f->N, f->L));
+                BrdfV3 R = { VSub(VMul(twoNdotL, f->N.x), f->L.x), VSub(VMul(twoNdotL, f->N.y), f->L.y), VSub(VMul(twoNdotL, f->N.z), f->L.z) };
+                shininess = VExp2(VMul(VSub(one, f->roughness), VSet(8.0f)));
+                specDot = VMax(VDot(R, f->V), zero);
+            }
+            else
+            {
+                shininess = VExp2(VMul(VSub(one, f->roughness), VSet(9.0f)));
+                specDot = VMax(VDot(f->N, f->H), zero);
+            }
+
+            BrdfV specular = VMul(VMul(VSet(0.15f/(8.0f*PI)), VPow(specDot, shininess)), VAdd(shininess, VSet(2.0f)));
+            specular = VAnd(specular, VGreater(rawNdotL, zero));
+
+            for (int i = 0; i < 3; i++) out[i] = VAdd(VMul(VSet(color[i]/PI), NdotL), specular);
+        } break;
+        case BRDF_MODEL_COOK_TORRANCE:
+        case BRDF_MODEL_SHEEN:
+        case BRDF_MODEL_CLEARCOAT:
+        {
+            bool cookTorrance = (m->model == BRDF_MODEL_COOK_TORRANCE);
+            BrdfV LdotH = VMax(VDot(f->L, f->H), zero);
+            BrdfV burley = VBurley(f->roughness, rawNdotL, rawNdotV, LdotH);
+
+            BrdfV D = VDistribution(cookTorrance? m->ndfType : BRDF_NDF_GGX, f->roughness, m->anisotropy, f);
+            BrdfV G = VGeometry(cookTorrance? m->gsfType : BRDF_GSF_SMITH_GGX, f->roughness, m->anisotropy, f);
+            BrdfV F[3];
+            VFresnel(m, cookTorrance? m->fresnelType : BRDF_FRESNEL_SCHLICK, f, F);
+
+            BrdfV scale = VMul(VDiv(VMul(D, G), VMax(VMul(VSet(4.0f), VMul(rawNdotL, rawNdotV)), VSet(0.0001f))), rawNdotL);
+            BrdfV diffuse[3], specular[3], layer[3];
+            for (int i = 0; i < 3; i++)
+            {
+                diffuse[i] = VMul(VSet(color[i]), burley);
+                specular[i] = VMul(F[i], scale);
+                layer[i] = zero;
+            }
+
+            VMultiScatter(m, cookTorrance? m->multiScatterType : BRDF_MULTISCATTER_ACCURATE, f->roughness, f->metallic, rawNdotL, rawNdotV, specular);
+
+            if (m->model == BRDF_MODEL_SHEEN)
+            {
+                BrdfV NdotH = VMax(VDot(f->N, f->H), zero);
+                float invR = 1.0f/fmaxf(m->sheenRoughness, 0.0001f);
+                BrdfV sin2h = VMax(VSub(one, VMul(NdotH, NdotH)), VSet(0.0078125f));
+                BrdfV Dsheen = VMul(VSet((2.0f + invR)/(2.0f*PI)), VPow(sin2h, VSet(invR*0.5f)));
+                BrdfV Vsheen = VDiv(one, VMax(VMul(VSet(4.0f), VSub(VAdd(rawNdotL, rawNdotV), VMul(rawNdotL, rawNdotV))), VSet(0.0001f)));
+                BrdfV sheenFresnel = VPow5(VSub(one, VMax(VDot(f->V, f->H), zero)));
+                BrdfV attenuation = VSub(one, VMul(VSet(m->sheenWeight), sheenFresnel));
+                BrdfV sheen = VMul(VMul(Dsheen, Vsheen), rawNdotL);
+                const float tint[3] = { m->sheenTint.x, m->sheenTint.y, m->sheenTint.z };
+
+                for (int i = 0; i < 3; i++)
+                {
+                    layer[i] = VMul(VSet(m->sheenWeight*tint[i]), sheen);
+                    diffuse[i] = VMul(diffuse[i], attenuation);
+                    specular[i] = VMul(specular[i], attenuation);
+                }
+            }
+            else if (m->model == BRDF_MODEL_CLEARCOAT)
+            {
+                float coatF0 = BrdfReflectivity(m->clearcoatIor);
+                BrdfV coatFresnel = VAdd(VSet(coatF0), VMul(VSet(1.0f - coatF0), VPow5(VSub(one, VMax(VDot(f->V, f->H), zero)))));
+                BrdfV coatRoughness = VSet(m->clearcoatRoughness);
+                BrdfV Dcoat = VDistribution(BRDF_NDF_GGX, coatRoughness, 0.0f, f);
+                BrdfV Gcoat = VGeometry(BRDF_GSF_SMITH_GGX, coatRoughness, 0.0f, f);
+                BrdfV coat = VMul(VDiv(VMul(VMul(Dcoat, Gcoat), coatFresnel), VMax(VMul(VSet(4.0f), VMul(rawNdotL, rawNdotV)), VSet(0.0001f))), VMul(rawNdotL, VSet(m->clearcoatWeight)));
+                BrdfV transmitted = VSub(one, VMul(coatFresnel, VSet(m->clearcoatWeight)));
+                const float tint[3] = { m->clearcoatTint.x, m->clearcoatTint.y, m->clearcoatTint.z };
+
+                for (int i = 0; i < 3; i++)
+                {
+                    BrdfV baseAttenuation = VMul(transmitted, VSet(tint[i]*tint[i]));
+                    layer[i] = coat;
+                    diffuse[i] = VMul(diffuse[i], baseAttenuation);
+                    specular[i] = VMul(specular[i], baseAttenuation);
+                }
+            }
+
+            BrdfV kDMetal = VSub(one, f->metallic);
+            for (int i = 0; i < 3; i++) out[i] = VAdd(VAdd(VMul(VMul(VSub(one, F[i]), kDMetal), diffuse[i]), specular[i]), layer[i]);
+        } break;
+        default: out[0] = out[1] = out[2] = zero; break;
+    }
+
+    for (int i = 0; i < 3; i++) out[i] = VAnd(out[i], VFinite(out[i]));
+}
+
+static void BrdfEvalSimdRange(const BrdfMaterial *material, BrdfSamples s, BrdfResult result, int start, int end)
+{
+    int i = start;
+
+    for (; i + BRDF_LANES <= end; i += BRDF_LANES)
+    {
+        BrdfFrameV f;
+        f.N = VLoad3(s.normal, i);
+        f.L = VLoad3(s.light, i);
+        f.V = VLoad3(s.view, i);
+        f.T = VLoad3(s.tangent, i);
+        f.B = VLoad3(s.bitangent, i);
+        f.roughness = (s.roughness != NULL)? VLoad(s.roughness + i) : VSet(material->roughness);
+        f.metallic = (s.metallic != NULL)? VLoad(s.metallic + i) : VSet(material->metallic);
+
+        BrdfV3 H = { VAdd(f.L.x, f.V.x), VAdd(f.L.y, f.V.y), VAdd(f.L.z, f.V.z) };
+        BrdfV length = VSqrt(VDot(H, H));
+        BrdfV valid = VGreater(length, VSet(0.0f));
+        f.H.x = VSelect(valid, VDiv(H.x, length), f.N.x);
+        f.H.y = VSelect(valid, VDiv(H.y, length), f.N.y);
+        f.H.z = VSelect(valid, VDiv(H.z, length), f.N.z);
+
+        BrdfV out[3];
+        VEvalSamples(material, &f, out);
+
+        VStore(result.r + i, out[0]);
+        VStore(result.g + i, out[1]);
+        VStore(result.b + i, out[2]);
+    }
+
+    // Remainder through the reference
+    BrdfEvalReferenceRange(material, s, result, i, end);
+}
+
+#endif // BRDF_LANES > 1
+
+typedef struct BrdfJob {
+    const BrdfMaterial *material;
+    BrdfSamples samples;
+    BrdfResult result;
+} BrdfJob;
+
+static void BrdfEvalChunk(int index, void *userData)
+{
+    BrdfJob *job = (BrdfJob *)userData;
+    int start = index*BRDF_CHUNK_SIZE;
+    int end = (start + BRDF_CHUNK_SIZE < job->samples.count)? start + BRDF_CHUNK_SIZE : job->samples.count;
+
+#if (BRDF_LANES > 1)
+    BrdfEvalSimdRange(job->material, job->samples, job->result, start, end);
+#else
+    BrdfEvalReferenceRange(job->material, job->samples, job->result, start, end);
+#endif
+}
+
+void EvalBrdf(const BrdfMaterial *material, BrdfSamples samples, BrdfResult result)
+{
+    BrdfJob job = { material, samples, result };
+    int chunkCount = (samples.count + BRDF_CHUNK_SIZE - 1)/BRDF_CHUNK_SIZE;
+
+    if (chunkCount > 1) ParallelFor(chunkCount, BrdfEvalChunk, &job);
+    else if (chunkCount == 1) BrdfEvalChunk(0, &job);
+}
+
+#endif // BRDF_IMPLEMENTATION
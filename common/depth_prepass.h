@@ -0,0 +1,79 @@
+/**********************************************************************************************
+*
+*   depth_prepass - Depth only pass ahead of the shading pass, so expensive fragment shaders
+*                   run once per visible pixel
+*
+*   Single header module, define DEPTH_PREPASS_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   The geometry is drawn twice. The first time with a program that has the same vertex
+*   shader and an empty fragment shader (resources/depth_only.fs) and color writes off, which
+*   fills the depth buffer with the front surface. The second time with the shading program,
+*   depth writes off and an EQUAL depth test, so only the fragment that won the first pass is
+*   shaded, whatever the draw order and the overdraw:
+*
+*       BeginDepthPrepass();
+*           DrawModel(...);                 // Depth only program
+*       EndDepthPrepass();
+*
+*       BeginDepthEqualPass();
+*           DrawModel(...);                 // Shading program
+*       EndDepthEqualPass();
+*
+*   Both programs must compute the same depth for EQUAL to pass, the vertex shader declares
+*   "invariant gl_Position;" so the compiler may not evaluate it differently in the two.
+*   Anything drawn after the shading pass with the usual LEQUAL test (a skybox at the far
+*   plane) only covers the pixels left empty. Blending still works in the shading pass, but
+*   over whatever was drawn before it, not over geometry hidden by the pre-pass
+*
+**********************************************************************************************/
+
+#ifndef DEPTH_PREPASS_H
+#define DEPTH_PREPASS_H
+
+#include "raylib.h"
+
+#define DEPTH_PREPASS_FRAGMENT_SHADER   "resources/depth_only.fs"
+
+void BeginDepthPrepass(void);           // Color writes off
+void EndDepthPrepass(void);
+void BeginDepthEqualPass(void);         // EQUAL depth test, depth writes off
+void EndDepthEqualPass(void);           // Back to raylib's LEQUAL test with depth writes
+
+#endif // DEPTH_PREPASS_H
+
+#if defined(DEPTH_PREPASS_IMPLEMENTATION) && !defined(DEPTH_PREPASS_IMPLEMENTED)
+#define DEPTH_PREPASS_IMPLEMENTED
+
+#include "rlgl.h"
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, rlgl has no depth function call
+
+// Every change flushes the batch first, what it holds was drawn under the previous state
+
+void BeginDepthPrepass(void)
+{
+    rlDrawRenderBatchActive();
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+}
+
+void EndDepthPrepass(void)
+{
+    rlDrawRenderBatchActive();
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void BeginDepthEqualPass(void)
+{
+    rlDrawRenderBatchActive();
+    glDepthFunc(GL_EQUAL);
+    rlDisableDepthMask();
+}
+
+void EndDepthEqualPass(void)
+{
+    rlDrawRenderBatchActive();
+    glDepthFunc(GL_LEQUAL);
+    rlEnableDepthMask();
+}
+
+#endif // DEPTH_PREPASS_IMPLEMENTATION
@@ -0,0 +1,561 @@
+/**********************************************************************************************
+*
+*   env_assets - Everything a demo derives from its sky panorama, behind one cached call
+*
+*   Single header module, define ENV_ASSETS_IMPLEMENTATION in exactly one translation unit
+*   before including it (pulls in the cubemap, SH and prefilter implementations)
+*
+*   Every asset is cached next to the panorama in the env_cache.h format, keyed by the hash
+*   of the panorama bytes and the options that produced it:
+*
+*       resources/sky1_2k.sky.cache     -> skybox cube chain             (ENV_ASSET_SKYBOX)
+*       resources/sky1_2k.sh9.cache     -> 9 irradiance coefficients     (ENV_ASSET_IRRADIANCE)
+*       resources/sky1_2k.ggx.cache     -> GGX prefiltered cube chain    (ENV_ASSET_PREFILTER)
+*
+*   Warm start: hash the panorama, map the caches, upload the cube chains straight from the
+*   mappings. The JPEG is never decoded. Cold start: decode once, bake what is missing, write
+*   the caches. Both paths log their time, warm starts also log the cold time stored in the
+*   cache headers, so the two can be compared from any run
+*
+*   LoadEnvAssetsAsync() returns at once with grey placeholders and runs all of the above on
+*   a worker thread. Finished chains go through a single producer / single consumer ring to
+*   the render thread, where UpdateEnvAssets() uploads them coarse to fine within a per frame
+*   byte budget and lowers GL_TEXTURE_BASE_LEVEL as levels land. Texture ids never change, so
+*   materials are bound once. Cold starts push a small preview cube first (and the SH, which
+*   is cheap), the full bakes replace it when they are done
+*
+*   Build with -DENV_ASSETS_FORMAT=PIXELFORMAT_UNCOMPRESSED_R16G16B16 to cache and upload the
+*   cube chains as RGB16F, it is part of the cache key so both kinds can not get mixed up
+*
+**********************************************************************************************/
+
+#ifndef ENV_ASSETS_H
+#define ENV_ASSETS_H
+
+#include "raylib.h"
+#include "env_cubemap.h"
+#include "env_prefilter.h"
+#include "env_sh.h"
+
+#define ENV_ASSET_SKYBOX        1       // Panorama converted to a cubemap
+#define ENV_ASSET_IRRADIANCE    2       // SH9 diffuse irradiance
+#define ENV_ASSET_PREFILTER     4       // GGX prefiltered cubemap for the ambient specular term
+
+#define ENV_ASSETS_VERSION      1       // Bump when a baker changes its output, invalidates every cache file
+
+#if !defined(ENV_ASSETS_FORMAT)
+    #define ENV_ASSETS_FORMAT   PIXELFORMAT_UNCOMPRESSED_R8G8B8     // Cube chain storage, RGB8 or PIXELFORMAT_UNCOMPRESSED_R16G16B16
+#endif
+
+#define ENV_STREAM_QUEUE_SIZE       8           // Handoff slots, one load never produces more than 5 items
+#define ENV_STREAM_UPLOAD_BUDGET    (2 << 20)   // Bytes uploaded per UpdateEnvAssets() call, at least one level always goes
+#define ENV_STREAM_PREVIEW_SIZE     32          // Face size of the preview pushed before a cold bake
+#define ENV_STREAM_PLACEHOLDER      128         // sRGB grey shown until the first levels arrive
+
+typedef struct EnvAssetsStream EnvAssetsStream;
+
+// Assets requested from LoadEnvAssets(), the ones not requested stay zeroed
+typedef struct EnvAssets {
+    TextureCubemap skybox;      // Ids stay valid while levels stream in, width/mipmaps track the levels in use
+    TextureCubemap prefilter;
+    EnvSH9 irradiance;
+    bool ready;                 // Every requested asset is at full quality
+    bool warm;                  // Every requested asset came from the cache (valid once ready)
+    float loadTime;             // Seconds from the load call to full quality
+    float coldTime;             // Seconds a cold start takes, measured now or read back from the cache headers
+    EnvAssetsStream *stream;    // Loader state, NULL once ready
+} EnvAssets;
+
+EnvAssets LoadEnvAssets(const char *fileName, int flags);           // Load the requested ENV_ASSET_* flags, full quality on return
+EnvAssets LoadEnvAssetsAsync(const char *fileName, int flags);      // Placeholders on return, the rest streams in through UpdateEnvAssets()
+int UpdateEnvAssets(EnvAssets *assets);                             // Call once per frame, uploads finished levels, returns the ENV_ASSET_* flags that changed
+void UnloadEnvAssets(EnvAssets assets);                             // Stops the worker if still running
+
+#endif // ENV_ASSETS_H
+
+#if defined(ENV_ASSETS_IMPLEMENTATION) && !defined(ENV_ASSETS_IMPLEMENTED)
+#define ENV_ASSETS_IMPLEMENTED
+
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define ENV_CACHE_IMPLEMENTATION
+#include "env_cache.h"
+#define ENV_CUBEMAP_IMPLEMENTATION
+#include "env_cubemap.h"
+#define ENV_PREFILTER_IMPLEMENTATION
+#include "env_prefilter.h"
+#define ENV_SH_IMPLEMENTATION
+#include "env_sh.h"
+
+// One finished asset on its way to the render thread
+typedef struct EnvStreamItem {
+    int asset;                  // ENV_ASSET_*
+    EnvCubemap cubemap;         // Chain to upload, owned or pointing into cache
+    EnvCacheFile cache;         // Mapping behind cubemap.data, mapping is NULL for owned data
+    int firstLevel;             // Texture level receiving mip 0 of the chain (previews land on the coarse levels)
+    EnvSH9 irradiance;
+} EnvStreamItem;
+
+struct EnvAssetsStream {
+    char fileName[512];
+    int flags;
+    double startTime;
+    double firstUpdateTime;
+
+    pthread_t thread;
+    bool threaded;
+    int cancel;                 // Set by the render thread, checked by the worker between bakes and by the bakers inside them
+    int finished;               // Set by the worker after its last push
+
+    // Ring buffer, items are written before tail is published (release) and read after it is observed (acquire)
+    EnvStreamItem items[ENV_STREAM_QUEUE_SIZE];
+    int head;                   // Written by the render thread only
+    int tail;                   // Written by the worker only
+
+    // Render thread upload state
+    int nextMip;                // Next mip of the head item, coarse to fine, -1 before it starts
+    int baseLevel[2];           // Finest level in use for skybox/prefilter, -1 while the placeholder shows
+
+    // Worker state, read by the render thread once finished
+    unsigned long long sourceHash;
+    Image panorama;             // Decoded on the first cache miss only
+    float decodeTime;           // Measured, 0 when the panorama was not decoded
+    float cachedDecodeTime;     // Largest decode time recorded in the cache headers
+    float buildTime;            // Sum over the assets, measured or recorded
+    int misses;
+};
+
+//----------------------------------------------------------------------------------
+// Worker side
+//----------------------------------------------------------------------------------
+
+static void EnvStreamPush(EnvAssetsStream *stream, EnvStreamItem item)
+{
+    // Never waits in practice, the ring holds every item a load produces
+    while (stream->tail - __atomic_load_n(&stream->head, __ATOMIC_ACQUIRE) >= ENV_STREAM_QUEUE_SIZE) sched_yield();
+
+    stream->items[stream->tail%ENV_STREAM_QUEUE_SIZE] = item;
+    __atomic_store_n(&stream->tail, stream->tail + 1, __ATOMIC_RELEASE);
+}
+
+static bool EnvStreamCancelled(EnvAssetsStream *stream)
+{
+    return (__atomic_load_n(&stream->cancel, __ATOMIC_ACQUIRE) != 0);
+}
+
+static bool EnvStreamDecode(EnvAssetsStream *stream)
+{
+    if (stream->panorama.data == NULL)
+    {
+        double startTime = GetTime();
+        stream->panorama = LoadImage(stream->fileName);
+        stream->decodeTime = (float)(GetTime() - startTime);
+    }
+
+    return (stream->panorama.data != NULL);
+}
+
+// Cache key of one asset: tag, format version and every parameter that changes the payload
+static unsigned long long EnvStreamKey(EnvAssetsStream *stream, int asset, char *cachePath, int size)
+{
+    int options[4] = { 0 };
+    const char *tag = "sh9";
+
+    if (asset == ENV_ASSET_IRRADIANCE) options[0] = ENV_SH_PROJECTION_WIDTH;
+    else if (asset == ENV_ASSET_SKYBOX)
+    {
+        tag = "sky";
+        options[0] = ENV_ASSETS_FORMAT;
+        options[1] = ENV_CUBEMAP_SUPERSAMPLE;
+    }
+    else
+    {
+        tag = "ggx";
+        options[0] = ENV_ASSETS_FORMAT;
+        options[1] = ENV_PREFILTER_FACE_SIZE;
+        options[2] = ENV_PREFILTER_ROUGHNESS_LEVELS;
+        options[3] = ENV_PREFILTER_SAMPLE_COUNT;
+    }
+
+    GetEnvCachePath(stream->fileName, tag, cachePath, size);
+
+    int version = ENV_ASSETS_VERSION;
+    unsigned long long hash = HashMemory(tag, strlen(tag), ENV_HASH_SEED);
+    hash = HashMemory(&version, sizeof(version), hash);
+
+    return HashMemory(options, sizeof(options), hash);
+}
+
+static void EnvStreamRecordHit(EnvAssetsStream *stream, EnvCacheHeader header)
+{
+    stream->buildTime += header.buildTime;
+    if (header.decodeTime > stream->cachedDecodeTime) stream->cachedDecodeTime = header.decodeTime;
+}
+
+// Push the cached asset if there is a valid cache file, the mapping travels with the item
+static bool EnvStreamMapAsset(EnvAssetsStream *stream, int asset)
+{
+    char cachePath[512] = { 0 };
+    unsigned long long optionsHash = EnvStreamKey(stream, asset, cachePath, sizeof(cachePath));
+
+    EnvStreamItem item = { 0 };
+    item.asset = asset;
+
+    if (!MapEnvCache(cachePath, stream->sourceHash, optionsHash, &item.cache)) return false;
+
+    EnvCacheHeader header = item.cache.header;
+    bool valid = false;
+
+    if (asset == ENV_ASSET_IRRADIANCE)
+    {
+        valid = (header.dataSize == (long long)sizeof(EnvSH9));
+        if (valid) memcpy(&item.irradiance, item.cache.data, sizeof(EnvSH9));
+        UnmapEnvCache(&item.cache);
+    }
+    else
+    {
+        // The chain is uploaded from the mapped pages, nothing is copied on the way
+        EnvCubemap view = { header.width, header.mipmaps, header.format, (unsigned char *)item.cache.data };
+        valid = (view.size > 0) && (view.mipmaps > 0) && (header.dataSize == GetEnvCubemapOffset(view.size, view.format, view.mipmaps, 0));
+
+        if (valid) item.cubemap = view;
+        else UnmapEnvCache(&item.cache);
+    }
+
+    if (!valid) return false;
+
+    EnvStreamRecordHit(stream, header);
+    EnvStreamPush(stream, item);
+
+    return true;
+}
+
+static void EnvStreamSave(EnvAssetsStream *stream, int asset, EnvCacheHeader header, const void *data)
+{
+    char cachePath[512] = { 0 };
+    header.sourceHash = stream->sourceHash;
+    header.optionsHash = EnvStreamKey(stream, asset, cachePath, sizeof(cachePath));
+    header.decodeTime = stream->decodeTime;
+
+    SaveEnvCache(cachePath, header, data);
+}
+
+static void EnvStreamBakeIrradiance(EnvAssetsStream *stream)
+{
+    double startTime = GetTime();
+    EnvStreamItem item = { 0 };
+    item.asset = ENV_ASSET_IRRADIANCE;
+    item.irradiance = GenEnvSH9(stream->panorama);
+
+    EnvCacheHeader header = { 0 };
+    header.width = 9;
+    header.height = 1;
+    header.mipmaps = 1;
+    header.buildTime = (float)(GetTime() - startTime);
+    header.dataSize = sizeof(EnvSH9);
+    stream->buildTime += header.buildTime;
+
+    EnvStreamSave(stream, ENV_ASSET_IRRADIANCE, header, &item.irradiance);
+    EnvStreamPush(stream, item);
+}
+
+static void EnvStreamBakeCubemap(EnvAssetsStream *stream, int asset)
+{
+    double startTime = GetTime();
+    EnvStreamItem item = { 0 };
+    item.asset = asset;
+    item.cubemap = (asset == ENV_ASSET_PREFILTER)?
+        GenEnvCubemapPrefilteredEx(stream->panorama, ENV_PREFILTER_FACE_SIZE, ENV_PREFILTER_ROUGHNESS_LEVELS, ENV_PREFILTER_SAMPLE_COUNT, ENV_ASSETS_FORMAT, &stream->cancel) :
+        GenEnvCubemapFromEquirectEx(stream->panorama, stream->panorama.width/4, ENV_ASSETS_FORMAT, &stream->cancel);
+
+    // Cancelled halfway, nothing to cache or upload
+    if (item.cubemap.data == NULL) return;
+
+    EnvCacheHeader header = { 0 };
+    header.width = item.cubemap.size;
+    header.height = item.cubemap.size;
+    header.mipmaps = item.cubemap.mipmaps;
+    header.format = item.cubemap.format;
+    header.buildTime = (float)(GetTime() - startTime);
+    header.dataSize = GetEnvCubemapOffset(item.cubemap.size, item.cubemap.format, item.cubemap.mipmaps, 0);
+    stream->buildTime += header.buildTime;
+
+    EnvStreamSave(stream, asset, header, item.cubemap.data);
+    EnvStreamPush(stream, item);
+}
+
+// Small cube from the panorama, pushed on the coarse levels of the missing chains while they bake
+static void EnvStreamPushPreviews(EnvAssetsStream *stream, int missing)
+{
+    EnvCubemap preview = GenEnvCubemapFromEquirect(stream->panorama, ENV_STREAM_PREVIEW_SIZE, ENV_ASSETS_FORMAT);
+    int previewBytes = GetEnvCubemapOffset(preview.size, preview.format, preview.mipmaps, 0);
+
+    // Final face sizes, same rounding as the bakers
+    int skySize = 1;
+    while (skySize*2 <= stream->panorama.width/4) skySize *= 2;
+    int prefilterSize = 1;
+    while ((prefilterSize*2 <= ENV_PREFILTER_FACE_SIZE) && (prefilterSize*2*4 <= stream->panorama.width)) prefilterSize *= 2;
+
+    for (int asset = ENV_ASSET_SKYBOX; asset <= ENV_ASSET_PREFILTER; asset *= 2)
+    {
+        int size = (asset == ENV_ASSET_SKYBOX)? skySize : prefilterSize;
+        if (!(missing & asset) || (asset == ENV_ASSET_IRRADIANCE) || (preview.size > size)) continue;
+
+        EnvStreamItem item = { 0 };
+        item.asset = asset;
+        item.cubemap = preview;
+        item.cubemap.data = (unsigned char *)RL_MALLOC(previewBytes);
+        memcpy(item.cubemap.data, preview.data, previewBytes);
+        for (int s = preview.size; s < size; s *= 2) item.firstLevel++;
+
+        EnvStreamPush(stream, item);
+    }
+
+    UnloadEnvCubemap(preview);
+}
+
+static void EnvStreamLoad(EnvAssetsStream *stream)
+{
+    double startTime = GetTime();
+    int missing = 0;
+
+    stream->sourceHash = GetFileHash(stream->fileName);
+
+    if (stream->sourceHash == 0) TraceLog(LOG_WARNING, "ENV: [%s] Failed to read environment panorama", stream->fileName);
+    else
+    {
+        // Irradiance first, it is the smallest and the whole lit surface depends on it
+        const int order[3] = { ENV_ASSET_IRRADIANCE, ENV_ASSET_SKYBOX, ENV_ASSET_PREFILTER };
+        for (int i = 0; i < 3; i++)
+        {
+            if ((stream->flags & order[i]) && !EnvStreamMapAsset(stream, order[i])) missing |= order[i];
+        }
+
+        if ((missing != 0) && EnvStreamDecode(stream))
+        {
+            // Cheapest first, so the first frames already have the right ambient and a blurry sky
+            if (missing & ENV_ASSET_IRRADIANCE) EnvStreamBakeIrradiance(stream);
+            if (missing & (ENV_ASSET_SKYBOX | ENV_ASSET_PREFILTER)) EnvStreamPushPreviews(stream, missing);
+            if ((missing & ENV_ASSET_SKYBOX) && !EnvStreamCancelled(stream)) EnvStreamBakeCubemap(stream, ENV_ASSET_SKYBOX);
+            if ((missing & ENV_ASSET_PREFILTER) && !EnvStreamCancelled(stream)) EnvStreamBakeCubemap(stream, ENV_ASSET_PREFILTER);
+        }
+
+        for (int asset = ENV_ASSET_SKYBOX; asset <= ENV_ASSET_PREFILTER; asset *= 2) if (missing & asset) stream->misses++;
+
+        float loadTime = (float)(GetTime() - startTime);
+
+        if (EnvStreamCancelled(stream)) TraceLog(LOG_INFO, "ENV: [%s] Load cancelled after %.2f ms", stream->fileName, loadTime*1000.0f);
+        else if (stream->misses == 0)
+        {
+            float coldTime = stream->cachedDecodeTime + stream->buildTime;
+            TraceLog(LOG_INFO, "ENV: [%s] Warm start in %.2f ms from mapped caches (cold start: %.2f ms, %.1fx)", stream->fileName,
+                loadTime*1000.0f, coldTime*1000.0f, coldTime/((loadTime > 0.0f)? loadTime : 1e-6f));
+        }
+        else
+        {
+            TraceLog(LOG_INFO, "ENV: [%s] Cold start in %.2f ms (decode %.2f ms, %i assets baked), caches written for the next start", stream->fileName,
+                loadTime*1000.0f, stream->decodeTime*1000.0f, stream->misses);
+        }
+    }
+
+    UnloadImage(stream->panorama);
+    stream->panorama = (Image){ 0 };
+
+    __atomic_store_n(&stream->finished, 1, __ATOMIC_RELEASE);
+}
+
+static void *EnvStreamWorker(void *arg)
+{
+    EnvStreamLoad((EnvAssetsStream *)arg);
+
+    return NULL;
+}
+
+//----------------------------------------------------------------------------------
+// Render thread side
+//----------------------------------------------------------------------------------
+
+static void EnvStreamRelease(EnvStreamItem *item)
+{
+    if (item->cache.mapping != NULL) UnmapEnvCache(&item->cache);
+    else UnloadEnvCubemap(item->cubemap);
+}
+
+static TextureCubemap LoadEnvPlaceholder(void)
+{
+    unsigned char grey[ENV_CUBEMAP_FACE_COUNT*3];
+    memset(grey, ENV_STREAM_PLACEHOLDER, sizeof(grey));
+
+    EnvCubemap placeholder = { 1, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8, grey };
+
+    return LoadTextureFromEnvCubemap(placeholder);
+}
+
+// Upload queued levels until the budget is spent, returns the ENV_ASSET_* flags that changed
+static int EnvStreamDrain(EnvAssets *assets, int budget)
+{
+    EnvAssetsStream *stream = assets->stream;
+    int changed = 0;
+    int uploaded = 0;
+
+    while (stream->head != __atomic_load_n(&stream->tail, __ATOMIC_ACQUIRE))
+    {
+        EnvStreamItem *item = &stream->items[stream->head%ENV_STREAM_QUEUE_SIZE];
+
+        if (item->asset == ENV_ASSET_IRRADIANCE)
+        {
+            assets->irradiance = item->irradiance;
+            changed |= ENV_ASSET_IRRADIANCE;
+        }
+        else
+        {
+            int slot = (item->asset == ENV_ASSET_SKYBOX)? 0 : 1;
+            TextureCubemap *texture = (slot == 0)? &assets->skybox : &assets->prefilter;
+            EnvCubemap chain = item->cubemap;
+            int maxLevel = item->firstLevel + chain.mipmaps - 1;
+
+            if (stream->nextMip < 0) stream->nextMip = chain.mipmaps - 1;
+
+            // Coarse to fine, every frame samples a complete chain that only gets sharper
+            while (stream->nextMip >= 0)
+            {
+                int mip = stream->nextMip;
+                int bytes = GetEnvCubemapOffset(chain.size, chain.format, mip + 1, 0) - GetEnvCubemapOffset(chain.size, chain.format, mip, 0);
+                if ((uploaded > 0) && (uploaded + bytes > budget)) return changed;
+
+                int level = item->firstLevel + mip;
+                UpdateTextureCubemapLevel(*texture, chain, mip, level);
+
+                // Levels below the current base are already complete (previews cover the same coarse levels)
+                if ((stream->baseLevel[slot] < 0) || (level < stream->baseLevel[slot])) stream->baseLevel[slot] = level;
+                SetTextureCubemapLevels(*texture, stream->baseLevel[slot], maxLevel);
+
+                int size = chain.size >> mip;
+                texture->width = (size > 1)? size : 1;
+                texture->height = texture->width;
+                texture->mipmaps = maxLevel - stream->baseLevel[slot] + 1;
+                texture->format = chain.format;
+
+                uploaded += bytes;
+                stream->nextMip--;
+                changed |= item->asset;
+            }
+        }
+
+        EnvStreamRelease(item);
+        stream->nextMip = -1;
+        __atomic_store_n(&stream->head, stream->head + 1, __ATOMIC_RELEASE);
+    }
+
+    return changed;
+}
+
+static void EnvStreamFree(EnvAssets *assets)
+{
+    EnvAssetsStream *stream = assets->stream;
+
+    if (stream->threaded) pthread_join(stream->thread, NULL);
+
+    // Items the render thread never got to
+    while (stream->head != stream->tail)
+    {
+        EnvStreamRelease(&stream->items[stream->head%ENV_STREAM_QUEUE_SIZE]);
+        stream->head++;
+    }
+
+    RL_FREE(stream);
+    assets->stream = NULL;
+}
+
+static EnvAssets EnvStreamStart(const char *fileName, int flags)
+{
+    EnvAssets assets = { 0 };
+
+    EnvAssetsStream *stream = (EnvAssetsStream *)RL_CALLOC(1, sizeof(EnvAssetsStream));
+    strncpy(stream->fileName, fileName, sizeof(stream->fileName) - 1);
+    stream->flags = flags;
+    stream->startTime = GetTime();
+    stream->nextMip = -1;
+    stream->baseLevel[0] = -1;
+    stream->baseLevel[1] = -1;
+
+    // Grey until the real data lands, uniform radiance L gives E(n) = PI*L
+    if (flags & ENV_ASSET_SKYBOX) assets.skybox = LoadEnvPlaceholder();
+    if (flags & ENV_ASSET_PREFILTER) assets.prefilter = LoadEnvPlaceholder();
+    if (flags & ENV_ASSET_IRRADIANCE)
+    {
+        float radiance = SRGBToLinear(ENV_STREAM_PLACEHOLDER);
+        assets.irradiance.coefficients[0] = (Vector3){ PI*radiance, PI*radiance, PI*radiance };
+    }
+
+    assets.stream = stream;
+
+    return assets;
+}
+
+int UpdateEnvAssets(EnvAssets *assets)
+{
+    EnvAssetsStream *stream = assets->stream;
+    if (stream == NULL) return 0;
+
+    if (stream->firstUpdateTime == 0.0) stream->firstUpdateTime = GetTime();
+
+    bool finished = (__atomic_load_n(&stream->finished, __ATOMIC_ACQUIRE) != 0);
+    int changed = EnvStreamDrain(assets, ENV_STREAM_UPLOAD_BUDGET);
+
+    // Everything pushed before finished was set is visible now, so an empty queue means done
+    if (finished && (stream->head == __atomic_load_n(&stream->tail, __ATOMIC_ACQUIRE)))
+    {
+        assets->ready = true;
+        assets->warm = (stream->misses == 0);
+        assets->loadTime = (float)(GetTime() - stream->startTime);
+        assets->coldTime = assets->warm? stream->cachedDecodeTime + stream->buildTime : assets->loadTime;
+
+        TraceLog(LOG_INFO, "ENV: [%s] Full quality after %.2f ms, first frame after %.2f ms", stream->fileName,
+            assets->loadTime*1000.0f, (stream->firstUpdateTime - stream->startTime)*1000.0);
+
+        EnvStreamFree(assets);
+    }
+
+    return changed;
+}
+
+EnvAssets LoadEnvAssetsAsync(const char *fileName, int flags)
+{
+    EnvAssets assets = EnvStreamStart(fileName, flags);
+
+    if (pthread_create(&assets.stream->thread, NULL, EnvStreamWorker, assets.stream) == 0) assets.stream->threaded = true;
+    else EnvStreamLoad(assets.stream);      // No thread, load right here, the first update uploads it all
+
+    return assets;
+}
+
+EnvAssets LoadEnvAssets(const char *fileName, int flags)
+{
+    EnvAssets assets = EnvStreamStart(fileName, flags);
+
+    // Same path without the thread, then upload everything at once
+    EnvStreamLoad(assets.stream);
+    assets.stream->firstUpdateTime = GetTime();
+    EnvStreamDrain(&assets, 0x7fffffff);
+    UpdateEnvAssets(&assets);
+
+    return assets;
+}
+
+void UnloadEnvAssets(EnvAssets assets)
+{
+    if (assets.stream != NULL)
+    {
+        // A running bake stops within a face or a row of the GGX levels, the remaining ones are skipped
+        __atomic_store_n(&assets.stream->cancel, 1, __ATOMIC_RELEASE);
+        EnvStreamFree(&assets);
+    }
+
+    if (assets.skybox.id > 0) UnloadTexture(assets.skybox);
+    if (assets.prefilter.id > 0) UnloadTexture(assets.prefilter);
+}
+
+#endif // ENV_ASSETS_IMPLEMENTATION
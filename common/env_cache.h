@@ -0,0 +1,280 @@
+/**********************************************************************************************
+*
+*   env_cache - Versioned, memory mapped cache files for the baked environment data
+*
+*   Single header module, define ENV_CACHE_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   A cache file is one header followed by the raw payload (e.g. a cube chain exactly as
+*   glTexImage2D consumes it), starting at an ENV_CACHE_ALIGNMENT boundary:
+*
+*       EnvCacheHeader | padding | payload
+*
+*   Files are validated against a key, not against timestamps:
+*
+*       sourceHash  -> FNV-1a of the source file bytes, so copies and touched files still hit
+*       optionsHash -> FNV-1a of the processing options (sizes, sample counts, format, version)
+*
+*   A hit maps the file read-only and hands out a pointer into the mapping, so the payload
+*   goes from the page cache straight to the driver without any intermediate copy
+*
+*   A save never rewrites a file in place: it writes <path>.<pid>.tmp and renames it over the
+*   cache (rename() on POSIX, MoveFileEx() on Windows), so another instance still streaming
+*   from a mapping of the old file keeps reading the old contents, never a truncated one.
+*   On Windows the replace fails while the old file is mapped and the old file stays
+*
+**********************************************************************************************/
+
+#ifndef ENV_CACHE_H
+#define ENV_CACHE_H
+
+#include <stddef.h>
+#include "raylib.h"
+
+#define ENV_CACHE_MAGIC         0x43564E45      // "ENVC"
+#define ENV_CACHE_VERSION       1
+#define ENV_CACHE_ALIGNMENT     64              // Payload offset alignment, keeps the mapped data SIMD and DMA friendly
+
+#define ENV_HASH_SEED           0xcbf29ce484222325ULL     // FNV-1a 64 offset basis
+
+// Cache file header
+typedef struct EnvCacheHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned long long sourceHash;
+    unsigned long long optionsHash;
+    int width;                  // Payload description, meaning depends on the payload (cube face size, coefficient count...)
+    int height;
+    int mipmaps;
+    int format;                 // PixelFormat of texel payloads, 0 for plain data
+    float buildTime;            // Seconds the payload took to build, lets warm starts report the cold cost
+    float decodeTime;           // Seconds spent decoding the source for it
+    long long dataOffset;       // From the start of the file
+    long long dataSize;
+} EnvCacheHeader;
+
+// Mapped cache file, data points into the mapping
+typedef struct EnvCacheFile {
+    EnvCacheHeader header;
+    const unsigned char *data;
+    void *mapping;              // Start of the view
+    size_t mappingSize;
+} EnvCacheFile;
+
+unsigned long long HashMemory(const void *data, size_t size, unsigned long long seed);     // FNV-1a 64, chain calls through seed
+unsigned long long GetFileHash(const char *fileName);                                     // Hash of the file bytes, 0 if it can not be read
+void GetEnvCachePath(const char *fileName, const char *tag, char *path, int size);        // <dir>/<name>.<tag>.cache next to the source, thread safe
+bool MapEnvCache(const char *fileName, unsigned long long sourceHash, unsigned long long optionsHash, EnvCacheFile *file);  // Map and validate, false on miss
+void UnmapEnvCache(EnvCacheFile *file);
+bool SaveEnvCache(const char *fileName, EnvCacheHeader header, const void *data);         // Write header (magic, version, offset filled in) + payload
+
+#endif // ENV_CACHE_H
+
+#if defined(ENV_CACHE_IMPLEMENTATION) && !defined(ENV_CACHE_IMPLEMENTED)
+#define ENV_CACHE_IMPLEMENTED
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+// NOTE: Declared here instead of including windows.h, which clashes with raylib.h (raylib does the same for its few calls)
+__declspec(dllimport) void *__stdcall CreateFileA(const char *fileName, unsigned long access, unsigned long shareMode, void *security, unsigned long creation, unsigned long flags, void *templateFile);
+__declspec(dllimport) void *__stdcall CreateFileMappingA(void *file, void *security, unsigned long protect, unsigned long sizeHigh, unsigned long sizeLow, const char *name);
+__declspec(dllimport) void *__stdcall MapViewOfFile(void *mapping, unsigned long access, unsigned long offsetHigh, unsigned long offsetLow, size_t size);
+__declspec(dllimport) int __stdcall UnmapViewOfFile(const void *address);
+__declspec(dllimport) int __stdcall GetFileSizeEx(void *file, long long *size);
+__declspec(dllimport) int __stdcall CloseHandle(void *handle);
+__declspec(dllimport) int __stdcall MoveFileExA(const char *existingFileName, const char *newFileName, unsigned long flags);
+__declspec(dllimport) unsigned long __stdcall GetCurrentProcessId(void);
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Map a whole file read-only, returns NULL for missing or empty files
+static void *EnvMapFile(const char *fileName, size_t *size)
+{
+    void *view = NULL;
+    *size = 0;
+
+#if defined(_WIN32)
+    void *file = CreateFileA(fileName, 0x80000000ul, 0x00000001ul, NULL, 3, 0x80, NULL);      // GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL
+    if (file == (void *)(long long)-1) return NULL;                                             // INVALID_HANDLE_VALUE
+
+    long long length = 0;
+    if (GetFileSizeEx(file, &length) && (length > 0))
+    {
+        void *mapping = CreateFileMappingA(file, NULL, 0x02, 0, 0, NULL);                       // PAGE_READONLY
+        if (mapping != NULL)
+        {
+            view = MapViewOfFile(mapping, 0x0004, 0, 0, 0);                                     // FILE_MAP_READ
+            CloseHandle(mapping);           // The view keeps the mapping alive
+        }
+    }
+
+    CloseHandle(file);
+    if (view != NULL) *size = (size_t)length;
+#else
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if ((fstat(fd, &info) == 0) && (info.st_size > 0))
+    {
+        view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) view = NULL;
+        else *size = (size_t)info.st_size;
+    }
+
+    close(fd);          // The mapping keeps the file alive
+#endif
+
+    return view;
+}
+
+static void EnvUnmapFile(void *view, size_t size)
+{
+    if (view == NULL) return;
+
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(view);
+#else
+    munmap(view, size);
+#endif
+}
+
+unsigned long long HashMemory(const void *data, size_t size, unsigned long long seed)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    unsigned long long hash = seed;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;       // FNV-1a 64 prime
+    }
+
+    return hash;
+}
+
+unsigned long long GetFileHash(const char *fileName)
+{
+    size_t size = 0;
+    void *view = EnvMapFile(fileName, &size);
+    if (view == NULL) return 0;
+
+    unsigned long long hash = HashMemory(view, size, ENV_HASH_SEED);
+    EnvUnmapFile(view, size);
+
+    return hash;
+}
+
+void GetEnvCachePath(const char *fileName, const char *tag, char *path, int size)
+{
+    // Swap the extension for the tag, no raylib path helpers (static buffers) so loader threads can call it
+    int length = (int)strlen(fileName);
+    const char *dot = strrchr(fileName, '.');
+    if ((dot != NULL) && (strchr(dot, '/') == NULL) && (strchr(dot, '\\') == NULL)) length = (int)(dot - fileName);
+
+    snprintf(path, size, "%.*s.%s.cache", length, fileName, tag);
+}
+
+static long long GetEnvCacheDataOffset(void)
+{
+    return ((long long)sizeof(EnvCacheHeader) + ENV_CACHE_ALIGNMENT - 1)/ENV_CACHE_ALIGNMENT*ENV_CACHE_ALIGNMENT;
+}
+
+bool MapEnvCache(const char *fileName, unsigned long long sourceHash, unsigned long long optionsHash, EnvCacheFile *file)
+{
+    memset(file, 0, sizeof(EnvCacheFile));
+
+    size_t size = 0;
+    void *view = EnvMapFile(fileName, &size);
+    if (view == NULL) return false;
+
+    EnvCacheHeader header = { 0 };
+    if (size >= sizeof(header)) memcpy(&header, view, sizeof(header));
+
+    // A short file (interrupted write) fails the size check like any other mismatch
+    if ((header.magic != ENV_CACHE_MAGIC) || (header.version != ENV_CACHE_VERSION) ||
+        (header.sourceHash != sourceHash) || (header.optionsHash != optionsHash) ||
+        (header.dataOffset != GetEnvCacheDataOffset()) || (header.dataSize <= 0) ||
+        ((long long)size != header.dataOffset + header.dataSize))
+    {
+        EnvUnmapFile(view, size);
+        return false;
+    }
+
+    file->header = header;
+    file->data = (const unsigned char *)view + header.dataOffset;
+    file->mapping = view;
+    file->mappingSize = size;
+
+    return true;
+}
+
+void UnmapEnvCache(EnvCacheFile *file)
+{
+    EnvUnmapFile(file->mapping, file->mappingSize);
+    memset(file, 0, sizeof(EnvCacheFile));
+}
+
+bool SaveEnvCache(const char *fileName, EnvCacheHeader header, const void *data)
+{
+    header.magic = ENV_CACHE_MAGIC;
+    header.version = ENV_CACHE_VERSION;
+    header.dataOffset = GetEnvCacheDataOffset();
+
+    // Written aside and renamed over the cache, one temporary file per process so two instances
+    // saving the same cache never write into each other's
+    char tempName[1024] = { 0 };
+#if defined(_WIN32)
+    snprintf(tempName, sizeof(tempName), "%s.%lu.tmp", fileName, GetCurrentProcessId());
+#else
+    snprintf(tempName, sizeof(tempName), "%s.%ld.tmp", fileName, (long)getpid());
+#endif
+
+    FILE *file = fopen(tempName, "wb");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "CACHE: [%s] Failed to open file for writing", tempName);
+        return false;
+    }
+
+    // Written straight from the caller buffer, no staging copy of the payload
+    unsigned char padding[ENV_CACHE_ALIGNMENT] = { 0 };
+    size_t paddingSize = (size_t)(header.dataOffset - (long long)sizeof(header));
+    bool success = (fwrite(&header, sizeof(header), 1, file) == 1) &&
+                   (fwrite(padding, 1, paddingSize, file) == paddingSize) &&
+                   (fwrite(data, (size_t)header.dataSize, 1, file) == 1);
+
+    if (fclose(file) != 0) success = false;
+
+    if (!success)
+    {
+        // Never leave a truncated file behind, the cache itself was not touched
+        remove(tempName);
+        TraceLog(LOG_WARNING, "CACHE: [%s] Failed to write cache file", fileName);
+        return false;
+    }
+
+    // Readers mapping the old file keep its pages, the next map sees the new one
+#if defined(_WIN32)
+    success = MoveFileExA(tempName, fileName, 0x1);        // MOVEFILE_REPLACE_EXISTING
+#else
+    success = (rename(tempName, fileName) == 0);
+#endif
+
+    if (!success)
+    {
+        remove(tempName);
+        TraceLog(LOG_WARNING, "CACHE: [%s] Failed to replace cache file, it is in use", fileName);
+    }
+
+    return success;
+}
+
+#endif // ENV_CACHE_IMPLEMENTATION
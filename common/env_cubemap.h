@@ -0,0 +1,349 @@
+/**********************************************************************************************
+*
+*   env_cubemap - Load time equirect to cubemap conversion
+*
+*   Single header module, define ENV_CUBEMAP_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   The panorama is resampled once on the CPU (rows of every face spread over all cores) so
+*   the skybox and reflection shaders replace atan/asin per fragment with one cube fetch:
+*
+*       texture(environmentMap, dir)
+*
+*   Faces follow the GL orientation table (+X, -X, +Y, -Y, +Z, -Z, row 0 at t = -1), so a
+*   world space direction is the lookup vector, same convention as EquirectToDirection()
+*
+*   Mip levels are reduced 2x2 inside each face in linear light. With power of two faces no
+*   child texel ever straddles an edge, and GL_TEXTURE_CUBE_MAP_SEAMLESS filters across the
+*   edges at sample time, so there is no u-seam and no pole pinching at any lod
+*
+*   Texels are stored with the sRGB curve applied, which is what the shaders expect, either as
+*   RGB8 or as RGB16F half floats (same values without the 8 bit steps, no banding in the
+*   smooth gradients of the blurred levels)
+*
+**********************************************************************************************/
+
+#ifndef ENV_CUBEMAP_H
+#define ENV_CUBEMAP_H
+
+#include "raylib.h"
+
+#define ENV_CUBEMAP_FACE_COUNT      6
+#define ENV_CUBEMAP_SUPERSAMPLE     2       // Panorama samples per texel axis on the top level (the poles are dense in the panorama)
+
+// Cubemap with its full mip chain in CPU memory
+typedef struct EnvCubemap {
+    int size;               // Face width and height of mip 0
+    int mipmaps;
+    int format;             // PIXELFORMAT_UNCOMPRESSED_R8G8B8 or PIXELFORMAT_UNCOMPRESSED_R16G16B16 (half floats)
+    unsigned char *data;    // sRGB encoded, for every mip the 6 faces back to back
+} EnvCubemap;
+
+Vector3 CubemapToDirection(int face, float s, float t);                    // Face coordinates in [-1, 1] to unit direction
+int GetEnvCubemapOffset(int size, int format, int mip, int face);                     // Byte offset of one face of one mip inside EnvCubemap.data
+void EncodeEnvTexels(const float *linear, void *dst, int count, int format);          // Linear RGB floats to stored texels (sRGB curve applied)
+EnvCubemap GenEnvCubemapFromEquirect(Image panorama, int faceSize, int format);       // Resample panorama, face size rounded down to a power of two
+EnvCubemap GenEnvCubemapFromEquirectEx(Image panorama, int faceSize, int format, const int *cancel);  // Same, gives up (empty result) once *cancel is set
+void UnloadEnvCubemap(EnvCubemap cubemap);
+TextureCubemap LoadTextureFromEnvCubemap(EnvCubemap cubemap);                         // Upload every mip, trilinear and seamless filtering
+void UpdateTextureCubemapLevel(TextureCubemap texture, EnvCubemap cubemap, int mip, int level);    // Upload one mip of the chain (6 faces) as texture level
+void SetTextureCubemapLevels(TextureCubemap texture, int baseLevel, int maxLevel);               // Restrict sampling to the levels uploaded so far
+TextureCubemap LoadTextureCubemapFromPanorama(Image panorama);                        // Convert and upload as RGB8, face size matches the panorama equator (width/4)
+
+#endif // ENV_CUBEMAP_H
+
+#if defined(ENV_CUBEMAP_IMPLEMENTATION) && !defined(ENV_CUBEMAP_IMPLEMENTED)
+#define ENV_CUBEMAP_IMPLEMENTED
+
+#include <math.h>
+
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, needed to upload cube mip levels
+
+#define ENV_MAP_IMPLEMENTATION
+#include "env_map.h"
+
+Vector3 CubemapToDirection(int face, float s, float t)
+{
+    Vector3 dir = { 0 };
+
+    switch (face)
+    {
+        case 0: dir = (Vector3){ 1.0f, -t, -s }; break;     // +X
+        case 1: dir = (Vector3){ -1.0f, -t, s }; break;     // -X
+        case 2: dir = (Vector3){ s, 1.0f, t }; break;       // +Y
+        case 3: dir = (Vector3){ s, -1.0f, -t }; break;     // -Y
+        case 4: dir = (Vector3){ s, -t, 1.0f }; break;      // +Z
+        default: dir = (Vector3){ -s, -t, -1.0f }; break;   // -Z
+    }
+
+    float invLength = 1.0f/sqrtf(dir.x*dir.x + dir.y*dir.y + dir.z*dir.z);
+
+    return (Vector3){ dir.x*invLength, dir.y*invLength, dir.z*invLength };
+}
+
+int GetEnvCubemapOffset(int size, int format, int mip, int face)
+{
+    int texelSize = (format == PIXELFORMAT_UNCOMPRESSED_R16G16B16)? 3*(int)sizeof(unsigned short) : 3;
+    int offset = 0;
+
+    for (int i = 0; i < mip; i++)
+    {
+        offset += ENV_CUBEMAP_FACE_COUNT*size*size*texelSize;
+        size = (size > 1)? size/2 : 1;
+    }
+
+    return offset + face*size*size*texelSize;
+}
+
+void EncodeEnvTexels(const float *linear, void *dst, int count, int format)
+{
+    if (format == PIXELFORMAT_UNCOMPRESSED_R16G16B16)
+    {
+        unsigned short *halfs = (unsigned short *)dst;
+        for (int i = 0; i < count*3; i++) halfs[i] = FloatToHalf(LinearToSRGBFloat(linear[i]));
+    }
+    else
+    {
+        unsigned char *bytes = (unsigned char *)dst;
+        for (int i = 0; i < count*3; i++) bytes[i] = LinearToSRGB(linear[i]);
+    }
+}
+
+typedef struct EnvCubemapJob {
+    const unsigned char *pixels;    // Panorama, RGB8 sRGB
+    int width;
+    int height;
+    EnvMap face;                    // Linear float face being filled
+    int faceIndex;
+} EnvCubemapJob;
+
+// Bilinear panorama fetch in linear light, wraps horizontally and clamps at the poles
+static void EnvSamplePanorama(const EnvCubemapJob *job, Vector3 dir, float *rgb)
+{
+    Vector2 uv = DirectionToEquirect(dir);
+
+    float fx = uv.x*job->width - 0.5f;
+    float fy = uv.y*job->height - 0.5f;
+    int x0 = (int)floorf(fx);
+    int y0 = (int)floorf(fy);
+    float tx = fx - x0;
+    float ty = fy - y0;
+
+    x0 %= job->width;
+    if (x0 < 0) x0 += job->width;
+    int x1 = (x0 + 1 == job->width)? 0 : x0 + 1;
+    int y1 = y0 + 1;
+    if (y0 < 0) y0 = 0;
+    if (y1 > job->height - 1) y1 = job->height - 1;
+    if (y0 > job->height - 1) y0 = job->height - 1;
+
+    const unsigned char *r0 = job->pixels + (size_t)y0*job->width*3;
+    const unsigned char *r1 = job->pixels + (size_t)y1*job->width*3;
+
+    for (int c = 0; c < 3; c++)
+    {
+        float top = SRGBToLinear(r0[x0*3 + c]) + (SRGBToLinear(r0[x1*3 + c]) - SRGBToLinear(r0[x0*3 + c]))*tx;
+        float bottom = SRGBToLinear(r1[x0*3 + c]) + (SRGBToLinear(r1[x1*3 + c]) - SRGBToLinear(r1[x0*3 + c]))*tx;
+        rgb[c] = top + (bottom - top)*ty;
+    }
+}
+
+// Set by another thread to stop a bake, NULL never cancels
+static bool EnvBakeCancelled(const int *cancel)
+{
+    return (cancel != NULL) && (__atomic_load_n(cancel, __ATOMIC_ACQUIRE) != 0);
+}
+
+static void EnvCubemapRow(int y, void *userData)
+{
+    EnvCubemapJob *job = (EnvCubemapJob *)userData;
+    const int size = job->face.width;
+    const float norm = 1.0f/(ENV_CUBEMAP_SUPERSAMPLE*ENV_CUBEMAP_SUPERSAMPLE);
+
+    for (int x = 0; x < size; x++)
+    {
+        float sum[3] = { 0 };
+
+        // Regular sub-texel grid, averaged in linear light
+        for (int j = 0; j < ENV_CUBEMAP_SUPERSAMPLE; j++)
+        {
+            for (int i = 0; i < ENV_CUBEMAP_SUPERSAMPLE; i++)
+            {
+                float s = 2.0f*(x + (i + 0.5f)/ENV_CUBEMAP_SUPERSAMPLE)/size - 1.0f;
+                float t = 2.0f*(y + (j + 0.5f)/ENV_CUBEMAP_SUPERSAMPLE)/size - 1.0f;
+
+                float rgb[3];
+                EnvSamplePanorama(job, CubemapToDirection(job->faceIndex, s, t), rgb);
+                for (int c = 0; c < 3; c++) sum[c] += rgb[c];
+            }
+        }
+
+        float *out = job->face.data + ((size_t)y*size + x)*3;
+        for (int c = 0; c < 3; c++) out[c] = sum[c]*norm;
+    }
+}
+
+typedef struct EnvEncodeJob {
+    const float *src;
+    unsigned char *dst;
+    int width;
+    int format;
+} EnvEncodeJob;
+
+static void EnvEncodeRow(int y, void *userData)
+{
+    EnvEncodeJob *job = (EnvEncodeJob *)userData;
+    int texelSize = (job->format == PIXELFORMAT_UNCOMPRESSED_R16G16B16)? 3*(int)sizeof(unsigned short) : 3;
+
+    EncodeEnvTexels(job->src + (size_t)y*job->width*3, job->dst + (size_t)y*job->width*texelSize, job->width, job->format);
+}
+
+EnvCubemap GenEnvCubemapFromEquirect(Image panorama, int faceSize, int format)
+{
+    return GenEnvCubemapFromEquirectEx(panorama, faceSize, format, NULL);
+}
+
+EnvCubemap GenEnvCubemapFromEquirectEx(Image panorama, int faceSize, int format, const int *cancel)
+{
+    EnvCubemap cubemap = { 0 };
+    double startTime = GetTime();
+
+    int size = 1;
+    while (size*2 <= faceSize) size *= 2;
+
+    Image rgb = ImageCopy(panorama);
+    if (rgb.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8) ImageFormat(&rgb, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+
+    cubemap.size = size;
+    cubemap.mipmaps = 1;
+    for (int s = size; s > 1; s /= 2) cubemap.mipmaps++;
+    cubemap.format = (format == PIXELFORMAT_UNCOMPRESSED_R16G16B16)? format : PIXELFORMAT_UNCOMPRESSED_R8G8B8;
+    cubemap.data = (unsigned char *)RL_MALLOC(GetEnvCubemapOffset(size, cubemap.format, cubemap.mipmaps, 0));
+
+    // One face at a time keeps the float working set at a single face chain
+    EnvMap levels[2] = { 0 };
+    levels[0].data = (float *)RL_MALLOC((size_t)size*size*3*sizeof(float));
+    levels[1].data = (float *)RL_MALLOC((size_t)size*size*3*sizeof(float));
+
+    SRGBToLinear(0);    // Build the table before the workers race on it
+
+    // A cancel is seen between faces, one face of the largest panorama is a few milliseconds
+    bool cancelled = false;
+
+    for (int face = 0; (face < ENV_CUBEMAP_FACE_COUNT) && !(cancelled = EnvBakeCancelled(cancel)); face++)
+    {
+        EnvCubemapJob job = { (const unsigned char *)rgb.data, rgb.width, rgb.height, { size, size, levels[0].data }, face };
+        ParallelFor(size, EnvCubemapRow, &job);
+
+        int current = 0;
+
+        for (int mip = 0, s = size; mip < cubemap.mipmaps; mip++)
+        {
+            EnvMap src = { s, s, levels[current].data };
+
+            EnvEncodeJob encode = { src.data, cubemap.data + GetEnvCubemapOffset(size, cubemap.format, mip, face), s, cubemap.format };
+            ParallelFor(s, EnvEncodeRow, &encode);
+
+            if (mip + 1 < cubemap.mipmaps)
+            {
+                // Plain 2x2 box inside the face, never reads across an edge
+                EnvMap dst = { s/2, s/2, levels[1 - current].data };
+                EnvReduceJob reduce = { src, dst };
+                ParallelFor(dst.height, EnvReduceRow, &reduce);
+
+                current = 1 - current;
+                s /= 2;
+            }
+        }
+    }
+
+    RL_FREE(levels[0].data);
+    RL_FREE(levels[1].data);
+    UnloadImage(rgb);
+
+    if (cancelled)
+    {
+        UnloadEnvCubemap(cubemap);
+        TraceLog(LOG_INFO, "CUBEMAP: Conversion cancelled after %.2f ms", (GetTime() - startTime)*1000.0);
+        return (EnvCubemap){ 0 };
+    }
+
+    TraceLog(LOG_INFO, "CUBEMAP: Converted %ix%i panorama to %ix%i faces (%i mipmaps) in %.2f ms on %i threads", panorama.width, panorama.height, size, size, cubemap.mipmaps, (GetTime() - startTime)*1000.0, GetWorkerCount());
+
+    return cubemap;
+}
+
+void UnloadEnvCubemap(EnvCubemap cubemap)
+{
+    RL_FREE(cubemap.data);
+}
+
+TextureCubemap LoadTextureFromEnvCubemap(EnvCubemap cubemap)
+{
+    TextureCubemap texture = { 0 };
+
+    if (cubemap.data == NULL) return texture;
+
+    glGenTextures(1, &texture.id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture.id);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    // Filter across face edges (global state, core since GL 3.2)
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+    for (int mip = 0; mip < cubemap.mipmaps; mip++) UpdateTextureCubemapLevel(texture, cubemap, mip, mip);
+    SetTextureCubemapLevels(texture, 0, cubemap.mipmaps - 1);
+
+    texture.width = cubemap.size;
+    texture.height = cubemap.size;
+    texture.mipmaps = cubemap.mipmaps;
+    texture.format = (cubemap.format == PIXELFORMAT_UNCOMPRESSED_R16G16B16)? PIXELFORMAT_UNCOMPRESSED_R16G16B16 : PIXELFORMAT_UNCOMPRESSED_R8G8B8;
+
+    return texture;
+}
+
+void UpdateTextureCubemapLevel(TextureCubemap texture, EnvCubemap cubemap, int mip, int level)
+{
+    bool half = (cubemap.format == PIXELFORMAT_UNCOMPRESSED_R16G16B16);
+    int size = cubemap.size >> mip;
+    if (size < 1) size = 1;
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture.id);
+
+    // Small mips have rows that are not a multiple of 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (int face = 0; face < ENV_CUBEMAP_FACE_COUNT; face++)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, half? GL_RGB16F : GL_RGB8, size, size, 0, GL_RGB, half? GL_HALF_FLOAT : GL_UNSIGNED_BYTE,
+            cubemap.data + GetEnvCubemapOffset(cubemap.size, cubemap.format, mip, face));
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+void SetTextureCubemapLevels(TextureCubemap texture, int baseLevel, int maxLevel)
+{
+    // Levels outside [base, max] are never sampled, so stale or missing ones do not make the texture incomplete
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture.id);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, (maxLevel > baseLevel)? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, baseLevel);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, maxLevel);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+TextureCubemap LoadTextureCubemapFromPanorama(Image panorama)
+{
+    EnvCubemap cubemap = GenEnvCubemapFromEquirect(panorama, panorama.width/4, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+    TextureCubemap texture = LoadTextureFromEnvCubemap(cubemap);
+    UnloadEnvCubemap(cubemap);
+
+    return texture;
+}
+
+#endif // ENV_CUBEMAP_IMPLEMENTATION
@@ -0,0 +1,101 @@
+/**********************************************************************************************
+*
+*   env_dfg - Split-sum DFG lookup table (file format and loader)
+*
+*   Single header module, define ENV_DFG_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   The table is baked offline by tools/dfg_lut (GGX, height-correlated Smith, roughness used
+*   directly as alpha like the .fs files) and stored in resources/dfg_lut.bin:
+*
+*       x = NdotV, y = roughness, texel centers at (i + 0.5)/size
+*       r = A, g = B            -> split-sum scale and bias, E_spec(F0) = F0*A + B
+*       b = Eavg                -> cosine weighted average of A + B over the row (Kulla-Conty)
+*
+*   A + B is the single scatter directional albedo Ess, so one fetch feeds both the ambient
+*   specular term and the multiscatter energy compensation. Eavg only depends on the roughness,
+*   material_block.h reads it on the CPU (LoadBrdfDFG()) and folds it into the material constants
+*
+**********************************************************************************************/
+
+#ifndef ENV_DFG_H
+#define ENV_DFG_H
+
+#include "raylib.h"
+#include "env_map.h"               // FloatToHalf()/HalfToFloat() for the baker
+
+#define ENV_DFG_MAGIC       0x4C474644      // "DFGL"
+#define ENV_DFG_VERSION     1
+#define ENV_DFG_CHANNELS    3
+
+// File header, followed by size*size*ENV_DFG_CHANNELS half floats, row 0 is roughness 0
+typedef struct DFGLutHeader {
+    unsigned int magic;
+    unsigned int version;
+    int size;
+    int sampleCount;
+} DFGLutHeader;
+
+Texture2D LoadTextureDFG(const char *fileName);     // Load baked table as an RGB16F texture, bilinear and clamped
+
+#endif // ENV_DFG_H
+
+#if defined(ENV_DFG_IMPLEMENTATION) && !defined(ENV_DFG_IMPLEMENTED)
+#define ENV_DFG_IMPLEMENTED
+
+#include <string.h>
+
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, raylib has no RGB16F upload path
+
+#define ENV_MAP_IMPLEMENTATION
+#include "env_map.h"
+
+Texture2D LoadTextureDFG(const char *fileName)
+{
+    Texture2D texture = { 0 };
+
+    int fileSize = 0;
+    unsigned char *fileData = LoadFileData(fileName, &fileSize);
+    if (fileData == NULL) return texture;
+
+    DFGLutHeader header = { 0 };
+    if (fileSize >= (int)sizeof(header)) memcpy(&header, fileData, sizeof(header));
+
+    int dataSize = header.size*header.size*ENV_DFG_CHANNELS*(int)sizeof(unsigned short);
+
+    if ((header.magic != ENV_DFG_MAGIC) || (header.version != ENV_DFG_VERSION) || (header.size <= 0) ||
+        (fileSize != (int)sizeof(header) + dataSize))
+    {
+        TraceLog(LOG_WARNING, "DFG: [%s] Invalid or outdated LUT, rebake it with tools/dfg_lut", fileName);
+        UnloadFileData(fileData);
+        return texture;
+    }
+
+    glGenTextures(1, &texture.id);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+
+    // Rows of 3 half floats are not a multiple of 4 bytes for odd sizes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, header.size, header.size, 0, GL_RGB, GL_HALF_FLOAT, fileData + sizeof(header));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    texture.width = header.size;
+    texture.height = header.size;
+    texture.mipmaps = 1;
+    texture.format = PIXELFORMAT_UNCOMPRESSED_R16G16B16;
+
+    TraceLog(LOG_INFO, "DFG: [%s] Loaded %ix%i LUT (%i samples per texel)", fileName, header.size, header.size, header.sampleCount);
+
+    UnloadFileData(fileData);
+
+    return texture;
+}
+
+#endif // ENV_DFG_IMPLEMENTATION
@@ -0,0 +1,339 @@
+/**********************************************************************************************
+*
+*   env_map - Linear float equirect panoramas for the CPU environment bakers
+*
+*   Single header module, define ENV_MAP_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   Direction <-> UV mapping of the sky panoramas in resources/ (the shaders only see the
+*   cubemaps converted from them, see env_cubemap.h):
+*       u = atan(z, x) / (2*PI) + 0.5
+*       v = asin(-y) / PI + 0.5
+*
+*   Texels are stored as linear RGB floats (the JPEG skies are decoded from sRGB), so every
+*   filter built on top of this module averages light and not gamma-encoded values
+*
+**********************************************************************************************/
+
+#ifndef ENV_MAP_H
+#define ENV_MAP_H
+
+#include "raylib.h"
+
+#define ENV_MAP_MAX_LEVELS 16
+
+// Linear RGB float panorama
+typedef struct EnvMap {
+    int width;
+    int height;
+    float *data;            // width*height*3 floats, row 0 is the top of the sky (v = 0)
+} EnvMap;
+
+// Chain of panoramas, every level half the size of the previous one
+typedef struct EnvPyramid {
+    int levelCount;
+    EnvMap levels[ENV_MAP_MAX_LEVELS];
+} EnvPyramid;
+
+EnvMap LoadEnvMapFromImage(Image image, int maxWidth);                 // Decode sRGB image to linear floats, box-reduced until width <= maxWidth (0 = full size)
+void UnloadEnvMap(EnvMap map);
+EnvPyramid GenEnvPyramid(EnvMap base, int levelCount);                 // Build a box-filtered chain (takes ownership of base)
+void UnloadEnvPyramid(EnvPyramid pyramid);
+
+Vector3 EquirectToDirection(float u, float v);                         // Panorama UV to unit direction
+Vector2 DirectionToEquirect(Vector3 dir);                              // Unit direction to panorama UV
+void SampleEnvMap(EnvMap map, float u, float v, float *rgb);           // Bilinear fetch, wraps horizontally
+void SampleEnvPyramid(const EnvPyramid *pyramid, Vector3 dir, float lod, float *rgb);  // Trilinear fetch
+
+float SRGBToLinear(unsigned char value);
+unsigned char LinearToSRGB(float value);
+float LinearToSRGBFloat(float value);                                  // Same curve without the 8 bit quantization
+unsigned short FloatToHalf(float value);
+float HalfToFloat(unsigned short value);
+
+#endif // ENV_MAP_H
+
+#if defined(ENV_MAP_IMPLEMENTATION) && !defined(ENV_MAP_IMPLEMENTED)
+#define ENV_MAP_IMPLEMENTED
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PARALLEL_IMPLEMENTATION
+#include "parallel.h"
+
+#ifndef PI
+    #define PI 3.14159265358979323846f
+#endif
+
+static float envSRGBTable[256] = { 0 };
+static int envSRGBTableReady = 0;
+
+float SRGBToLinear(unsigned char value)
+{
+    if (!envSRGBTableReady)
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            float c = i/255.0f;
+            envSRGBTable[i] = (c <= 0.04045f)? c/12.92f : powf((c + 0.055f)/1.055f, 2.4f);
+        }
+        envSRGBTableReady = 1;
+    }
+
+    return envSRGBTable[value];
+}
+
+unsigned char LinearToSRGB(float value)
+{
+    return (unsigned char)(LinearToSRGBFloat(value)*255.0f + 0.5f);
+}
+
+float LinearToSRGBFloat(float value)
+{
+    if (value <= 0.0f) return 0.0f;
+    if (value >= 1.0f) return 1.0f;
+
+    return (value <= 0.0031308f)? value*12.92f : 1.055f*powf(value, 1.0f/2.4f) - 0.055f;
+}
+
+unsigned short FloatToHalf(float value)
+{
+    unsigned int bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+
+    unsigned int sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+    unsigned int mantissa = bits & 0x7fffff;
+
+    if (exponent <= 0)
+    {
+        // Subnormal half or zero, round the shifted mantissa to nearest
+        if (exponent < -10) return (unsigned short)sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        return (unsigned short)(sign | ((mantissa + (1u << (shift - 1))) >> shift));
+    }
+
+    if (exponent >= 31) return (unsigned short)(sign | 0x7c00);     // Overflow to infinity, light values never get there
+
+    // Round to nearest, a mantissa carry correctly bumps the exponent
+    return (unsigned short)((sign | ((unsigned int)exponent << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1));
+}
+
+float HalfToFloat(unsigned short value)
+{
+    unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+    int exponent = (value >> 10) & 0x1f;
+    unsigned int mantissa = value & 0x3ff;
+    unsigned int bits = 0;
+
+    if (exponent == 0)
+    {
+        if (mantissa == 0) bits = sign;
+        else
+        {
+            // Normalize the subnormal
+            exponent = 1;
+            while ((mantissa & 0x400) == 0) { mantissa <<= 1; exponent--; }
+            bits = sign | ((unsigned int)(exponent + 127 - 15) << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    }
+    else if (exponent == 31) bits = sign | 0x7f800000 | (mantissa << 13);
+    else bits = sign | ((unsigned int)(exponent + 127 - 15) << 23) | (mantissa << 13);
+
+    float result = 0.0f;
+    memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
+
+Vector3 EquirectToDirection(float u, float v)
+{
+    float phi = (u - 0.5f)*2.0f*PI;
+    float lat = (v - 0.5f)*PI;
+
+    return (Vector3){ cosf(lat)*cosf(phi), -sinf(lat), cosf(lat)*sinf(phi) };
+}
+
+Vector2 DirectionToEquirect(Vector3 dir)
+{
+    float y = (dir.y < -1.0f)? -1.0f : (dir.y > 1.0f)? 1.0f : dir.y;
+
+    return (Vector2){ atan2f(dir.z, dir.x)/(2.0f*PI) + 0.5f, asinf(-y)/PI + 0.5f };
+}
+
+void SampleEnvMap(EnvMap map, float u, float v, float *rgb)
+{
+    float fx = u*map.width - 0.5f;
+    float fy = v*map.height - 0.5f;
+
+    int x0 = (int)floorf(fx);
+    int y0 = (int)floorf(fy);
+    float tx = fx - x0;
+    float ty = fy - y0;
+
+    // Horizontal wrap across the u seam, vertical clamp at the poles
+    x0 %= map.width;
+    if (x0 < 0) x0 += map.width;
+    int x1 = (x0 + 1 == map.width)? 0 : x0 + 1;
+    int y1 = y0 + 1;
+    if (y0 < 0) y0 = 0;
+    if (y1 > map.height - 1) y1 = map.height - 1;
+    if (y0 > map.height - 1) y0 = map.height - 1;
+
+    const float *r0 = map.data + (size_t)y0*map.width*3;
+    const float *r1 = map.data + (size_t)y1*map.width*3;
+
+    for (int c = 0; c < 3; c++)
+    {
+        float top = r0[x0*3 + c] + (r0[x1*3 + c] - r0[x0*3 + c])*tx;
+        float bottom = r1[x0*3 + c] + (r1[x1*3 + c] - r1[x0*3 + c])*tx;
+        rgb[c] = top + (bottom - top)*ty;
+    }
+}
+
+void SampleEnvPyramid(const EnvPyramid *pyramid, Vector3 dir, float lod, float *rgb)
+{
+    Vector2 uv = DirectionToEquirect(dir);
+
+    float maxLod = (float)(pyramid->levelCount - 1);
+    if (lod < 0.0f) lod = 0.0f;
+    if (lod > maxLod) lod = maxLod;
+
+    int level = (int)lod;
+    float t = lod - level;
+
+    SampleEnvMap(pyramid->levels[level], uv.x, uv.y, rgb);
+
+    if ((t > 0.0f) && (level + 1 < pyramid->levelCount))
+    {
+        float next[3];
+        SampleEnvMap(pyramid->levels[level + 1], uv.x, uv.y, next);
+        for (int c = 0; c < 3; c++) rgb[c] += (next[c] - rgb[c])*t;
+    }
+}
+
+typedef struct EnvDecodeJob {
+    const unsigned char *pixels;
+    int srcWidth;
+    int channels;
+    int factor;
+    EnvMap dst;
+} EnvDecodeJob;
+
+static void EnvDecodeRow(int y, void *userData)
+{
+    EnvDecodeJob *job = (EnvDecodeJob *)userData;
+    float norm = 1.0f/(job->factor*job->factor);
+
+    for (int x = 0; x < job->dst.width; x++)
+    {
+        float sum[3] = { 0 };
+
+        // Average factor x factor source texels in linear space
+        for (int j = 0; j < job->factor; j++)
+        {
+            const unsigned char *row = job->pixels + ((size_t)(y*job->factor + j)*job->srcWidth + (size_t)x*job->factor)*job->channels;
+
+            for (int i = 0; i < job->factor; i++)
+            {
+                for (int c = 0; c < 3; c++) sum[c] += SRGBToLinear(row[i*job->channels + c]);
+            }
+        }
+
+        float *out = job->dst.data + ((size_t)y*job->dst.width + x)*3;
+        for (int c = 0; c < 3; c++) out[c] = sum[c]*norm;
+    }
+}
+
+EnvMap LoadEnvMapFromImage(Image image, int maxWidth)
+{
+    EnvMap map = { 0 };
+
+    Image rgb = ImageCopy(image);
+    if (rgb.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8) ImageFormat(&rgb, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+
+    int factor = 1;
+    while ((maxWidth > 0) && (rgb.width/factor > maxWidth) && ((rgb.height/(factor*2)) > 0)) factor *= 2;
+
+    map.width = rgb.width/factor;
+    map.height = rgb.height/factor;
+    map.data = (float *)RL_MALLOC((size_t)map.width*map.height*3*sizeof(float));
+
+    EnvDecodeJob job = { (const unsigned char *)rgb.data, rgb.width, 3, factor, map };
+    SRGBToLinear(0);    // Build the table before the workers race on it
+    ParallelFor(map.height, EnvDecodeRow, &job);
+
+    UnloadImage(rgb);
+
+    return map;
+}
+
+void UnloadEnvMap(EnvMap map)
+{
+    RL_FREE(map.data);
+}
+
+typedef struct EnvReduceJob {
+    EnvMap src;
+    EnvMap dst;
+} EnvReduceJob;
+
+static void EnvReduceRow(int y, void *userData)
+{
+    EnvReduceJob *job = (EnvReduceJob *)userData;
+    int sy0 = (y*2 < job->src.height)? y*2 : job->src.height - 1;
+    int sy1 = (y*2 + 1 < job->src.height)? y*2 + 1 : sy0;
+
+    for (int x = 0; x < job->dst.width; x++)
+    {
+        int sx0 = (x*2) % job->src.width;
+        int sx1 = (x*2 + 1) % job->src.width;
+
+        const float *a = job->src.data + ((size_t)sy0*job->src.width + sx0)*3;
+        const float *b = job->src.data + ((size_t)sy0*job->src.width + sx1)*3;
+        const float *c = job->src.data + ((size_t)sy1*job->src.width + sx0)*3;
+        const float *d = job->src.data + ((size_t)sy1*job->src.width + sx1)*3;
+
+        float *out = job->dst.data + ((size_t)y*job->dst.width + x)*3;
+        for (int k = 0; k < 3; k++) out[k] = 0.25f*(a[k] + b[k] + c[k] + d[k]);
+    }
+}
+
+EnvPyramid GenEnvPyramid(EnvMap base, int levelCount)
+{
+    EnvPyramid pyramid = { 0 };
+
+    if (levelCount > ENV_MAP_MAX_LEVELS) levelCount = ENV_MAP_MAX_LEVELS;
+
+    pyramid.levels[0] = base;
+    pyramid.levelCount = 1;
+
+    while ((pyramid.levelCount < levelCount) || (levelCount <= 0))
+    {
+        EnvMap src = pyramid.levels[pyramid.levelCount - 1];
+        if ((src.width == 1) && (src.height == 1)) break;
+        if (pyramid.levelCount == ENV_MAP_MAX_LEVELS) break;
+
+        EnvMap dst = { 0 };
+        dst.width = (src.width > 1)? src.width/2 : 1;
+        dst.height = (src.height > 1)? src.height/2 : 1;
+        dst.data = (float *)RL_MALLOC((size_t)dst.width*dst.height*3*sizeof(float));
+
+        EnvReduceJob job = { src, dst };
+        ParallelFor(dst.height, EnvReduceRow, &job);
+
+        pyramid.levels[pyramid.levelCount++] = dst;
+    }
+
+    return pyramid;
+}
+
+void UnloadEnvPyramid(EnvPyramid pyramid)
+{
+    for (int i = 0; i < pyramid.levelCount; i++) UnloadEnvMap(pyramid.levels[i]);
+}
+
+#endif // ENV_MAP_IMPLEMENTATION
@@ -0,0 +1,279 @@
+/**********************************************************************************************
+*
+*   env_prefilter - Offline GGX prefiltered specular environment (split-sum, first term)
+*
+*   Single header module, define ENV_PREFILTER_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   The baker importance-samples the GGX lobe (N = V = R, as in the split-sum approximation)
+*   for every texel of every roughness level and stores the result as the mip chain of one
+*   cubemap (faces as in env_cubemap.h):
+*
+*       mip 0                           -> roughness 0.0 (mirror)
+*       mip i                           -> roughness i/(ENV_PREFILTER_ROUGHNESS_LEVELS - 1)
+*       mip >= ROUGHNESS_LEVELS         -> box-filtered tail, only there to keep the texture complete
+*
+*   So a shader only needs one cube lookup:
+*
+*       textureLod(prefilterMap, R, roughness*prefilterMaxLod)
+*
+*   NOTE: roughness is used directly as GGX alpha, same as Distribution() in the .fs files
+*   (alpha2 = roughness*roughness), so the baked lobes match the direct lighting lobes
+*
+*   Source texels are fetched with filtered importance sampling (the lod of every sample is
+*   picked from its pdf), which keeps the sample count low without fireflies
+*
+*   The bake runs once per panorama, env_assets.h caches the result next to the source file
+*   (e.g. resources/sky1_2k.ggx.cache) and maps it back on later starts
+*
+**********************************************************************************************/
+
+#ifndef ENV_PREFILTER_H
+#define ENV_PREFILTER_H
+
+#include "raylib.h"
+#include "env_cubemap.h"
+
+#define ENV_PREFILTER_FACE_SIZE         256     // Face size of the mirror level, same texel density as a 1024 wide panorama
+#define ENV_PREFILTER_ROUGHNESS_LEVELS  6       // Mip levels carrying a GGX lobe (including the mirror level)
+#define ENV_PREFILTER_SAMPLE_COUNT      64      // GGX samples per texel
+
+EnvCubemap GenEnvCubemapPrefiltered(Image panorama, int faceSize, int roughnessLevels, int sampleCount, int format);    // Bake the GGX cube chain (RGB8 or RGB16F)
+EnvCubemap GenEnvCubemapPrefilteredEx(Image panorama, int faceSize, int roughnessLevels, int sampleCount, int format, const int *cancel); // Same, gives up (empty result) once *cancel is set
+
+#endif // ENV_PREFILTER_H
+
+#if defined(ENV_PREFILTER_IMPLEMENTATION) && !defined(ENV_PREFILTER_IMPLEMENTED)
+#define ENV_PREFILTER_IMPLEMENTED
+
+#include <math.h>
+
+#define ENV_CUBEMAP_IMPLEMENTATION
+#include "env_cubemap.h"
+
+// One importance sample in tangent space (N = +Z)
+typedef struct EnvPrefilterSample {
+    float x, y, z;          // Reflected light direction
+    float weight;           // NdotL
+    float lod;              // Source lod picked from the sample pdf
+} EnvPrefilterSample;
+
+typedef struct EnvPrefilterJob {
+    const EnvPyramid *source;
+    EnvMap faces[ENV_CUBEMAP_FACE_COUNT];       // Target mip, one float map per face
+    const EnvPrefilterSample *samples;
+    int sampleCount;
+    const int *cancel;                          // Rows left once it is set are skipped
+} EnvPrefilterJob;
+
+// Van der Corput radical inverse, second Hammersley coordinate
+static float EnvRadicalInverse(unsigned int bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+    return (float)bits*2.3283064365386963e-10f;
+}
+
+// Build the sample table for one roughness level, shared by every texel of that level
+static int EnvBuildSamples(float roughness, int sampleCount, const EnvMap *sourceBase, EnvPrefilterSample *samples)
+{
+    float alpha = (roughness < 0.0001f)? 0.0001f : roughness;
+    float alpha2 = alpha*alpha;
+
+    // Average solid angle of one source texel at lod 0
+    float texelSolidAngle = 4.0f*PI/((float)sourceBase->width*sourceBase->height);
+
+    int count = 0;
+
+    for (int i = 0; i < sampleCount; i++)
+    {
+        float xi1 = (float)i/sampleCount;
+        float xi2 = EnvRadicalInverse((unsigned int)i);
+
+        // GGX half vector around N = +Z
+        float phi = 2.0f*PI*xi1;
+        float cosThetaH = sqrtf((1.0f - xi2)/(1.0f + (alpha2 - 1.0f)*xi2));
+        float sinThetaH = sqrtf(1.0f - cosThetaH*cosThetaH);
+        float hx = sinThetaH*cosf(phi);
+        float hy = sinThetaH*sinf(phi);
+        float hz = cosThetaH;
+
+        // L = reflect(-V, H) with V = N
+        float NdotL = 2.0f*hz*hz - 1.0f;
+        if (NdotL <= 0.0f) continue;
+
+        // pdf(L) = D*NdotH/(4*VdotH) = D/4 when V = N
+        float denom = (alpha2 - 1.0f)*hz*hz + 1.0f;
+        float D = alpha2/(PI*denom*denom);
+        float pdf = D*0.25f;
+
+        float sampleSolidAngle = 1.0f/(sampleCount*pdf + 0.0001f);
+        float lod = (roughness == 0.0f)? 0.0f : 0.5f*log2f(sampleSolidAngle/texelSolidAngle) + 1.0f;
+
+        samples[count].x = 2.0f*hz*hx;
+        samples[count].y = 2.0f*hz*hy;
+        samples[count].z = NdotL;
+        samples[count].weight = NdotL;
+        samples[count].lod = (lod < 0.0f)? 0.0f : lod;
+        count++;
+    }
+
+    return count;
+}
+
+static void EnvPrefilterRow(int index, void *userData)
+{
+    EnvPrefilterJob *job = (EnvPrefilterJob *)userData;
+
+    // A rough level is the long part of the bake, it stops within a row
+    if (EnvBakeCancelled(job->cancel)) return;
+
+    // Rows of all six faces are one flat index space
+    const int size = job->faces[0].width;
+    const int face = index/size;
+    const int y = index%size;
+    EnvMap target = job->faces[face];
+
+    for (int x = 0; x < size; x++)
+    {
+        Vector3 N = CubemapToDirection(face, 2.0f*(x + 0.5f)/size - 1.0f, 2.0f*(y + 0.5f)/size - 1.0f);
+
+        // Orthonormal basis around N (Frisvad, branchless variant by Duff et al.)
+        float sign = (N.z >= 0.0f)? 1.0f : -1.0f;
+        float a = -1.0f/(sign + N.z);
+        float b = N.x*N.y*a;
+        Vector3 T = { 1.0f + sign*N.x*N.x*a, sign*b, -sign*N.x };
+        Vector3 B = { b, sign + N.y*N.y*a, -N.y };
+
+        float sum[3] = { 0 };
+        float weight = 0.0f;
+
+        for (int i = 0; i < job->sampleCount; i++)
+        {
+            const EnvPrefilterSample *s = &job->samples[i];
+            Vector3 L = {
+                T.x*s->x + B.x*s->y + N.x*s->z,
+                T.y*s->x + B.y*s->y + N.y*s->z,
+                T.z*s->x + B.z*s->y + N.z*s->z
+            };
+
+            float rgb[3];
+            SampleEnvPyramid(job->source, L, s->lod, rgb);
+
+            sum[0] += rgb[0]*s->weight;
+            sum[1] += rgb[1]*s->weight;
+            sum[2] += rgb[2]*s->weight;
+            weight += s->weight;
+        }
+
+        float *out = target.data + ((size_t)y*size + x)*3;
+        float norm = (weight > 0.0f)? 1.0f/weight : 0.0f;
+        for (int c = 0; c < 3; c++) out[c] = sum[c]*norm;
+    }
+}
+
+EnvCubemap GenEnvCubemapPrefiltered(Image panorama, int faceSize, int roughnessLevels, int sampleCount, int format)
+{
+    return GenEnvCubemapPrefilteredEx(panorama, faceSize, roughnessLevels, sampleCount, format, NULL);
+}
+
+EnvCubemap GenEnvCubemapPrefilteredEx(Image panorama, int faceSize, int roughnessLevels, int sampleCount, int format, const int *cancel)
+{
+    EnvCubemap result = { 0 };
+    double startTime = GetTime();
+
+    int size = 1;
+    while ((size*2 <= faceSize) && (size*2*4 <= panorama.width)) size *= 2;
+    if (roughnessLevels < 2) roughnessLevels = 2;
+
+    // Source pyramid starts one level above the mirror density (4 faces around the equator),
+    // finer texels never get picked by the filtered importance sampling at the first rough level
+    EnvMap source = LoadEnvMapFromImage(panorama, size*4*2);
+    EnvPyramid sourcePyramid = GenEnvPyramid(source, 0);
+
+    int mipmaps = 1;
+    for (int s = size; s > 1; s /= 2) mipmaps++;
+    if (roughnessLevels > mipmaps) roughnessLevels = mipmaps;
+
+    result.size = size;
+    result.mipmaps = mipmaps;
+    result.format = (format == PIXELFORMAT_UNCOMPRESSED_R16G16B16)? format : PIXELFORMAT_UNCOMPRESSED_R8G8B8;
+    result.data = (unsigned char *)RL_MALLOC(GetEnvCubemapOffset(size, result.format, mipmaps, 0));
+
+    EnvPrefilterSample *samples = (EnvPrefilterSample *)RL_MALLOC(sampleCount*sizeof(EnvPrefilterSample));
+    EnvMap previous[ENV_CUBEMAP_FACE_COUNT] = { 0 };
+    bool cancelled = false;
+
+    for (int mip = 0, s = size; (mip < mipmaps) && !(cancelled = EnvBakeCancelled(cancel)); mip++)
+    {
+        EnvMap faces[ENV_CUBEMAP_FACE_COUNT] = { 0 };
+        for (int face = 0; face < ENV_CUBEMAP_FACE_COUNT; face++)
+        {
+            faces[face].width = s;
+            faces[face].height = s;
+            faces[face].data = (float *)RL_MALLOC((size_t)s*s*3*sizeof(float));
+        }
+
+        if (mip < roughnessLevels)
+        {
+            EnvPrefilterJob job = { 0 };
+            job.source = &sourcePyramid;
+            for (int face = 0; face < ENV_CUBEMAP_FACE_COUNT; face++) job.faces[face] = faces[face];
+            job.samples = samples;
+            job.cancel = cancel;
+
+            if (mip == 0)
+            {
+                // Mirror level, GGX lobe degenerates to a single direction at the matching source density
+                float lod = log2f((float)sourcePyramid.levels[0].width/(s*4.0f));
+                samples[0] = (EnvPrefilterSample){ 0.0f, 0.0f, 1.0f, 1.0f, (lod > 0.0f)? lod : 0.0f };
+                job.sampleCount = 1;
+            }
+            else job.sampleCount = EnvBuildSamples((float)mip/(roughnessLevels - 1), sampleCount, &sourcePyramid.levels[0], samples);
+
+            ParallelFor(ENV_CUBEMAP_FACE_COUNT*s, EnvPrefilterRow, &job);
+        }
+        else
+        {
+            // Tail keeps the roughest lobe, plain 2x2 reduction inside every face of the previous level
+            for (int face = 0; face < ENV_CUBEMAP_FACE_COUNT; face++)
+            {
+                EnvReduceJob job = { previous[face], faces[face] };
+                ParallelFor(s, EnvReduceRow, &job);
+            }
+        }
+
+        // Encode back to the storage format
+        for (int face = 0; face < ENV_CUBEMAP_FACE_COUNT; face++)
+        {
+            EncodeEnvTexels(faces[face].data, result.data + GetEnvCubemapOffset(size, result.format, mip, face), s*s, result.format);
+
+            UnloadEnvMap(previous[face]);
+            previous[face] = faces[face];
+        }
+
+        s = (s > 1)? s/2 : 1;
+    }
+
+    for (int face = 0; face < ENV_CUBEMAP_FACE_COUNT; face++) UnloadEnvMap(previous[face]);
+    RL_FREE(samples);
+    UnloadEnvPyramid(sourcePyramid);
+
+    // The level a cancel cut short is not complete either, nothing of the chain is kept
+    if (cancelled || EnvBakeCancelled(cancel))
+    {
+        UnloadEnvCubemap(result);
+        TraceLog(LOG_INFO, "PREFILTER: Bake cancelled after %.2f s", GetTime() - startTime);
+        return (EnvCubemap){ 0 };
+    }
+
+    TraceLog(LOG_INFO, "PREFILTER: Baked %ix%i GGX cubemap (%i roughness levels, %i samples) in %.2f s on %i threads", size, size, roughnessLevels, sampleCount, GetTime() - startTime, GetWorkerCount());
+
+    return result;
+}
+
+#endif // ENV_PREFILTER_IMPLEMENTATION
@@ -0,0 +1,252 @@
+/**********************************************************************************************
+*
+*   env_sh - Order 2 (9 coefficient) spherical harmonic irradiance of a sky panorama
+*
+*   Single header module, define ENV_SH_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   The panorama is decoded to linear light, projected onto the 9 real SH basis functions
+*   with per-texel solid angle weighting (equirect texels shrink by cos(latitude) towards
+*   the poles), then convolved with the clamped cosine lobe (Ramamoorthi & Hanrahan 2001)
+*
+*   The basis constants are folded into the coefficients, so a shader evaluates the
+*   irradiance with ALU only:
+*
+*       E(n) = c0
+*            + c1*n.y + c2*n.z + c3*n.x
+*            + c4*n.x*n.y + c5*n.y*n.z + c6*(3*n.z*n.z - 1) + c7*n.x*n.z + c8*(n.x*n.x - n.y*n.y)
+*
+*   Lambertian ambient is then E(n)/PI*albedo
+*
+**********************************************************************************************/
+
+#ifndef ENV_SH_H
+#define ENV_SH_H
+
+#include "raylib.h"
+
+#define ENV_SH_PROJECTION_WIDTH 512         // Panorama is box-reduced to this width first, order 2 SH is band limited anyway
+
+// Irradiance coefficients, upload as a vec3[9] uniform
+typedef struct EnvSH9 {
+    Vector3 coefficients[9];
+} EnvSH9;
+
+EnvSH9 GenEnvSH9(Image panorama);                                   // Project panorama to irradiance SH
+EnvSH9 LoadEnvSH9(const char *fileName);                            // Load panorama file and project it
+Vector3 EvalEnvSH9(EnvSH9 sh, Vector3 normal);                      // CPU evaluation of E(n), same formula as the shaders
+void SetShaderValueSH9(Shader shader, int locIndex, EnvSH9 sh);     // Upload to a vec3[9] uniform
+
+#endif // ENV_SH_H
+
+#if defined(ENV_SH_IMPLEMENTATION) && !defined(ENV_SH_IMPLEMENTED)
+#define ENV_SH_IMPLEMENTED
+
+#include <math.h>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+#define ENV_MAP_IMPLEMENTATION
+#include "env_map.h"
+
+// Radiance projection of one panorama row (9 coefficients x RGB)
+typedef struct EnvSHRow {
+    float sum[9][3];
+} EnvSHRow;
+
+typedef struct EnvSHJob {
+    EnvMap map;
+    const float *cosPhi;
+    const float *sinPhi;
+    EnvSHRow *rows;
+} EnvSHJob;
+
+static void EnvProjectRow(int y, void *userData)
+{
+    EnvSHJob *job = (EnvSHJob *)userData;
+    const EnvMap map = job->map;
+
+    // Every texel of a row has the same latitude, so y and the solid angle are shared
+    float lat = ((y + 0.5f)/map.height - 0.5f)*PI;
+    float cosLat = cosf(lat);
+    float dirY = -sinf(lat);
+    float solidAngle = (2.0f*PI/map.width)*(PI/map.height)*cosLat;
+
+    float sum[9][3] = { 0 };
+    const float *texel = map.data + (size_t)y*map.width*3;
+    int x = 0;
+
+#if defined(__SSE2__)
+    // Four texels per iteration, RGB de-interleaved into separate lanes
+    __m128 acc[9][3];
+    for (int i = 0; i < 9; i++) for (int c = 0; c < 3; c++) acc[i][c] = _mm_setzero_ps();
+
+    const __m128 vy = _mm_set1_ps(dirY);
+    const __m128 vcosLat = _mm_set1_ps(cosLat);
+
+    for (; x + 4 <= map.width; x += 4)
+    {
+        const float *t = texel + x*3;
+        __m128 r = _mm_set_ps(t[9], t[6], t[3], t[0]);
+        __m128 g = _mm_set_ps(t[10], t[7], t[4], t[1]);
+        __m128 b = _mm_set_ps(t[11], t[8], t[5], t[2]);
+
+        __m128 vx = _mm_mul_ps(vcosLat, _mm_loadu_ps(job->cosPhi + x));
+        __m128 vz = _mm_mul_ps(vcosLat, _mm_loadu_ps(job->sinPhi + x));
+
+        __m128 basis[9];
+        basis[0] = _mm_set1_ps(0.282095f);
+        basis[1] = _mm_mul_ps(_mm_set1_ps(0.488603f), vy);
+        basis[2] = _mm_mul_ps(_mm_set1_ps(0.488603f), vz);
+        basis[3] = _mm_mul_ps(_mm_set1_ps(0.488603f), vx);
+        basis[4] = _mm_mul_ps(_mm_set1_ps(1.092548f), _mm_mul_ps(vx, vy));
+        basis[5] = _mm_mul_ps(_mm_set1_ps(1.092548f), _mm_mul_ps(vy, vz));
+        basis[6] = _mm_mul_ps(_mm_set1_ps(0.315392f), _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(vz, vz)), _mm_set1_ps(1.0f)));
+        basis[7] = _mm_mul_ps(_mm_set1_ps(1.092548f), _mm_mul_ps(vx, vz));
+        basis[8] = _mm_mul_ps(_mm_set1_ps(0.546274f), _mm_sub_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+
+        for (int i = 0; i < 9; i++)
+        {
+            acc[i][0] = _mm_add_ps(acc[i][0], _mm_mul_ps(basis[i], r));
+            acc[i][1] = _mm_add_ps(acc[i][1], _mm_mul_ps(basis[i], g));
+            acc[i][2] = _mm_add_ps(acc[i][2], _mm_mul_ps(basis[i], b));
+        }
+    }
+
+    for (int i = 0; i < 9; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            float lanes[4];
+            _mm_storeu_ps(lanes, acc[i][c]);
+            sum[i][c] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        }
+    }
+#endif
+
+    // Scalar path, also handles the remainder of the SIMD loop
+    for (; x < map.width; x++)
+    {
+        const float *t = texel + x*3;
+        float dx = cosLat*job->cosPhi[x];
+        float dz = cosLat*job->sinPhi[x];
+
+        float basis[9] = {
+            0.282095f,
+            0.488603f*dirY,
+            0.488603f*dz,
+            0.488603f*dx,
+            1.092548f*dx*dirY,
+            1.092548f*dirY*dz,
+            0.315392f*(3.0f*dz*dz - 1.0f),
+            1.092548f*dx*dz,
+            0.546274f*(dx*dx - dirY*dirY)
+        };
+
+        for (int i = 0; i < 9; i++)
+        {
+            sum[i][0] += basis[i]*t[0];
+            sum[i][1] += basis[i]*t[1];
+            sum[i][2] += basis[i]*t[2];
+        }
+    }
+
+    for (int i = 0; i < 9; i++)
+    {
+        for (int c = 0; c < 3; c++) job->rows[y].sum[i][c] = sum[i][c]*solidAngle;
+    }
+}
+
+EnvSH9 GenEnvSH9(Image panorama)
+{
+    EnvSH9 sh = { 0 };
+    double startTime = GetTime();
+
+    EnvMap map = LoadEnvMapFromImage(panorama, ENV_SH_PROJECTION_WIDTH);
+
+    // Longitude terms only depend on the column
+    float *cosPhi = (float *)RL_MALLOC(map.width*sizeof(float));
+    float *sinPhi = (float *)RL_MALLOC(map.width*sizeof(float));
+    for (int x = 0; x < map.width; x++)
+    {
+        float phi = ((x + 0.5f)/map.width - 0.5f)*2.0f*PI;
+        cosPhi[x] = cosf(phi);
+        sinPhi[x] = sinf(phi);
+    }
+
+    EnvSHJob job = { 0 };
+    job.map = map;
+    job.cosPhi = cosPhi;
+    job.sinPhi = sinPhi;
+    job.rows = (EnvSHRow *)RL_CALLOC(map.height, sizeof(EnvSHRow));
+
+    ParallelFor(map.height, EnvProjectRow, &job);
+
+    // Reduce rows in a fixed order so the result does not depend on thread timing
+    double radiance[9][3] = { 0 };
+    for (int y = 0; y < map.height; y++)
+    {
+        for (int i = 0; i < 9; i++) for (int c = 0; c < 3; c++) radiance[i][c] += job.rows[y].sum[i][c];
+    }
+
+    // Cosine lobe convolution per band (A0 = PI, A1 = 2*PI/3, A2 = PI/4) times the basis constant
+    const float scale[9] = {
+        PI*0.282095f,
+        (2.0f*PI/3.0f)*0.488603f, (2.0f*PI/3.0f)*0.488603f, (2.0f*PI/3.0f)*0.488603f,
+        (PI/4.0f)*1.092548f, (PI/4.0f)*1.092548f, (PI/4.0f)*0.315392f, (PI/4.0f)*1.092548f, (PI/4.0f)*0.546274f
+    };
+
+    for (int i = 0; i < 9; i++)
+    {
+        sh.coefficients[i].x = (float)radiance[i][0]*scale[i];
+        sh.coefficients[i].y = (float)radiance[i][1]*scale[i];
+        sh.coefficients[i].z = (float)radiance[i][2]*scale[i];
+    }
+
+    RL_FREE(job.rows);
+    RL_FREE(cosPhi);
+    RL_FREE(sinPhi);
+    UnloadEnvMap(map);
+
+    TraceLog(LOG_INFO, "SH: Projected %ix%i panorama to irradiance in %.2f ms on %i threads", panorama.width, panorama.height, (GetTime() - startTime)*1000.0, GetWorkerCount());
+
+    return sh;
+}
+
+EnvSH9 LoadEnvSH9(const char *fileName)
+{
+    EnvSH9 sh = { 0 };
+
+    Image panorama = LoadImage(fileName);
+    if (panorama.data == NULL) return sh;
+
+    sh = GenEnvSH9(panorama);
+
+    UnloadImage(panorama);
+
+    return sh;
+}
+
+Vector3 EvalEnvSH9(EnvSH9 sh, Vector3 n)
+{
+    float basis[9] = { 1.0f, n.y, n.z, n.x, n.x*n.y, n.y*n.z, 3.0f*n.z*n.z - 1.0f, n.x*n.z, n.x*n.x - n.y*n.y };
+    Vector3 result = { 0 };
+
+    for (int i = 0; i < 9; i++)
+    {
+        result.x += sh.coefficients[i].x*basis[i];
+        result.y += sh.coefficients[i].y*basis[i];
+        result.z += sh.coefficients[i].z*basis[i];
+    }
+
+    return result;
+}
+
+void SetShaderValueSH9(Shader shader, int locIndex, EnvSH9 sh)
+{
+    SetShaderValueV(shader, locIndex, sh.coefficients, SHADER_UNIFORM_VEC3, 9);
+}
+
+#endif // ENV_SH_IMPLEMENTATION
@@ -0,0 +1,229 @@
+/**********************************************************************************************
+*
+*   gbuffer - Geometry buffer of the deferred path, the surface of every visible pixel
+*
+*   Single header module, define GBUFFER_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   The geometry pass writes the material of the front surface into three color attachments
+*   and a depth texture, the lighting pass then shades every pixel once with a full screen
+*   quad. Overdraw only costs the cheap geometry shader and the light loop runs once per pixel
+*   instead of once per covering fragment. Attachments, as the geometry shader writes them:
+*
+*       layout(location = 0) out vec4 gbufferAlbedo;    // RGBA8: color, metallic
+*       layout(location = 1) out vec4 gbufferNormal;    // RGBA16F: octahedral normal, roughness, clearcoat roughness
+*       layout(location = 2) out vec4 gbufferSurface;   // RGBA8: (ior - 1)/2.5, clearcoat weight, (clearcoat ior - 1)/2.5, alpha
+*
+*   The world position is not stored, the lighting shader rebuilds it from the depth and the
+*   inverse view projection. The normal is folded onto an octahedron, two half floats per
+*   pixel hold it to well under a tenth of a degree. IOR uses the 1.0 - 3.5 range of the
+*   demo sliders
+*
+*   The G-buffer is drawn like any RenderTexture2D (BeginGBufferMode() is BeginTextureMode()
+*   without blending, it would mix the metallic and alpha channels with the clear color), so
+*   the pass goes before BeginDrawing(). DrawGBufferLighting() binds the material maps the
+*   way DrawMesh() does, the four G-buffer textures after them on GBUFFER_TEXTURE_UNIT:
+*
+*       uniform sampler2D gbufferAlbedo;
+*       uniform sampler2D gbufferNormal;
+*       uniform sampler2D gbufferSurface;
+*       uniform sampler2D gbufferDepth;
+*
+*   and draws the quad without depth test into the current target, which must be the size
+*   of the G-buffer (the shader reads it with texelFetch(gl_FragCoord)). The G-buffer depth is
+*   then copied into the target's, so the passes after it (the tone map of common/hdr_target.h)
+*   see the lit surfaces like forward drawn ones. The window's own framebuffer is left out, its
+*   depth format is the platform's
+*
+**********************************************************************************************/
+
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include "raylib.h"
+
+#define GBUFFER_TEXTURE_UNIT        16          // Albedo, normal, surface, depth, after the material maps and the light clusters
+#define GBUFFER_MAP_COUNT           (MATERIAL_MAP_BRDF + 1)     // Maps DrawMesh() binds, MAX_MATERIAL_MAPS is not public
+
+typedef struct GBuffer {
+    RenderTexture2D target;     // BeginTextureMode() target: texture is the albedo attachment, depth a depth texture
+    Texture2D normal;
+    Texture2D surface;
+} GBuffer;
+
+GBuffer LoadGBuffer(int width, int height);                                     // Framebuffer with the three attachments and depth
+void UnloadGBuffer(GBuffer gbuffer);
+void BeginGBufferMode(GBuffer gbuffer);                                         // BeginTextureMode(), blending off and every attachment cleared
+void EndGBufferMode(void);
+void DrawGBufferLighting(GBuffer gbuffer, Material material);                   // Full screen pass of the material's shader over the G-buffer
+
+#endif // GBUFFER_H
+
+#if defined(GBUFFER_IMPLEMENTATION) && !defined(GBUFFER_IMPLEMENTED)
+#define GBUFFER_IMPLEMENTED
+
+#include "rlgl.h"
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, rlLoadFramebuffer() changed signature between releases
+
+static unsigned int LoadGBufferTexture(int width, int height, int internalFormat, int format, int type)
+{
+    unsigned int id = 0;
+
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+
+    // Read texel by texel, no filtering and no mipmaps
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return id;
+}
+
+GBuffer LoadGBuffer(int width, int height)
+{
+    GBuffer gbuffer = { 0 };
+
+    unsigned int albedo = LoadGBufferTexture(width, height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    unsigned int normal = LoadGBufferTexture(width, height, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+    unsigned int surface = LoadGBufferTexture(width, height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    unsigned int depth = LoadGBufferTexture(width, height, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+
+    unsigned int fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, surface, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+
+    // The draw buffers are framebuffer state, set once here
+    const GLenum drawBuffers[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, drawBuffers);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    gbuffer.target.id = fbo;
+    gbuffer.target.texture = (Texture2D){ albedo, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    gbuffer.target.depth = (Texture2D){ depth, width, height, 1, 19 };      // Same format value LoadRenderTexture() gives its depth
+    gbuffer.normal = (Texture2D){ normal, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16 };
+    gbuffer.surface = (Texture2D){ surface, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        TraceLog(LOG_WARNING, "GBUFFER: [ID %i] Framebuffer incomplete (0x%x)", fbo, status);
+        UnloadGBuffer(gbuffer);
+        return (GBuffer){ 0 };
+    }
+
+    TraceLog(LOG_INFO, "GBUFFER: [ID %i] %ix%i G-buffer, 12 bytes per pixel plus depth", fbo, width, height);
+
+    return gbuffer;
+}
+
+void UnloadGBuffer(GBuffer gbuffer)
+{
+    unsigned int textures[4] = { gbuffer.target.texture.id, gbuffer.normal.id, gbuffer.surface.id, gbuffer.target.depth.id };
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (textures[i] > 0) glDeleteTextures(1, &textures[i]);
+    }
+
+    if (gbuffer.target.id > 0) glDeleteFramebuffers(1, &gbuffer.target.id);
+}
+
+void BeginGBufferMode(GBuffer gbuffer)
+{
+    BeginTextureMode(gbuffer.target);
+
+    // Depth 1.0 marks the pixels no surface covers, the lighting pass skips them
+    rlDisableColorBlend();
+    ClearBackground(BLANK);
+}
+
+void EndGBufferMode(void)
+{
+    EndTextureMode();
+    rlEnableColorBlend();
+}
+
+// Material maps on the slots DrawMesh() uses, the G-buffer after them, then one quad over the target
+void DrawGBufferLighting(GBuffer gbuffer, Material material)
+{
+    static const char *samplers[4] = { "gbufferAlbedo", "gbufferNormal", "gbufferSurface", "gbufferDepth" };
+    unsigned int textures[4] = { gbuffer.target.texture.id, gbuffer.normal.id, gbuffer.surface.id, gbuffer.target.depth.id };
+
+    if (gbuffer.target.id == 0) return;
+
+    // Whatever the batch holds goes first, it was drawn under the current state
+    rlDrawRenderBatchActive();
+    rlEnableShader(material.shader.id);
+
+    for (int i = 0; i < GBUFFER_MAP_COUNT; i++)
+    {
+        if ((material.maps[i].texture.id > 0) && (material.shader.locs[SHADER_LOC_MAP_DIFFUSE + i] != -1))
+        {
+            rlActiveTextureSlot(i);
+
+            if ((i == MATERIAL_MAP_IRRADIANCE) || (i == MATERIAL_MAP_PREFILTER) || (i == MATERIAL_MAP_CUBEMAP)) rlEnableTextureCubemap(material.maps[i].texture.id);
+            else rlEnableTexture(material.maps[i].texture.id);
+
+            rlSetUniform(material.shader.locs[SHADER_LOC_MAP_DIFFUSE + i], &i, SHADER_UNIFORM_INT, 1);
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        int unit = GBUFFER_TEXTURE_UNIT + i;
+
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        rlSetUniform(glGetUniformLocation(material.shader.id, samplers[i]), &unit, SHADER_UNIFORM_INT, 1);
+    }
+
+    // The quad covers the whole target at depth 0, the skybox under it must stay
+    rlDisableDepthTest();
+    rlDisableBackfaceCulling();
+    rlLoadDrawQuad();
+    rlEnableBackfaceCulling();
+    rlEnableDepthTest();
+
+    // Depth of the surfaces into the current target, both are DEPTH_COMPONENT24 of one size
+    int target = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+
+    if (target != 0)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, gbuffer.target.id);
+        glBlitFramebuffer(0, 0, gbuffer.target.texture.width, gbuffer.target.texture.height, 0, 0,
+            gbuffer.target.texture.width, gbuffer.target.texture.height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)target);
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + GBUFFER_TEXTURE_UNIT + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    for (int i = 0; i < GBUFFER_MAP_COUNT; i++)
+    {
+        if ((material.maps[i].texture.id > 0) && (material.shader.locs[SHADER_LOC_MAP_DIFFUSE + i] != -1))
+        {
+            rlActiveTextureSlot(i);
+
+            if ((i == MATERIAL_MAP_IRRADIANCE) || (i == MATERIAL_MAP_PREFILTER) || (i == MATERIAL_MAP_CUBEMAP)) rlDisableTextureCubemap();
+            else rlDisableTexture();
+        }
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    rlDisableShader();
+}
+
+#endif // GBUFFER_IMPLEMENTATION
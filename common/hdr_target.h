@@ -0,0 +1,312 @@
+/**********************************************************************************************
+*
+*   hdr_target - Float scene target with one exposure and tone map pass for every material
+*
+*   Single header module, define HDR_TARGET_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   The 3D scene (skybox included) renders into an RGBA16F or R11G11B10F color attachment with
+*   its own depth, the material shaders write linear radiance and never clamp. One full screen
+*   pass then applies the exposure and the tone map curve into the frame, so every material
+*   shares one curve and the per fragment ALU of it runs once per pixel, not once per shaded
+*   fragment of every material. The pass reads the depth too: pixels still at the cleared depth
+*   (the skybox, drawn without depth writes, and the background) go to the frame as they were
+*   drawn, at exposure 1 and only clamped, the way the sky always looked:
+*
+*       HdrTarget hdr = LoadHdrTarget(width, height, ParseHdrArgs(argc, argv, HDR_EXPOSURE_DEFAULT));
+*
+*       BeginHeadlessDrawing(&headless);
+*           BeginHdrMode(&hdr);             // Until EndHdrMode() draws go to the float target
+*               ClearBackground(...);
+*               BeginMode3D(camera); ... EndMode3D();
+*           EndHdrMode(&hdr);               // Back to the target bound before
+*           DrawHdrToneMap(&hdr);           // Full screen pass, GUI and text go after it
+*       EndHeadlessDrawing(&headless);
+*
+*   DrawHdrToneMapViewport() tone maps one viewport with its own exposure, the shading lab's
+*   compare grid shows every technique at the exposure of its demo that way
+*
+*   The target must be the size of the one it resolves into (the shader reads it with
+*   texelFetch(gl_FragCoord)), BeginHdrMode() keeps the viewport and the projection.
+*   Command line, read by ParseHdrArgs():
+*
+*       --ldr               No target, the scene goes straight to the frame unexposed (the
+*                           three calls do nothing), the baseline of a measurement
+*       --hdr-format F      rgba16f (8 bytes per pixel, default) or r11g11b10f (4 bytes, no alpha:
+*                           blending only reads the source alpha, nothing needs it stored)
+*       --tonemap T         clamp (default, the output the material shaders gave before), reinhard
+*                           or aces
+*       --exposure X        Scale of the radiance before the curve, each demo has its default
+*                           (ParseHdrArgs() keeps the one it is given when there is no option)
+*
+*   Against the back buffer the target costs memory traffic, not shading: every scene fragment
+*   writes the float format instead of RGBA8 and the pass reads every pixel once more and writes
+*   it once. LoadHdrTarget() logs that lower bound per frame; the measured cost is the "Tonemap"
+*   pass of the pass timer and the frame times of the same bench run with --ldr and each format
+*   (the result lines carry the arguments, one file collects the three):
+*
+*       demo --headless --bench --size 1920x1080 --timings ldr.csv --ldr --bench-output hdr.jsonl
+*       demo --headless --bench --size 1920x1080 --timings rgba16f.csv --bench-output hdr.jsonl
+*       demo --headless --bench --size 1920x1080 --timings r11g11b10f.csv --hdr-format r11g11b10f --bench-output hdr.jsonl
+*
+**********************************************************************************************/
+
+#ifndef HDR_TARGET_H
+#define HDR_TARGET_H
+
+#include "raylib.h"
+
+#define HDR_FORMAT_NONE             0       // --ldr, no target
+#define HDR_FORMAT_RGBA16F          1
+#define HDR_FORMAT_R11G11B10F       2
+
+#define HDR_TONEMAP_CLAMP           0       // Exposure then clip, what the material shaders did before
+#define HDR_TONEMAP_REINHARD        1
+#define HDR_TONEMAP_ACES            2
+
+#define HDR_EXPOSURE_DEFAULT        3.0f    // The factor the lit material shaders applied themselves
+
+#define HDR_TONEMAP_VERTEX_SHADER       "resources/tonemap.vs"
+#define HDR_TONEMAP_FRAGMENT_SHADER     "resources/tonemap.fs"
+
+// Options of the pass, from the command line
+typedef struct HdrSettings {
+    int format;                 // HDR_FORMAT_*
+    int toneMapper;             // HDR_TONEMAP_*
+    float exposure;
+} HdrSettings;
+
+typedef struct HdrTarget {
+    HdrSettings settings;
+    RenderTexture2D target;     // Float color and depth textures, id 0 without a target
+    Shader shader;              // Exposure and tone map pass
+    int exposureLoc;
+    int toneMapperLoc;
+    int colorLoc;
+    int depthLoc;
+    int previous;               // Framebuffer bound at BeginHdrMode()
+} HdrTarget;
+
+HdrSettings ParseHdrArgs(int argc, char *argv[], float exposure);       // --ldr, --hdr-format, --tonemap, --exposure
+HdrTarget LoadHdrTarget(int width, int height, HdrSettings settings);  // Framebuffer and pass program, none for HDR_FORMAT_NONE
+void UnloadHdrTarget(HdrTarget hdr);
+void BeginHdrMode(HdrTarget *hdr);                                      // Bind the float target, same viewport
+void EndHdrMode(HdrTarget *hdr);                                        // Bind the previous target again
+void DrawHdrToneMap(const HdrTarget *hdr);                              // Exposure and tone map into the current target
+void DrawHdrToneMapViewport(const HdrTarget *hdr, int x, int y, int width, int height, float exposure); // One viewport, lower left origin
+
+#endif // HDR_TARGET_H
+
+#if defined(HDR_TARGET_IMPLEMENTATION) && !defined(HDR_TARGET_IMPLEMENTED)
+#define HDR_TARGET_IMPLEMENTED
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rlgl.h"
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, rlgl has no float formats beyond RGBA16F/32F
+#include "shader_cache.h"
+
+static const char *hdrFormatNames[3] = { "none", "rgba16f", "r11g11b10f" };
+static const char *hdrToneMapperNames[3] = { "clamp", "reinhard", "aces" };
+
+// Index of a name in a list, -1 when it is not there
+static int FindHdrName(const char **names, int count, const char *name)
+{
+    for (int i = 0; i < count; i++) if (strcmp(names[i], name) == 0) return i;
+
+    return -1;
+}
+
+HdrSettings ParseHdrArgs(int argc, char *argv[], float exposure)
+{
+    HdrSettings settings = { HDR_FORMAT_RGBA16F, HDR_TONEMAP_CLAMP, exposure };    // The curves are opt-in, the frame looks as it did
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = (i + 1 < argc)? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--ldr") == 0) settings.format = HDR_FORMAT_NONE;
+        else if ((strcmp(argv[i], "--hdr-format") == 0) && (value != NULL))
+        {
+            int format = FindHdrName(hdrFormatNames + 1, 2, value);
+
+            if (format >= 0) settings.format = format + 1;
+            else TraceLog(LOG_WARNING, "HDR: Unknown format [%s], expected rgba16f or r11g11b10f", value);
+            i++;
+        }
+        else if ((strcmp(argv[i], "--tonemap") == 0) && (value != NULL))
+        {
+            int toneMapper = FindHdrName(hdrToneMapperNames, 3, value);
+
+            if (toneMapper >= 0) settings.toneMapper = toneMapper;
+            else TraceLog(LOG_WARNING, "HDR: Unknown tone map [%s], expected clamp, reinhard or aces", value);
+            i++;
+        }
+        else if ((strcmp(argv[i], "--exposure") == 0) && (value != NULL))
+        {
+            settings.exposure = (float)atof(value);
+            i++;
+        }
+    }
+
+    // --ldr wins over a format given after it
+    for (int i = 1; i < argc; i++) if (strcmp(argv[i], "--ldr") == 0) settings.format = HDR_FORMAT_NONE;
+
+    return settings;
+}
+
+HdrTarget LoadHdrTarget(int width, int height, HdrSettings settings)
+{
+    HdrTarget hdr = { 0 };
+    hdr.settings = settings;
+
+    if (settings.format == HDR_FORMAT_NONE)
+    {
+        TraceLog(LOG_INFO, "HDR: No scene target, drawing straight to the frame (--ldr)");
+        return hdr;
+    }
+
+    bool packed = (settings.format == HDR_FORMAT_R11G11B10F);
+    int bytesPerPixel = packed? 4 : 8;
+
+    unsigned int color = 0;
+    glGenTextures(1, &color);
+    glBindTexture(GL_TEXTURE_2D, color);
+    if (packed) glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, width, height, 0, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV, NULL);
+    else glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, NULL);
+
+    // Read texel by texel, no filtering and no mipmaps
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Depth is sampled by the pass too, it tells the background from the scene
+    unsigned int depth = 0;
+    glGenTextures(1, &depth);
+    glBindTexture(GL_TEXTURE_2D, depth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    unsigned int fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // raylib has no packed float format, the closest three channel one stands in for it
+    hdr.target.id = fbo;
+    hdr.target.texture = (Texture2D){ color, width, height, 1, packed? PIXELFORMAT_UNCOMPRESSED_R16G16B16 : PIXELFORMAT_UNCOMPRESSED_R16G16B16A16 };
+    hdr.target.depth = (Texture2D){ depth, width, height, 1, 19 };         // Same format value LoadRenderTexture() gives its depth
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        TraceLog(LOG_WARNING, "HDR: [ID %i] Framebuffer incomplete (0x%x), drawing straight to the frame", fbo, status);
+        UnloadHdrTarget(hdr);
+        hdr = (HdrTarget){ 0 };
+        hdr.settings = settings;
+        hdr.settings.format = HDR_FORMAT_NONE;
+        return hdr;
+    }
+
+    hdr.shader = LoadShaderCached(HDR_TONEMAP_VERTEX_SHADER, HDR_TONEMAP_FRAGMENT_SHADER);
+    hdr.exposureLoc = GetShaderLocation(hdr.shader, "exposure");
+    hdr.toneMapperLoc = GetShaderLocation(hdr.shader, "toneMapper");
+    hdr.colorLoc = GetShaderLocation(hdr.shader, "hdrColor");
+    hdr.depthLoc = GetShaderLocation(hdr.shader, "hdrDepth");
+
+    // Lower bound of the extra traffic per frame, every pixel written once by the scene: the wider scene
+    // writes, then one read of the target and its depth and one RGBA8 write in the pass
+    double pixels = (double)width*height;
+    double extra = pixels*((bytesPerPixel - 4) + bytesPerPixel + 4 + 4);
+
+    TraceLog(LOG_INFO, "HDR: [ID %i] %ix%i %s scene target, %.1f MB, %s x%.2f, at least %.1f MB more traffic per frame than the back buffer",
+        fbo, width, height, hdrFormatNames[settings.format], pixels*bytesPerPixel/(1024.0*1024.0),
+        hdrToneMapperNames[settings.toneMapper], settings.exposure, extra/(1024.0*1024.0));
+
+    return hdr;
+}
+
+void UnloadHdrTarget(HdrTarget hdr)
+{
+    if (hdr.shader.id > 0) UnloadShader(hdr.shader);
+    if (hdr.target.texture.id > 0) glDeleteTextures(1, &hdr.target.texture.id);
+    if (hdr.target.depth.id > 0) glDeleteTextures(1, &hdr.target.depth.id);
+    if (hdr.target.id > 0) glDeleteFramebuffers(1, &hdr.target.id);
+}
+
+void BeginHdrMode(HdrTarget *hdr)
+{
+    if (hdr->target.id == 0) return;
+
+    // What the batch holds belongs to the previous target
+    rlDrawRenderBatchActive();
+
+    // The frame is the window or the headless target, either way the size of this one, so the
+    // viewport and the projection stay
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &hdr->previous);
+    rlEnableFramebuffer(hdr->target.id);
+}
+
+void EndHdrMode(HdrTarget *hdr)
+{
+    if (hdr->target.id == 0) return;
+
+    rlDrawRenderBatchActive();
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)hdr->previous);
+}
+
+void DrawHdrToneMap(const HdrTarget *hdr)
+{
+    DrawHdrToneMapViewport(hdr, 0, 0, hdr->target.texture.width, hdr->target.texture.height, hdr->settings.exposure);
+}
+
+void DrawHdrToneMapViewport(const HdrTarget *hdr, int x, int y, int width, int height, float exposure)
+{
+    if (hdr->target.id == 0) return;
+
+    // Whatever the batch holds goes first, it was drawn under the current state
+    rlDrawRenderBatchActive();
+    rlEnableShader(hdr->shader.id);
+
+    int colorUnit = 0;
+    int depthUnit = 1;
+    rlSetUniform(hdr->exposureLoc, &exposure, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(hdr->toneMapperLoc, &hdr->settings.toneMapper, SHADER_UNIFORM_INT, 1);
+    rlSetUniform(hdr->colorLoc, &colorUnit, SHADER_UNIFORM_INT, 1);
+    rlSetUniform(hdr->depthLoc, &depthUnit, SHADER_UNIFORM_INT, 1);
+
+    rlActiveTextureSlot(colorUnit);
+    rlEnableTexture(hdr->target.texture.id);
+    rlActiveTextureSlot(depthUnit);
+    rlEnableTexture(hdr->target.depth.id);
+
+    // The quad covers the viewport, the shader reads the texel under every pixel of it
+    rlViewport(x, y, width, height);
+
+    // Every pixel is replaced, nothing to blend with or test against
+    rlDisableColorBlend();
+    rlDisableDepthTest();
+    rlDisableBackfaceCulling();
+    rlLoadDrawQuad();
+    rlEnableBackfaceCulling();
+    rlEnableColorBlend();
+
+    rlViewport(0, 0, hdr->target.texture.width, hdr->target.texture.height);
+
+    rlDisableTexture();
+    rlActiveTextureSlot(colorUnit);
+    rlDisableTexture();
+    rlDisableShader();
+}
+
+#endif // HDR_TARGET_IMPLEMENTATION
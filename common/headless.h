@@ -0,0 +1,403 @@
+/**********************************************************************************************
+*
+*   headless - Offscreen render mode for the demos, selected from the command line
+*
+*   Single header module, define HEADLESS_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   Options, every demo accepts them:
+*
+*       --headless              Hidden window, frames go to an offscreen target, no frame rate cap
+*       --frames N              Frames to render before exiting (default 1)
+*       --size WxH              Offscreen resolution (default: the demo's window size)
+*       --output FILE           Written after the last frame, .raw is RGB8 rows top to bottom, any
+*                               other extension goes through ExportImage(). A %i style pattern in
+*                               the name writes every frame, e.g. out/frame_%04i.png
+*
+*       --bench                 Timed run, windowed or with --headless: no frame rate cap, the
+*                               camera follows a fixed orbit and the GUI is not read, so every
+*                               run draws the same frames. --frames is then the measured count
+*                               (default 600)
+*       --warmup N              Untimed frames before the measured ones (default 60), shaders and
+*                               caches settle there
+*       --sweep NAME            Slider moved from its minimum to its maximum over the measured
+*                               frames, named in each demo's header (e.g. roughness)
+*       --bench-output FILE     Result line appended to FILE as well
+*
+*   Other arguments are left to the demo, e.g. --cpu in the polygon shading demos
+*
+*   A bench run ends with one JSON line on stdout, the demo, its arguments, renderer, size, sweep
+*   and the frame rate with the mean, p50, p95, p99 and max frame time of the measured frames,
+*   kept next to earlier ones to track regressions. The arguments tell apart runs of one demo
+*   with different options (e.g. --ldr against --hdr-format r11g11b10f):
+*
+*       {"demo":"specular_cook_torrance","args":"--bench --ldr","renderer":"...","width":800,"height":800,
+*        "offscreen":false,"sweep":"roughness","warmup":60,"frames":600,"fps":412.5,"mean_ms":2.424,...}
+*
+*   A frame time is the time between the ends of two frames, the whole loop of the demo with
+*   the buffer swap. raylib leaves vsync off unless FLAG_VSYNC_HINT is set, which no demo does;
+*   a driver forcing it still caps the rate (vblank_mode=0 on Mesa, __GL_SYNC_TO_VBLANK=0 on
+*   NVIDIA turn it off)
+*
+*   Demos lay their text and sliders out with GetHeadlessScreenWidth()/GetHeadlessScreenHeight(), so
+*   they stay on the frame at any --size (and follow resizable windows)
+*
+*   Headless runs see no mouse input, so the camera and sliders keep their startup values and
+*   frame N of a run is always the same image. Demos load their sky in full before the first
+*   frame in this mode instead of streaming it
+*
+*   The window still needs a GL 3.3 context. On build machines without a GPU run the demos on
+*   Mesa's software rasterizer behind a virtual display:
+*
+*       LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a -s "-screen 0 1024x768x24" ./specular_cook_torrance --headless --output out.png
+*
+**********************************************************************************************/
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "raylib.h"
+
+typedef struct HeadlessRun {
+    bool enabled;               // --headless given, the rest only applies then
+    int width;                  // Window size, offscreen size in headless runs
+    int height;
+    int frameCount;
+    int frame;                  // Frames finished so far
+    const char *output;         // NULL for no output
+    RenderTexture2D target;
+    double startTime;
+
+    bool bench;                 // --bench given, frames are timed on a fixed camera orbit
+    int warmupFrames;           // Untimed frames before the frameCount measured ones
+    const char *sweep;          // Slider swept over the measured frames, NULL for none
+    const char *benchOutput;    // File the result line is appended to, NULL for stdout only
+    char name[64];              // Demo name in the results, the executable's
+    char args[256];             // Command line after the executable, in the results
+    float *frameTimes;          // Measured frames, milliseconds
+    double frameEnd;            // End of the previous frame
+} HeadlessRun;
+
+HeadlessRun ParseHeadlessArgs(int argc, char *argv[], int width, int height);   // Default size is the demo's window size
+void InitHeadlessWindow(HeadlessRun *run, const char *title);                  // InitWindow(), hidden with a target in headless runs
+bool HeadlessShouldClose(HeadlessRun *run);                                     // WindowShouldClose(), or all frames done
+void BeginHeadlessDrawing(HeadlessRun *run);                                    // BeginDrawing(), into the target in headless runs
+void EndHeadlessDrawing(HeadlessRun *run);                                      // EndDrawing(), writes the output in headless runs
+void UnloadHeadlessRun(HeadlessRun *run);                                       // Before CloseWindow()
+int GetHeadlessScreenWidth(const HeadlessRun *run);                             // Frame width to lay the GUI out on, the target's in headless runs
+int GetHeadlessScreenHeight(const HeadlessRun *run);                            // Frame height to lay the GUI out on, the target's in headless runs
+void UpdateHeadlessOrbit(const HeadlessRun *run, float *yaw, float *pitch);     // Bench runs: the orbit angles of the frame
+float GetHeadlessSweep(const HeadlessRun *run, const char *name, float value, float min, float max);   // Bench runs: the swept value of the frame
+
+#endif // HEADLESS_H
+
+#if defined(HEADLESS_IMPLEMENTATION) && !defined(HEADLESS_IMPLEMENTED)
+#define HEADLESS_IMPLEMENTED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, for the renderer name of the results
+
+#define HEADLESS_BENCH_FRAMES       600     // Measured frames of a bench run without --frames
+#define HEADLESS_BENCH_WARMUP       60
+
+HeadlessRun ParseHeadlessArgs(int argc, char *argv[], int width, int height)
+{
+    HeadlessRun run = { 0 };
+    run.width = width;
+    run.height = height;
+    run.frameCount = 1;
+    run.warmupFrames = HEADLESS_BENCH_WARMUP;
+    snprintf(run.name, sizeof(run.name), "%s", GetFileNameWithoutExt(argv[0]));
+    for (int i = 1, length = 0; (i < argc) && (length < (int)sizeof(run.args) - 1); i++)
+    {
+        int written = snprintf(run.args + length, sizeof(run.args) - length, (i > 1)? " %s" : "%s", argv[i]);
+        length += (written > 0)? written : 0;
+    }
+    bool framesGiven = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = (i + 1 < argc)? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--headless") == 0) run.enabled = true;
+        else if ((strcmp(argv[i], "--frames") == 0) && (value != NULL))
+        {
+            run.frameCount = atoi(value);
+            framesGiven = true;
+            i++;
+        }
+        else if ((strcmp(argv[i], "--size") == 0) && (value != NULL))
+        {
+            int w = 0, h = 0;
+            if ((sscanf(value, "%ix%i", &w, &h) == 2) && (w > 0) && (h > 0))
+            {
+                run.width = w;
+                run.height = h;
+            }
+            else TraceLog(LOG_WARNING, "HEADLESS: Invalid size [%s], expected WxH", value);
+            i++;
+        }
+        else if ((strcmp(argv[i], "--output") == 0) && (value != NULL))
+        {
+            run.output = value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--bench") == 0) run.bench = true;
+        else if ((strcmp(argv[i], "--warmup") == 0) && (value != NULL))
+        {
+            run.warmupFrames = atoi(value);
+            i++;
+        }
+        else if ((strcmp(argv[i], "--sweep") == 0) && (value != NULL))
+        {
+            run.sweep = value;
+            i++;
+        }
+        else if ((strcmp(argv[i], "--bench-output") == 0) && (value != NULL))
+        {
+            run.benchOutput = value;
+            i++;
+        }
+    }
+
+    if (run.bench && !framesGiven) run.frameCount = HEADLESS_BENCH_FRAMES;
+    if (run.frameCount < 1) run.frameCount = 1;
+    if (!run.bench || (run.warmupFrames < 0)) run.warmupFrames = 0;
+    if (run.bench) run.frameTimes = (float *)RL_CALLOC(run.frameCount, sizeof(float));
+
+    // Options only change headless runs, interactive ones keep the demo's window
+    if (!run.enabled)
+    {
+        run.width = width;
+        run.height = height;
+    }
+
+    return run;
+}
+
+void InitHeadlessWindow(HeadlessRun *run, const char *title)
+{
+    if (run->enabled) SetConfigFlags(FLAG_WINDOW_HIDDEN);
+
+    InitWindow(run->width, run->height, title);
+
+    if (run->enabled)
+    {
+        run->target = LoadRenderTexture(run->width, run->height);
+        TraceLog(LOG_INFO, "HEADLESS: Rendering %i frames at %ix%i offscreen", run->warmupFrames + run->frameCount, run->width, run->height);
+    }
+
+    if (run->bench) TraceLog(LOG_INFO, "HEADLESS: Bench run, %i warm-up and %i measured frames%s%s", run->warmupFrames, run->frameCount,
+        (run->sweep != NULL)? ", sweeping " : "", (run->sweep != NULL)? run->sweep : "");
+}
+
+static int CompareHeadlessFrameTimes(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Nearest rank percentile of sorted frame times
+static float GetHeadlessPercentile(const float *sorted, int count, float percentile)
+{
+    int rank = (int)(percentile/100.0f*count + 0.999f) - 1;
+
+    return sorted[(rank < 0)? 0 : (rank > count - 1)? count - 1 : rank];
+}
+
+// JSON string, the renderer name comes from the driver
+static void WriteHeadlessString(FILE *file, const char *text)
+{
+    fputc('"', file);
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        if ((*c == '"') || (*c == '\\')) fputc('\\', file);
+        if ((unsigned char)*c >= 0x20) fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+static void WriteHeadlessBenchResult(const HeadlessRun *run, FILE *file, const float *sorted, double mean)
+{
+    int count = run->frameCount;
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+
+    fprintf(file, "{\"demo\":");
+    WriteHeadlessString(file, run->name);
+    fprintf(file, ",\"args\":");
+    WriteHeadlessString(file, run->args);
+    fprintf(file, ",\"renderer\":");
+    WriteHeadlessString(file, (renderer != NULL)? renderer : "");
+    fprintf(file, ",\"width\":%i,\"height\":%i,\"offscreen\":%s,\"sweep\":", run->width, run->height, run->enabled? "true" : "false");
+    if (run->sweep != NULL) WriteHeadlessString(file, run->sweep);
+    else fprintf(file, "null");
+    fprintf(file, ",\"warmup\":%i,\"frames\":%i,\"time\":%lld,\"fps\":%.2f,\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p95_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f}\n",
+        run->warmupFrames, count, (long long)time(NULL), (mean > 0.0)? 1000.0/mean : 0.0, mean,
+        GetHeadlessPercentile(sorted, count, 50.0f), GetHeadlessPercentile(sorted, count, 95.0f), GetHeadlessPercentile(sorted, count, 99.0f), sorted[count - 1]);
+}
+
+// Frame rate and percentiles of the measured frames, on stdout and appended to --bench-output
+static void ReportHeadlessBench(const HeadlessRun *run)
+{
+    int count = run->frameCount;
+    float *sorted = (float *)RL_MALLOC(count*sizeof(float));
+    memcpy(sorted, run->frameTimes, count*sizeof(float));
+    qsort(sorted, count, sizeof(float), CompareHeadlessFrameTimes);
+
+    double total = 0.0;
+    for (int i = 0; i < count; i++) total += sorted[i];
+    double mean = total/count;
+
+    TraceLog(LOG_INFO, "HEADLESS: Bench %.1f frames/s, frame time mean %.3f ms, p50 %.3f p95 %.3f p99 %.3f ms", 1000.0/mean, mean,
+        GetHeadlessPercentile(sorted, count, 50.0f), GetHeadlessPercentile(sorted, count, 95.0f), GetHeadlessPercentile(sorted, count, 99.0f));
+
+    WriteHeadlessBenchResult(run, stdout, sorted, mean);
+    fflush(stdout);
+
+    if (run->benchOutput != NULL)
+    {
+        FILE *file = fopen(run->benchOutput, "a");
+        if (file != NULL)
+        {
+            WriteHeadlessBenchResult(run, file, sorted, mean);
+            fclose(file);
+        }
+        else TraceLog(LOG_WARNING, "HEADLESS: [%s] Failed to append the bench result", run->benchOutput);
+    }
+
+    RL_FREE(sorted);
+}
+
+bool HeadlessShouldClose(HeadlessRun *run)
+{
+    if (!run->enabled && !run->bench) return WindowShouldClose();
+
+    int lastFrame = run->warmupFrames + run->frameCount;
+
+    if (run->frame == 0)
+    {
+        run->startTime = GetTime();
+        run->frameEnd = run->startTime;
+    }
+    else if (run->frame == lastFrame)
+    {
+        double time = GetTime() - run->startTime;
+        TraceLog(LOG_INFO, "HEADLESS: %i frames in %.2f ms (%.3f ms per frame)", run->frame, time*1000.0, time*1000.0/run->frame);
+
+        if (run->bench) ReportHeadlessBench(run);
+    }
+
+    // A closed window ends a windowed bench run early, without results
+    if (!run->enabled && WindowShouldClose()) return true;
+
+    return (run->frame >= lastFrame);
+}
+
+void BeginHeadlessDrawing(HeadlessRun *run)
+{
+    BeginDrawing();
+
+    if (run->enabled) BeginTextureMode(run->target);
+}
+
+// Read back the target and write it, GL rows are bottom to top
+static void HeadlessWriteFrame(const HeadlessRun *run, const char *fileName)
+{
+    Image image = LoadImageFromTexture(run->target.texture);
+    ImageFlipVertical(&image);
+
+    // Alpha holds whatever the blended shaders left there, the demos are opaque
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+
+    bool success = false;
+    if (IsFileExtension(fileName, ".raw")) success = SaveFileData(fileName, image.data, image.width*image.height*3);
+    else success = ExportImage(image, fileName);
+
+    if (!success) TraceLog(LOG_WARNING, "HEADLESS: [%s] Failed to write frame %i", fileName, run->frame - 1);
+
+    UnloadImage(image);
+}
+
+void EndHeadlessDrawing(HeadlessRun *run)
+{
+    if (run->enabled)
+    {
+        EndTextureMode();
+        run->frame++;
+
+        if (run->output != NULL)
+        {
+            bool sequence = (strchr(run->output, '%') != NULL);
+
+            if (sequence) HeadlessWriteFrame(run, TextFormat(run->output, run->frame - 1));
+            else if (run->frame == run->warmupFrames + run->frameCount) HeadlessWriteFrame(run, run->output);
+        }
+    }
+
+    EndDrawing();
+
+    if (run->bench)
+    {
+        if (!run->enabled) run->frame++;
+
+        // Whole frames, end to end: the first measured one starts where the last warm-up one ended
+        double now = GetTime();
+        int measured = run->frame - run->warmupFrames - 1;
+        if ((measured >= 0) && (measured < run->frameCount)) run->frameTimes[measured] = (float)((now - run->frameEnd)*1000.0);
+        run->frameEnd = now;
+    }
+}
+
+void UnloadHeadlessRun(HeadlessRun *run)
+{
+    if (run->enabled) UnloadRenderTexture(run->target);
+
+    RL_FREE(run->frameTimes);
+    run->frameTimes = NULL;
+}
+
+// NOTE: The platform may clamp a hidden window to the display, the target always has the --size asked for
+int GetHeadlessScreenWidth(const HeadlessRun *run)
+{
+    return run->enabled? run->width : GetScreenWidth();
+}
+
+int GetHeadlessScreenHeight(const HeadlessRun *run)
+{
+    return run->enabled? run->height : GetScreenHeight();
+}
+
+// Progress through the measured frames, 0 over the warm-up
+static float GetHeadlessBenchProgress(const HeadlessRun *run)
+{
+    int measured = run->frame - run->warmupFrames;
+    if ((measured <= 0) || (run->frameCount < 2)) return 0.0f;
+
+    return (measured >= run->frameCount - 1)? 1.0f : (float)measured/(run->frameCount - 1);
+}
+
+void UpdateHeadlessOrbit(const HeadlessRun *run, float *yaw, float *pitch)
+{
+    if (!run->bench) return;
+
+    // One turn around the model over the measured frames, rising and falling once to see it from above and below
+    float t = GetHeadlessBenchProgress(run);
+    *yaw = 2.0f*PI*t;
+    *pitch = 0.4f*sinf(2.0f*PI*t);
+}
+
+float GetHeadlessSweep(const HeadlessRun *run, const char *name, float value, float min, float max)
+{
+    if (!run->bench || (run->sweep == NULL) || (strcmp(run->sweep, name) != 0)) return value;
+
+    return min + (max - min)*GetHeadlessBenchProgress(run);
+}
+
+#endif // HEADLESS_IMPLEMENTATION
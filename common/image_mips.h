@@ -0,0 +1,399 @@
+/**********************************************************************************************
+*
+*   image_mips - Gamma-correct, multithreaded mip chain generator for 8 bit images
+*
+*   Single header module, define IMAGE_MIPS_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   Drop-in replacement for raylib ImageMipmaps() on RGB8/RGBA8 images, which resizes the
+*   sRGB bytes directly (darkening every level) on a single thread. Here:
+*
+*       - texels are decoded to linear light, filtered, and re-encoded to sRGB per level
+*         (alpha is filtered as plain linear coverage)
+*       - the filter is the separable [1 3 3 1]/8 tent (a bilinear 2x reduction), which
+*         reads one texel past each side of the 2x2 footprint
+*       - IMAGE_MIPS_WRAP_X wraps those reads horizontally, for equirect panoramas whose left
+*         and right edges meet at the u seam; rows always clamp (the poles)
+*       - rows of a level are filtered in parallel while the previous level is being encoded,
+*         so every ParallelFor() call covers two levels
+*       - the float passes use AVX2 or SSE2 when the compiler targets them (-mavx2 / -msse2),
+*         with a scalar fallback
+*
+*   Level sizes follow ImageMipmaps() and GL: floor(size/2), down to 1x1
+*
+**********************************************************************************************/
+
+#ifndef IMAGE_MIPS_H
+#define IMAGE_MIPS_H
+
+#include "raylib.h"
+
+#define IMAGE_MIPS_WRAP_X   1       // Wrap horizontally (equirect panoramas), clamp otherwise
+
+void ImageMipmapsLinear(Image *image, int flags);      // Generate all mipmap levels in linear light, RGB8 and RGBA8 only
+
+#endif // IMAGE_MIPS_H
+
+#if defined(IMAGE_MIPS_IMPLEMENTATION) && !defined(IMAGE_MIPS_IMPLEMENTED)
+#define IMAGE_MIPS_IMPLEMENTED
+
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define IMAGE_MIPS_BACKEND "AVX2"
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+    #define IMAGE_MIPS_BACKEND "SSE2"
+#else
+    #define IMAGE_MIPS_BACKEND "scalar"
+#endif
+
+#define ENV_MAP_IMPLEMENTATION
+#include "env_map.h"                // SRGBToLinear(), LinearToSRGBFloat(), ParallelFor()
+
+#define IMAGE_MIPS_BUCKETS      4096    // sqrt(linear) buckets of the encode table, adjacent sRGB codes never share one
+#define IMAGE_MIPS_SERIAL_SIZE  4096    // Levels below this many texels finish the chain on the calling thread
+#define IMAGE_MIPS_BAND_ROWS    8       // Output rows per filter task
+
+// Float levels are RGBA (alpha 1 for RGB sources), one texel per SSE register
+typedef struct MipsLevel {
+    int width;
+    int height;
+    float *data;
+} MipsLevel;
+
+typedef struct MipsJob {
+    const unsigned char *srcPixels;     // Level 0 bytes, NULL when src is a float level
+    int channels;
+    int flags;
+    MipsLevel src;
+    MipsLevel dst;
+
+    MipsLevel encodeLevel;              // Float level encoded to bytes alongside the filtering, height 0 when none
+    unsigned char *encodePixels;
+} MipsJob;
+
+static unsigned char mipsBucketCode[IMAGE_MIPS_BUCKETS];
+static float mipsCodeStart[257];        // Lowest linear value encoding to each code, [256] = +inf
+static int mipsTablesReady = 0;
+
+static void MipsInitTables(void)
+{
+    if (mipsTablesReady) return;
+
+    SRGBToLinear(0);        // Build the decode table before the workers race on it
+
+    // Code k covers sRGB values from (k - 0.5)/255, same rounding as LinearToSRGB()
+    mipsCodeStart[0] = -1.0f;
+    for (int k = 1; k < 256; k++)
+    {
+        float s = (k - 0.5f)/255.0f;
+        mipsCodeStart[k] = (s <= 0.04045f)? s/12.92f : powf((s + 0.055f)/1.055f, 2.4f);
+    }
+    mipsCodeStart[256] = 2.0f;
+
+    int code = 0;
+    for (int i = 0; i < IMAGE_MIPS_BUCKETS; i++)
+    {
+        float t = (float)i/(IMAGE_MIPS_BUCKETS - 1);
+        while (mipsCodeStart[code + 1] <= t*t) code++;
+        mipsBucketCode[i] = (unsigned char)code;
+    }
+
+    mipsTablesReady = 1;
+}
+
+// Table lookup plus at most one boundary test per texel instead of a powf()
+static inline unsigned char MipsEncodeSRGB(float value)
+{
+    if (!(value > 0.0f)) return 0;
+    if (value >= 1.0f) return 255;
+
+    int code = mipsBucketCode[(int)(sqrtf(value)*(IMAGE_MIPS_BUCKETS - 1))];
+    while (value >= mipsCodeStart[code + 1]) code++;
+
+    return (unsigned char)code;
+}
+
+static inline int MipsWrap(int x, int width, int flags)
+{
+    if (flags & IMAGE_MIPS_WRAP_X) return ((x % width) + width) % width;
+
+    return (x < 0)? 0 : ((x >= width)? width - 1 : x);
+}
+
+// Vertical [1 3 3 1] over four float rows, unnormalized
+static void MipsVerticalFloat(const float *r0, const float *r1, const float *r2, const float *r3, float *out, int count)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    const __m256 three = _mm256_set1_ps(3.0f);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 outer = _mm256_add_ps(_mm256_loadu_ps(r0 + i), _mm256_loadu_ps(r3 + i));
+        __m256 inner = _mm256_add_ps(_mm256_loadu_ps(r1 + i), _mm256_loadu_ps(r2 + i));
+        _mm256_storeu_ps(out + i, _mm256_add_ps(outer, _mm256_mul_ps(inner, three)));
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128 three4 = _mm_set1_ps(3.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 outer = _mm_add_ps(_mm_loadu_ps(r0 + i), _mm_loadu_ps(r3 + i));
+        __m128 inner = _mm_add_ps(_mm_loadu_ps(r1 + i), _mm_loadu_ps(r2 + i));
+        _mm_storeu_ps(out + i, _mm_add_ps(outer, _mm_mul_ps(inner, three4)));
+    }
+#endif
+
+    for (; i < count; i++) out[i] = r0[i] + r3[i] + 3.0f*(r1[i] + r2[i]);
+}
+
+// Level 0 row to linear RGBA floats through the sRGB table (a gather, so scalar)
+static void MipsDecodeRow(const unsigned char *row, int channels, float *out, int width)
+{
+    const float *table = envSRGBTable;         // Filled by MipsInitTables(), read directly to skip the per call ready check
+
+    for (int x = 0; x < width; x++)
+    {
+        const unsigned char *texel = row + x*channels;
+        out[x*4 + 0] = table[texel[0]];
+        out[x*4 + 1] = table[texel[1]];
+        out[x*4 + 2] = table[texel[2]];
+        out[x*4 + 3] = (channels == 4)? texel[3]/255.0f : 1.0f;
+    }
+}
+
+// Horizontal [1 3 3 1] of a vertically filtered row, normalized by 1/64 for both passes
+static void MipsHorizontal(const float *row, int width, float *out, int dstWidth, int flags)
+{
+    const float norm = 1.0f/64.0f;
+
+    // Taps 2x - 1 .. 2x + 2 are in range for every x in [first, last)
+    int first = (dstWidth > 1)? 1 : dstWidth;
+    int last = (width - 1)/2;
+    if (last < first) last = first;
+    if (last > dstWidth) last = dstWidth;
+
+    for (int x = 0; x < dstWidth; x++)
+    {
+        if (x == first) x = last;           // Interior is done below without index wrapping
+        if (x >= dstWidth) break;
+
+        const float *t0 = row + MipsWrap(2*x - 1, width, flags)*4;
+        const float *t1 = row + MipsWrap(2*x, width, flags)*4;
+        const float *t2 = row + MipsWrap(2*x + 1, width, flags)*4;
+        const float *t3 = row + MipsWrap(2*x + 2, width, flags)*4;
+
+        for (int c = 0; c < 4; c++) out[x*4 + c] = (t0[c] + t3[c] + 3.0f*(t1[c] + t2[c]))*norm;
+    }
+
+    int x = first;
+
+#if defined(__AVX2__)
+    // Two output texels per iteration: P = [2x-1 | 2x+1], Q = [2x | 2x+2], R = [2x+1 | 2x+3], S = [2x+2 | 2x+4]
+    const __m256 three = _mm256_set1_ps(3.0f);
+    const __m256 norm8 = _mm256_set1_ps(norm);
+    for (; x + 2 <= last; x += 2)
+    {
+        const float *base = row + (size_t)(2*x - 1)*4;
+        __m256 a = _mm256_loadu_ps(base);
+        __m256 b = _mm256_loadu_ps(base + 8);
+        __m256 c = _mm256_loadu_ps(base + 16);
+
+        __m256 p = _mm256_permute2f128_ps(a, b, 0x20);
+        __m256 q = _mm256_permute2f128_ps(a, b, 0x31);
+        __m256 r = _mm256_permute2f128_ps(b, c, 0x20);
+        __m256 s = _mm256_permute2f128_ps(b, c, 0x31);
+
+        __m256 sum = _mm256_add_ps(_mm256_add_ps(p, s), _mm256_mul_ps(_mm256_add_ps(q, r), three));
+        _mm256_storeu_ps(out + (size_t)x*4, _mm256_mul_ps(sum, norm8));
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128 three4 = _mm_set1_ps(3.0f);
+    const __m128 norm4 = _mm_set1_ps(norm);
+    for (; x < last; x++)
+    {
+        const float *base = row + (size_t)(2*x - 1)*4;
+        __m128 outer = _mm_add_ps(_mm_loadu_ps(base), _mm_loadu_ps(base + 12));
+        __m128 inner = _mm_add_ps(_mm_loadu_ps(base + 4), _mm_loadu_ps(base + 8));
+        _mm_storeu_ps(out + (size_t)x*4, _mm_mul_ps(_mm_add_ps(outer, _mm_mul_ps(inner, three4)), norm4));
+    }
+#endif
+
+    for (; x < last; x++)
+    {
+        const float *t = row + (size_t)(2*x - 1)*4;
+        for (int c = 0; c < 4; c++) out[x*4 + c] = (t[c] + t[12 + c] + 3.0f*(t[4 + c] + t[8 + c]))*norm;
+    }
+}
+
+static inline int MipsClampRow(int y, int height)
+{
+    return (y < 0)? 0 : ((y >= height)? height - 1 : y);
+}
+
+// Rows [band*IMAGE_MIPS_BAND_ROWS, +IMAGE_MIPS_BAND_ROWS) of the next level, source rows shared
+// by neighbouring output rows are decoded once per band
+static void MipsFilterBand(MipsJob *job, int band)
+{
+    const int width = job->src.width;
+    const size_t rowSize = (size_t)width*4;
+    const int y0 = band*IMAGE_MIPS_BAND_ROWS;
+    const int y1 = (y0 + IMAGE_MIPS_BAND_ROWS < job->dst.height)? y0 + IMAGE_MIPS_BAND_ROWS : job->dst.height;
+
+    // Decoded source rows (level 0 only) followed by the vertically filtered row
+    const int firstRow = MipsClampRow(2*y0 - 1, job->src.height);
+    const int lastRow = MipsClampRow(2*y1, job->src.height);
+    const int decodedCount = (job->srcPixels != NULL)? lastRow - firstRow + 1 : 0;
+    float *scratch = (float *)RL_MALLOC(((size_t)decodedCount + 1)*rowSize*sizeof(float));
+    float *filtered = scratch + (size_t)decodedCount*rowSize;
+
+    for (int i = 0; i < decodedCount; i++)
+    {
+        MipsDecodeRow(job->srcPixels + (size_t)(firstRow + i)*width*job->channels, job->channels, scratch + (size_t)i*rowSize, width);
+    }
+
+    const float *rows = (job->srcPixels != NULL)? scratch : job->src.data;
+    const int rowBase = (job->srcPixels != NULL)? firstRow : 0;
+
+    for (int y = y0; y < y1; y++)
+    {
+        const float *taps[4];
+        for (int j = 0; j < 4; j++) taps[j] = rows + (size_t)(MipsClampRow(2*y - 1 + j, job->src.height) - rowBase)*rowSize;
+
+        MipsVerticalFloat(taps[0], taps[1], taps[2], taps[3], filtered, (int)rowSize);
+        MipsHorizontal(filtered, width, job->dst.data + (size_t)y*job->dst.width*4, job->dst.width, job->flags);
+    }
+
+    RL_FREE(scratch);
+}
+
+static void MipsEncodeRow(MipsJob *job, int y)
+{
+    const MipsLevel level = job->encodeLevel;
+    const float *src = level.data + (size_t)y*level.width*4;
+    unsigned char *dst = job->encodePixels + (size_t)y*level.width*job->channels;
+
+    for (int x = 0; x < level.width; x++)
+    {
+        for (int c = 0; c < 3; c++) dst[x*job->channels + c] = MipsEncodeSRGB(src[x*4 + c]);
+        if (job->channels == 4)
+        {
+            float alpha = src[x*4 + 3];
+            dst[x*4 + 3] = (alpha <= 0.0f)? 0 : ((alpha >= 1.0f)? 255 : (unsigned char)(alpha*255.0f + 0.5f));
+        }
+    }
+}
+
+static int GetMipsBandCount(const MipsJob *job)
+{
+    return (job->dst.height + IMAGE_MIPS_BAND_ROWS - 1)/IMAGE_MIPS_BAND_ROWS;
+}
+
+// The first indices filter a band of the next level, the rest encode a row of the previous one
+static void MipsTask(int index, void *userData)
+{
+    MipsJob *job = (MipsJob *)userData;
+    int bandCount = GetMipsBandCount(job);
+
+    if (index < bandCount) MipsFilterBand(job, index);
+    else MipsEncodeRow(job, index - bandCount);
+}
+
+static void MipsRun(MipsJob *job, bool parallel)
+{
+    int count = GetMipsBandCount(job) + job->encodeLevel.height;
+
+    if (parallel) ParallelFor(count, MipsTask, job);
+    else for (int i = 0; i < count; i++) MipsTask(i, job);
+}
+
+void ImageMipmapsLinear(Image *image, int flags)
+{
+    if ((image->data == NULL) || (image->width <= 0) || (image->height <= 0)) return;
+
+    if (image->mipmaps > 1)
+    {
+        TraceLog(LOG_WARNING, "MIPS: Image mipmaps already available");
+        return;
+    }
+
+    if ((image->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8) && (image->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8))
+    {
+        TraceLog(LOG_WARNING, "MIPS: Pixel format not supported, falling back to ImageMipmaps()");
+        ImageMipmaps(image);
+        return;
+    }
+
+    MipsInitTables();
+
+    const int channels = (image->format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)? 4 : 3;
+
+    // Same level count and layout as ImageMipmaps(): levels packed back to back after level 0
+    int mipCount = 1;
+    size_t totalSize = (size_t)image->width*image->height*channels;
+    for (int w = image->width, h = image->height; (w > 1) || (h > 1); mipCount++)
+    {
+        w = (w > 1)? w/2 : 1;
+        h = (h > 1)? h/2 : 1;
+        totalSize += (size_t)w*h*channels;
+    }
+
+    if (mipCount == 1) return;
+
+    unsigned char *pixels = (unsigned char *)RL_REALLOC(image->data, totalSize);
+    if (pixels == NULL)
+    {
+        TraceLog(LOG_WARNING, "MIPS: Failed to allocate mipmap levels");
+        return;
+    }
+    image->data = pixels;
+
+    // Two float levels are alive at a time (the one being read and the one being written)
+    const int width1 = (image->width > 1)? image->width/2 : 1;
+    const int height1 = (image->height > 1)? image->height/2 : 1;
+    float *buffers[2];
+    buffers[0] = (float *)RL_MALLOC((size_t)width1*height1*4*sizeof(float));
+    buffers[1] = (float *)RL_MALLOC((size_t)((width1 > 1)? width1/2 : 1)*((height1 > 1)? height1/2 : 1)*4*sizeof(float));
+
+    MipsJob job = { 0 };
+    job.srcPixels = pixels;
+    job.channels = channels;
+    job.flags = flags;
+    job.src = (MipsLevel){ image->width, image->height, NULL };
+
+    unsigned char *levelPixels = pixels + (size_t)image->width*image->height*channels;
+
+    for (int level = 1; level <= mipCount; level++)
+    {
+        // Past the last level only the encode of the previous one is left
+        if (level < mipCount)
+        {
+            job.dst.width = (job.src.width > 1)? job.src.width/2 : 1;
+            job.dst.height = (job.src.height > 1)? job.src.height/2 : 1;
+            job.dst.data = buffers[(level - 1)%2];
+        }
+        else job.dst.height = 0;
+
+        MipsRun(&job, (job.src.width*job.src.height >= IMAGE_MIPS_SERIAL_SIZE));
+
+        if (job.encodeLevel.height > 0) levelPixels += (size_t)job.encodeLevel.width*job.encodeLevel.height*channels;
+
+        // The level just written is read and encoded on the next round
+        job.srcPixels = NULL;
+        job.src = job.dst;
+        job.encodeLevel = job.dst;
+        job.encodePixels = levelPixels;
+    }
+
+    RL_FREE(buffers[0]);
+    RL_FREE(buffers[1]);
+
+    image->mipmaps = mipCount;
+}
+
+#endif // IMAGE_MIPS_IMPLEMENTATION
@@ -0,0 +1,484 @@
+/**********************************************************************************************
+*
+*   light_clusters - Clustered forward lighting, point lights binned into a froxel grid
+*
+*   Single header module, define LIGHT_CLUSTERS_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   The view frustum is cut into LIGHT_CLUSTERS_X x LIGHT_CLUSTERS_Y screen tiles and
+*   LIGHT_CLUSTERS_Z depth slices. Slices are spaced exponentially between LIGHT_CLUSTERS_NEAR
+*   and LIGHT_CLUSTERS_FAR, so every froxel is about as deep as it is wide, the first one starts
+*   at the camera and the last one runs on to the far plane. Perspective cameras only.
+*   BuildLightClusters() bins the lights on the CPU every frame:
+*
+*       1. Every light's sphere is moved to view space and bounded by a range of slices and
+*          tiles (the screen rectangle of its projected bounding box)
+*       2. The slices are binned on the worker pool of common/parallel.h (a wake up per build,
+*          no thread is created), each one tests the lights of its range against the view space
+*          box of every tile they cover and counting sorts the hits by tile, so no slice ever
+*          writes into another one's lists. Below LIGHT_CLUSTERS_PARALLEL_LIGHTS visible lights
+*          the calling thread bins them alone, tools/cluster_bench times both paths
+*       3. The slices are stitched into one index list, every cluster gets its first index
+*          and its light count
+*
+*   UploadLightClusters() sends the lights, the cluster ranges and the index list to three
+*   buffer textures (GL 3.3 has no SSBO) and binds them to LIGHT_CLUSTERS_TEXTURE_UNIT and
+*   the two units after it. The shaders find their cluster from gl_FragCoord and the view
+*   depth of the fragment and loop over its lights only:
+*
+*       uniform samplerBuffer clusterLights;    // 2 texels per light: position, radius / color
+*       uniform usamplerBuffer clusterGrid;     // Per cluster: first index, light count
+*       uniform usamplerBuffer clusterIndices;  // Light indices grouped by cluster
+*       uniform vec4 clusterViewDepth;          // View depth = dot(clusterViewDepth, vec4(position, 1))
+*       uniform vec4 clusterScale;              // Tiles per pixel (xy), slice = log(depth)*z + w
+*       uniform vec2 clusterOrigin;             // Lower left pixel of the viewport, 0 on a full target
+*
+*   SetShaderLightClusters() points a program at the units and sets the three vectors, it goes
+*   after every build since they follow the camera. A build covers width x height pixels from
+*   origin, so viewports of one size that share the camera (the shading lab's compare grid)
+*   share a build and only move the origin between their draws
+*
+*   Lights fade out with a windowed inverse square falloff that reaches 0 at their radius, so
+*   the binning can drop them outside it without a visible edge
+*
+**********************************************************************************************/
+
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include "raylib.h"
+
+#define LIGHT_CLUSTERS_X                16
+#define LIGHT_CLUSTERS_Y                16
+#define LIGHT_CLUSTERS_Z                24
+#define LIGHT_CLUSTERS_COUNT            (LIGHT_CLUSTERS_X*LIGHT_CLUSTERS_Y*LIGHT_CLUSTERS_Z)
+
+#define LIGHT_CLUSTERS_NEAR             0.1f        // The first slice covers everything closer
+#define LIGHT_CLUSTERS_FAR              100.0f      // The last slice covers everything further
+#define LIGHT_CLUSTERS_MAX_LIGHTS       65536       // Indices are 16 bit
+#define LIGHT_CLUSTERS_TEXTURE_UNIT     13          // Lights, then the grid and the indices, raylib uses the low units
+
+// Point light, two RGBA32F texels in the light buffer
+typedef struct ClusterLight {
+    Vector3 position;           // World space
+    float radius;               // Range, the falloff reaches 0 here
+    Vector3 color;              // Intensity folded in
+    float padding;
+} ClusterLight;
+
+// Lights of one depth slice, grouped by tile, filled by the slice's own task
+typedef struct LightClusterSlice {
+    unsigned int *pairs;        // Light index in the low 16 bits, tile in the high ones
+    unsigned short *indices;
+    int count;
+    int capacity;
+    unsigned int tileStart[LIGHT_CLUSTERS_X*LIGHT_CLUSTERS_Y + 1];
+} LightClusterSlice;
+
+typedef struct LightClusters {
+    int width;                  // Render target size of the last build
+    int height;
+    Vector4 viewDepth;          // Shader constants of the last build
+    Vector4 scale;
+    Vector2 origin;             // Lower left pixel of the viewport in the target, set by the caller
+
+    int lightCount;
+    int indexCount;             // Light references over all clusters
+    const ClusterLight *lights; // Caller's array, read until the upload
+    unsigned int *grid;         // First index and light count of every cluster
+    unsigned short *indices;
+    int indexCapacity;
+
+    void *bounds;               // View space bounds of every light, scratch of the build
+    int boundsCapacity;
+    LightClusterSlice slices[LIGHT_CLUSTERS_Z];
+
+    unsigned int buffers[3];    // Lights, grid, indices
+    unsigned int textures[3];
+    double buildTime;           // Seconds spent in the last BuildLightClusters()
+} LightClusters;
+
+LightClusters LoadLightClusters(void);                                                  // Buffer textures, a zeroed struct builds fine without them
+void UnloadLightClusters(LightClusters *clusters);
+void BuildLightClusters(LightClusters *clusters, const ClusterLight *lights, int count, Camera camera, int width, int height); // Bin the lights, CPU only
+void UploadLightClusters(LightClusters *clusters);                                      // Send the last build and bind the buffer textures
+void SetShaderLightClusters(Shader shader, const LightClusters *clusters);              // Texture units and the view constants of the last build
+void AnimateClusterLights(ClusterLight *lights, int count, float time);                 // Colored lights orbiting the origin, the demos' light field
+
+#endif // LIGHT_CLUSTERS_H
+
+#if defined(LIGHT_CLUSTERS_IMPLEMENTATION) && !defined(LIGHT_CLUSTERS_IMPLEMENTED)
+#define LIGHT_CLUSTERS_IMPLEMENTED
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raymath.h"
+#include "rlgl.h"               // RL_CULL_DISTANCE_FAR, the far plane BeginMode3D() uses
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, rlgl has no buffer textures
+
+#define PARALLEL_IMPLEMENTATION
+#include "parallel.h"
+
+#define LIGHT_CLUSTERS_TILES            (LIGHT_CLUSTERS_X*LIGHT_CLUSTERS_Y)
+#ifndef LIGHT_CLUSTERS_PARALLEL_LIGHTS
+    #define LIGHT_CLUSTERS_PARALLEL_LIGHTS 64       // Fewer visible lights are binned on the calling thread
+#endif
+
+
+// Light bounds in view space, depth grows away from the camera
+typedef struct LightClusterBounds {
+    float x, y, depth, radius;
+    int light;                  // Index in the caller's array
+    int slice0, slice1;
+    int tileX0, tileX1, tileY0, tileY1;
+} LightClusterBounds;
+
+// Shared by the slice tasks, read only
+typedef struct LightClusterJob {
+    LightClusters *clusters;
+    const LightClusterBounds *bounds;
+    int boundsCount;
+    float tanX, tanY;           // Half extents of the frustum at depth 1
+} LightClusterJob;
+
+// Slices per unit of log depth, the shader gets it in clusterScale.z
+static float GetSliceScale(void)
+{
+    return LIGHT_CLUSTERS_Z/logf(LIGHT_CLUSTERS_FAR/LIGHT_CLUSTERS_NEAR);
+}
+
+// Slice of a view depth, the shader does the same with clusterScale.zw
+static int GetDepthSlice(float depth)
+{
+    if (depth <= LIGHT_CLUSTERS_NEAR) return 0;
+
+    int slice = (int)floorf(logf(depth/LIGHT_CLUSTERS_NEAR)*GetSliceScale());
+
+    return (slice < LIGHT_CLUSTERS_Z)? slice : LIGHT_CLUSTERS_Z - 1;
+}
+
+// Depth where a slice starts, slice LIGHT_CLUSTERS_Z is where the last one ends
+static float GetSliceDepth(int slice)
+{
+    if (slice <= 0) return 0.0f;
+    if (slice >= LIGHT_CLUSTERS_Z) return RL_CULL_DISTANCE_FAR;
+
+    return LIGHT_CLUSTERS_NEAR*expf(slice/GetSliceScale());
+}
+
+// Tile under a normalized device coordinate, clamped to the screen
+static int GetNdcTile(float ndc, int tiles)
+{
+    int tile = (int)floorf((ndc*0.5f + 0.5f)*tiles);
+
+    return (tile < 0)? 0 : ((tile >= tiles)? tiles - 1 : tile);
+}
+
+// Bounds of one light, false when it can not touch the frustum
+static bool GetLightClusterBounds(const ClusterLight *light, Matrix view, float tanX, float tanY, LightClusterBounds *bounds)
+{
+    Vector3 center = Vector3Transform(light->position, view);
+    float r = light->radius;
+
+    bounds->x = center.x;
+    bounds->y = center.y;
+    bounds->depth = -center.z;
+    bounds->radius = r;
+
+    float minDepth = bounds->depth - r;
+    float maxDepth = bounds->depth + r;
+
+    if ((r <= 0.0f) || (maxDepth <= 0.0f) || (minDepth >= RL_CULL_DISTANCE_FAR)) return false;
+
+    bounds->slice0 = GetDepthSlice(minDepth);
+    bounds->slice1 = GetDepthSlice(maxDepth);
+
+    // The sphere reaches the camera plane, its projection is unbounded
+    if (minDepth <= LIGHT_CLUSTERS_NEAR)
+    {
+        bounds->tileX0 = 0;
+        bounds->tileX1 = LIGHT_CLUSTERS_X - 1;
+        bounds->tileY0 = 0;
+        bounds->tileY1 = LIGHT_CLUSTERS_Y - 1;
+
+        return true;
+    }
+
+    // Projected bounding box, every side is widest at the near or the far depth of the sphere
+    float left = (center.x - r)/(((center.x - r) < 0.0f)? minDepth : maxDepth)/tanX;
+    float right = (center.x + r)/(((center.x + r) > 0.0f)? minDepth : maxDepth)/tanX;
+    float bottom = (center.y - r)/(((center.y - r) < 0.0f)? minDepth : maxDepth)/tanY;
+    float top = (center.y + r)/(((center.y + r) > 0.0f)? minDepth : maxDepth)/tanY;
+
+    if ((left > 1.0f) || (right < -1.0f) || (bottom > 1.0f) || (top < -1.0f)) return false;
+
+    bounds->tileX0 = GetNdcTile(left, LIGHT_CLUSTERS_X);
+    bounds->tileX1 = GetNdcTile(right, LIGHT_CLUSTERS_X);
+    bounds->tileY0 = GetNdcTile(bottom, LIGHT_CLUSTERS_Y);
+    bounds->tileY1 = GetNdcTile(top, LIGHT_CLUSTERS_Y);
+
+    return true;
+}
+
+// Squared distance from v to [min, max], 0 inside
+static float GetRangeDistance2(float v, float min, float max)
+{
+    float d = (v < min)? min - v : ((v > max)? v - max : 0.0f);
+
+    return d*d;
+}
+
+// Side of the froxel box at both ends of the slice, edge is the tile edge at depth 1
+static float GetFroxelDistance2(float v, float edge0, float edge1, float nearDepth, float farDepth)
+{
+    return GetRangeDistance2(v, fminf(edge0*nearDepth, edge0*farDepth), fmaxf(edge1*nearDepth, edge1*farDepth));
+}
+
+// Lights of one slice, tested against every tile they cover, then counting sorted by tile
+static void BinLightClusterSlice(int slice, void *userData)
+{
+    const LightClusterJob *job = (const LightClusterJob *)userData;
+    LightClusterSlice *output = &job->clusters->slices[slice];
+
+    float nearDepth = GetSliceDepth(slice);
+    float farDepth = GetSliceDepth(slice + 1);
+
+    output->count = 0;
+
+    for (int i = 0; i < job->boundsCount; i++)
+    {
+        const LightClusterBounds *light = &job->bounds[i];
+        if ((slice < light->slice0) || (slice > light->slice1)) continue;
+
+        float r2 = light->radius*light->radius;
+        float depthDistance2 = GetRangeDistance2(light->depth, nearDepth, farDepth);
+
+        for (int ty = light->tileY0; ty <= light->tileY1; ty++)
+        {
+            float bottom = (2.0f*ty/LIGHT_CLUSTERS_Y - 1.0f)*job->tanY;
+            float top = (2.0f*(ty + 1)/LIGHT_CLUSTERS_Y - 1.0f)*job->tanY;
+            float rowDistance2 = depthDistance2 + GetFroxelDistance2(light->y, bottom, top, nearDepth, farDepth);
+            if (rowDistance2 > r2) continue;
+
+            for (int tx = light->tileX0; tx <= light->tileX1; tx++)
+            {
+                float left = (2.0f*tx/LIGHT_CLUSTERS_X - 1.0f)*job->tanX;
+                float right = (2.0f*(tx + 1)/LIGHT_CLUSTERS_X - 1.0f)*job->tanX;
+                if (rowDistance2 + GetFroxelDistance2(light->x, left, right, nearDepth, farDepth) > r2) continue;
+
+                if (output->count == output->capacity)
+                {
+                    output->capacity = (output->capacity > 0)? output->capacity*2 : 256;
+                    output->pairs = (unsigned int *)RL_REALLOC(output->pairs, output->capacity*sizeof(unsigned int));
+                    output->indices = (unsigned short *)RL_REALLOC(output->indices, output->capacity*sizeof(unsigned short));
+                }
+
+                output->pairs[output->count++] = ((unsigned int)(ty*LIGHT_CLUSTERS_X + tx) << 16) | (unsigned int)light->light;
+            }
+        }
+    }
+
+    // Count per tile, then scatter, the lights keep their order inside a tile
+    unsigned int next[LIGHT_CLUSTERS_TILES];
+    memset(output->tileStart, 0, sizeof(output->tileStart));
+
+    for (int i = 0; i < output->count; i++) output->tileStart[(output->pairs[i] >> 16) + 1]++;
+    for (int t = 0; t < LIGHT_CLUSTERS_TILES; t++) output->tileStart[t + 1] += output->tileStart[t];
+
+    memcpy(next, output->tileStart, sizeof(next));
+    for (int i = 0; i < output->count; i++) output->indices[next[output->pairs[i] >> 16]++] = (unsigned short)(output->pairs[i] & 0xffff);
+}
+
+LightClusters LoadLightClusters(void)
+{
+    LightClusters clusters = { 0 };
+    const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+
+    glGenBuffers(3, clusters.buffers);
+    glGenTextures(3, clusters.textures);
+
+    for (int i = 0; i < 3; i++)
+    {
+        // Not empty, some drivers reject a texture over a buffer without storage
+        glBindBuffer(GL_TEXTURE_BUFFER, clusters.buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+
+        glBindTexture(GL_TEXTURE_BUFFER, clusters.textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], clusters.buffers[i]);
+    }
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    return clusters;
+}
+
+void UnloadLightClusters(LightClusters *clusters)
+{
+    for (int i = 0; i < LIGHT_CLUSTERS_Z; i++)
+    {
+        RL_FREE(clusters->slices[i].pairs);
+        RL_FREE(clusters->slices[i].indices);
+    }
+
+    RL_FREE(clusters->grid);
+    RL_FREE(clusters->indices);
+    RL_FREE(clusters->bounds);
+
+    if (clusters->textures[0] > 0) glDeleteTextures(3, clusters->textures);
+    if (clusters->buffers[0] > 0) glDeleteBuffers(3, clusters->buffers);
+
+    *clusters = (LightClusters){ 0 };
+}
+
+void BuildLightClusters(LightClusters *clusters, const ClusterLight *lights, int count, Camera camera, int width, int height)
+{
+    double startTime = GetMonotonicTime();
+
+    if (count > LIGHT_CLUSTERS_MAX_LIGHTS) count = LIGHT_CLUSTERS_MAX_LIGHTS;
+    if (count < 0) count = 0;
+
+    if (clusters->grid == NULL) clusters->grid = (unsigned int *)RL_CALLOC(LIGHT_CLUSTERS_COUNT*2, sizeof(unsigned int));
+
+    if (count > clusters->boundsCapacity)
+    {
+        clusters->boundsCapacity = count;
+        clusters->bounds = RL_REALLOC(clusters->bounds, count*sizeof(LightClusterBounds));
+    }
+
+    // Same frustum as BeginMode3D(), the aspect comes from the render target
+    Matrix view = GetCameraMatrix(camera);
+    float tanY = tanf(camera.fovy*0.5f*DEG2RAD);
+    float tanX = tanY*(float)width/(float)height;
+
+    LightClusterBounds *bounds = (LightClusterBounds *)clusters->bounds;
+    int boundsCount = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!GetLightClusterBounds(&lights[i], view, tanX, tanY, &bounds[boundsCount])) continue;
+
+        bounds[boundsCount].light = i;
+        boundsCount++;
+    }
+
+    // One task per slice on the pool's sleeping workers, a few lights are not worth waking them for
+    LightClusterJob job = { clusters, bounds, boundsCount, tanX, tanY };
+
+    if (boundsCount >= LIGHT_CLUSTERS_PARALLEL_LIGHTS) ParallelFor(LIGHT_CLUSTERS_Z, BinLightClusterSlice, &job);
+    else for (int i = 0; i < LIGHT_CLUSTERS_Z; i++) BinLightClusterSlice(i, &job);
+
+    // Stitch the slices into one list
+    int indexCount = 0;
+    for (int i = 0; i < LIGHT_CLUSTERS_Z; i++) indexCount += clusters->slices[i].count;
+
+    if (indexCount > clusters->indexCapacity)
+    {
+        clusters->indexCapacity = indexCount;
+        clusters->indices = (unsigned short *)RL_REALLOC(clusters->indices, indexCount*sizeof(unsigned short));
+    }
+
+    unsigned int offset = 0;
+
+    for (int i = 0; i < LIGHT_CLUSTERS_Z; i++)
+    {
+        const LightClusterSlice *slice = &clusters->slices[i];
+        unsigned int *grid = clusters->grid + i*LIGHT_CLUSTERS_TILES*2;
+
+        if (slice->count > 0) memcpy(clusters->indices + offset, slice->indices, slice->count*sizeof(unsigned short));
+
+        for (int t = 0; t < LIGHT_CLUSTERS_TILES; t++)
+        {
+            grid[t*2] = offset + slice->tileStart[t];
+            grid[t*2 + 1] = slice->tileStart[t + 1] - slice->tileStart[t];
+        }
+
+        offset += slice->count;
+    }
+
+    // Row of the view matrix giving the depth, negated as the camera looks down -Z
+    clusters->viewDepth = (Vector4){ -view.m2, -view.m6, -view.m10, -view.m14 };
+    clusters->scale = (Vector4){ (float)LIGHT_CLUSTERS_X/width, (float)LIGHT_CLUSTERS_Y/height, GetSliceScale(), -logf(LIGHT_CLUSTERS_NEAR)*GetSliceScale() };
+
+    clusters->width = width;
+    clusters->height = height;
+    clusters->lights = lights;
+    clusters->lightCount = count;
+    clusters->indexCount = indexCount;
+    clusters->buildTime = GetMonotonicTime() - startTime;
+}
+
+void UploadLightClusters(LightClusters *clusters)
+{
+    if (clusters->buffers[0] == 0) return;
+
+    const void *data[3] = { clusters->lights, clusters->grid, clusters->indices };
+    size_t sizes[3] = {
+        clusters->lightCount*sizeof(ClusterLight),
+        (clusters->grid != NULL)? LIGHT_CLUSTERS_COUNT*2*sizeof(unsigned int) : 0,
+        clusters->indexCount*sizeof(unsigned short)
+    };
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (sizes[i] == 0) continue;
+
+        // Orphan the last frame's storage, the GPU may still be reading it
+        glBindBuffer(GL_TEXTURE_BUFFER, clusters->buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, sizes[i], NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, sizes[i], data[i]);
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    for (int i = 0; i < 3; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + LIGHT_CLUSTERS_TEXTURE_UNIT + i);
+        glBindTexture(GL_TEXTURE_BUFFER, clusters->textures[i]);
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void SetShaderLightClusters(Shader shader, const LightClusters *clusters)
+{
+    const char *samplers[3] = { "clusterLights", "clusterGrid", "clusterIndices" };
+
+    // NOTE: Looked up without GetShaderLocation(), it would log every frame for programs without clusters
+    for (int i = 0; i < 3; i++)
+    {
+        int unit = LIGHT_CLUSTERS_TEXTURE_UNIT + i;
+        SetShaderValue(shader, glGetUniformLocation(shader.id, samplers[i]), &unit, SHADER_UNIFORM_INT);
+    }
+
+    SetShaderValue(shader, glGetUniformLocation(shader.id, "clusterViewDepth"), &clusters->viewDepth, SHADER_UNIFORM_VEC4);
+    SetShaderValue(shader, glGetUniformLocation(shader.id, "clusterScale"), &clusters->scale, SHADER_UNIFORM_VEC4);
+    SetShaderValue(shader, glGetUniformLocation(shader.id, "clusterOrigin"), &clusters->origin, SHADER_UNIFORM_VEC2);
+}
+
+void AnimateClusterLights(ClusterLight *lights, int count, float time)
+{
+    // The radius shrinks with the count, about one light reaches every point of the shell
+    float radius = Clamp(2.0f/cbrtf((float)((count > 0)? count : 1)), 0.25f, 1.5f);
+
+    for (int i = 0; i < count; i++)
+    {
+        // R3 low discrepancy sequence, evenly spread for any count
+        float u = fmodf(0.5f + i*0.8191725f, 1.0f);
+        float v = fmodf(0.5f + i*0.6710436f, 1.0f);
+        float w = fmodf(0.5f + i*0.5497005f, 1.0f);
+
+        float orbit = 0.6f + 1.2f*u;
+        float angle = 2.0f*PI*v + time*(0.5f + w);
+        Color hue = ColorFromHSV(360.0f*v, 0.7f, 1.0f);
+
+        lights[i].position = (Vector3){ orbit*cosf(angle), 0.7f*(2.0f*w - 1.0f), orbit*sinf(angle) };
+        lights[i].radius = radius;
+        lights[i].color = (Vector3){ 0.5f*hue.r/255.0f, 0.5f*hue.g/255.0f, 0.5f*hue.b/255.0f };
+        lights[i].padding = 0.0f;
+    }
+}
+
+#endif // LIGHT_CLUSTERS_IMPLEMENTATION
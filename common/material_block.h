@@ -0,0 +1,336 @@
+/**********************************************************************************************
+*
+*   material_block - Material parameters in a std140 uniform buffer, uploaded only when changed,
+*                    with the material-only constants of the shaders derived on the CPU
+*
+*   Single header module, define MATERIAL_BLOCK_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   The Cook-Torrance, sheen and clearcoat shaders declare the same block, each reads the
+*   fields it needs and ignores the rest:
+*
+*       layout(std140) uniform MaterialBlock
+*       {
+*           vec3 objectColor;               // offset  0
+*           float roughnessValue;           // offset 12, packs into the vec3's last slot
+*           vec3 sheenTint;                 // offset 16
+*           float metallicValue;
+*           vec3 clearcoatTint;             // offset 32
+*           float alphaValue;
+*           float anisotropyValue;          // offset 48
+*           float iorValue;
+*           float sheenWeightValue;
+*           float sheenRoughnessValue;
+*           float clearcoatWeightValue;     // offset 64
+*           float clearcoatRoughnessValue;
+*           float clearcoatIorValue;
+*
+*           vec3 specularF0;                // offset 80, derived from here on
+*           float specularAlpha2;
+*           vec3 averageFresnel;            // offset 96
+*           float smithAlpha2;
+*           vec3 multiScatterLobe;          // offset 112
+*           float clearcoatF0;
+*           vec3 multiScatterApprox;        // offset 128
+*           float clearcoatAlpha2;
+*           vec3 clearcoatAttenuation;      // offset 144
+*           float clearcoatSmithAlpha2;
+*           vec3 sheenColor;                // offset 160
+*           float sheenExponent;
+*           vec2 anisotropicAlpha;          // offset 176
+*           float sheenNorm;
+*           float averageAlbedo;            // 192 bytes in total
+*       };
+*
+*   MaterialParams mirrors the first part field for field (plus the padding std140 leaves
+*   after clearcoatIorValue), MaterialDerived the second. Demos write the params directly
+*   (e.g. from the sliders) and call UpdateMaterialBlock() once per frame. When the params
+*   differ from the last upload the derived constants are computed again, then the changed
+*   range goes out with a single glBufferSubData(), or nothing is sent
+*
+*   Derived constants, the expressions the shaders used to evaluate for every fragment:
+*
+*       specularF0              mix(F0 of iorValue, objectColor, metallicValue)
+*       specularAlpha2          max(roughness^2, 0.0001), Beckmann and GGX NDF
+*       smithAlpha2             max(roughness, 0.0001)^2, Smith-GGX GSF
+*       averageFresnel          Favg = F0 + (1 - F0)/21
+*       averageAlbedo           Eavg, row of the DFG table at the roughness
+*       multiScatterLobe        Favg*Eavg/(1 - Favg*(1 - Eavg))/(PI*max(1 - Eavg, 0.001)), the
+*                               shader scales it by (1 - EssV)*(1 - EssL)
+*       multiScatterApprox      (1 - Ess)*Favg with Ess = 1 - 0.28*roughness^2
+*       anisotropicAlpha        GGX alpha along the tangent and the bitangent
+*       clearcoatF0/Alpha2/SmithAlpha2, clearcoatAttenuation = clearcoatTint^2
+*       sheenColor              sheenWeight*sheenTint
+*       sheenExponent/Norm      Charlie NDF as sheenNorm*pow(sin2h, sheenExponent)
+*
+*   GLSL 330 has no layout(binding), so every program using the block is pointed at
+*   MATERIAL_BLOCK_BINDING once with BindMaterialBlock(), programs then share the buffer
+*
+**********************************************************************************************/
+
+#ifndef MATERIAL_BLOCK_H
+#define MATERIAL_BLOCK_H
+
+#include "raylib.h"
+#include "brdf.h"                                   // BrdfDFG, Eavg of the multiscatter term
+
+#define MATERIAL_BLOCK_BINDING      1               // Uniform buffer binding point, 0 is left to raylib
+#define MATERIAL_BLOCK_NAME         "MaterialBlock"
+
+// std140 layout of the MaterialBlock parameters, a vec3 and a float share 16 bytes
+typedef struct MaterialParams {
+    Vector3 color;                  // objectColor
+    float roughness;
+    Vector3 sheenTint;
+    float metallic;
+    Vector3 clearcoatTint;
+    float alpha;
+    float anisotropy;
+    float ior;
+    float sheenWeight;
+    float sheenRoughness;
+    float clearcoatWeight;
+    float clearcoatRoughness;
+    float clearcoatIor;
+    float padding;                  // Rounds the block up to the vec3 that follows
+} MaterialParams;
+
+// std140 layout of the derived constants, written by UpdateMaterialBlock() only
+typedef struct MaterialDerived {
+    Vector3 specularF0;
+    float specularAlpha2;
+    Vector3 averageFresnel;
+    float smithAlpha2;
+    Vector3 multiScatterLobe;
+    float clearcoatF0;
+    Vector3 multiScatterApprox;
+    float clearcoatAlpha2;
+    Vector3 clearcoatAttenuation;
+    float clearcoatSmithAlpha2;
+    Vector3 sheenColor;
+    float sheenExponent;
+    Vector2 anisotropicAlpha;
+    float sheenNorm;
+    float averageAlbedo;
+} MaterialDerived;
+
+// Buffer contents
+typedef struct MaterialBlockData {
+    MaterialParams params;
+    MaterialDerived derived;
+} MaterialBlockData;
+
+typedef struct MaterialBlock {
+    MaterialParams params;          // Written by the demo, uploaded by UpdateMaterialBlock()
+    MaterialBlockData uploaded;     // Buffer contents
+    BrdfDFG dfg;                    // Eavg rows, empty when the table failed to load
+    unsigned int ubo;
+    int uploadCount;                // Buffer uploads so far
+} MaterialBlock;
+
+MaterialParams GetMaterialParamsDefault(void);                                  // The slider defaults of the demos
+MaterialDerived GetMaterialDerived(MaterialParams params, const BrdfDFG *dfg);  // Material-only constants of the shaders, dfg may be NULL
+Vector2 GetOrenNayarCoefficients(float roughness);                              // Oren-Nayar A and B from sigma, diffuse_oren_nayar.fs
+MaterialBlock LoadMaterialBlock(MaterialParams params, const char *dfgFileName); // Create the buffer with the params uploaded
+void UnloadMaterialBlock(MaterialBlock *block);
+void BindMaterialBlock(Shader shader);                                          // Point the program's MaterialBlock at MATERIAL_BLOCK_BINDING
+bool UpdateMaterialBlock(MaterialBlock *block);                                 // Derive and upload the changed fields and bind, true when anything was sent
+
+#endif // MATERIAL_BLOCK_H
+
+#if defined(MATERIAL_BLOCK_IMPLEMENTATION) && !defined(MATERIAL_BLOCK_IMPLEMENTED)
+#define MATERIAL_BLOCK_IMPLEMENTED
+
+#include <math.h>
+#include <string.h>
+
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, rlgl has no uniform buffer calls
+
+#define BRDF_IMPLEMENTATION
+#include "brdf.h"
+
+// Block size in the shaders, a mismatch here breaks the compile instead of the shading
+typedef char MaterialParamsSizeCheck[(sizeof(MaterialParams) == 80)? 1 : -1];
+typedef char MaterialDerivedSizeCheck[(sizeof(MaterialDerived) == 112)? 1 : -1];
+
+static unsigned int materialBlockBound = 0;     // Buffer at MATERIAL_BLOCK_BINDING, skips redundant binds
+
+MaterialParams GetMaterialParamsDefault(void)
+{
+    MaterialParams params = { 0 };
+
+    params.color = (Vector3){ 0.5f, 0.0f, 0.0f };
+    params.roughness = 0.5f;
+    params.sheenTint = (Vector3){ 1.0f, 1.0f, 1.0f };
+    params.metallic = 0.5f;
+    params.clearcoatTint = (Vector3){ 1.0f, 1.0f, 1.0f };
+    params.alpha = 1.0f;
+    params.anisotropy = 0.0f;
+    params.ior = 1.5f;
+    params.sheenWeight = 0.0f;
+    params.sheenRoughness = 0.5f;
+    params.clearcoatWeight = 0.0f;
+    params.clearcoatRoughness = 0.025f;
+    params.clearcoatIor = 1.5f;
+
+    return params;
+}
+
+// F0 = ((n1 - n2)/(n1 + n2))^2 against air
+static float GetDielectricF0(float ior)
+{
+    float r = (1.0f - ior)/(1.0f + ior);
+
+    return r*r;
+}
+
+MaterialDerived GetMaterialDerived(MaterialParams params, const BrdfDFG *dfg)
+{
+    MaterialDerived derived = { 0 };
+    const float roughness = params.roughness;
+
+    // Base layer Fresnel, metals use the albedo color as F0
+    float reflectivity = GetDielectricF0(params.ior);
+    float F0[3] = { params.color.x, params.color.y, params.color.z };
+    float Favg[3] = { 0 };
+
+    for (int i = 0; i < 3; i++)
+    {
+        F0[i] = reflectivity + (F0[i] - reflectivity)*params.metallic;
+        Favg[i] = F0[i] + (1.0f - F0[i])/21.0f;
+    }
+
+    derived.specularF0 = (Vector3){ F0[0], F0[1], F0[2] };
+    derived.averageFresnel = (Vector3){ Favg[0], Favg[1], Favg[2] };
+
+    // Same clamps as the NDF and GSF functions, they differ below roughness 0.01
+    derived.specularAlpha2 = fmaxf(roughness*roughness, 0.0001f);
+    derived.smithAlpha2 = fmaxf(roughness, 0.0001f)*fmaxf(roughness, 0.0001f);
+
+    float aspect = sqrtf(1.0f - params.anisotropy*0.75f);
+    derived.anisotropicAlpha = (Vector2){ fmaxf(0.0001f, roughness/aspect), fmaxf(0.0001f, roughness*aspect) };
+
+    // Kulla-Conty energy return, Eavg is constant along each row of the table so any NdotV reads it
+    float Eavg = 0.0f;
+    if ((dfg != NULL) && (dfg->data != NULL))
+    {
+        float dfgRow[3] = { 0 };
+        SampleBrdfDFG(dfg, 0.5f, roughness, dfgRow);
+        Eavg = dfgRow[2];
+    }
+
+    float lobeScale = 1.0f/(PI*fmaxf(1.0f - Eavg, 0.001f));
+    float Ems = 0.28f*roughness*roughness;
+    float lobe[3] = { 0 };
+    float approx[3] = { 0 };
+
+    for (int i = 0; i < 3; i++)
+    {
+        lobe[i] = (Favg[i]*Eavg)/(1.0f - Favg[i]*(1.0f - Eavg))*lobeScale;
+        approx[i] = Ems*Favg[i];
+    }
+
+    derived.averageAlbedo = Eavg;
+    derived.multiScatterLobe = (Vector3){ lobe[0], lobe[1], lobe[2] };
+    derived.multiScatterApprox = (Vector3){ approx[0], approx[1], approx[2] };
+
+    // Clearcoat, always dielectric
+    derived.clearcoatF0 = GetDielectricF0(params.clearcoatIor);
+    derived.clearcoatAlpha2 = fmaxf(params.clearcoatRoughness*params.clearcoatRoughness, 0.0001f);
+    derived.clearcoatSmithAlpha2 = fmaxf(params.clearcoatRoughness, 0.0001f)*fmaxf(params.clearcoatRoughness, 0.0001f);
+    derived.clearcoatAttenuation = (Vector3){ params.clearcoatTint.x*params.clearcoatTint.x,
+        params.clearcoatTint.y*params.clearcoatTint.y, params.clearcoatTint.z*params.clearcoatTint.z };
+
+    // Sheen, Charlie NDF = (2 + 1/r)*sin2h^(0.5/r)/(2*PI)
+    float invR = 1.0f/fmaxf(params.sheenRoughness, 0.0001f);
+    derived.sheenColor = (Vector3){ params.sheenWeight*params.sheenTint.x, params.sheenWeight*params.sheenTint.y, params.sheenWeight*params.sheenTint.z };
+    derived.sheenExponent = 0.5f*invR;
+    derived.sheenNorm = (2.0f + invR)/(2.0f*PI);
+
+    return derived;
+}
+
+Vector2 GetOrenNayarCoefficients(float roughness)
+{
+    float sigma2 = roughness*roughness;
+
+    return (Vector2){ 1.0f - 0.5f*(sigma2/(sigma2 + 0.33f)), 0.45f*(sigma2/(sigma2 + 0.09f)) };
+}
+
+MaterialBlock LoadMaterialBlock(MaterialParams params, const char *dfgFileName)
+{
+    MaterialBlock block = { 0 };
+    block.dfg = LoadBrdfDFG(dfgFileName);
+    block.params = params;
+    block.uploaded.params = params;
+    block.uploaded.derived = GetMaterialDerived(params, &block.dfg);
+
+    glGenBuffers(1, &block.ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, block.ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(MaterialBlockData), &block.uploaded, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    block.uploadCount = 1;
+
+    return block;
+}
+
+void UnloadMaterialBlock(MaterialBlock *block)
+{
+    if (materialBlockBound == block->ubo) materialBlockBound = 0;
+
+    glDeleteBuffers(1, &block->ubo);
+    block->ubo = 0;
+
+    UnloadBrdfDFG(block->dfg);
+    block->dfg = (BrdfDFG){ 0 };
+}
+
+void BindMaterialBlock(Shader shader)
+{
+    unsigned int index = glGetUniformBlockIndex(shader.id, MATERIAL_BLOCK_NAME);
+
+    if (index != GL_INVALID_INDEX) glUniformBlockBinding(shader.id, index, MATERIAL_BLOCK_BINDING);
+    else TraceLog(LOG_WARNING, "SHADER: [ID %i] No %s uniform block", shader.id, MATERIAL_BLOCK_NAME);
+}
+
+bool UpdateMaterialBlock(MaterialBlock *block)
+{
+    if (materialBlockBound != block->ubo)
+    {
+        glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, block->ubo);
+        materialBlockBound = block->ubo;
+    }
+
+    // Nothing moved, the derived constants are still valid
+    if (memcmp(&block->params, &block->uploaded.params, sizeof(MaterialParams)) == 0) return false;
+
+    MaterialBlockData data = { 0 };
+    data.params = block->params;
+    data.derived = GetMaterialDerived(block->params, &block->dfg);
+
+    // Every field is 4 bytes, the dirty range runs from the first to the last changed one
+    const unsigned char *current = (const unsigned char *)&data;
+    unsigned char *uploaded = (unsigned char *)&block->uploaded;
+    const int fieldCount = sizeof(MaterialBlockData)/sizeof(float);
+
+    int first = 0;
+    while ((first < fieldCount) && (memcmp(current + 4*first, uploaded + 4*first, 4) == 0)) first++;
+
+    int last = fieldCount - 1;
+    while (memcmp(current + 4*last, uploaded + 4*last, 4) == 0) last--;
+
+    size_t offset = 4*first;
+    size_t size = 4*(last - first + 1);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, block->ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, current + offset);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    memcpy(uploaded + offset, current + offset, size);
+    block->uploadCount++;
+
+    return true;
+}
+
+#endif // MATERIAL_BLOCK_IMPLEMENTATION
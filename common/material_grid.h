@@ -0,0 +1,249 @@
+/**********************************************************************************************
+*
+*   material_grid - Roughness x metallic x IOR sweeps of one mesh in a single instanced draw
+*
+*   Single header module, define MATERIAL_GRID_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   Every grid cell is a copy of the mesh with its own material. The cells share the base
+*   MaterialParams (color, anisotropy, alpha, ...). The three swept values and the constants
+*   GetMaterialDerived() computes from them go into an instance buffer, attached to the mesh
+*   VAO with a divisor of 1. The whole grid is one instanced draw call and no uniform changes
+*   between cells. The buffer is filled again only when the base params change
+*
+*   Per-instance attributes, as the shader declares them:
+*
+*       layout(location = 10) in vec4 instancePlacement;            // offset (xyz), uniform scale (w)
+*       layout(location = 11) in vec4 instanceParams;               // roughness, metallic, ior, specularAlpha2
+*       layout(location = 12) in vec4 instanceSpecularF0;           // specularF0, smithAlpha2
+*       layout(location = 13) in vec4 instanceMultiScatter;         // multiScatterLobe, anisotropicAlpha.x
+*       layout(location = 14) in vec4 instanceMultiScatterApprox;   // multiScatterApprox, anisotropicAlpha.y
+*
+*   The locations start after the ones rlgl binds by name, so the mesh attributes keep theirs.
+*   Placement is an offset and a uniform scale in model space, so the draw's matNormal stays
+*   valid for every cell
+*
+*   Roughness runs along X, metallic along Y and IOR along Z over the ranges of the demo
+*   sliders. An axis with a single step keeps the base value. The grid is centered on the
+*   origin and fits in a cube of the given size
+*
+**********************************************************************************************/
+
+#ifndef MATERIAL_GRID_H
+#define MATERIAL_GRID_H
+
+#include "raylib.h"
+#include "material_block.h"                         // MaterialParams, GetMaterialDerived()
+
+#define MATERIAL_GRID_ATTRIB_LOCATION   10          // First instance attribute, five vec4 from here
+#define MATERIAL_GRID_MAP_COUNT         (MATERIAL_MAP_BRDF + 1)     // Maps DrawMesh() binds, MAX_MATERIAL_MAPS is not public
+
+#define MATERIAL_GRID_ROUGHNESS_MIN     0.0f
+#define MATERIAL_GRID_ROUGHNESS_MAX     1.0f
+#define MATERIAL_GRID_METALLIC_MIN      0.0f
+#define MATERIAL_GRID_METALLIC_MAX      1.0f
+#define MATERIAL_GRID_IOR_MIN           1.0f
+#define MATERIAL_GRID_IOR_MAX           3.5f
+
+// Instance buffer layout, one per cell
+typedef struct MaterialInstance {
+    Vector4 placement;              // Offset (xyz) and uniform scale (w) of the mesh
+    Vector4 params;                 // roughness, metallic, ior, specularAlpha2
+    Vector4 specularF0;             // specularF0, smithAlpha2
+    Vector4 multiScatter;           // multiScatterLobe, anisotropicAlpha.x
+    Vector4 multiScatterApprox;     // multiScatterApprox, anisotropicAlpha.y
+} MaterialInstance;
+
+typedef struct MaterialGrid {
+    Mesh mesh;                      // Not owned, its VAO holds the instance attributes
+    int roughnessCount;
+    int metallicCount;
+    int iorCount;
+    int instanceCount;
+    float size;                     // Edge of the cube the grid fits in
+    MaterialInstance *instances;    // Buffer contents
+    MaterialParams base;            // Base params of the last fill
+    bool filled;
+    unsigned int vbo;
+    int fillCount;                  // Buffer uploads so far
+} MaterialGrid;
+
+MaterialGrid LoadMaterialGrid(Mesh mesh, int roughnessCount, int metallicCount, int iorCount, float size); // Instance buffer attached to the mesh VAO
+void UnloadMaterialGrid(MaterialGrid *grid);                                                                // Leaves the mesh loaded
+bool UpdateMaterialGrid(MaterialGrid *grid, MaterialParams base, const BrdfDFG *dfg);                       // Fill again when base changed, true when anything was sent
+void DrawMaterialGrid(const MaterialGrid *grid, Material material, Matrix transform);                      // DrawMesh() for every cell in one call
+
+#endif // MATERIAL_GRID_H
+
+#if defined(MATERIAL_GRID_IMPLEMENTATION) && !defined(MATERIAL_GRID_IMPLEMENTED)
+#define MATERIAL_GRID_IMPLEMENTED
+
+#include <string.h>
+
+#include "raymath.h"
+#include "rlgl.h"
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, rlSetVertexAttribute() changed signature between releases
+
+#define MATERIAL_BLOCK_IMPLEMENTATION
+#include "material_block.h"
+
+// Value of step i of count over [min, max], a single step keeps the base value
+static float GetMaterialGridStep(int i, int count, float min, float max, float base)
+{
+    return (count > 1)? min + (max - min)*(float)i/(float)(count - 1) : base;
+}
+
+MaterialGrid LoadMaterialGrid(Mesh mesh, int roughnessCount, int metallicCount, int iorCount, float size)
+{
+    MaterialGrid grid = { 0 };
+
+    if ((mesh.vaoId == 0) || (roughnessCount <= 0) || (metallicCount <= 0) || (iorCount <= 0))
+    {
+        TraceLog(LOG_WARNING, "GRID: Mesh not uploaded or empty grid (%ix%ix%i)", roughnessCount, metallicCount, iorCount);
+        return grid;
+    }
+
+    grid.mesh = mesh;
+    grid.roughnessCount = roughnessCount;
+    grid.metallicCount = metallicCount;
+    grid.iorCount = iorCount;
+    grid.instanceCount = roughnessCount*metallicCount*iorCount;
+    grid.size = size;
+    grid.instances = (MaterialInstance *)RL_CALLOC(grid.instanceCount, sizeof(MaterialInstance));
+
+    // One interleaved buffer, the placement never changes but is written with the rest on every fill
+    glBindVertexArray(mesh.vaoId);
+    glGenBuffers(1, &grid.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, grid.vbo);
+    glBufferData(GL_ARRAY_BUFFER, grid.instanceCount*sizeof(MaterialInstance), NULL, GL_DYNAMIC_DRAW);
+
+    for (int i = 0; i < (int)(sizeof(MaterialInstance)/sizeof(Vector4)); i++)
+    {
+        glEnableVertexAttribArray(MATERIAL_GRID_ATTRIB_LOCATION + i);
+        glVertexAttribPointer(MATERIAL_GRID_ATTRIB_LOCATION + i, 4, GL_FLOAT, GL_FALSE, sizeof(MaterialInstance), (void *)(i*sizeof(Vector4)));
+        glVertexAttribDivisor(MATERIAL_GRID_ATTRIB_LOCATION + i, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    TraceLog(LOG_INFO, "GRID: [VAO %i] %ix%ix%i material grid, %i instances of %i vertices", mesh.vaoId, roughnessCount, metallicCount, iorCount, grid.instanceCount, mesh.vertexCount);
+
+    return grid;
+}
+
+void UnloadMaterialGrid(MaterialGrid *grid)
+{
+    if (grid->mesh.vaoId > 0)
+    {
+        // The mesh may outlive the grid, its VAO must not keep pointing at the deleted buffer
+        glBindVertexArray(grid->mesh.vaoId);
+        for (int i = 0; i < (int)(sizeof(MaterialInstance)/sizeof(Vector4)); i++) glDisableVertexAttribArray(MATERIAL_GRID_ATTRIB_LOCATION + i);
+        glBindVertexArray(0);
+    }
+
+    if (grid->vbo > 0) glDeleteBuffers(1, &grid->vbo);
+    RL_FREE(grid->instances);
+
+    *grid = (MaterialGrid){ 0 };
+}
+
+bool UpdateMaterialGrid(MaterialGrid *grid, MaterialParams base, const BrdfDFG *dfg)
+{
+    if ((grid->vbo == 0) || (grid->filled && (memcmp(&grid->base, &base, sizeof(MaterialParams)) == 0))) return false;
+
+    // Cubic cells of size/max(count), the mesh is scaled to 80% of a cell so a unit diameter one leaves gaps
+    int maxCount = grid->roughnessCount;
+    if (grid->metallicCount > maxCount) maxCount = grid->metallicCount;
+    if (grid->iorCount > maxCount) maxCount = grid->iorCount;
+
+    float cell = grid->size/(float)maxCount;
+    float scale = 0.8f*cell;
+
+    int index = 0;
+    for (int z = 0; z < grid->iorCount; z++)
+    {
+        for (int y = 0; y < grid->metallicCount; y++)
+        {
+            for (int x = 0; x < grid->roughnessCount; x++)
+            {
+                MaterialParams params = base;
+                params.roughness = GetMaterialGridStep(x, grid->roughnessCount, MATERIAL_GRID_ROUGHNESS_MIN, MATERIAL_GRID_ROUGHNESS_MAX, base.roughness);
+                params.metallic = GetMaterialGridStep(y, grid->metallicCount, MATERIAL_GRID_METALLIC_MIN, MATERIAL_GRID_METALLIC_MAX, base.metallic);
+                params.ior = GetMaterialGridStep(z, grid->iorCount, MATERIAL_GRID_IOR_MIN, MATERIAL_GRID_IOR_MAX, base.ior);
+
+                MaterialDerived derived = GetMaterialDerived(params, dfg);
+                MaterialInstance *instance = &grid->instances[index++];
+
+                instance->placement = (Vector4){ (x - 0.5f*(grid->roughnessCount - 1))*cell, (y - 0.5f*(grid->metallicCount - 1))*cell, (z - 0.5f*(grid->iorCount - 1))*cell, scale };
+                instance->params = (Vector4){ params.roughness, params.metallic, params.ior, derived.specularAlpha2 };
+                instance->specularF0 = (Vector4){ derived.specularF0.x, derived.specularF0.y, derived.specularF0.z, derived.smithAlpha2 };
+                instance->multiScatter = (Vector4){ derived.multiScatterLobe.x, derived.multiScatterLobe.y, derived.multiScatterLobe.z, derived.anisotropicAlpha.x };
+                instance->multiScatterApprox = (Vector4){ derived.multiScatterApprox.x, derived.multiScatterApprox.y, derived.multiScatterApprox.z, derived.anisotropicAlpha.y };
+            }
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, grid->vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, grid->instanceCount*sizeof(MaterialInstance), grid->instances);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    grid->base = base;
+    grid->filled = true;
+    grid->fillCount++;
+
+    return true;
+}
+
+// Same uniforms and texture slots DrawMesh() sets, then one instanced draw
+void DrawMaterialGrid(const MaterialGrid *grid, Material material, Matrix transform)
+{
+    if (grid->vbo == 0) return;
+
+    rlEnableShader(material.shader.id);
+
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matProjection = rlGetMatrixProjection();
+    Matrix matModel = MatrixMultiply(transform, rlGetMatrixTransform());
+    Matrix matModelViewProjection = MatrixMultiply(MatrixMultiply(matModel, matView), matProjection);
+
+    if (material.shader.locs[SHADER_LOC_MATRIX_VIEW] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_VIEW], matView);
+    if (material.shader.locs[SHADER_LOC_MATRIX_PROJECTION] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_PROJECTION], matProjection);
+    if (material.shader.locs[SHADER_LOC_MATRIX_MODEL] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_MODEL], matModel);
+    if (material.shader.locs[SHADER_LOC_MATRIX_NORMAL] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(matModel)));
+    rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_MVP], matModelViewProjection);
+
+    for (int i = 0; i < MATERIAL_GRID_MAP_COUNT; i++)
+    {
+        if (material.maps[i].texture.id > 0)
+        {
+            rlActiveTextureSlot(i);
+
+            if ((i == MATERIAL_MAP_IRRADIANCE) || (i == MATERIAL_MAP_PREFILTER) || (i == MATERIAL_MAP_CUBEMAP)) rlEnableTextureCubemap(material.maps[i].texture.id);
+            else rlEnableTexture(material.maps[i].texture.id);
+
+            rlSetUniform(material.shader.locs[SHADER_LOC_MAP_DIFFUSE + i], &i, SHADER_UNIFORM_INT, 1);
+        }
+    }
+
+    rlEnableVertexArray(grid->mesh.vaoId);
+
+    if (grid->mesh.indices != NULL) rlDrawVertexArrayElementsInstanced(0, grid->mesh.triangleCount*3, 0, grid->instanceCount);
+    else rlDrawVertexArrayInstanced(0, grid->mesh.vertexCount, grid->instanceCount);
+
+    for (int i = 0; i < MATERIAL_GRID_MAP_COUNT; i++)
+    {
+        if (material.maps[i].texture.id > 0)
+        {
+            rlActiveTextureSlot(i);
+
+            if ((i == MATERIAL_MAP_IRRADIANCE) || (i == MATERIAL_MAP_PREFILTER) || (i == MATERIAL_MAP_CUBEMAP)) rlDisableTextureCubemap();
+            else rlDisableTexture();
+        }
+    }
+
+    rlDisableVertexArray();
+    rlDisableShader();
+}
+
+#endif // MATERIAL_GRID_IMPLEMENTATION
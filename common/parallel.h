@@ -0,0 +1,205 @@
+/**********************************************************************************************
+*
+*   parallel - Minimal parallel-for on a persistent worker pool, shared by the CPU bakers,
+*              the software rasterizer and the light cluster binning
+*
+*   Single header module, define PARALLEL_IMPLEMENTATION in exactly one translation unit
+*   before including it (every demo is a single .c file, so the demo itself does it)
+*
+*   The GetWorkerCount() - 1 worker threads are created by the first ParallelFor() and live
+*   until the process exits, they sleep on a condition variable between jobs, so a call costs
+*   a wake up instead of a thread creation and join. The calling thread works on its own job too.
+*
+*   Work items are handed out through an atomic counter per job, so uneven items (e.g. rows near
+*   the poles of an equirect map, tiles covered by many triangles) balance themselves: a worker
+*   done with its items takes the next free one. Open jobs sit in a list and an idle worker takes
+*   leftover items from any of them, so calls from several threads at once (the environment
+*   streaming thread baking while the frame bins its lights) share the pool instead of waiting
+*   for each other. A task may call ParallelFor() again, the caller always drains its own job
+*
+*   GetMonotonicTime() is the clock of everything timed on the CPU side: raylib's GetTime() needs
+*   an initialized window, which the tools and the pools' callers do not always have
+*
+**********************************************************************************************/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// Task callback, called once for every index in [0, count)
+typedef void (*ParallelTask)(int index, void *userData);
+
+int GetWorkerCount(void);                                           // Number of hardware threads used by ParallelFor()
+void ParallelFor(int count, ParallelTask task, void *userData);     // Run task for every index, blocks until all are done
+double GetMonotonicTime(void);                                      // Seconds on a monotonic clock, no window needed
+
+#endif // PARALLEL_H
+
+#if defined(PARALLEL_IMPLEMENTATION) && !defined(PARALLEL_IMPLEMENTED)
+#define PARALLEL_IMPLEMENTED
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#if !defined(_WIN32)
+    #include <unistd.h>
+#endif
+
+#define PARALLEL_MAX_WORKERS 256
+
+typedef struct ParallelJob {
+    ParallelTask task;
+    void *userData;
+    int count;
+    volatile int next;                  // Next free index, taken with an atomic add
+    int active;                         // Workers inside the job, guarded by the pool lock
+    struct ParallelJob *link;           // Next open job
+} ParallelJob;
+
+typedef struct ParallelPool {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;                // A job was opened
+    pthread_cond_t done;                // A worker left a job
+    ParallelJob *jobs;                  // Open jobs, newest first
+    int threadCount;
+} ParallelPool;
+
+static ParallelPool parallelPool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0 };
+static pthread_once_t parallelPoolOnce = PTHREAD_ONCE_INIT;
+
+static void DrainParallelJob(ParallelJob *job)
+{
+    // Grab the next free index until the job is drained
+    for (int i = __sync_fetch_and_add(&job->next, 1); i < job->count; i = __sync_fetch_and_add(&job->next, 1))
+    {
+        job->task(i, job->userData);
+    }
+}
+
+// First open job with items left, called with the pool locked
+static ParallelJob *FindParallelJob(void)
+{
+    for (ParallelJob *job = parallelPool.jobs; job != NULL; job = job->link)
+    {
+        if (__sync_fetch_and_add(&job->next, 0) < job->count) return job;
+    }
+
+    return NULL;
+}
+
+static void *ParallelWorker(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&parallelPool.lock);
+
+    for (;;)
+    {
+        ParallelJob *job = FindParallelJob();
+
+        if (job == NULL)
+        {
+            pthread_cond_wait(&parallelPool.wake, &parallelPool.lock);
+            continue;
+        }
+
+        // The caller waits for active to drop back to 0 before its job goes out of scope
+        job->active++;
+        pthread_mutex_unlock(&parallelPool.lock);
+
+        DrainParallelJob(job);
+
+        pthread_mutex_lock(&parallelPool.lock);
+        job->active--;
+        if (job->active == 0) pthread_cond_broadcast(&parallelPool.done);
+    }
+
+    return NULL;
+}
+
+static void StartParallelPool(void)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    // The calling thread of every job works too, so one thread less than the hardware has
+    for (int i = 1; i < GetWorkerCount(); i++)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, ParallelWorker, NULL) == 0) parallelPool.threadCount++;
+    }
+
+    pthread_attr_destroy(&attr);
+}
+
+int GetWorkerCount(void)
+{
+    static int workerCount = 0;
+
+    if (workerCount == 0)
+    {
+        // NOTE: Windows is queried through the environment to avoid pulling windows.h next to raylib.h
+#if defined(_WIN32)
+        const char *processors = getenv("NUMBER_OF_PROCESSORS");
+        workerCount = (processors != NULL)? atoi(processors) : 1;
+#else
+        workerCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        if (workerCount < 1) workerCount = 1;
+        if (workerCount > PARALLEL_MAX_WORKERS) workerCount = PARALLEL_MAX_WORKERS;
+    }
+
+    return workerCount;
+}
+
+void ParallelFor(int count, ParallelTask task, void *userData)
+{
+    if (count <= 0) return;
+
+    ParallelJob job = { task, userData, count, 0, 0, NULL };
+    bool queued = false;
+
+    // A single item is not worth waking anyone
+    if (count > 1)
+    {
+        pthread_once(&parallelPoolOnce, StartParallelPool);
+
+        if (parallelPool.threadCount > 0)
+        {
+            pthread_mutex_lock(&parallelPool.lock);
+            job.link = parallelPool.jobs;
+            parallelPool.jobs = &job;
+            pthread_cond_broadcast(&parallelPool.wake);
+            pthread_mutex_unlock(&parallelPool.lock);
+            queued = true;
+        }
+    }
+
+    DrainParallelJob(&job);
+
+    if (queued)
+    {
+        pthread_mutex_lock(&parallelPool.lock);
+
+        // Close the job, then wait for the workers still finishing its last items
+        for (ParallelJob **open = &parallelPool.jobs; *open != NULL; open = &(*open)->link)
+        {
+            if (*open == &job) { *open = job.link; break; }
+        }
+
+        while (job.active > 0) pthread_cond_wait(&parallelPool.done, &parallelPool.lock);
+
+        pthread_mutex_unlock(&parallelPool.lock);
+    }
+}
+
+double GetMonotonicTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec*1e-9;
+}
+
+#endif // PARALLEL_IMPLEMENTATION
@@ -0,0 +1,371 @@
+/**********************************************************************************************
+*
+*   pass_timer - CPU and GPU time of the render passes of a frame, with an on-screen overlay
+*                and a CSV dump
+*
+*   Single header module, define PASS_TIMER_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   Every pass is a scope of the frame (sky, model, GUI...) timed twice:
+*
+*       CPU -> GetTime() around the calls that issue it, draw submission and driver work
+*       GPU -> GL_TIME_ELAPSED query around its draws, the time the GPU spent on them
+*
+*   The GPU finishes a frame well after the CPU has issued it, so every pass owns
+*   PASS_TIMER_FRAMES queries used in turn and a result is read PASS_TIMER_FRAMES - 1 frames
+*   after it was issued. A result that is still not available then is dropped rather than
+*   waited for, reading the timers never stalls the frame:
+*
+*       const char *passNames[] = { "Sky", "Model", "GUI" };
+*       PassTimer timer = LoadPassTimer(passNames, 3);
+*       timer.output = ParsePassTimerArgs(argc, argv);     // --timings FILE.csv
+*
+*       UpdatePassTimer(&timer);            // Once per frame, before the first pass
+*       BeginPassTimer(&timer, 1);
+*           DrawModel(...);
+*       EndPassTimer(&timer);
+*       DrawPassTimer(&timer, x, y);        // p50/p95/p99 of the last PASS_TIMER_HISTORY frames
+*
+*   Timer queries do not nest, one pass is timed at a time. Begin and end flush the raylib
+*   batch, so the draws of the pass land inside its scope. The "Frame" row of the overlay is
+*   the sum of the passes of each frame, the frame rate cap and the buffer swap are not in it.
+*   time[] and cpuTime[] hold running averages in milliseconds for the demos' own labels,
+*   passes not drawn in a frame keep their last value
+*
+*   UnloadPassTimer() logs the mean of every pass over the run with the percentiles of the last
+*   frames and, with an output set, writes every sample as CSV, one row per pass and frame:
+*
+*       frame,pass,cpu_ms,gpu_ms            gpu_ms is empty for a dropped query
+*
+*   The same demo and scene with another shading model is then compared on equal terms, e.g.
+*   two headless runs of a few hundred frames
+*
+**********************************************************************************************/
+
+#ifndef PASS_TIMER_H
+#define PASS_TIMER_H
+
+#include "raylib.h"
+
+#define PASS_TIMER_MAX_PASSES       8
+#define PASS_TIMER_FRAMES           4       // Queries per pass in flight, results are read this many frames later minus one
+#define PASS_TIMER_HISTORY          240     // Frames the overlay percentiles look back over
+
+// One pass of one frame, gpu is negative until its query is read and stays so when it is dropped
+typedef struct PassTimerRecord {
+    int frame;
+    int pass;
+    float cpu;                              // Milliseconds
+    float gpu;
+} PassTimerRecord;
+
+// Last PASS_TIMER_HISTORY results of a pass, milliseconds
+typedef struct PassTimerHistory {
+    float samples[PASS_TIMER_HISTORY];
+    int count;                              // Results so far, the newest is at (count - 1)%PASS_TIMER_HISTORY
+    double total;                           // Sum of every result, for the mean of the run
+} PassTimerHistory;
+
+typedef struct PassTimer {
+    int passCount;
+    const char *names[PASS_TIMER_MAX_PASSES];
+    const char *output;                     // CSV written by UnloadPassTimer(), NULL for none
+
+    unsigned int queries[PASS_TIMER_FRAMES][PASS_TIMER_MAX_PASSES];
+    bool issued[PASS_TIMER_FRAMES][PASS_TIMER_MAX_PASSES];
+    int pending[PASS_TIMER_FRAMES][PASS_TIMER_MAX_PASSES];     // Record waiting for the query, -1 for none
+    int slot;                               // Query set of the current frame
+    int frame;                              // Frames started so far
+    int active;                             // Pass being timed, -1 outside
+    double activeStart;
+    int dropped;                            // GPU results not ready in time
+
+    float time[PASS_TIMER_MAX_PASSES];      // GPU running average, milliseconds
+    float cpuTime[PASS_TIMER_MAX_PASSES];   // CPU running average, milliseconds
+
+    // One more entry than passes, the last one is the sum of the frame
+    PassTimerHistory cpu[PASS_TIMER_MAX_PASSES + 1];
+    PassTimerHistory gpu[PASS_TIMER_MAX_PASSES + 1];
+    float frameCpu;                         // Sum of the passes of the current frame so far
+
+    PassTimerRecord *records;               // Every sample, only kept with an output set
+    int recordCount;
+    int recordCapacity;
+} PassTimer;
+
+const char *ParsePassTimerArgs(int argc, char *argv[]);                  // File given with --timings, NULL without
+PassTimer LoadPassTimer(const char **names, int count);                 // Queries for count passes, names are not copied
+void UnloadPassTimer(PassTimer *timer);                                 // Logs the statistics, writes the output if set
+void UpdatePassTimer(PassTimer *timer);                                 // Read the results that are ready, once per frame
+void BeginPassTimer(PassTimer *timer, int pass);
+void EndPassTimer(PassTimer *timer);
+float GetPassTimerPercentile(const PassTimerHistory *history, float percentile);   // Over the kept samples, 0 without any
+void DrawPassTimer(const PassTimer *timer, int posX, int posY);         // Overlay of the CPU and GPU p50/p95/p99
+bool ExportPassTimerCSV(const PassTimer *timer, const char *fileName);  // Every record, see the header
+
+#endif // PASS_TIMER_H
+
+#if defined(PASS_TIMER_IMPLEMENTATION) && !defined(PASS_TIMER_IMPLEMENTED)
+#define PASS_TIMER_IMPLEMENTED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rlgl.h"
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, rlgl has no query calls
+
+#define PASS_TIMER_SMOOTHING        0.1f    // Weight of a new result in the running averages
+
+static void AddPassTimerSample(PassTimerHistory *history, float ms)
+{
+    history->samples[history->count%PASS_TIMER_HISTORY] = ms;
+    history->count++;
+    history->total += ms;
+}
+
+static int ComparePassTimerSamples(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+
+    return (x > y) - (x < y);
+}
+
+const char *ParsePassTimerArgs(int argc, char *argv[])
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--timings") == 0) return argv[i + 1];
+    }
+
+    return NULL;
+}
+
+PassTimer LoadPassTimer(const char **names, int count)
+{
+    PassTimer timer = { 0 };
+
+    if ((count <= 0) || (count > PASS_TIMER_MAX_PASSES))
+    {
+        TraceLog(LOG_WARNING, "TIMER: %i passes given, at most %i are supported", count, PASS_TIMER_MAX_PASSES);
+        return timer;
+    }
+
+    timer.passCount = count;
+    timer.active = -1;
+    for (int i = 0; i < count; i++) timer.names[i] = names[i];
+
+    for (int i = 0; i < PASS_TIMER_FRAMES; i++)
+    {
+        glGenQueries(count, timer.queries[i]);
+        for (int j = 0; j < count; j++) timer.pending[i][j] = -1;
+    }
+
+    return timer;
+}
+
+void UnloadPassTimer(PassTimer *timer)
+{
+    for (int i = 0; i <= timer->passCount; i++)
+    {
+        const PassTimerHistory *cpu = &timer->cpu[i];
+        const PassTimerHistory *gpu = &timer->gpu[i];
+        if (cpu->count == 0) continue;
+
+        TraceLog(LOG_INFO, "TIMER: %-10s CPU %7.3f ms mean, p50 %7.3f p95 %7.3f p99 %7.3f | GPU %7.3f ms mean, p50 %7.3f p95 %7.3f p99 %7.3f (%i frames)",
+            (i < timer->passCount)? timer->names[i] : "Frame",
+            cpu->total/cpu->count, GetPassTimerPercentile(cpu, 50.0f), GetPassTimerPercentile(cpu, 95.0f), GetPassTimerPercentile(cpu, 99.0f),
+            (gpu->count > 0)? gpu->total/gpu->count : 0.0, GetPassTimerPercentile(gpu, 50.0f), GetPassTimerPercentile(gpu, 95.0f), GetPassTimerPercentile(gpu, 99.0f),
+            cpu->count);
+    }
+
+    if (timer->dropped > 0) TraceLog(LOG_INFO, "TIMER: %i GPU results were not ready in time and were dropped", timer->dropped);
+
+    if (timer->output != NULL) ExportPassTimerCSV(timer, timer->output);
+
+    if (timer->passCount > 0)
+    {
+        for (int i = 0; i < PASS_TIMER_FRAMES; i++) glDeleteQueries(timer->passCount, timer->queries[i]);
+    }
+
+    RL_FREE(timer->records);
+
+    *timer = (PassTimer){ 0 };
+}
+
+void UpdatePassTimer(PassTimer *timer)
+{
+    if (timer->passCount == 0) return;
+
+    // The frame that just ended adds its CPU sum
+    if (timer->frame > 0) AddPassTimerSample(&timer->cpu[timer->passCount], timer->frameCpu);
+    timer->frameCpu = 0.0f;
+
+    // The oldest set goes next, its queries were issued PASS_TIMER_FRAMES - 1 frames ago
+    timer->slot = (timer->slot + 1)%PASS_TIMER_FRAMES;
+    timer->frame++;
+
+    float frameGpu = 0.0f;
+    bool frameIssued = false;
+    bool frameComplete = true;
+
+    for (int i = 0; i < timer->passCount; i++)
+    {
+        if (!timer->issued[timer->slot][i]) continue;
+
+        unsigned int query = timer->queries[timer->slot][i];
+        int record = timer->pending[timer->slot][i];
+        timer->issued[timer->slot][i] = false;
+        timer->pending[timer->slot][i] = -1;
+        frameIssued = true;
+
+        // The query is begun again this frame, a late result is lost instead of waited for
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            timer->dropped++;
+            frameComplete = false;
+            continue;
+        }
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+
+        float ms = (float)(elapsed*1e-6);
+        timer->time[i] = (timer->gpu[i].count == 0)? ms : timer->time[i] + (ms - timer->time[i])*PASS_TIMER_SMOOTHING;
+        AddPassTimerSample(&timer->gpu[i], ms);
+        if (record >= 0) timer->records[record].gpu = ms;
+        frameGpu += ms;
+    }
+
+    if (frameIssued && frameComplete) AddPassTimerSample(&timer->gpu[timer->passCount], frameGpu);
+}
+
+void BeginPassTimer(PassTimer *timer, int pass)
+{
+    if ((pass < 0) || (pass >= timer->passCount) || (timer->active >= 0)) return;
+
+    // What the batch still holds belongs to the previous scope
+    rlDrawRenderBatchActive();
+
+    timer->active = pass;
+    timer->activeStart = GetTime();
+    glBeginQuery(GL_TIME_ELAPSED, timer->queries[timer->slot][pass]);
+}
+
+void EndPassTimer(PassTimer *timer)
+{
+    if (timer->active < 0) return;
+
+    int pass = timer->active;
+
+    rlDrawRenderBatchActive();
+    glEndQuery(GL_TIME_ELAPSED);
+
+    float ms = (float)((GetTime() - timer->activeStart)*1000.0);
+    timer->cpuTime[pass] = (timer->cpu[pass].count == 0)? ms : timer->cpuTime[pass] + (ms - timer->cpuTime[pass])*PASS_TIMER_SMOOTHING;
+    AddPassTimerSample(&timer->cpu[pass], ms);
+    timer->frameCpu += ms;
+
+    timer->issued[timer->slot][pass] = true;
+    timer->active = -1;
+
+    // Keep the sample for the CSV, its GPU time is filled in when the query is read
+    if (timer->output != NULL)
+    {
+        if (timer->recordCount == timer->recordCapacity)
+        {
+            int capacity = (timer->recordCapacity > 0)? timer->recordCapacity*2 : 1024;
+            PassTimerRecord *records = (PassTimerRecord *)RL_REALLOC(timer->records, capacity*sizeof(PassTimerRecord));
+            if (records == NULL) return;
+
+            timer->records = records;
+            timer->recordCapacity = capacity;
+        }
+
+        timer->records[timer->recordCount] = (PassTimerRecord){ timer->frame, pass, ms, -1.0f };
+        timer->pending[timer->slot][pass] = timer->recordCount;
+        timer->recordCount++;
+    }
+}
+
+float GetPassTimerPercentile(const PassTimerHistory *history, float percentile)
+{
+    int count = (history->count < PASS_TIMER_HISTORY)? history->count : PASS_TIMER_HISTORY;
+    if (count == 0) return 0.0f;
+
+    float sorted[PASS_TIMER_HISTORY];
+    memcpy(sorted, history->samples, count*sizeof(float));
+    qsort(sorted, count, sizeof(float), ComparePassTimerSamples);
+
+    // Nearest rank
+    int rank = (int)(percentile/100.0f*count + 0.999f) - 1;
+    if (rank < 0) rank = 0;
+    if (rank > count - 1) rank = count - 1;
+
+    return sorted[rank];
+}
+
+void DrawPassTimer(const PassTimer *timer, int posX, int posY)
+{
+    const int fontSize = 10;
+    const int lineHeight = 12;
+    const int nameWidth = 60;
+    const int valueWidth = 40;
+    const int cpuX = posX + 4 + nameWidth;
+    const int gpuX = cpuX + 3*valueWidth + 10;
+
+    int rows = 0;
+    for (int i = 0; i <= timer->passCount; i++) rows += (timer->cpu[i].count > 0)? 1 : 0;
+
+    DrawRectangle(posX, posY, 4 + nameWidth + 6*valueWidth + 14, (rows + 1)*lineHeight + 4, Fade(RAYWHITE, 0.8f));
+
+    int y = posY + 2;
+    DrawText("ms", posX + 4, y, fontSize, DARKGRAY);
+    DrawText("CPU p50/p95/p99", cpuX, y, fontSize, DARKGRAY);
+    DrawText("GPU p50/p95/p99", gpuX, y, fontSize, DARKGRAY);
+
+    for (int i = 0; i <= timer->passCount; i++)
+    {
+        if (timer->cpu[i].count == 0) continue;
+
+        const float percentiles[3] = { 50.0f, 95.0f, 99.0f };
+        y += lineHeight;
+
+        DrawText((i < timer->passCount)? timer->names[i] : "Frame", posX + 4, y, fontSize, BLACK);
+        for (int j = 0; j < 3; j++)
+        {
+            DrawText(TextFormat("%.2f", GetPassTimerPercentile(&timer->cpu[i], percentiles[j])), cpuX + j*valueWidth, y, fontSize, BLACK);
+            DrawText(TextFormat("%.2f", GetPassTimerPercentile(&timer->gpu[i], percentiles[j])), gpuX + j*valueWidth, y, fontSize, BLACK);
+        }
+    }
+}
+
+bool ExportPassTimerCSV(const PassTimer *timer, const char *fileName)
+{
+    FILE *file = fopen(fileName, "w");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "TIMER: [%s] Failed to open the timings file", fileName);
+        return false;
+    }
+
+    fprintf(file, "frame,pass,cpu_ms,gpu_ms\n");
+    for (int i = 0; i < timer->recordCount; i++)
+    {
+        const PassTimerRecord *record = &timer->records[i];
+
+        if (record->gpu >= 0.0f) fprintf(file, "%i,%s,%.4f,%.4f\n", record->frame, timer->names[record->pass], record->cpu, record->gpu);
+        else fprintf(file, "%i,%s,%.4f,\n", record->frame, timer->names[record->pass], record->cpu);
+    }
+
+    fclose(file);
+
+    TraceLog(LOG_INFO, "TIMER: [%s] %i pass timings written", fileName, timer->recordCount);
+
+    return true;
+}
+
+#endif // PASS_TIMER_IMPLEMENTATION
@@ -0,0 +1,223 @@
+/**********************************************************************************************
+*
+*   shader_cache - On-disk cache of linked GL program binaries, skips shader compilation on
+*                  warm starts
+*
+*   Single header module, define SHADER_CACHE_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   Drop-in for LoadShader(), the program binary (glGetProgramBinary) goes to an env_cache
+*   file next to the fragment shader, <dir>/<name>.program_<vs>.cache, where <vs> is the hash
+*   of the vertex shader path: programs sharing a fragment shader (resources/depth_only.fs
+*   behind several vertex shaders) keep one file each instead of replacing each other's:
+*
+*       sourceHash  -> FNV-1a of the vertex and fragment source text
+*       optionsHash -> FNV-1a of GL_VENDOR, GL_RENDERER, GL_VERSION and RAYLIB_VERSION
+*       format      -> binary format returned by the driver
+*
+*   A driver or source change misses and the program is compiled and cached again. When the
+*   driver rejects a binary that did match (glProgramBinary() failing to link) the file is
+*   removed and the source is compiled, so a stale cache costs one compile and never a broken
+*   shader. Drivers without binary formats always compile from source
+*
+*   Every load logs its time, the warm one next to the compile time of the run that cached it
+*
+*   NOTE: raylib links the program itself, so PROGRAM_BINARY_RETRIEVABLE_HINT can not be set
+*   before linking. Mesa and the desktop drivers hand out binaries without it, a driver that
+*   returns none is logged and keeps compiling from source
+*
+**********************************************************************************************/
+
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include "raylib.h"
+
+Shader LoadShaderCached(const char *vsFileName, const char *fsFileName);                         // LoadShader() through the binary cache
+Shader LoadShaderFromMemoryCached(const char *vsCode, const char *fsCode, const char *cachePath); // LoadShaderFromMemory() through a given cache file
+
+#endif // SHADER_CACHE_H
+
+#if defined(SHADER_CACHE_IMPLEMENTATION) && !defined(SHADER_CACHE_IMPLEMENTED)
+#define SHADER_CACHE_IMPLEMENTED
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rlgl.h"
+#include "external/glad.h"      // Raw GL entry points loaded by raylib, rlgl has no program binary calls
+
+#define ENV_CACHE_IMPLEMENTATION
+#include "env_cache.h"
+
+// Key of the driver, a binary only loads on the driver build that produced it
+static unsigned long long GetShaderCacheDriverHash(void)
+{
+    const char *strings[4] = {
+        (const char *)glGetString(GL_VENDOR),
+        (const char *)glGetString(GL_RENDERER),
+        (const char *)glGetString(GL_VERSION),
+        RAYLIB_VERSION          // Default vertex shader and bound attribute locations
+    };
+
+    unsigned long long hash = ENV_HASH_SEED;
+    for (int i = 0; i < 4; i++)
+    {
+        if (strings[i] != NULL) hash = HashMemory(strings[i], strlen(strings[i]) + 1, hash);
+    }
+
+    return hash;
+}
+
+// Same locations LoadShaderFromMemory() sets up, binaries skip it
+static void SetShaderDefaultLocations(Shader *shader)
+{
+    shader->locs = (int *)RL_CALLOC(RL_MAX_SHADER_LOCATIONS, sizeof(int));
+    for (int i = 0; i < RL_MAX_SHADER_LOCATIONS; i++) shader->locs[i] = -1;
+
+    shader->locs[SHADER_LOC_VERTEX_POSITION] = rlGetLocationAttrib(shader->id, RL_DEFAULT_SHADER_ATTRIB_NAME_POSITION);
+    shader->locs[SHADER_LOC_VERTEX_TEXCOORD01] = rlGetLocationAttrib(shader->id, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD);
+    shader->locs[SHADER_LOC_VERTEX_TEXCOORD02] = rlGetLocationAttrib(shader->id, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD2);
+    shader->locs[SHADER_LOC_VERTEX_NORMAL] = rlGetLocationAttrib(shader->id, RL_DEFAULT_SHADER_ATTRIB_NAME_NORMAL);
+    shader->locs[SHADER_LOC_VERTEX_TANGENT] = rlGetLocationAttrib(shader->id, RL_DEFAULT_SHADER_ATTRIB_NAME_TANGENT);
+    shader->locs[SHADER_LOC_VERTEX_COLOR] = rlGetLocationAttrib(shader->id, RL_DEFAULT_SHADER_ATTRIB_NAME_COLOR);
+    shader->locs[SHADER_LOC_VERTEX_BONEIDS] = rlGetLocationAttrib(shader->id, RL_DEFAULT_SHADER_ATTRIB_NAME_BONEIDS);
+    shader->locs[SHADER_LOC_VERTEX_BONEWEIGHTS] = rlGetLocationAttrib(shader->id, RL_DEFAULT_SHADER_ATTRIB_NAME_BONEWEIGHTS);
+
+    shader->locs[SHADER_LOC_MATRIX_MVP] = rlGetLocationUniform(shader->id, RL_DEFAULT_SHADER_UNIFORM_NAME_MVP);
+    shader->locs[SHADER_LOC_MATRIX_VIEW] = rlGetLocationUniform(shader->id, RL_DEFAULT_SHADER_UNIFORM_NAME_VIEW);
+    shader->locs[SHADER_LOC_MATRIX_PROJECTION] = rlGetLocationUniform(shader->id, RL_DEFAULT_SHADER_UNIFORM_NAME_PROJECTION);
+    shader->locs[SHADER_LOC_MATRIX_MODEL] = rlGetLocationUniform(shader->id, RL_DEFAULT_SHADER_UNIFORM_NAME_MODEL);
+    shader->locs[SHADER_LOC_MATRIX_NORMAL] = rlGetLocationUniform(shader->id, RL_DEFAULT_SHADER_UNIFORM_NAME_NORMAL);
+    shader->locs[SHADER_LOC_BONE_MATRICES] = rlGetLocationUniform(shader->id, RL_DEFAULT_SHADER_UNIFORM_NAME_BONE_MATRICES);
+
+    shader->locs[SHADER_LOC_COLOR_DIFFUSE] = rlGetLocationUniform(shader->id, RL_DEFAULT_SHADER_UNIFORM_NAME_COLOR);
+    shader->locs[SHADER_LOC_MAP_DIFFUSE] = rlGetLocationUniform(shader->id, RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE0);
+    shader->locs[SHADER_LOC_MAP_SPECULAR] = rlGetLocationUniform(shader->id, RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE1);
+    shader->locs[SHADER_LOC_MAP_NORMAL] = rlGetLocationUniform(shader->id, RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE2);
+}
+
+// Program from a cached binary, id 0 when the driver rejects it
+static Shader LoadShaderBinary(const EnvCacheFile *cache)
+{
+    Shader shader = { 0 };
+
+    shader.id = glCreateProgram();
+    glProgramBinary(shader.id, (GLenum)cache->header.format, cache->data, (GLsizei)cache->header.dataSize);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(shader.id, GL_LINK_STATUS, &linked);
+
+    if (linked != GL_TRUE)
+    {
+        glDeleteProgram(shader.id);
+        shader.id = 0;
+        return shader;
+    }
+
+    SetShaderDefaultLocations(&shader);
+
+    return shader;
+}
+
+static void SaveShaderBinary(Shader shader, const char *cachePath, EnvCacheHeader header)
+{
+    GLint length = 0;
+    glGetProgramiv(shader.id, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0)
+    {
+        TraceLog(LOG_INFO, "SHADER: [%s] Driver returned no program binary, not cached", cachePath);
+        return;
+    }
+
+    void *data = RL_MALLOC(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(shader.id, length, &written, &format, data);
+
+    header.format = (int)format;
+    header.dataSize = written;
+
+    if (written > 0) SaveEnvCache(cachePath, header, data);
+
+    RL_FREE(data);
+}
+
+Shader LoadShaderFromMemoryCached(const char *vsCode, const char *fsCode, const char *cachePath)
+{
+    double startTime = GetTime();
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+    // No binary support (or no entry points loaded), plain source compilation
+    if ((formatCount <= 0) || (glProgramBinary == NULL) || (glGetProgramBinary == NULL) || (cachePath == NULL))
+    {
+        Shader shader = LoadShaderFromMemory(vsCode, fsCode);
+        TraceLog(LOG_INFO, "SHADER: [ID %i] Program compiled in %.2f ms (no binary cache)", shader.id, (GetTime() - startTime)*1000.0);
+        return shader;
+    }
+
+    // A NULL stage is raylib's default shader, hashed as an empty source
+    unsigned long long sourceHash = HashMemory((vsCode != NULL)? vsCode : "", (vsCode != NULL)? strlen(vsCode) + 1 : 1, ENV_HASH_SEED);
+    sourceHash = HashMemory((fsCode != NULL)? fsCode : "", (fsCode != NULL)? strlen(fsCode) + 1 : 1, sourceHash);
+    unsigned long long optionsHash = GetShaderCacheDriverHash();
+
+    EnvCacheFile cache = { 0 };
+    if (MapEnvCache(cachePath, sourceHash, optionsHash, &cache))
+    {
+        Shader shader = LoadShaderBinary(&cache);
+        float buildTime = cache.header.buildTime;
+        UnmapEnvCache(&cache);
+
+        if (shader.id != 0)
+        {
+            TraceLog(LOG_INFO, "SHADER: [%s] Program loaded from binary cache in %.2f ms (compiled in %.2f ms)", cachePath, (GetTime() - startTime)*1000.0, buildTime*1000.0f);
+            return shader;
+        }
+
+        TraceLog(LOG_WARNING, "SHADER: [%s] Driver rejected the cached binary, compiling from source", cachePath);
+        remove(cachePath);
+    }
+
+    Shader shader = LoadShaderFromMemory(vsCode, fsCode);
+    float buildTime = (float)(GetTime() - startTime);
+
+    // A failed build is raylib's default program, nothing worth caching
+    if (shader.id == rlGetShaderIdDefault()) return shader;
+
+    EnvCacheHeader header = { 0 };
+    header.sourceHash = sourceHash;
+    header.optionsHash = optionsHash;
+    header.buildTime = buildTime;
+    SaveShaderBinary(shader, cachePath, header);
+
+    TraceLog(LOG_INFO, "SHADER: [%s] Program compiled in %.2f ms", cachePath, buildTime*1000.0f);
+
+    return shader;
+}
+
+Shader LoadShaderCached(const char *vsFileName, const char *fsFileName)
+{
+    char *vsCode = (vsFileName != NULL)? LoadFileText(vsFileName) : NULL;
+    char *fsCode = (fsFileName != NULL)? LoadFileText(fsFileName) : NULL;
+
+    // Cached next to the fragment shader, it is the one every demo has, tagged with the vertex shader
+    // it is linked to (NULL, raylib's default, hashes as an empty path)
+    char cachePath[512] = { 0 };
+    char tag[32] = { 0 };
+    const char *cacheSource = (fsFileName != NULL)? fsFileName : vsFileName;
+    unsigned long long vsHash = HashMemory((vsFileName != NULL)? vsFileName : "", (vsFileName != NULL)? strlen(vsFileName) : 0, ENV_HASH_SEED);
+    snprintf(tag, sizeof(tag), "program_%08x", (unsigned int)(vsHash ^ (vsHash >> 32)));
+    if (cacheSource != NULL) GetEnvCachePath(cacheSource, tag, cachePath, sizeof(cachePath));
+
+    Shader shader = LoadShaderFromMemoryCached(vsCode, fsCode, (cacheSource != NULL)? cachePath : NULL);
+
+    UnloadFileText(vsCode);
+    UnloadFileText(fsCode);
+
+    return shader;
+}
+
+#endif // SHADER_CACHE_IMPLEMENTATION
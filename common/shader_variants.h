@@ -0,0 +1,188 @@
+/**********************************************************************************************
+*
+*   shader_variants - Compile time shader permutations, built on first use and cached
+*
+*   Single header module, define SHADER_VARIANTS_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   Model selections that used to be int uniforms tested with if/else in the fragment shader
+*   are preprocessor defines instead, so every program holds a single straight line BRDF:
+*
+*       const char *defines[] = { "NDF_TYPE", "GSF_TYPE" };
+*       ShaderVariants variants = LoadShaderVariants("model.vs", "model.fs", defines, 2);
+*
+*       int values[2] = { ndfActive, gsfActive };
+*       Shader shader = GetShaderVariant(&variants, values);    // Compiled the first time only
+*
+*   The sources are read once, "#define NAME value" lines go right after the #version line of
+*   both stages, so a define can also switch vertex inputs (e.g. instancing). Values are 0..255.
+*   Every variant is its own program, so a switch needs the uniform locations queried again
+*   and every uniform that is not set per frame set again
+*
+*   Programs go through common/shader_cache.h, one binary per combination next to the fragment
+*   shader (<dir>/<name>.program_<set>_<key>.cache), so only the first use of a combination
+*   compiles. <set> hashes the vertex shader path and the define names in order, two variant
+*   sets over one fragment shader never share a file even when their values pack the same
+*
+**********************************************************************************************/
+
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "raylib.h"
+
+#define SHADER_VARIANT_MAX_DEFINES      8       // Each value takes 8 bits of the cache key
+
+typedef struct ShaderVariant {
+    unsigned long long key;                     // Define values packed 8 bits each
+    Shader shader;
+} ShaderVariant;
+
+typedef struct ShaderVariants {
+    char *vsCode;                               // NULL uses the raylib default vertex shader
+    char *fsCode;
+    char fsFileName[512];                       // Cache files go next to it
+    int defineCount;
+    const char *defineNames[SHADER_VARIANT_MAX_DEFINES];
+    unsigned int setHash;                       // Vertex shader path and define names, part of the cache tag
+    ShaderVariant *variants;                    // Compiled so far
+    int count;
+    int capacity;
+    int last;                                   // Returned by the previous call, the common case
+} ShaderVariants;
+
+ShaderVariants LoadShaderVariants(const char *vsFileName, const char *fsFileName, const char **defineNames, int defineCount);
+Shader GetShaderVariant(ShaderVariants *variants, const int *values);  // One value per define, compiled on first use
+void UnloadShaderVariants(ShaderVariants *variants);                  // Unload every compiled program
+
+#endif // SHADER_VARIANTS_H
+
+#if defined(SHADER_VARIANTS_IMPLEMENTATION) && !defined(SHADER_VARIANTS_IMPLEMENTED)
+#define SHADER_VARIANTS_IMPLEMENTED
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rlgl.h"               // rlGetShaderIdDefault(), to tell a failed build
+
+#define SHADER_CACHE_IMPLEMENTATION
+#include "shader_cache.h"
+
+ShaderVariants LoadShaderVariants(const char *vsFileName, const char *fsFileName, const char **defineNames, int defineCount)
+{
+    ShaderVariants variants = { 0 };
+
+    if ((defineCount < 0) || (defineCount > SHADER_VARIANT_MAX_DEFINES))
+    {
+        TraceLog(LOG_WARNING, "SHADER: [%s] %i defines given, at most %i are supported", fsFileName, defineCount, SHADER_VARIANT_MAX_DEFINES);
+        return variants;
+    }
+
+    if (vsFileName != NULL) variants.vsCode = LoadFileText(vsFileName);
+    variants.fsCode = LoadFileText(fsFileName);
+    snprintf(variants.fsFileName, sizeof(variants.fsFileName), "%s", fsFileName);
+
+    variants.defineCount = defineCount;
+    for (int i = 0; i < defineCount; i++) variants.defineNames[i] = defineNames[i];
+    variants.last = -1;
+
+    // The terminators keep the names apart, ("AB", "C") and ("A", "BC") hash differently
+    unsigned long long hash = HashMemory((vsFileName != NULL)? vsFileName : "", (vsFileName != NULL)? strlen(vsFileName) + 1 : 1, ENV_HASH_SEED);
+    for (int i = 0; i < defineCount; i++) hash = HashMemory(defineNames[i], strlen(defineNames[i]) + 1, hash);
+    variants.setHash = (unsigned int)(hash ^ (hash >> 32));
+
+    return variants;
+}
+
+// Copy of a stage source with the defines after the #version line, it has to stay first
+static char *BuildVariantCode(const ShaderVariants *variants, const char *code, const int *values)
+{
+    const char *body = code;
+
+    const char *version = strstr(code, "#version");
+    if (version != NULL)
+    {
+        const char *lineEnd = strchr(version, '\n');
+        body = (lineEnd != NULL)? lineEnd + 1 : version + strlen(version);
+    }
+
+    size_t headerSize = (size_t)(body - code);
+    size_t size = strlen(code) + 1 + variants->defineCount*(strlen("#define  \n") + 64 + 4);
+    for (int i = 0; i < variants->defineCount; i++) size += strlen(variants->defineNames[i]);
+
+    char *result = (char *)RL_MALLOC(size);
+    memcpy(result, code, headerSize);
+
+    // An unterminated #version line still needs its own line
+    size_t length = headerSize;
+    if ((headerSize > 0) && (code[headerSize - 1] != '\n')) result[length++] = '\n';
+
+    for (int i = 0; i < variants->defineCount; i++)
+    {
+        length += sprintf(result + length, "#define %s %i\n", variants->defineNames[i], values[i]);
+    }
+
+    strcpy(result + length, body);
+
+    return result;
+}
+
+Shader GetShaderVariant(ShaderVariants *variants, const int *values)
+{
+    unsigned long long key = 0;
+    for (int i = 0; i < variants->defineCount; i++) key |= (unsigned long long)(values[i] & 0xff) << (8*i);
+
+    if ((variants->last >= 0) && (variants->variants[variants->last].key == key)) return variants->variants[variants->last].shader;
+
+    for (int i = 0; i < variants->count; i++)
+    {
+        if (variants->variants[i].key == key)
+        {
+            variants->last = i;
+            return variants->variants[i].shader;
+        }
+    }
+
+    if (variants->fsCode == NULL) return (Shader){ 0 };
+
+    char tag[48] = { 0 };
+    char cachePath[512] = { 0 };
+    snprintf(tag, sizeof(tag), "program_%08x_%016llx", variants->setHash, key);
+    GetEnvCachePath(variants->fsFileName, tag, cachePath, sizeof(cachePath));
+
+    char *vsCode = (variants->vsCode != NULL)? BuildVariantCode(variants, variants->vsCode, values) : NULL;
+    char *fsCode = BuildVariantCode(variants, variants->fsCode, values);
+    Shader shader = LoadShaderFromMemoryCached(vsCode, fsCode, cachePath);
+    RL_FREE(vsCode);
+    RL_FREE(fsCode);
+
+    // raylib falls back to its default program, keep it cached so a broken variant is not rebuilt every frame
+    if (shader.id == rlGetShaderIdDefault()) TraceLog(LOG_WARNING, "SHADER: Variant %016llx failed to compile, using the default shader", key);
+    else TraceLog(LOG_INFO, "SHADER: [ID %i] Built variant %i (key %016llx)", shader.id, variants->count, key);
+
+    if (variants->count == variants->capacity)
+    {
+        variants->capacity = (variants->capacity == 0)? 16 : 2*variants->capacity;
+        variants->variants = (ShaderVariant *)RL_REALLOC(variants->variants, variants->capacity*sizeof(ShaderVariant));
+    }
+
+    variants->variants[variants->count] = (ShaderVariant){ key, shader };
+    variants->last = variants->count;
+    variants->count++;
+
+    return shader;
+}
+
+void UnloadShaderVariants(ShaderVariants *variants)
+{
+    // UnloadShader() leaves the default program alone
+    for (int i = 0; i < variants->count; i++) UnloadShader(variants->variants[i].shader);
+
+    RL_FREE(variants->variants);
+    UnloadFileText(variants->vsCode);
+    UnloadFileText(variants->fsCode);
+
+    *variants = (ShaderVariants){ 0 };
+}
+
+#endif // SHADER_VARIANTS_IMPLEMENTATION
@@ -0,0 +1,932 @@
+/**********************************************************************************************
+*
+*   soft_raster - Tile-based CPU rasterizer for the polygon shading demos
+*
+*   Single header module, define SOFT_RASTER_IMPLEMENTATION in exactly one translation unit
+*   before including it
+*
+*   Renders a raylib Mesh with the lighting of polygon_shading_methods/, no GL involved:
+*
+*       SOFT_SHADING_FLAT       shading_flat.fs, one normal per triangle (provoking vertex)
+*       SOFT_SHADING_GOURAUD    shading_gouraud.vs, lit per vertex, color interpolated
+*       SOFT_SHADING_PHONG      shading_phong.fs, normal and position interpolated, lit per pixel
+*
+*   DrawSoftMesh() runs three ParallelFor() passes on the persistent worker pool of
+*   common/parallel.h (ClearSoftRaster() a fourth), a pass wakes the workers, none are created:
+*
+*       vertex      transform to clip space, world position and normal (and the Gouraud color)
+*       setup/bin   clip against the near/far planes and a guard band, snap to 1/16 pixel, cull
+*                   back faces, bin into SOFT_TILE_SIZE tiles. Bins are merged in triangle order
+*       raster      one task per tile, edge functions, depth test and shading 8 (AVX2) or 4 (SSE2)
+*                   pixels at a time, then the tile is copied to the output pixels
+*
+*   A tile only ever sees its triangles in submission order, so the image is the same for any
+*   thread count. Shared edges are evaluated from the same ordered vertex pair with the top-left
+*   rule, no pixel is drawn twice or missed along an edge
+*
+*   Conventions follow GL and raylib: counter-clockwise front faces with back faces culled,
+*   GL_LEQUAL depth, last vertex as the provoking one, projection from the camera as BeginMode3D()
+*   builds it. Output pixels are RGBA8 rows top to bottom (an Image layout), ready for
+*   UpdateTexture()
+*
+**********************************************************************************************/
+
+#ifndef SOFT_RASTER_H
+#define SOFT_RASTER_H
+
+#include "raylib.h"
+
+#define SOFT_TILE_SIZE      32          // Tile edge in pixels, a multiple of the SIMD width
+
+typedef enum {
+    SOFT_SHADING_FLAT = 0,
+    SOFT_SHADING_GOURAUD,
+    SOFT_SHADING_PHONG
+} SoftShading;
+
+// Uniforms of the polygon shading shaders
+typedef struct SoftLight {
+    Vector3 lightPos;
+    Vector3 lightColor;
+    Vector3 objectColor;
+    Vector3 viewPos;
+} SoftLight;
+
+// Timings of the last DrawSoftMesh() call, in seconds
+typedef struct SoftRasterStats {
+    double vertexTime;
+    double setupTime;           // Clipping, culling and binning
+    double rasterTime;          // Coverage, depth and pixel shading
+    int triangleCount;          // Triangles that reached the binner
+    int binCount;               // Triangle/tile pairs
+} SoftRasterStats;
+
+typedef struct SoftRasterScratch SoftRasterScratch;
+
+typedef struct SoftRaster {
+    int width;
+    int height;
+    int tilesX;
+    int tilesY;
+    unsigned char *pixels;      // width*height RGBA8, top row first
+    Texture2D texture;          // Display texture, only created when a window is open
+    SoftRasterStats stats;
+    SoftRasterScratch *scratch; // Padded color/depth targets, vertex and bin storage
+} SoftRaster;
+
+SoftRaster LoadSoftRaster(int width, int height);
+void UnloadSoftRaster(SoftRaster *raster);
+void ClearSoftRaster(SoftRaster *raster, Color color);                  // Color and depth
+void DrawSoftMesh(SoftRaster *raster, Mesh mesh, Matrix transform, Camera camera, SoftShading shading, SoftLight light);
+void DrawSoftRaster(SoftRaster *raster, int posX, int posY);            // Upload the pixels and draw them
+
+#endif // SOFT_RASTER_H
+
+#if defined(SOFT_RASTER_IMPLEMENTATION) && !defined(SOFT_RASTER_IMPLEMENTED)
+#define SOFT_RASTER_IMPLEMENTED
+
+#include <math.h>
+#include <string.h>
+
+#include "raymath.h"
+#include "rlgl.h"                   // RL_CULL_DISTANCE_NEAR/FAR, same planes as BeginMode3D()
+
+#define PARALLEL_IMPLEMENTATION
+#include "parallel.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SOFT_RASTER_BACKEND "AVX2"
+    #define SOFT_LANES 8
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+    #define SOFT_RASTER_BACKEND "SSE2"
+    #define SOFT_LANES 4
+#else
+    #define SOFT_RASTER_BACKEND "scalar"
+    #define SOFT_LANES 1
+#endif
+
+#define SOFT_VERTEX_CHUNK   1024        // Vertices per vertex task
+#define SOFT_SETUP_CHUNK    256         // Source triangles per setup task
+#define SOFT_MAX_CLIPPED    7           // Triangles one source triangle can turn into (6 planes)
+#define SOFT_SUBPIXEL       16.0f       // Vertex snapping grid
+#define SOFT_GUARD_BAND     8192.0f     // Max distance of a vertex from the screen center in pixels
+
+// Vertex stage output
+typedef struct SoftVertex {
+    float clip[4];
+    float position[3];          // World space
+    float normal[3];            // World space, not normalized (the shaders normalize per pixel)
+    float color[3];             // Gouraud only
+} SoftVertex;
+
+// Triangle ready for the tiles, attributes are premultiplied by 1/w for perspective correct interpolation
+typedef struct SoftTriangle {
+    float edgeX[3];             // Edge k is opposite vertex k, evaluated from its lower (y, x) endpoint
+    float edgeY[3];
+    float edgeDx[3];
+    float edgeDy[3];
+    float edgeSign[3];          // +1/-1, interior is positive
+    bool topLeft[3];
+    float invArea;
+    float z[3];                 // Window depth, [0, 1]
+    float invW[3];
+    float attr[3][6];
+    float flatNormal[3];        // Normalized provoking vertex normal
+    int minX, minY, maxX, maxY; // Pixels whose centers can be covered
+} SoftTriangle;
+
+typedef struct SoftBinEntry {
+    int tile;
+    int triangle;
+} SoftBinEntry;
+
+// Bins of one setup task, kept between frames
+typedef struct SoftSetupBins {
+    SoftBinEntry *entries;
+    int count;
+    int capacity;
+    int triangleCount;
+} SoftSetupBins;
+
+struct SoftRasterScratch {
+    int stride;                 // Padded target width, tilesX*SOFT_TILE_SIZE
+    unsigned int *color;        // Padded RGBA8 target
+    float *depth;               // Padded depth target
+
+    SoftVertex *vertices;
+    int vertexCapacity;
+    SoftTriangle *triangles;    // SOFT_SETUP_CHUNK*SOFT_MAX_CLIPPED slots per setup task
+    int triangleCapacity;
+    SoftSetupBins *bins;
+    int binsCapacity;
+    int *tileStart;             // tileCount + 1 offsets into tileTriangles
+    int *tileTriangles;
+    int tileTrianglesCapacity;
+};
+
+// Per draw state shared by the tasks
+typedef struct SoftDrawJob {
+    SoftRaster *raster;
+    Mesh mesh;
+    int triangleCount;
+    Matrix mvp;
+    Matrix model;
+    Matrix normalMatrix;
+    SoftShading shading;
+    SoftLight light;
+    Color clearColor;
+} SoftDrawJob;
+
+//----------------------------------------------------------------------------------
+// SIMD helpers, SoftV holds SOFT_LANES floats, masks are all bits set per lane
+//----------------------------------------------------------------------------------
+#if defined(__AVX2__)
+typedef __m256 SoftV;
+
+static inline SoftV SoftSet(float x) { return _mm256_set1_ps(x); }
+static inline SoftV SoftLanes(void) { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+static inline SoftV SoftLoad(const float *p) { return _mm256_loadu_ps(p); }
+static inline void SoftStore(float *p, SoftV a) { _mm256_storeu_ps(p, a); }
+static inline SoftV SoftAdd(SoftV a, SoftV b) { return _mm256_add_ps(a, b); }
+static inline SoftV SoftSub(SoftV a, SoftV b) { return _mm256_sub_ps(a, b); }
+static inline SoftV SoftMul(SoftV a, SoftV b) { return _mm256_mul_ps(a, b); }
+static inline SoftV SoftDiv(SoftV a, SoftV b) { return _mm256_div_ps(a, b); }
+static inline SoftV SoftMin(SoftV a, SoftV b) { return _mm256_min_ps(a, b); }
+static inline SoftV SoftMax(SoftV a, SoftV b) { return _mm256_max_ps(a, b); }
+static inline SoftV SoftSqrt(SoftV a) { return _mm256_sqrt_ps(a); }
+static inline SoftV SoftGreater(SoftV a, SoftV b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline SoftV SoftGreaterEqual(SoftV a, SoftV b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+static inline SoftV SoftLessEqual(SoftV a, SoftV b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static inline SoftV SoftAnd(SoftV a, SoftV b) { return _mm256_and_ps(a, b); }
+static inline SoftV SoftSelect(SoftV mask, SoftV a, SoftV b) { return _mm256_blendv_ps(b, a, mask); }
+static inline int SoftAny(SoftV mask) { return _mm256_movemask_ps(mask); }
+
+// Clamp to [0, 1], scale to bytes and write the covered lanes as opaque RGBA8
+static inline void SoftStoreColor(unsigned int *dst, SoftV mask, SoftV r, SoftV g, SoftV b)
+{
+    const __m256 scale = _mm256_set1_ps(255.0f);
+    __m256i ri = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(r, _mm256_setzero_ps()), _mm256_set1_ps(1.0f)), scale));
+    __m256i gi = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(g, _mm256_setzero_ps()), _mm256_set1_ps(1.0f)), scale));
+    __m256i bi = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(b, _mm256_setzero_ps()), _mm256_set1_ps(1.0f)), scale));
+    __m256i rgba = _mm256_or_si256(_mm256_or_si256(ri, _mm256_slli_epi32(gi, 8)), _mm256_or_si256(_mm256_slli_epi32(bi, 16), _mm256_set1_epi32((int)0xff000000)));
+
+    __m256i old = _mm256_loadu_si256((const __m256i *)dst);
+    _mm256_storeu_si256((__m256i *)dst, _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(old), _mm256_castsi256_ps(rgba), mask)));
+}
+#elif defined(__SSE2__)
+typedef __m128 SoftV;
+
+static inline SoftV SoftSet(float x) { return _mm_set1_ps(x); }
+static inline SoftV SoftLanes(void) { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+static inline SoftV SoftLoad(const float *p) { return _mm_loadu_ps(p); }
+static inline void SoftStore(float *p, SoftV a) { _mm_storeu_ps(p, a); }
+static inline SoftV SoftAdd(SoftV a, SoftV b) { return _mm_add_ps(a, b); }
+static inline SoftV SoftSub(SoftV a, SoftV b) { return _mm_sub_ps(a, b); }
+static inline SoftV SoftMul(SoftV a, SoftV b) { return _mm_mul_ps(a, b); }
+static inline SoftV SoftDiv(SoftV a, SoftV b) { return _mm_div_ps(a, b); }
+static inline SoftV SoftMin(SoftV a, SoftV b) { return _mm_min_ps(a, b); }
+static inline SoftV SoftMax(SoftV a, SoftV b) { return _mm_max_ps(a, b); }
+static inline SoftV SoftSqrt(SoftV a) { return _mm_sqrt_ps(a); }
+static inline SoftV SoftGreater(SoftV a, SoftV b) { return _mm_cmpgt_ps(a, b); }
+static inline SoftV SoftGreaterEqual(SoftV a, SoftV b) { return _mm_cmpge_ps(a, b); }
+static inline SoftV SoftLessEqual(SoftV a, SoftV b) { return _mm_cmple_ps(a, b); }
+static inline SoftV SoftAnd(SoftV a, SoftV b) { return _mm_and_ps(a, b); }
+static inline SoftV SoftSelect(SoftV mask, SoftV a, SoftV b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline int SoftAny(SoftV mask) { return _mm_movemask_ps(mask); }
+
+static inline void SoftStoreColor(unsigned int *dst, SoftV mask, SoftV r, SoftV g, SoftV b)
+{
+    const __m128 scale = _mm_set1_ps(255.0f);
+    __m128i ri = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(r, _mm_setzero_ps()), _mm_set1_ps(1.0f)), scale));
+    __m128i gi = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(g, _mm_setzero_ps()), _mm_set1_ps(1.0f)), scale));
+    __m128i bi = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(b, _mm_setzero_ps()), _mm_set1_ps(1.0f)), scale));
+    __m128i rgba = _mm_or_si128(_mm_or_si128(ri, _mm_slli_epi32(gi, 8)), _mm_or_si128(_mm_slli_epi32(bi, 16), _mm_set1_epi32((int)0xff000000)));
+
+    __m128i keep = _mm_castps_si128(mask);
+    __m128i old = _mm_loadu_si128((const __m128i *)dst);
+    _mm_storeu_si128((__m128i *)dst, _mm_or_si128(_mm_and_si128(keep, rgba), _mm_andnot_si128(keep, old)));
+}
+#else
+typedef float SoftV;
+
+// Masks are 0.0f or a NaN with all bits set, SoftAnd() is bitwise like the vector versions
+static inline unsigned int SoftBits(float x) { unsigned int u; memcpy(&u, &x, sizeof(u)); return u; }
+static inline float SoftMask(bool b) { unsigned int u = b? 0xffffffffu : 0u; float x; memcpy(&x, &u, sizeof(x)); return x; }
+
+static inline SoftV SoftSet(float x) { return x; }
+static inline SoftV SoftLanes(void) { return 0.0f; }
+static inline SoftV SoftLoad(const float *p) { return *p; }
+static inline void SoftStore(float *p, SoftV a) { *p = a; }
+static inline SoftV SoftAdd(SoftV a, SoftV b) { return a + b; }
+static inline SoftV SoftSub(SoftV a, SoftV b) { return a - b; }
+static inline SoftV SoftMul(SoftV a, SoftV b) { return a*b; }
+static inline SoftV SoftDiv(SoftV a, SoftV b) { return a/b; }
+static inline SoftV SoftMin(SoftV a, SoftV b) { return (a < b)? a : b; }
+static inline SoftV SoftMax(SoftV a, SoftV b) { return (a > b)? a : b; }
+static inline SoftV SoftSqrt(SoftV a) { return sqrtf(a); }
+static inline SoftV SoftGreater(SoftV a, SoftV b) { return SoftMask(a > b); }
+static inline SoftV SoftGreaterEqual(SoftV a, SoftV b) { return SoftMask(a >= b); }
+static inline SoftV SoftLessEqual(SoftV a, SoftV b) { return SoftMask(a <= b); }
+static inline SoftV SoftAnd(SoftV a, SoftV b) { unsigned int u = SoftBits(a) & SoftBits(b); float x; memcpy(&x, &u, sizeof(x)); return x; }
+static inline SoftV SoftSelect(SoftV mask, SoftV a, SoftV b) { return (SoftBits(mask) != 0)? a : b; }
+static inline int SoftAny(SoftV mask) { return (SoftBits(mask) != 0); }
+
+static inline void SoftStoreColor(unsigned int *dst, SoftV mask, SoftV r, SoftV g, SoftV b)
+{
+    if (SoftBits(mask) == 0) return;
+
+    unsigned int ri = (unsigned int)lrintf(fminf(fmaxf(r, 0.0f), 1.0f)*255.0f);
+    unsigned int gi = (unsigned int)lrintf(fminf(fmaxf(g, 0.0f), 1.0f)*255.0f);
+    unsigned int bi = (unsigned int)lrintf(fminf(fmaxf(b, 0.0f), 1.0f)*255.0f);
+    *dst = ri | (gi << 8) | (bi << 16) | 0xff000000u;
+}
+#endif
+
+static inline SoftV SoftOr(SoftV a, SoftV b) { return SoftSelect(a, a, b); }
+
+// x^(2^n), the shaders use the integer exponents 16 and 32
+static inline SoftV SoftPow2n(SoftV x, int n)
+{
+    for (int i = 0; i < n; i++) x = SoftMul(x, x);
+    return x;
+}
+
+static inline float SoftPow2nScalar(float x, int n)
+{
+    for (int i = 0; i < n; i++) x = x*x;
+    return x;
+}
+
+//----------------------------------------------------------------------------------
+// Targets
+//----------------------------------------------------------------------------------
+
+SoftRaster LoadSoftRaster(int width, int height)
+{
+    SoftRaster raster = { 0 };
+
+    if ((width <= 0) || (height <= 0) || (width > (int)SOFT_GUARD_BAND) || (height > (int)SOFT_GUARD_BAND))
+    {
+        TraceLog(LOG_WARNING, "RASTER: Invalid target size %ix%i", width, height);
+        return raster;
+    }
+
+    raster.width = width;
+    raster.height = height;
+    raster.tilesX = (width + SOFT_TILE_SIZE - 1)/SOFT_TILE_SIZE;
+    raster.tilesY = (height + SOFT_TILE_SIZE - 1)/SOFT_TILE_SIZE;
+    raster.pixels = (unsigned char *)RL_CALLOC((size_t)width*height, 4);
+
+    SoftRasterScratch *scratch = (SoftRasterScratch *)RL_CALLOC(1, sizeof(SoftRasterScratch));
+    size_t padded = (size_t)raster.tilesX*raster.tilesY*SOFT_TILE_SIZE*SOFT_TILE_SIZE;
+    scratch->stride = raster.tilesX*SOFT_TILE_SIZE;
+    scratch->color = (unsigned int *)RL_CALLOC(padded, sizeof(unsigned int));
+    scratch->depth = (float *)RL_CALLOC(padded, sizeof(float));
+    scratch->tileStart = (int *)RL_CALLOC((size_t)raster.tilesX*raster.tilesY + 1, sizeof(int));
+    raster.scratch = scratch;
+
+    if (IsWindowReady())
+    {
+        Image image = { raster.pixels, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        raster.texture = LoadTextureFromImage(image);
+    }
+
+    TraceLog(LOG_INFO, "RASTER: %ix%i target, %ix%i tiles, %s, %i threads", width, height, raster.tilesX, raster.tilesY, SOFT_RASTER_BACKEND, GetWorkerCount());
+
+    return raster;
+}
+
+void UnloadSoftRaster(SoftRaster *raster)
+{
+    SoftRasterScratch *scratch = raster->scratch;
+
+    if (scratch != NULL)
+    {
+        for (int i = 0; i < scratch->binsCapacity; i++) RL_FREE(scratch->bins[i].entries);
+        RL_FREE(scratch->bins);
+        RL_FREE(scratch->color);
+        RL_FREE(scratch->depth);
+        RL_FREE(scratch->vertices);
+        RL_FREE(scratch->triangles);
+        RL_FREE(scratch->tileStart);
+        RL_FREE(scratch->tileTriangles);
+        RL_FREE(scratch);
+    }
+
+    if (raster->texture.id > 0) UnloadTexture(raster->texture);
+    RL_FREE(raster->pixels);
+
+    *raster = (SoftRaster){ 0 };
+}
+
+static void SoftClearRow(int index, void *userData)
+{
+    SoftDrawJob *job = (SoftDrawJob *)userData;
+    SoftRasterScratch *scratch = job->raster->scratch;
+    Color c = job->clearColor;
+    unsigned int rgba = (unsigned int)c.r | ((unsigned int)c.g << 8) | ((unsigned int)c.b << 16) | ((unsigned int)c.a << 24);
+
+    size_t start = (size_t)index*SOFT_TILE_SIZE*scratch->stride;
+    for (size_t i = start; i < start + (size_t)SOFT_TILE_SIZE*scratch->stride; i++)
+    {
+        scratch->color[i] = rgba;
+        scratch->depth[i] = 1.0f;
+    }
+
+    // Same for the visible part of the output
+    for (int y = index*SOFT_TILE_SIZE; (y < (index + 1)*SOFT_TILE_SIZE) && (y < job->raster->height); y++)
+    {
+        memcpy(job->raster->pixels + (size_t)y*job->raster->width*4, scratch->color + (size_t)y*scratch->stride, (size_t)job->raster->width*4);
+    }
+}
+
+void ClearSoftRaster(SoftRaster *raster, Color color)
+{
+    if (raster->scratch == NULL) return;
+
+    SoftDrawJob job = { 0 };
+    job.raster = raster;
+    job.clearColor = color;
+
+    ParallelFor(raster->tilesY, SoftClearRow, &job);
+}
+
+void DrawSoftRaster(SoftRaster *raster, int posX, int posY)
+{
+    if (raster->texture.id == 0) return;
+
+    UpdateTexture(raster->texture, raster->pixels);
+    DrawTexture(raster->texture, posX, posY, WHITE);
+}
+
+//----------------------------------------------------------------------------------
+// Vertex stage
+//----------------------------------------------------------------------------------
+
+// Gouraud lighting, shading_gouraud.vs
+static void SoftLightVertex(const SoftLight *light, const float *position, const float *normal, float *color)
+{
+    Vector3 P = { position[0], position[1], position[2] };
+    Vector3 N = Vector3Normalize((Vector3){ normal[0], normal[1], normal[2] });
+    Vector3 L = Vector3Normalize(Vector3Subtract(light->lightPos, P));
+    Vector3 V = Vector3Normalize(Vector3Subtract(light->viewPos, P));
+    Vector3 R = Vector3Subtract(Vector3Scale(N, 2.0f*Vector3DotProduct(N, L)), L);
+
+    float rawNdotL = Vector3DotProduct(N, L);
+    float NdotL = fmaxf(rawNdotL, 0.0001f);
+    float specular = (rawNdotL > 0.0f)? 0.5f*SoftPow2nScalar(fmaxf(Vector3DotProduct(V, R), 0.0f), 5) : 0.0f;
+
+    const float lightColor[3] = { light->lightColor.x, light->lightColor.y, light->lightColor.z };
+    const float objectColor[3] = { light->objectColor.x, light->objectColor.y, light->objectColor.z };
+
+    for (int i = 0; i < 3; i++) color[i] = 0.1f*lightColor[i]*objectColor[i] + objectColor[i]*lightColor[i]*NdotL + specular*lightColor[i];
+}
+
+static void SoftVertexTask(int index, void *userData)
+{
+    SoftDrawJob *job = (SoftDrawJob *)userData;
+    SoftVertex *vertices = job->raster->scratch->vertices;
+    const Matrix m = job->mvp;
+    const Matrix w = job->model;
+    const Matrix n = job->normalMatrix;
+
+    int start = index*SOFT_VERTEX_CHUNK;
+    int end = (start + SOFT_VERTEX_CHUNK < job->mesh.vertexCount)? start + SOFT_VERTEX_CHUNK : job->mesh.vertexCount;
+
+    for (int i = start; i < end; i++)
+    {
+        const float *p = job->mesh.vertices + i*3;
+        const float *nrm = job->mesh.normals + i*3;
+        SoftVertex *v = &vertices[i];
+
+        v->clip[0] = p[0]*m.m0 + p[1]*m.m4 + p[2]*m.m8 + m.m12;
+        v->clip[1] = p[0]*m.m1 + p[1]*m.m5 + p[2]*m.m9 + m.m13;
+        v->clip[2] = p[0]*m.m2 + p[1]*m.m6 + p[2]*m.m10 + m.m14;
+        v->clip[3] = p[0]*m.m3 + p[1]*m.m7 + p[2]*m.m11 + m.m15;
+
+        v->position[0] = p[0]*w.m0 + p[1]*w.m4 + p[2]*w.m8 + w.m12;
+        v->position[1] = p[0]*w.m1 + p[1]*w.m5 + p[2]*w.m9 + w.m13;
+        v->position[2] = p[0]*w.m2 + p[1]*w.m6 + p[2]*w.m10 + w.m14;
+
+        // mat3(matNormal)*vertexNormal, normalMatrix is computed once per draw like DrawMesh() does
+        v->normal[0] = nrm[0]*n.m0 + nrm[1]*n.m4 + nrm[2]*n.m8;
+        v->normal[1] = nrm[0]*n.m1 + nrm[1]*n.m5 + nrm[2]*n.m9;
+        v->normal[2] = nrm[0]*n.m2 + nrm[1]*n.m6 + nrm[2]*n.m10;
+
+        if (job->shading == SOFT_SHADING_GOURAUD) SoftLightVertex(&job->light, v->position, v->normal, v->color);
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Setup and binning
+//----------------------------------------------------------------------------------
+
+// Clip space vertex with its attributes, linear in clip space so clipping can lerp them
+typedef struct SoftClipVertex {
+    float clip[4];
+    float attr[6];
+} SoftClipVertex;
+
+// Signed distance to clip plane k: near, far, then the guard band left/right/bottom/top
+static inline float SoftPlaneDistance(const float *c, int k, float guardX, float guardY)
+{
+    switch (k)
+    {
+        case 0: return c[2] + c[3];
+        case 1: return c[3] - c[2];
+        case 2: return guardX*c[3] + c[0];
+        case 3: return guardX*c[3] - c[0];
+        case 4: return guardY*c[3] + c[1];
+        default: return guardY*c[3] - c[1];
+    }
+}
+
+// Sutherland-Hodgman against one plane, returns the new vertex count
+static int SoftClipPolygon(const SoftClipVertex *in, int count, SoftClipVertex *out, int k, float guardX, float guardY)
+{
+    int outCount = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        const SoftClipVertex *a = &in[i];
+        const SoftClipVertex *b = &in[(i + 1)%count];
+        float da = SoftPlaneDistance(a->clip, k, guardX, guardY);
+        float db = SoftPlaneDistance(b->clip, k, guardX, guardY);
+
+        if (da >= 0.0f) out[outCount++] = *a;
+
+        if ((da >= 0.0f) != (db >= 0.0f))
+        {
+            float t = da/(da - db);
+            SoftClipVertex *v = &out[outCount++];
+            for (int j = 0; j < 4; j++) v->clip[j] = a->clip[j] + (b->clip[j] - a->clip[j])*t;
+            for (int j = 0; j < 6; j++) v->attr[j] = a->attr[j] + (b->attr[j] - a->attr[j])*t;
+        }
+    }
+
+    return outCount;
+}
+
+// Project, snap, cull and prepare the edge functions, false for culled or empty triangles
+static bool SoftSetupTriangle(const SoftRaster *raster, const SoftClipVertex *v0, const SoftClipVertex *v1, const SoftClipVertex *v2, const float *flatNormal, SoftTriangle *tri)
+{
+    const SoftClipVertex *v[3] = { v0, v1, v2 };
+    float x[3], y[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        float invW = 1.0f/v[i]->clip[3];
+
+        // Viewport transform, y down like the output rows
+        x[i] = roundf((v[i]->clip[0]*invW*0.5f + 0.5f)*raster->width*SOFT_SUBPIXEL)/SOFT_SUBPIXEL;
+        y[i] = roundf((0.5f - v[i]->clip[1]*invW*0.5f)*raster->height*SOFT_SUBPIXEL)/SOFT_SUBPIXEL;
+
+        tri->z[i] = v[i]->clip[2]*invW*0.5f + 0.5f;
+        tri->invW[i] = invW;
+        for (int j = 0; j < 6; j++) tri->attr[i][j] = v[i]->attr[j]*invW;
+    }
+
+    // Counter-clockwise in GL (y up) is clockwise on screen, negative area, the rest is culled
+    float area = (x[1] - x[0])*(y[2] - y[0]) - (x[2] - x[0])*(y[1] - y[0]);
+    if (!(area < 0.0f)) return false;
+
+    float minX = fminf(x[0], fminf(x[1], x[2]));
+    float maxX = fmaxf(x[0], fmaxf(x[1], x[2]));
+    float minY = fminf(y[0], fminf(y[1], y[2]));
+    float maxY = fmaxf(y[0], fmaxf(y[1], y[2]));
+
+    // Pixels with centers inside the bounds
+    tri->minX = (int)ceilf(minX - 0.5f);
+    tri->maxX = (int)floorf(maxX - 0.5f);
+    tri->minY = (int)ceilf(minY - 0.5f);
+    tri->maxY = (int)floorf(maxY - 0.5f);
+    if (tri->minX < 0) tri->minX = 0;
+    if (tri->minY < 0) tri->minY = 0;
+    if (tri->maxX > raster->width - 1) tri->maxX = raster->width - 1;
+    if (tri->maxY > raster->height - 1) tri->maxY = raster->height - 1;
+    if ((tri->minX > tri->maxX) || (tri->minY > tri->maxY)) return false;
+
+    for (int k = 0; k < 3; k++)
+    {
+        int i = (k + 1)%3;
+        int j = (k + 2)%3;
+
+        // Directed edge i -> j keeps the interior positive on this winding, evaluate it from the
+        // lower (y, x) endpoint so the neighbour triangle computes the same value negated
+        bool swap = (y[j] < y[i]) || ((y[j] == y[i]) && (x[j] < x[i]));
+        int a = swap? j : i;
+        int b = swap? i : j;
+
+        tri->edgeX[k] = x[a];
+        tri->edgeY[k] = y[a];
+        tri->edgeDx[k] = x[b] - x[a];
+        tri->edgeDy[k] = y[b] - y[a];
+
+        // Swapped endpoints negate the function, flip it back so that the interior stays positive
+        tri->edgeSign[k] = swap? -1.0f : 1.0f;
+
+        // Gradient of the signed edge function, top edges point down (+y), left edges point right
+        float gx = tri->edgeSign[k]*tri->edgeDy[k];
+        float gy = -tri->edgeSign[k]*tri->edgeDx[k];
+        tri->topLeft[k] = (gx > 0.0f) || ((gx == 0.0f) && (gy > 0.0f));
+    }
+
+    tri->invArea = 1.0f/fabsf(area);
+    tri->flatNormal[0] = flatNormal[0];
+    tri->flatNormal[1] = flatNormal[1];
+    tri->flatNormal[2] = flatNormal[2];
+
+    return true;
+}
+
+static void SoftAddBin(SoftSetupBins *bins, int tile, int triangle)
+{
+    if (bins->count == bins->capacity)
+    {
+        bins->capacity = (bins->capacity > 0)? bins->capacity*2 : 1024;
+        bins->entries = (SoftBinEntry *)RL_REALLOC(bins->entries, (size_t)bins->capacity*sizeof(SoftBinEntry));
+    }
+
+    bins->entries[bins->count++] = (SoftBinEntry){ tile, triangle };
+}
+
+static void SoftSetupTask(int index, void *userData)
+{
+    SoftDrawJob *job = (SoftDrawJob *)userData;
+    SoftRaster *raster = job->raster;
+    SoftRasterScratch *scratch = raster->scratch;
+    SoftSetupBins *bins = &scratch->bins[index];
+    SoftTriangle *triangles = scratch->triangles + (size_t)index*SOFT_SETUP_CHUNK*SOFT_MAX_CLIPPED;
+    const unsigned short *indices = job->mesh.indices;
+
+    const float guardX = 2.0f*SOFT_GUARD_BAND/raster->width;
+    const float guardY = 2.0f*SOFT_GUARD_BAND/raster->height;
+
+    bins->count = 0;
+    bins->triangleCount = 0;
+
+    int start = index*SOFT_SETUP_CHUNK;
+    int end = (start + SOFT_SETUP_CHUNK < job->triangleCount)? start + SOFT_SETUP_CHUNK : job->triangleCount;
+
+    for (int t = start; t < end; t++)
+    {
+        SoftClipVertex polygon[2][9];
+        const SoftVertex *src[3];
+
+        for (int i = 0; i < 3; i++)
+        {
+            src[i] = &scratch->vertices[(indices != NULL)? indices[t*3 + i] : t*3 + i];
+
+            SoftClipVertex *cv = &polygon[0][i];
+            memcpy(cv->clip, src[i]->clip, sizeof(cv->clip));
+            if (job->shading == SOFT_SHADING_GOURAUD) memcpy(cv->attr, src[i]->color, 3*sizeof(float));
+            else memcpy(cv->attr, src[i]->position, 3*sizeof(float));
+            memcpy(cv->attr + 3, src[i]->normal, 3*sizeof(float));
+        }
+
+        // Provoking vertex is the last one (GL_LAST_VERTEX_CONVENTION)
+        Vector3 flat = Vector3Normalize((Vector3){ src[2]->normal[0], src[2]->normal[1], src[2]->normal[2] });
+        const float flatNormal[3] = { flat.x, flat.y, flat.z };
+
+        // Most triangles are inside every plane and skip clipping
+        int count = 3;
+        int current = 0;
+        for (int k = 0; k < 6; k++)
+        {
+            bool inside = true;
+            for (int i = 0; i < count; i++) if (SoftPlaneDistance(polygon[current][i].clip, k, guardX, guardY) < 0.0f) inside = false;
+            if (inside) continue;
+
+            count = SoftClipPolygon(polygon[current], count, polygon[1 - current], k, guardX, guardY);
+            current = 1 - current;
+            if (count < 3) break;
+        }
+
+        // Fan triangulation keeps the winding
+        for (int i = 1; i + 1 < count; i++)
+        {
+            SoftTriangle *tri = &triangles[bins->triangleCount];
+            if (!SoftSetupTriangle(raster, &polygon[current][0], &polygon[current][i], &polygon[current][i + 1], flatNormal, tri)) continue;
+
+            int triangle = (int)(tri - scratch->triangles);
+            for (int ty = tri->minY/SOFT_TILE_SIZE; ty <= tri->maxY/SOFT_TILE_SIZE; ty++)
+            {
+                for (int tx = tri->minX/SOFT_TILE_SIZE; tx <= tri->maxX/SOFT_TILE_SIZE; tx++) SoftAddBin(bins, ty*raster->tilesX + tx, triangle);
+            }
+
+            bins->triangleCount++;
+        }
+    }
+}
+
+// Merge the task bins into per tile lists, counting sort keeps submission order
+static void SoftMergeBins(SoftRaster *raster, int setupCount)
+{
+    SoftRasterScratch *scratch = raster->scratch;
+    int tileCount = raster->tilesX*raster->tilesY;
+    int total = 0;
+
+    memset(scratch->tileStart, 0, ((size_t)tileCount + 1)*sizeof(int));
+    for (int i = 0; i < setupCount; i++)
+    {
+        for (int j = 0; j < scratch->bins[i].count; j++) scratch->tileStart[scratch->bins[i].entries[j].tile + 1]++;
+        total += scratch->bins[i].count;
+        raster->stats.triangleCount += scratch->bins[i].triangleCount;
+    }
+
+    for (int i = 0; i < tileCount; i++) scratch->tileStart[i + 1] += scratch->tileStart[i];
+
+    if (total > scratch->tileTrianglesCapacity)
+    {
+        scratch->tileTrianglesCapacity = total*2;
+        scratch->tileTriangles = (int *)RL_REALLOC(scratch->tileTriangles, (size_t)scratch->tileTrianglesCapacity*sizeof(int));
+    }
+
+    // tileStart[i] is advanced while filling and ends up at the start of tile i + 1, shift back after
+    for (int i = 0; i < setupCount; i++)
+    {
+        for (int j = 0; j < scratch->bins[i].count; j++)
+        {
+            SoftBinEntry entry = scratch->bins[i].entries[j];
+            scratch->tileTriangles[scratch->tileStart[entry.tile]++] = entry.triangle;
+        }
+    }
+
+    for (int i = tileCount; i > 0; i--) scratch->tileStart[i] = scratch->tileStart[i - 1];
+    scratch->tileStart[0] = 0;
+
+    raster->stats.binCount = total;
+}
+
+//----------------------------------------------------------------------------------
+// Raster stage
+//----------------------------------------------------------------------------------
+
+// Lighting of the shading mode for SOFT_LANES pixels, attributes already interpolated
+static void SoftShadePixels(const SoftDrawJob *job, const SoftTriangle *tri, const SoftV *attr, SoftV *rgb)
+{
+    const SoftLight *light = &job->light;
+    const float lightColor[3] = { light->lightColor.x, light->lightColor.y, light->lightColor.z };
+    const float objectColor[3] = { light->objectColor.x, light->objectColor.y, light->objectColor.z };
+
+    if (job->shading == SOFT_SHADING_GOURAUD)
+    {
+        rgb[0] = attr[0];
+        rgb[1] = attr[1];
+        rgb[2] = attr[2];
+        return;
+    }
+
+    // L = normalize(lightPos - fragPosition)
+    SoftV Lx = SoftSub(SoftSet(light->lightPos.x), attr[0]);
+    SoftV Ly = SoftSub(SoftSet(light->lightPos.y), attr[1]);
+    SoftV Lz = SoftSub(SoftSet(light->lightPos.z), attr[2]);
+    SoftV invLength = SoftDiv(SoftSet(1.0f), SoftSqrt(SoftAdd(SoftAdd(SoftMul(Lx, Lx), SoftMul(Ly, Ly)), SoftMul(Lz, Lz))));
+    Lx = SoftMul(Lx, invLength);
+    Ly = SoftMul(Ly, invLength);
+    Lz = SoftMul(Lz, invLength);
+
+    if (job->shading == SOFT_SHADING_FLAT)
+    {
+        SoftV NdotL = SoftAdd(SoftAdd(SoftMul(SoftSet(tri->flatNormal[0]), Lx), SoftMul(SoftSet(tri->flatNormal[1]), Ly)), SoftMul(SoftSet(tri->flatNormal[2]), Lz));
+        NdotL = SoftMax(NdotL, SoftSet(0.0f));
+
+        for (int i = 0; i < 3; i++) rgb[i] = SoftMul(SoftSet(objectColor[i]*lightColor[i]), NdotL);
+        return;
+    }
+
+    // Phong: N interpolated and normalized, V per pixel, R = reflect(-L, N)
+    SoftV Nx = attr[3], Ny = attr[4], Nz = attr[5];
+    invLength = SoftDiv(SoftSet(1.0f), SoftSqrt(SoftAdd(SoftAdd(SoftMul(Nx, Nx), SoftMul(Ny, Ny)), SoftMul(Nz, Nz))));
+    Nx = SoftMul(Nx, invLength);
+    Ny = SoftMul(Ny, invLength);
+    Nz = SoftMul(Nz, invLength);
+
+    SoftV Vx = SoftSub(SoftSet(light->viewPos.x), attr[0]);
+    SoftV Vy = SoftSub(SoftSet(light->viewPos.y), attr[1]);
+    SoftV Vz = SoftSub(SoftSet(light->viewPos.z), attr[2]);
+    invLength = SoftDiv(SoftSet(1.0f), SoftSqrt(SoftAdd(SoftAdd(SoftMul(Vx, Vx), SoftMul(Vy, Vy)), SoftMul(Vz, Vz))));
+    Vx = SoftMul(Vx, invLength);
+    Vy = SoftMul(Vy, invLength);
+    Vz = SoftMul(Vz, invLength);
+
+    SoftV rawNdotL = SoftAdd(SoftAdd(SoftMul(Nx, Lx), SoftMul(Ny, Ly)), SoftMul(Nz, Lz));
+    SoftV NdotL = SoftMax(rawNdotL, SoftSet(0.0001f));
+
+    SoftV twoNdotL = SoftMul(SoftSet(2.0f), rawNdotL);
+    SoftV Rx = SoftSub(SoftMul(twoNdotL, Nx), Lx);
+    SoftV Ry = SoftSub(SoftMul(twoNdotL, Ny), Ly);
+    SoftV Rz = SoftSub(SoftMul(twoNdotL, Nz), Lz);
+    SoftV VdotR = SoftMax(SoftAdd(SoftAdd(SoftMul(Vx, Rx), SoftMul(Vy, Ry)), SoftMul(Vz, Rz)), SoftSet(0.0f));
+
+    // 0.45*spec*(shininess + 2)/(8*PI) with shininess 16, only facing the light
+    SoftV specular = SoftMul(SoftSet(0.45f*18.0f/(8.0f*PI)), SoftPow2n(VdotR, 4));
+    specular = SoftAnd(specular, SoftGreater(rawNdotL, SoftSet(0.0f)));
+
+    for (int i = 0; i < 3; i++)
+    {
+        SoftV lit = SoftAdd(SoftSet(0.1f*lightColor[i]*objectColor[i]), SoftMul(SoftSet(objectColor[i]*lightColor[i]), NdotL));
+        rgb[i] = SoftAdd(lit, SoftMul(SoftSet(lightColor[i]), specular));
+    }
+}
+
+static void SoftRasterTriangle(const SoftDrawJob *job, const SoftTriangle *tri, int tileX, int tileY)
+{
+    SoftRasterScratch *scratch = job->raster->scratch;
+    const int attrCount = (job->shading == SOFT_SHADING_PHONG)? 6 : 3;
+
+    int x0 = (tri->minX > tileX)? tri->minX : tileX;
+    int y0 = (tri->minY > tileY)? tri->minY : tileY;
+    int x1 = (tri->maxX < tileX + SOFT_TILE_SIZE - 1)? tri->maxX : tileX + SOFT_TILE_SIZE - 1;
+    int y1 = (tri->maxY < tileY + SOFT_TILE_SIZE - 1)? tri->maxY : tileY + SOFT_TILE_SIZE - 1;
+
+    // Lanes stay aligned to the tile, the target is padded to whole tiles
+    x0 -= (x0 - tileX)%SOFT_LANES;
+
+    SoftV topLeft[3];
+    for (int k = 0; k < 3; k++) topLeft[k] = SoftGreater(SoftSet(tri->topLeft[k]? 1.0f : 0.0f), SoftSet(0.0f));
+
+    for (int y = y0; y <= y1; y++)
+    {
+        float py = (float)y + 0.5f;
+        float rowTerm[3];
+        for (int k = 0; k < 3; k++) rowTerm[k] = (py - tri->edgeY[k])*tri->edgeDx[k];
+
+        for (int x = x0; x <= x1; x += SOFT_LANES)
+        {
+            SoftV px = SoftAdd(SoftSet((float)x + 0.5f), SoftLanes());
+
+            // E = (px - ax)*dy - (py - ay)*dx from the ordered endpoint, then oriented
+            SoftV e[3];
+            SoftV inside = SoftGreater(SoftSet(1.0f), SoftSet(0.0f));
+            for (int k = 0; k < 3; k++)
+            {
+                e[k] = SoftMul(SoftSet(tri->edgeSign[k]), SoftSub(SoftMul(SoftSub(px, SoftSet(tri->edgeX[k])), SoftSet(tri->edgeDy[k])), SoftSet(rowTerm[k])));
+
+                SoftV covered = SoftOr(SoftGreater(e[k], SoftSet(0.0f)), SoftAnd(SoftGreaterEqual(e[k], SoftSet(0.0f)), topLeft[k]));
+                inside = SoftAnd(inside, covered);
+            }
+            if (!SoftAny(inside)) continue;
+
+            SoftV b[3];
+            for (int k = 0; k < 3; k++) b[k] = SoftMul(e[k], SoftSet(tri->invArea));
+
+            // Window depth is affine in screen space
+            size_t offset = (size_t)y*scratch->stride + x;
+            SoftV z = SoftAdd(SoftAdd(SoftMul(b[0], SoftSet(tri->z[0])), SoftMul(b[1], SoftSet(tri->z[1]))), SoftMul(b[2], SoftSet(tri->z[2])));
+            SoftV depth = SoftLoad(scratch->depth + offset);
+            SoftV mask = SoftAnd(inside, SoftLessEqual(z, depth));
+            if (!SoftAny(mask)) continue;
+
+            SoftStore(scratch->depth + offset, SoftSelect(mask, z, depth));
+
+            // Perspective correct attributes, a/w and 1/w are affine in screen space
+            SoftV w = SoftDiv(SoftSet(1.0f), SoftAdd(SoftAdd(SoftMul(b[0], SoftSet(tri->invW[0])), SoftMul(b[1], SoftSet(tri->invW[1]))), SoftMul(b[2], SoftSet(tri->invW[2]))));
+            SoftV attr[6];
+            for (int j = 0; j < attrCount; j++)
+            {
+                SoftV sum = SoftAdd(SoftAdd(SoftMul(b[0], SoftSet(tri->attr[0][j])), SoftMul(b[1], SoftSet(tri->attr[1][j]))), SoftMul(b[2], SoftSet(tri->attr[2][j])));
+                attr[j] = SoftMul(sum, w);
+            }
+
+            SoftV rgb[3];
+            SoftShadePixels(job, tri, attr, rgb);
+            SoftStoreColor(scratch->color + offset, mask, rgb[0], rgb[1], rgb[2]);
+        }
+    }
+}
+
+static void SoftRasterTask(int index, void *userData)
+{
+    SoftDrawJob *job = (SoftDrawJob *)userData;
+    SoftRaster *raster = job->raster;
+    SoftRasterScratch *scratch = raster->scratch;
+
+    int tileX = (index%raster->tilesX)*SOFT_TILE_SIZE;
+    int tileY = (index/raster->tilesX)*SOFT_TILE_SIZE;
+
+    for (int i = scratch->tileStart[index]; i < scratch->tileStart[index + 1]; i++)
+    {
+        SoftRasterTriangle(job, &scratch->triangles[scratch->tileTriangles[i]], tileX, tileY);
+    }
+
+    // Copy the visible part of the tile to the output
+    int width = (tileX + SOFT_TILE_SIZE < raster->width)? SOFT_TILE_SIZE : raster->width - tileX;
+    for (int y = tileY; (y < tileY + SOFT_TILE_SIZE) && (y < raster->height); y++)
+    {
+        memcpy(raster->pixels + ((size_t)y*raster->width + tileX)*4, scratch->color + (size_t)y*scratch->stride + tileX, (size_t)width*4);
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Draw
+//----------------------------------------------------------------------------------
+
+void DrawSoftMesh(SoftRaster *raster, Mesh mesh, Matrix transform, Camera camera, SoftShading shading, SoftLight light)
+{
+    SoftRasterScratch *scratch = raster->scratch;
+    if ((scratch == NULL) || (mesh.vertices == NULL) || (mesh.normals == NULL)) return;
+
+    SoftDrawJob job = { 0 };
+    job.raster = raster;
+    job.mesh = mesh;
+    job.triangleCount = (mesh.indices != NULL)? mesh.triangleCount : mesh.vertexCount/3;
+    job.shading = shading;
+    job.light = light;
+    raster->stats = (SoftRasterStats){ 0 };
+
+    // Same matrices as BeginMode3D() and the mvp/matModel uniforms
+    double aspect = (double)raster->width/(double)raster->height;
+    Matrix projection = { 0 };
+    if (camera.projection == CAMERA_PERSPECTIVE) projection = MatrixPerspective(camera.fovy*DEG2RAD, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    else
+    {
+        double top = camera.fovy/2.0;
+        double right = top*aspect;
+        projection = MatrixOrtho(-right, right, -top, top, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    job.model = transform;
+    job.mvp = MatrixMultiply(MatrixMultiply(transform, view), projection);
+    job.normalMatrix = MatrixTranspose(MatrixInvert(transform));
+
+    if (mesh.vertexCount > scratch->vertexCapacity)
+    {
+        scratch->vertexCapacity = mesh.vertexCount;
+        scratch->vertices = (SoftVertex *)RL_REALLOC(scratch->vertices, (size_t)scratch->vertexCapacity*sizeof(SoftVertex));
+    }
+
+    int setupCount = (job.triangleCount + SOFT_SETUP_CHUNK - 1)/SOFT_SETUP_CHUNK;
+    if (setupCount > scratch->binsCapacity)
+    {
+        scratch->bins = (SoftSetupBins *)RL_REALLOC(scratch->bins, (size_t)setupCount*sizeof(SoftSetupBins));
+        memset(scratch->bins + scratch->binsCapacity, 0, (size_t)(setupCount - scratch->binsCapacity)*sizeof(SoftSetupBins));
+        scratch->binsCapacity = setupCount;
+    }
+
+    if (setupCount*SOFT_SETUP_CHUNK*SOFT_MAX_CLIPPED > scratch->triangleCapacity)
+    {
+        scratch->triangleCapacity = setupCount*SOFT_SETUP_CHUNK*SOFT_MAX_CLIPPED;
+        scratch->triangles = (SoftTriangle *)RL_REALLOC(scratch->triangles, (size_t)scratch->triangleCapacity*sizeof(SoftTriangle));
+    }
+
+    double startTime = GetMonotonicTime();
+    ParallelFor((mesh.vertexCount + SOFT_VERTEX_CHUNK - 1)/SOFT_VERTEX_CHUNK, SoftVertexTask, &job);
+
+    double setupTime = GetMonotonicTime();
+    ParallelFor(setupCount, SoftSetupTask, &job);
+    SoftMergeBins(raster, setupCount);
+
+    double rasterTime = GetMonotonicTime();
+    ParallelFor(raster->tilesX*raster->tilesY, SoftRasterTask, &job);
+
+    double endTime = GetMonotonicTime();
+    raster->stats.vertexTime = setupTime - startTime;
+    raster->stats.setupTime = rasterTime - setupTime;
+    raster->stats.rasterTime = endTime - rasterTime;
+}
+
+#endif // SOFT_RASTER_IMPLEMENTATION
@@ -8,7 +8,9 @@ in vec3 fragPosition;
 uniform vec3 lightColor;
 uniform vec3 objectColor;
 uniform vec3 viewPos;
-uniform sampler2D reflectionMap;
+uniform vec3 shIrradiance[9];      // Sky irradiance as order 2 spherical harmonics
+uniform samplerCube prefilterMap;   // GGX prefiltered cubemap, one roughness per mip level
+uniform float prefilterMaxLod;      // Mip level holding roughness 1.0
 uniform float reflectivityValue;
 
 // Output color to the screen
@@ -17,15 +19,14 @@ out vec4 finalColor;
 // Define PI
 const float PI = 3.14159265359;
 
-// Convert 3D direction to panoramic UV coordinates
-vec2 directionToSphericalUV(vec3 dir)
+// Irradiance from the 9 SH coefficients (basis constants and cosine lobe already folded in)
+vec3 IrradianceSH(vec3 n)
 {
-    vec3 normalized = normalize(dir);
-    float u = atan(normalized.z, normalized.x);
-    float v = asin(-normalized.y);
-    u = u / (2.0 * PI) + 0.5;
-    v = v / PI + 0.5;
-    return vec2(u, v);
+    return shIrradiance[0]
+         + shIrradiance[1] * n.y + shIrradiance[2] * n.z + shIrradiance[3] * n.x
+         + shIrradiance[4] * (n.x * n.y) + shIrradiance[5] * (n.y * n.z)
+         + shIrradiance[6] * (3.0 * n.z * n.z - 1.0)
+         + shIrradiance[7] * (n.x * n.z) + shIrradiance[8] * (n.x * n.x - n.y * n.y);
 }
 
 void main()
@@ -36,29 +37,16 @@ void main()
 
     // ==================== Ambient Term (IBL) ====================
 
-    // Calculate which mip level to use based on reflectivity
-    // reflectivity = 0 (diffuse): Use highest mip level (most blurred)
-    // reflectivity = 1 (mirror): Use mip level 0 (sharpest)
-    
-    float maxMipLevel = 10.0;
-    float mipLevel = (1.0 - reflectivityValue) * maxMipLevel;
-    
-    // Sample using different mip levels for diffuse vs specular
-    vec2 uvDiffuse = directionToSphericalUV(N);
-    vec2 uvSpecular = directionToSphericalUV(R);
-
-    // Smooth mipmap blending - sample adjacent mip levels and blend
-    float mipFloor = floor(mipLevel);
-    float mipCeil = ceil(mipLevel);
-    float mipFract = fract(mipLevel);
+    // Every mip of the prefiltered map is the GGX lobe for one roughness
+    // reflectivity = 0 (diffuse): roughness 1.0, widest lobe
+    // reflectivity = 1 (mirror): roughness 0.0, mip level 0
+    float roughness = 1.0 - reflectivityValue;
 
-    // Sample two adjacent mip levels for specular
-    vec3 specular1 = textureLod(reflectionMap, uvSpecular, mipFloor).rgb;
-    vec3 specular2 = textureLod(reflectionMap, uvSpecular, mipCeil).rgb;
-    vec3 envSpecular = mix(specular1, specular2, mipFract);
+    // Trilinear filtering blends the two closest roughness levels in one cube fetch
+    vec3 envSpecular = textureLod(prefilterMap, R, roughness * prefilterMaxLod).rgb;
 
-    // Diffuse always uses max mip (most blurred)
-    vec3 envDiffuse = textureLod(reflectionMap, uvDiffuse, maxMipLevel).rgb;
+    // Diffuse is the cosine-weighted irradiance, projected to SH on the CPU
+    vec3 envDiffuse = IrradianceSH(N) / PI;
     
     // Blend between diffuse and specular based on reflectivity
     vec3 environmentContribution = mix(envDiffuse, envSpecular, reflectivityValue);
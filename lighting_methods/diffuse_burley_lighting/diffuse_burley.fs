@@ -9,14 +9,81 @@ uniform vec3 lightPos;
 uniform vec3 lightColor;
 uniform vec3 objectColor;
 uniform vec3 viewPos;
+uniform vec3 shIrradiance[9];      // Sky irradiance as order 2 spherical harmonics
 uniform float roughnessValue;
 
+// Clustered point lights, binned into a froxel grid on the CPU every frame (layout in common/light_clusters.h,
+// keep the four copies in sync). The main light above stays, these add on top
+uniform samplerBuffer clusterLights;    // 2 texels per light: position, radius / color
+uniform usamplerBuffer clusterGrid;     // Per cluster: first index, light count
+uniform usamplerBuffer clusterIndices;  // Light indices grouped by cluster
+uniform vec4 clusterViewDepth;          // View depth = dot(clusterViewDepth, vec4(position, 1))
+uniform vec4 clusterScale;              // Tiles per pixel (xy), slice = log(depth)*z + w
+uniform vec2 clusterOrigin;             // Lower left pixel of the viewport, 0 on a full target
+
+const ivec3 clusterCount = ivec3(16, 16, 24);  // LIGHT_CLUSTERS_X, _Y, _Z
+
 // Output color to the screen
 out vec4 finalColor;
 
 // Define PI
 const float PI = 3.14159265359;
 
+// Irradiance from the 9 SH coefficients (basis constants and cosine lobe already folded in)
+vec3 IrradianceSH(vec3 n)
+{
+    return shIrradiance[0]
+         + shIrradiance[1] * n.y + shIrradiance[2] * n.z + shIrradiance[3] * n.x
+         + shIrradiance[4] * (n.x * n.y) + shIrradiance[5] * (n.y * n.z)
+         + shIrradiance[6] * (3.0 * n.z * n.z - 1.0)
+         + shIrradiance[7] * (n.x * n.z) + shIrradiance[8] * (n.x * n.x - n.y * n.y);
+}
+
+// First index and light count of the fragment's cluster
+uvec2 GetClusterRange()
+{
+    float depth = max(dot(clusterViewDepth, vec4(fragPosition, 1.0)), 0.0001);
+    ivec2 tile = min(ivec2((gl_FragCoord.xy - clusterOrigin) * clusterScale.xy), clusterCount.xy - 1);
+    int slice = clamp(int(floor(log(depth) * clusterScale.z + clusterScale.w)), 0, clusterCount.z - 1);
+
+    return texelFetch(clusterGrid, (slice * clusterCount.y + tile.y) * clusterCount.x + tile.x).rg;
+}
+
+// Light vector and incoming radiance of one clustered light
+vec3 GetClusterLight(uint index, out vec3 L)
+{
+    int light = int(texelFetch(clusterIndices, int(index)).r);
+    vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+    vec3 color = texelFetch(clusterLights, 2 * light + 1).rgb;
+
+    vec3 toLight = positionRadius.xyz - fragPosition;
+    float distance2 = max(dot(toLight, toLight), 0.0001);
+    L = toLight * inversesqrt(distance2);
+
+    // Windowed inverse square falloff, reaches 0 at the radius so the binning can cut there
+    float ratio2 = distance2 / (positionRadius.w * positionRadius.w);
+    float window = clamp(1.0 - ratio2 * ratio2, 0.0, 1.0);
+
+    return color * (window * window) / (distance2 + 1.0);
+}
+
+// Burley diffuse of one clustered light, the same terms as the main light in main()
+vec3 PointLight(vec3 N, vec3 V, vec3 L, vec3 radiance, float roughness)
+{
+    float NdotL = dot(N, L);
+    if (NdotL <= 0.0) return vec3(0.0);
+
+    vec3 H = normalize(L + V);
+    float NdotV = max(dot(N, V), 0.0001);
+    float LdotH = max(dot(L, H), 0.0001);
+
+    float FD90 = 0.5 + 2.0 * roughness * (LdotH * LdotH);
+    float viewScatter  = 1.0 + (FD90 - 1.0) * pow(1.0 - NdotV, 5.0);
+    float lightScatter = 1.0 + (FD90 - 1.0) * pow(1.0 - NdotL, 5.0);
+
+    return (objectColor / PI) * radiance * NdotL * viewScatter * lightScatter;
+}
+
 void main()
 {
     // Setup vectors
@@ -39,10 +106,11 @@ void main()
     // 0.0 = Smooth (Lambert), 1.0 = Very Rough (Bright periphery)
     float roughness = roughnessValue;
 
-    // ==================== Ambient Term (Simple) ====================
+    // ==================== Ambient Term (SH Irradiance) ====================
     
-    float ambientStrength = 0.1;
-    vec3 ambient = ambientStrength * lightColor * objectColor;
+    // Cosine-weighted irradiance of the sky, evaluated from 9 coefficients with ALU only
+    vec3 irradiance = IrradianceSH(N);
+    vec3 ambient = (irradiance / PI) * objectColor;
 
     // ==================== Diffuse Term (Burley) ====================
 
@@ -61,10 +129,17 @@ void main()
 
     vec3 result = ambient + diffuse;
 
-    // In PBR, we usually need much brighter lights (Intensity > 1.0).
-    // For this demo, let's multiply the final result by an "Exposure" factor.
-    // Allows us to see it clearly on our screen.
-    float exposure = 3.0; 
-    
-    finalColor = vec4(result * exposure, 1.0);
+    // ==================== Clustered Point Lights ====================
+
+    // Only the lights binned into this fragment's cluster, no other one reaches it
+    uvec2 cluster = GetClusterRange();
+    for (uint i = cluster.x; i < cluster.x + cluster.y; i++)
+    {
+        vec3 pointL;
+        vec3 radiance = GetClusterLight(i, pointL);
+        result += PointLight(N, V, pointL, radiance, roughness);
+    }
+
+    // Linear radiance, kept unclamped by the HDR target, the tone map pass exposes it (common/hdr_target.h)
+    finalColor = vec4(result, 1.0);
 }
\ No newline at end of file
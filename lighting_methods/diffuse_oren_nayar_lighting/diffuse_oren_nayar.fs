@@ -9,7 +9,8 @@ uniform vec3 lightPos;
 uniform vec3 lightColor;
 uniform vec3 objectColor;
 uniform vec3 viewPos;
-uniform float roughnessValue;
+uniform vec3 shIrradiance[9];      // Sky irradiance as order 2 spherical harmonics
+uniform vec2 orenNayarAB;          // A and B from the roughness (sigma), computed on the CPU
 
 // Output color to the screen
 out vec4 finalColor;
@@ -17,6 +18,16 @@ out vec4 finalColor;
 // Define PI
 const float PI = 3.14159265359;
 
+// Irradiance from the 9 SH coefficients (basis constants and cosine lobe already folded in)
+vec3 IrradianceSH(vec3 n)
+{
+    return shIrradiance[0]
+         + shIrradiance[1] * n.y + shIrradiance[2] * n.z + shIrradiance[3] * n.x
+         + shIrradiance[4] * (n.x * n.y) + shIrradiance[5] * (n.y * n.z)
+         + shIrradiance[6] * (3.0 * n.z * n.z - 1.0)
+         + shIrradiance[7] * (n.x * n.z) + shIrradiance[8] * (n.x * n.x - n.y * n.y);
+}
+
 void main()
 {
     // Setup Vectors
@@ -32,23 +43,18 @@ void main()
     float NdotL = max(rawNdotL, 0.0001);
     float NdotV = max(rawNdotV, 0.0001);
 
-    // Get roughness (Sigma)
-    // 0.0 = Smooth (Lambert), 1.0 = Very Rough (Clay/Moon)
-    float roughness = roughnessValue;
-
-    // ==================== Ambient Term (Simple) ====================
+    // ==================== Ambient Term (SH Irradiance) ====================
     
-    float ambientStrength = 0.1;
-    vec3 ambient = ambientStrength * lightColor * objectColor;
+    // Cosine-weighted irradiance of the sky, evaluated from 9 coefficients with ALU only
+    vec3 irradiance = IrradianceSH(N);
+    vec3 ambient = (irradiance / PI) * objectColor;
 
     // ==================== Diffuse Term (Oren-Nayar) ====================
     
-    // Get sigma squared
-    float sigma2 = roughness * roughness;
-
-    // Calculate A and B (The Coefficients)
-    float A = 1.0 - 0.5 * (sigma2 / (sigma2 + 0.33));
-    float B = 0.45 * (sigma2 / (sigma2 + 0.09));
+    // The coefficients A and B only depend on sigma, the CPU derives them once per slider change
+    // A = 1 - 0.5 * sigma^2 / (sigma^2 + 0.33), B = 0.45 * sigma^2 / (sigma^2 + 0.09)
+    float A = orenNayarAB.x;
+    float B = orenNayarAB.y;
 
     // Calculate Angles (Alpha and Beta)
     // thetaL = angle between Normal and Light
@@ -88,10 +94,6 @@ void main()
 
     vec3 result = ambient + diffuse;
 
-    // In PBR, we usually need much brighter lights (Intensity > 1.0).
-    // For this demo, let's multiply the final result by an "Exposure" factor.
-    // Allows us to see it clearly on our screen.
-    float exposure = 3.0; 
-    
-    finalColor = vec4(result * exposure, 1.0);
+    // Linear radiance, kept unclamped by the HDR target, the tone map pass exposes it (common/hdr_target.h)
+    finalColor = vec4(result, 1.0);
 }
\ No newline at end of file
@@ -100,10 +100,6 @@ void main()
     
     vec3 result = ambient + diffuse + specular;
 
-    // In PBR, we usually need much brighter lights (Intensity > 1.0).
-    // For this demo, let's multiply the final result by an "Exposure" factor 
-    // just to see it clearly on our screen.
-    float exposure = 3.0; 
-    
-    finalColor = vec4(result * exposure, 1.0);
+    // Linear radiance, kept unclamped by the HDR target, the tone map pass exposes it (common/hdr_target.h)
+    finalColor = vec4(result, 1.0);
 }
\ No newline at end of file
@@ -3,24 +3,79 @@
 -> Press middle mouse button to move the camera
 -> Use mouse wheel to zoom in and out
 -> Press left mouse button to interact with the GUI
+-> Press G to toggle the material grid, a roughness x metallic x IOR sweep of spheres in one instanced draw,
+   --grid [RxMxI] starts with it (default 16x16x8, see common/material_grid.h)
+-> Use the Lights slider to add point lights, binned into view clusters every frame (see common/light_clusters.h),
+   --lights N starts with N of them
+-> Press P to toggle the depth pre-pass: the torus or grid goes in depth only first, then is shaded once per visible pixel
+   and the sky is drawn last, the GPU time of every pass is shown (see common/depth_prepass.h), --prepass starts with it
+-> The scene renders into a float target, one pass applies the exposure and the tone map curve to all of it
+   (see common/hdr_target.h): --exposure X, --tonemap clamp|reinhard|aces, --hdr-format rgba16f|r11g11b10f,
+   --ldr draws straight to the frame
+-> Press T to toggle the pass timings overlay (CPU and GPU p50/p95/p99 of every pass), --timings file.csv writes
+   the timings of every frame on exit (see common/pass_timer.h)
+-> Run with --headless [--frames N] [--size WxH] [--output file.png] to render offscreen (see common/headless.h)
+-> Run with --bench [--warmup N] [--frames M] [--bench-output file.jsonl] for an uncapped timed run on a fixed camera
+   orbit, printed as a JSON line of frame rate and frame time percentiles (see common/headless.h),
+   --sweep roughness|metallic|ior|alpha|anisotropy|lights moves that slider over the run
+-> The program variants, uniforms, material block and sliders are the shading lab's Cook-Torrance technique (see
+   shading_lab/lighting_methods.h), the grid and the pre-pass draw with its state
 */
 
 #define RAYGUI_IMPLEMENTATION
+#define ENV_ASSETS_IMPLEMENTATION
+#define ENV_DFG_IMPLEMENTATION
+#define HEADLESS_IMPLEMENTATION
+#define SHADER_CACHE_IMPLEMENTATION
+#define SHADER_VARIANTS_IMPLEMENTATION
+#define MATERIAL_BLOCK_IMPLEMENTATION
+#define MATERIAL_GRID_IMPLEMENTATION
+#define LIGHT_CLUSTERS_IMPLEMENTATION
+#define DEPTH_PREPASS_IMPLEMENTATION
+#define HDR_TARGET_IMPLEMENTATION
+#define PASS_TIMER_IMPLEMENTATION
+#define TECHNIQUE_IMPLEMENTATION
+#define LIGHTING_METHODS_IMPLEMENTATION
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "raylib.h"
 #include "raymath.h"
 #include "raygui.h"
 #include "rlgl.h"
-
-int main()
+#include "../../common/env_assets.h"
+#include "../../common/env_dfg.h"
+#include "../../common/headless.h"
+#include "../../common/shader_cache.h"
+#include "../../common/shader_variants.h"
+#include "../../common/material_block.h"
+#include "../../common/material_grid.h"
+#include "../../common/light_clusters.h"
+#include "../../common/depth_prepass.h"
+#include "../../common/hdr_target.h"
+#include "../../common/pass_timer.h"
+#include "../../shading_lab/lighting_methods.h"
+
+// Passes timed every frame
+#define PASS_DEPTH      0
+#define PASS_SHADING    1
+#define PASS_SKY        2
+#define PASS_CLUSTERS   3
+#define PASS_TONEMAP    4
+#define PASS_GUI        5
+
+int main(int argc, char *argv[])
 {
     // Set window dimensions
     const int screenWidth = 800;
     const int screenHeight = 800;
 
+    // Read the headless options, --headless renders offscreen into a hidden window
+    HeadlessRun headless = ParseHeadlessArgs(argc, argv, screenWidth, screenHeight);
+
     // Initialize the window
-    InitWindow(screenWidth, screenHeight, "Shading Lab");
+    InitHeadlessWindow(&headless, "Shading Lab");
 
     // Define the camera
     Camera camera = { 0 };
@@ -35,109 +90,106 @@ int main()
     float pitch = 0.0f;
     float radius = 2.5f;
 
-    // Load the panoramic environment map
-    Image img = LoadImage("resources/sky1_2k.jpg");
-    Texture2D panorama = LoadTextureFromImage(img);
-    UnloadImage(img);
+    // Start loading the sky on a worker thread: cubemap for the skybox, 9 SH coefficients for the diffuse
+    // ambient term and the GGX prefiltered cubemap (every mip level holds the reflection for one roughness,
+    // so the shader needs a single fetch). Grey placeholders are bound until the data streams in. Baked on
+    // the first run, mapped back from the caches next to the panorama afterwards, the cold and warm start
+    // times are logged
+    // Headless and bench runs load it in full before the first frame, so every run renders the same sky
+    EnvAssets sky = ((headless.enabled || headless.bench)? LoadEnvAssets : LoadEnvAssetsAsync)("resources/sky1_2k.jpg", ENV_ASSET_ALL);
 
     // Create skybox cube mesh
     Mesh cube = GenMeshCube(100.0f, 100.0f, 100.0f);
     Model skybox = LoadModelFromMesh(cube);
 
-    // Load skybox shader and set panorama texture
-    skybox.materials[0].shader = LoadShader("resources/skybox.vs", "resources/skybox.fs");
-    
-    // The shader converts the panorama to a skybox view
-    skybox.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = panorama;
-    
-    // Generate a torus mesh
-    Mesh mesh = GenMeshTorus(0.4f, 1.0f, 48, 96);
-    Model torus = LoadModelFromMesh(mesh);
-
-    // Generate tangents
-    GenMeshTangents(&mesh);
-
-    // Load and assign the shaders
-    Shader shader = LoadShader("lighting_methods/specular_cook_torrance_lighting/specular_cook_torrance.vs", "lighting_methods/specular_cook_torrance_lighting/specular_cook_torrance.fs");
-    torus.materials[0].shader = shader;
-
-    // Assign the uniforms
-    int lightPosLoc    = GetShaderLocation(shader, "lightPos");
-    int lightColorLoc  = GetShaderLocation(shader, "lightColor");
-    int objectColorLoc = GetShaderLocation(shader, "objectColor");
-    int viewPosLoc     = GetShaderLocation(shader, "viewPos");
-    int roughnessValueLoc = GetShaderLocation(shader, "roughnessValue");
-    int metallicValueLoc  = GetShaderLocation(shader, "metallicValue");
-    int anisotropyValueLoc = GetShaderLocation(shader, "anisotropyValue");
-    int iorValueLoc = GetShaderLocation(shader, "iorValue");
-    int alphaLoc       = GetShaderLocation(shader, "alphaValue");
-    int ndfTypeLoc     = GetShaderLocation(shader, "ndfType");
-    int gsfTypeLoc     = GetShaderLocation(shader, "gsfType");
-    int fresnelTypeLoc = GetShaderLocation(shader, "fresnelType");
-    int multiScatterTypeLoc = GetShaderLocation(shader, "multiScatterType");
-    int conductorPresetTypeLoc = GetShaderLocation(shader, "conductorPresetType");
-
-    int envLoc = GetShaderLocation(skybox.materials[0].shader, "environmentMap");
+    // Load skybox shader and set the cubemap
+    skybox.materials[0].shader = LoadShaderCached("resources/skybox.vs", "resources/skybox.fs");
+
+    // Raylib binds MATERIAL_MAP_CUBEMAP as a cube texture, the shader samples it with the view direction
+    skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = sky.skybox;
+    skybox.materials[0].shader.locs[SHADER_LOC_MAP_CUBEMAP] = GetShaderLocation(skybox.materials[0].shader, "environmentMap");
     
-    // Set static uniform values
-    Vector3 lightPos = { 5.0f, 5.0f, 5.0f };
-    Vector3 lightColor = { 1.0f, 1.0f, 1.0f };
-    Vector3 objectColor = { 0.5f, 0.0f, 0.0f };
-
-    // Update shader uniform values
-
-    SetShaderValue(shader, lightPosLoc, &lightPos, SHADER_UNIFORM_VEC3);                        // Light position
-    SetShaderValue(shader, lightColorLoc, &lightColor, SHADER_UNIFORM_VEC3);                    // Light color
-    SetShaderValue(shader, objectColorLoc, &objectColor, SHADER_UNIFORM_VEC3);                  // Object color
-
-    float cameraPos[3] = { camera.position.x, camera.position.y, camera.position.z };
-    SetShaderValue(shader, viewPosLoc, cameraPos, SHADER_UNIFORM_VEC3);                         // View position
-
-    float roughnessSliderValue = 0.5f;
-    float roughnessValue = roughnessSliderValue;
-    SetShaderValue(shader, roughnessValueLoc, &roughnessValue, SHADER_UNIFORM_FLOAT);           // Roughness
-
-    float metallicSliderValue = 0.5f;
-    float metallicValue = metallicSliderValue;
-    SetShaderValue(shader, metallicValueLoc, &metallicValue, SHADER_UNIFORM_FLOAT);             // Metallic
-
-    float anisotropySliderValue = 0.0f;  // 0 = isotropic
-    float anisotropyValue = anisotropySliderValue;
-    SetShaderValue(shader, anisotropyValueLoc, &anisotropyValue, SHADER_UNIFORM_FLOAT);         // Anisotropy
-
-    float iorSliderValue = 1.5; // 1 = vaccume
-    float iorValue = iorSliderValue;
-    SetShaderValue(shader, iorValueLoc, &iorValue, SHADER_UNIFORM_FLOAT);                       // IOR
-
-    float alphaSliderValue = 1.0f;
-    float alphaValue = alphaSliderValue;
-    SetShaderValue(shader, alphaLoc, &alphaValue, SHADER_UNIFORM_FLOAT);                         // Alpha - Visibility
-
-    int ndfActive = 0;
-    bool ndfEditMode = false;
-    SetShaderValue(shader, ndfTypeLoc, &ndfActive, SHADER_UNIFORM_INT);                         // NDF
-    int gsfActive = 0;
-    bool gsfEditMode = false;
-    SetShaderValue(shader, gsfTypeLoc, &gsfActive, SHADER_UNIFORM_INT);                         // GSF
-    int fresnelActive = 0;
-    bool fresnelEditMode = false;
-    SetShaderValue(shader, fresnelTypeLoc, &fresnelActive, SHADER_UNIFORM_INT);                 // FF
-    int multiScatterActive = 0;
-    bool multiScatterEditMode = false;
-    SetShaderValue(shader, multiScatterTypeLoc, &multiScatterActive, SHADER_UNIFORM_INT);       // MS
-    int conductorPresetActive = 0;
-    bool conductorPresetEditMode = false;
-    SetShaderValue(shader, conductorPresetTypeLoc, &conductorPresetActive, SHADER_UNIFORM_INT); // Conductor Presets
-
-    // Passing the environment map to the skybox shader
-    SetShaderValueTexture(skybox.materials[0].shader, envLoc, panorama);
-
-    // Lock the frames rate
-    SetTargetFPS(60);
+    // The lab's technique: program variants, material block and the dense torus with tangents, with the
+    // split-sum DFG table baked by tools/dfg_lut (environment BRDF and multiscatter albedo)
+    const Technique *technique = &specularCookTorranceTechnique;
+    TechniqueAssets assets = LoadTechniqueAssets(&sky);
+    CookTorranceState *cook = (CookTorranceState *)technique->Init(technique, &assets);
+    int envPending = technique->envAssets;
+
+    // Material grid, --grid starts with it and may give its size
+    bool gridMode = false;
+    int gridCounts[3] = { 16, 16, 8 };
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--grid") != 0) continue;
+
+        gridMode = true;
+        if ((i + 1 < argc) && (sscanf(argv[i + 1], "%ix%ix%i", &gridCounts[0], &gridCounts[1], &gridCounts[2]) == 3)) i++;
+    }
+
+    // Every cell is a copy of one sphere, the swept material comes from an instance buffer attached to its VAO
+    Mesh sphere = GenMeshSphere(0.5f, 12, 24);
+    GenMeshTangents(&sphere);
+    MaterialGrid grid = LoadMaterialGrid(sphere, gridCounts[0], gridCounts[1], gridCounts[2], 1.2f);
+
+    // Depth only programs for the pre-pass, the same vertex shader (with or without instancing) and an empty
+    // fragment shader. --prepass starts with it
+    const char *depthDefines[] = { "INSTANCED" };
+    ShaderVariants depthVariants = LoadShaderVariants("lighting_methods/specular_cook_torrance_lighting/specular_cook_torrance.vs", DEPTH_PREPASS_FRAGMENT_SHADER, depthDefines, 1);
+
+    bool prepass = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--prepass") == 0) prepass = true;
+    }
+
+    // The scene goes to a float target the size of the frame, one pass exposes and tone maps all of it
+    HdrTarget hdr = LoadHdrTarget(headless.enabled? headless.width : GetRenderWidth(), headless.enabled? headless.height : GetRenderHeight(),
+        ParseHdrArgs(argc, argv, technique->exposure));
+
+    const char *passNames[] = { "Depth", "Shading", "Sky", "Clusters", "Tonemap", "GUI" };
+    PassTimer timer = LoadPassTimer(passNames, 6);
+
+    // T shows the timings overlay (off in headless and bench runs), --timings FILE.csv keeps
+    // every sample
+    timer.output = ParsePassTimerArgs(argc, argv);
+    bool showTimings = !headless.enabled && !headless.bench;
+
+    // Point lights on top of the main one, binned into the clusters of the view every frame, so every fragment
+    // only loops over the lights that reach it. --lights N starts with N of them
+    const int maxLights = 4096;
+    float lightCountValue = 0.0f;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--lights") == 0) lightCountValue = Clamp((float)atoi(argv[i + 1]), 0.0f, (float)maxLights);
+    }
+
+    ClusterLight *pointLights = (ClusterLight *)RL_CALLOC(maxLights, sizeof(ClusterLight));
+    LightClusters clusters = LoadLightClusters();
+
+    // Lock the frames rate, headless and bench runs are not capped
+    if (!headless.enabled && !headless.bench) SetTargetFPS(60);
+
+    // Bench runs keep the startup slider values, or the swept one
+    if (headless.bench) GuiLock();
     
     // Main render loop
-    while (!WindowShouldClose())
+    while (!HeadlessShouldClose(&headless))
     {
+        // Toggle the material grid, it has its own program
+        if (IsKeyPressed(KEY_G)) gridMode = !gridMode;
+
+        // Toggle the depth pre-pass
+        if (IsKeyPressed(KEY_P)) prepass = !prepass;
+
+        // Collect the pass times of the frame the GPU finished
+        UpdatePassTimer(&timer);
+        if (IsKeyPressed(KEY_T)) showTimings = !showTimings;
+
+        // Upload the environment levels the loader thread finished since the last frame, the technique sends
+        // them on its update
+        envPending |= UpdateEnvAssets(&sky);
+
         // Camera orbit controls
         if (IsMouseButtonDown(MOUSE_MIDDLE_BUTTON))
         {
@@ -155,6 +207,9 @@ int main()
         radius -= wheel * 0.2f;
         radius = Clamp(radius, 1.0f, 10.0f);
 
+        // Bench runs follow a fixed orbit instead
+        UpdateHeadlessOrbit(&headless, &yaw, &pitch);
+
         // Spherical to cartesian
         camera.position.x = radius * cosf(pitch) * sinf(yaw);
         camera.position.y = radius * sinf(pitch);
@@ -162,51 +217,44 @@ int main()
 
         camera.target = (Vector3){ 0.0f, 0.0f, 0.0f};
 
-        // Update camera position every frame
-        float cameraPos[3] = { camera.position.x, camera.position.y, camera.position.z };
-        SetShaderValue(shader, viewPosLoc, cameraPos, SHADER_UNIFORM_VEC3);
+        // Bench runs may sweep the light count over the measured frames (--sweep), the technique sweeps its sliders
+        lightCountValue = GetHeadlessSweep(&headless, "lights", lightCountValue, 0.0f, (float)maxLights);
 
         // Rotate the torus over time
         static float angle = 0.0f;
         angle += 0.01f;
-        torus.transform = MatrixMultiply(
-            MatrixRotateZ(angle),
-            MatrixRotateX(DEG2RAD * 90.0f)
-        );
-        
-        // Start rendering
-        BeginDrawing();
-
-        // Update roughness from slider
-        roughnessValue = roughnessSliderValue;
-        SetShaderValue(shader, roughnessValueLoc, &roughnessValue, SHADER_UNIFORM_FLOAT);
-
-        // Update metallic from slider
-        metallicValue = metallicSliderValue;
-        SetShaderValue(shader, metallicValueLoc, &metallicValue, SHADER_UNIFORM_FLOAT);
 
-        // Update anisotropy from slider
-        anisotropyValue = anisotropySliderValue;
-        SetShaderValue(shader, anisotropyValueLoc, &anisotropyValue, SHADER_UNIFORM_FLOAT);
+        TechniqueFrame frame = { 0 };
+        frame.camera = camera;
+        frame.transform = MatrixMultiply(MatrixRotateZ(angle), MatrixRotateX(DEG2RAD * 90.0f));
+        frame.width = headless.enabled? headless.width : GetRenderWidth();
+        frame.height = headless.enabled? headless.height : GetRenderHeight();
+        frame.envChanged = envPending;
+        frame.run = &headless;
+        frame.clusters = &clusters;
+        envPending = 0;
+
+        // Move the point lights and bin them for this view, the shader reads the lists from buffer textures
+        int lightCount = (int)lightCountValue;
+        BeginPassTimer(&timer, PASS_CLUSTERS);
+        AnimateClusterLights(pointLights, lightCount, angle);
+        BuildLightClusters(&clusters, pointLights, lightCount, camera, frame.width, frame.height);
+        UploadLightClusters(&clusters);
+        EndPassTimer(&timer);
+
+        // Pick the program of the current selections and grid mode, then the uniforms and the material fields
+        // the sliders changed since the last frame
+        cook->instanced = gridMode;
+        technique->Update(cook, &frame);
 
-        // Update IOR from slider
-        iorValue = iorSliderValue;
-        SetShaderValue(shader, iorValueLoc, &iorValue, SHADER_UNIFORM_FLOAT);
-
-        // Update alpha from slider
-        alphaValue = alphaSliderValue;
-        SetShaderValue(shader, alphaLoc, &alphaValue, SHADER_UNIFORM_FLOAT);
-
-        // Update DGF uniforms
-        SetShaderValue(shader, ndfTypeLoc, &ndfActive, SHADER_UNIFORM_INT);
-        SetShaderValue(shader, gsfTypeLoc, &gsfActive, SHADER_UNIFORM_INT);
-        SetShaderValue(shader, fresnelTypeLoc, &fresnelActive, SHADER_UNIFORM_INT);
+        // Start rendering
+        BeginHeadlessDrawing(&headless);
 
-        // Update Multi-scatter uniforms
-        SetShaderValue(shader, multiScatterTypeLoc, &multiScatterActive, SHADER_UNIFORM_INT);
+        // The grid derives the swept materials from the same params, its buffer is filled again only when they change
+        if (gridMode) UpdateMaterialGrid(&grid, cook->block.params, &cook->block.dfg);
 
-        // Update conductor preset uniform
-        SetShaderValue(shader, conductorPresetTypeLoc, &conductorPresetActive, SHADER_UNIFORM_INT);
+        // Draw the scene into the float target, the background included
+        BeginHdrMode(&hdr);
 
         // Clear the screen with an off-white background
         ClearBackground((Color){200, 200, 200, 255});
@@ -214,79 +262,113 @@ int main()
         // Switch to 3D rendering using the given camera
         BeginMode3D(camera);
 
-        // Draw skybox (disable depth writing so it's always in background)
-        rlDisableBackfaceCulling();
-        rlDisableDepthMask();
-        DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
-        rlEnableBackfaceCulling();
-        rlEnableDepthMask();
-        
-        // Draw the torus model at given position, scale and color
-        DrawModel(torus, (Vector3){0,0,0}, 1.0f, (Color){objectColor.x * 255, objectColor.y * 255, objectColor.z * 255, 255});
+        if (prepass)
+        {
+            // Depth pre-pass, the same draw with the depth only program of the current grid mode
+            Material depthMaterial = cook->material;
+            depthMaterial.shader = GetShaderVariant(&depthVariants, (int[1]){ gridMode? 1 : 0 });
+
+            BeginPassTimer(&timer, PASS_DEPTH);
+            BeginDepthPrepass();
+            if (gridMode) DrawMaterialGrid(&grid, depthMaterial, MatrixIdentity());
+            else DrawMesh(cook->mesh, depthMaterial, frame.transform);
+            EndDepthPrepass();
+            EndPassTimer(&timer);
+        }
+        else
+        {
+            // Draw skybox (disable depth writing so it's always in background)
+            BeginPassTimer(&timer, PASS_SKY);
+            rlDisableBackfaceCulling();
+            rlDisableDepthMask();
+            DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
+            rlEnableBackfaceCulling();
+            rlEnableDepthMask();
+            EndPassTimer(&timer);
+        }
+
+        // Draw the whole grid in one instanced call, or the technique's torus. After the pre-pass only the fragments
+        // that kept their depth are shaded
+        BeginPassTimer(&timer, PASS_SHADING);
+        if (prepass) BeginDepthEqualPass();
+        if (gridMode) DrawMaterialGrid(&grid, cook->material, MatrixIdentity());
+        else technique->Draw(cook, &frame);
+        if (prepass) EndDepthEqualPass();
+        EndPassTimer(&timer);
+
+        // Sky last, it sits on the far plane and the depth test leaves it only the pixels nothing covered
+        if (prepass)
+        {
+            BeginPassTimer(&timer, PASS_SKY);
+            rlDisableBackfaceCulling();
+            rlDisableDepthMask();
+            DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
+            rlEnableBackfaceCulling();
+            rlEnableDepthMask();
+            EndPassTimer(&timer);
+        }
 
         // Exit 3D mode and return to 2D rendering
         EndMode3D();
 
+        // Back to the frame, the scene exposed and tone mapped into it
+        EndHdrMode(&hdr);
+
+        BeginPassTimer(&timer, PASS_TONEMAP);
+        DrawHdrToneMap(&hdr);
+        EndPassTimer(&timer);
+
+        // GUI laid out on the frame size, which --size or a window resize can change
+        const int guiWidth = GetHeadlessScreenWidth(&headless);
+        const int guiHeight = GetHeadlessScreenHeight(&headless);
+
+        // Text and GUI
+        BeginPassTimer(&timer, PASS_GUI);
+
         // Add information text
-        char infoText[128];
-        snprintf(infoText, sizeof(infoText), "Diffuse Burley + Specular Cook-Torrance Lighting");
-        DrawText(infoText, 10, 10, 20, BLACK);
-
-        // Draw roughness slider
-        DrawText("Roughness", 10, 40, 20, BLACK);
-        GuiSlider((Rectangle){ 130, 40, 200, 20 }, "", TextFormat("%.2f", roughnessSliderValue), &roughnessSliderValue, 0.0f, 1.0f);
-
-        // Draw metallic slider
-        DrawText("Metallic", 10, 70, 20, BLACK);
-        GuiSlider((Rectangle){ 130, 70, 200, 20 }, "", TextFormat("%.2f", metallicSliderValue), &metallicSliderValue, 0.0f, 1.0f);
-
-        // Draw IOR slider
-        DrawText("IOR", 10, 100, 20, BLACK);
-        GuiSlider((Rectangle){ 130, 100, 200, 20 }, "", TextFormat("%.2f", iorSliderValue), &iorSliderValue, 1.0f, 3.5f);
-
-        // Draw alpha slider
-        DrawText("Alpha", 10, 130, 20, BLACK);
-        GuiSlider((Rectangle){ 130, 130, 200, 20 }, "", TextFormat("%.2f", alphaSliderValue), &alphaSliderValue, 0.0f, 1.0f);
-
-        // NDF Dropdown
-        DrawText("NDF", 10, 160, 20, BLACK);
-        if (GuiDropdownBox((Rectangle){ 10, 190, 180, 20 }, "Beckmann;GGX (Trowbridge-Reitz);GGX (Anisotropic);Disable", &ndfActive, ndfEditMode)) ndfEditMode = !ndfEditMode;
-        
-        // GSF Dropdown
-        DrawText("GSF", 200, 160, 20, BLACK);
-        if (GuiDropdownBox((Rectangle){ 200, 190, 180, 20 }, "Kelemen;Neuman;Schlick (Disney);Schlick (Epic);Smith-Beckmann;Smith-GGX;Smith-GGX (Anisotropic);Disable", &gsfActive, gsfEditMode)) gsfEditMode = !gsfEditMode;
-        
-        // Fresnel Dropdown
-        DrawText("FF", 390, 160, 20, BLACK);
-        if (GuiDropdownBox((Rectangle){ 390, 190, 180, 20 }, "Schlick;Fresnel (Dielectrics); Fresnel (Conductors);Disable", &fresnelActive, fresnelEditMode)) fresnelEditMode = !fresnelEditMode;
-
-        // Multiscatter Dropdown
-        DrawText("MS", 580, 160, 20, BLACK);
-        if (GuiDropdownBox((Rectangle){ 580, 190, 180, 20 }, "Multi-scatter (Accurate);Multi-scatter (Approx);Disable", &multiScatterActive, multiScatterEditMode)) multiScatterEditMode = !multiScatterEditMode;
-
-        // Draw anisotropy slider (ONLY when GGX Anisotropic is selected)
-        if (ndfActive == 2)
-        {
-            DrawText("Anisotropy", 410, 40, 20, BLACK);
-            GuiSlider((Rectangle){ 530, 40, 200, 20 }, "", TextFormat("%.2f", anisotropySliderValue), &anisotropySliderValue, -1.0f, 1.0f);
-        }
-        
-        // Draw preset selecetor (ONLY when Fresnel Conductor is selected)
-        if (fresnelActive == 2)
+        DrawText(technique->title, 10, 10, 20, BLACK);
+
+        // Material sliders and the D/G/F, multiscatter and conductor dropdowns
+        technique->DrawGui(cook, guiWidth, guiHeight);
+
+        // Grid layout, the roughness, metallic and IOR sliders only set the axes with a single step
+        if (gridMode)
         {
-            DrawText("Presets", 410, 70, 20, BLACK);
-            if (GuiDropdownBox((Rectangle){ 530, 70, 180, 20 }, "Gold;Copper;Aluminium;Silver;Iron", &conductorPresetActive, conductorPresetEditMode)) conductorPresetEditMode = !conductorPresetEditMode;
+            DrawText(TextFormat("Grid %ix%ix%i, %i in 1 draw (X rough, Y metal, Z IOR)", grid.roughnessCount, grid.metallicCount, grid.iorCount, grid.instanceCount), 10, guiHeight - 30, 20, BLACK);
         }
 
+        // GPU time of the passes, averaged over the last frames
+        if (prepass) DrawText(TextFormat("Pre-pass: depth %.2f + shading %.2f + sky %.2f ms", timer.time[PASS_DEPTH], timer.time[PASS_SHADING], timer.time[PASS_SKY]), 10, guiHeight - 90, 20, BLACK);
+        else DrawText(TextFormat("No pre-pass (P): sky %.2f + shading %.2f ms", timer.time[PASS_SKY], timer.time[PASS_SHADING]), 10, guiHeight - 90, 20, BLACK);
+
+        // Draw point light count slider, with the binning time of this frame
+        DrawText("Lights", 10, guiHeight - 60, 20, BLACK);
+        GuiSlider((Rectangle){ 130, guiHeight - 60, 200, 20 }, "", TextFormat("%i", lightCount), &lightCountValue, 0.0f, (float)maxLights);
+        DrawText(TextFormat("Binned in %.2f ms, %i references", clusters.buildTime*1000.0, clusters.indexCount), 410, guiHeight - 60, 20, BLACK);
+
+        EndPassTimer(&timer);
+
+        // Percentiles of the pass times over the last frames
+        if (showTimings) DrawPassTimer(&timer, guiWidth - 330, 230);
+
         // Finish the frame and present it on screen
-        EndDrawing();
+        EndHeadlessDrawing(&headless);
     }
 
     // Cleanup
-    UnloadTexture(panorama);
+    technique->Unload(cook);
+    UnloadEnvAssets(sky);
+    UnloadTechniqueAssets(&assets);
+    skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = (Texture2D){ 0 };    // The sky's, UnloadEnvAssets() deleted it
     UnloadModel(skybox);
-    UnloadModel(torus);
-    UnloadShader(shader);
+    UnloadLightClusters(&clusters);
+    RL_FREE(pointLights);
+    UnloadMaterialGrid(&grid);
+    UnloadMesh(sphere);
+    UnloadShaderVariants(&depthVariants);
+    UnloadHdrTarget(hdr);
+    UnloadPassTimer(&timer);
+    UnloadHeadlessRun(&headless);
     CloseWindow();
 
     return 0;
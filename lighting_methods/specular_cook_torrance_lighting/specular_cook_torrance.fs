@@ -12,22 +12,100 @@ in vec3 fragBitangent;
 // Uniforms (set from cook_torrance.c)
 uniform vec3 lightPos;
 uniform vec3 lightColor;
-uniform vec3 objectColor;
 uniform vec3 viewPos;
+uniform vec3 shIrradiance[9];      // Sky irradiance as order 2 spherical harmonics
 
-uniform float roughnessValue;
-uniform float metallicValue;
-uniform float anisotropyValue;
-uniform float iorValue;
-uniform float alphaValue;
-
-uniform int ndfType;
-uniform int gsfType;
-uniform int fresnelType;
-
-uniform int multiScatterType;
-
-uniform int conductorPresetType;
+// Material parameters and the constants derived from them on the CPU, one std140 uniform buffer
+// shared with the other material shaders (layout in common/material_block.h, keep the three copies in sync)
+layout(std140) uniform MaterialBlock
+{
+    vec3 objectColor;
+    float roughnessValue;
+    vec3 sheenTint;
+    float metallicValue;
+    vec3 clearcoatTint;
+    float alphaValue;
+    float anisotropyValue;
+    float iorValue;
+    float sheenWeightValue;
+    float sheenRoughnessValue;
+    float clearcoatWeightValue;
+    float clearcoatRoughnessValue;
+    float clearcoatIorValue;
+
+    vec3 specularF0;                // mix(F0 of iorValue, objectColor, metallicValue)
+    float specularAlpha2;           // max(roughness^2, 0.0001), NDF
+    vec3 averageFresnel;            // Favg = F0 + (1 - F0)/21
+    float smithAlpha2;              // max(roughness, 0.0001)^2, GSF
+    vec3 multiScatterLobe;          // Kulla-Conty lobe over (1 - EssV)*(1 - EssL)
+    float clearcoatF0;
+    vec3 multiScatterApprox;        // (1 - Ess)*Favg of the approximate multiscatter
+    float clearcoatAlpha2;
+    vec3 clearcoatAttenuation;      // clearcoatTint^2, in and out of the coat
+    float clearcoatSmithAlpha2;
+    vec3 sheenColor;                // sheenWeightValue*sheenTint
+    float sheenExponent;            // Charlie NDF = sheenNorm*pow(sin2h, sheenExponent)
+    vec2 anisotropicAlpha;          // GGX alpha along T and B
+    float sheenNorm;
+    float averageAlbedo;            // Eavg at roughnessValue
+};
+
+// Model selection, compiled in per combination by specular_cook_torrance.c (see common/shader_variants.h)
+// so every program only holds the code of its own D, G, F and multiscatter terms. The defaults apply when
+// the file is compiled as is and match the demo's startup selection
+#ifndef NDF_TYPE
+    #define NDF_TYPE 0              // 0 Beckmann, 1 GGX, 2 GGX (Anisotropic), 3 Disabled
+#endif
+#ifndef GSF_TYPE
+    #define GSF_TYPE 0              // 0 Kelemen ... 6 Smith-GGX (Anisotropic), 7 Disabled
+#endif
+#ifndef FRESNEL_TYPE
+    #define FRESNEL_TYPE 0          // 0 Schlick, 1 Dielectrics, 2 Conductors, 3 Disabled
+#endif
+#ifndef MULTISCATTER_TYPE
+    #define MULTISCATTER_TYPE 0     // 0 Accurate, 1 Approximate, 2 Disabled
+#endif
+#ifndef CONDUCTOR_PRESET
+    #define CONDUCTOR_PRESET 0      // 0 Gold, 1 Copper, 2 Aluminium, 3 Silver, 4 Iron
+#endif
+#ifndef INSTANCED
+    #define INSTANCED 0             // 1 Material grid, the same define goes to the vertex shader
+#endif
+
+#if INSTANCED
+// Material grid mode (common/material_grid.h), every instance sweeps roughness, metallic and IOR. Those and
+// the constants derived from them come per instance from the vertex shader and stand in for the block fields
+// of the same name, the rest of the block (color, anisotropy, alpha) is shared by the whole grid
+flat in vec4 fragInstanceParams;                // roughness, metallic, ior, specularAlpha2
+flat in vec4 fragInstanceSpecularF0;            // specularF0, smithAlpha2
+flat in vec4 fragInstanceMultiScatter;          // multiScatterLobe, anisotropicAlpha.x
+flat in vec4 fragInstanceMultiScatterApprox;    // multiScatterApprox, anisotropicAlpha.y
+
+#define roughnessValue      fragInstanceParams.x
+#define metallicValue       fragInstanceParams.y
+#define iorValue            fragInstanceParams.z
+#define specularAlpha2      fragInstanceParams.w
+#define specularF0          fragInstanceSpecularF0.xyz
+#define smithAlpha2         fragInstanceSpecularF0.w
+#define multiScatterLobe    fragInstanceMultiScatter.xyz
+#define multiScatterApprox  fragInstanceMultiScatterApprox.xyz
+#define anisotropicAlpha    vec2(fragInstanceMultiScatter.w, fragInstanceMultiScatterApprox.w)
+#endif
+
+uniform samplerCube prefilterMap;   // GGX prefiltered cubemap, one roughness per mip level
+uniform float prefilterMaxLod;      // Mip level holding roughness 1.0
+uniform sampler2D dfgLut;           // Baked GGX table over (NdotV, roughness): rg = split-sum scale/bias, b = Eavg
+
+// Clustered point lights, binned into a froxel grid on the CPU every frame (layout in common/light_clusters.h,
+// keep the four copies in sync). The main light above stays, these add on top
+uniform samplerBuffer clusterLights;    // 2 texels per light: position, radius / color
+uniform usamplerBuffer clusterGrid;     // Per cluster: first index, light count
+uniform usamplerBuffer clusterIndices;  // Light indices grouped by cluster
+uniform vec4 clusterViewDepth;          // View depth = dot(clusterViewDepth, vec4(position, 1))
+uniform vec4 clusterScale;              // Tiles per pixel (xy), slice = log(depth)*z + w
+uniform vec2 clusterOrigin;             // Lower left pixel of the viewport, 0 on a full target
+
+const ivec3 clusterCount = ivec3(16, 16, 24);  // LIGHT_CLUSTERS_X, _Y, _Z
 
 // Output color to the screen
 out vec4 finalColor;
@@ -35,26 +113,24 @@ out vec4 finalColor;
 // Define PI
 const float PI = 3.14159265359;
 
-vec3 ACESFilm(vec3 x)
+// Split-sum environment BRDF (scale and bias applied to F0), one fetch of the baked table
+vec3 EnvironmentBRDF(vec3 F0, float roughness, float NdotV)
 {
-    float a = 2.51;
-    float b = 0.03;
-    float c = 2.43;
-    float d = 0.59;
-    float e = 0.14;
-    return clamp((x*(a*x+b))/(x*(c*x+d)+e), 0.0, 1.0);
+    vec2 AB = texture(dfgLut, vec2(NdotV, roughness)).rg;
+
+    return F0 * AB.x + AB.y;
 }
 
 // D: Normal Distribution Functions (NDF)
 float Distribution(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, vec3 H, vec3 T, vec3 B)
 {
+#if (NDF_TYPE == 0)
     // Beckmann
-    if (ndfType == 0) 
     {
         // D_beckmann = (e^(-(tan(θ_H)^2 / alpha^2)) / (pi * alpha^2 * NdotH^4)
         // tan(θ_H)^2 = sin(θ_H)^2 / cos(θ_H)^2 = (1 - cos(θ_H)^2) / cos(θ_H)^2 = (1 - NdotH^2) / NdotH^2
 
-        float alpha2 = max(roughness * roughness, 0.0001); // Prevent division by zero
+        float alpha2 = specularAlpha2; // Clamped on the CPU to prevent division by zero
         
         float NdotH = max(dot(N, H), 0.0001); // Prevent division by zero
 
@@ -65,12 +141,12 @@ float Distribution(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, ve
         return exp(-tanThetaH2 / alpha2) / (PI * alpha2 * NdotH2 * NdotH2);
     }
 
+#elif (NDF_TYPE == 1)
     // GGX (Trowbridge-Reitz)
-    if (ndfType == 1) 
     {
         // D_GGX = alpha^2 / (pi * ((alpha^2-1) * (NdotH^2) + 1)^2)
 
-        float alpha2 = max(roughness * roughness, 0.0001); // Prevent division by zero
+        float alpha2 = specularAlpha2; // Clamped on the CPU to prevent division by zero
         
         float NdotH = max(dot(N, H), 0.0001); // Prevent division by zero
 
@@ -83,16 +159,15 @@ float Distribution(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, ve
         return alpha2 / denom;
     }
 
+#elif (NDF_TYPE == 2)
     // GGX (Anisotropic)
-    if (ndfType == 2) 
     {
         // D_GGX_Aniso = 1 / (pi * alpha_x * alpha_y * ((TdotH/alpha_x)^2 + (BdotH/alpha_y)^2 + (NdotH^2)^2)
-        // Convert scalar roughness to directional roughness
+        // Scalar roughness converted to directional roughness on the CPU (anisotropicAlpha)
         // anisotropy ranges from -1 (stretched along tangent) to +1 (stretched along bitangent)
 
-        float aspect = sqrt(1.0 - anisotropy * 0.75); // To prevent extreme values
-        float alpha_x = max(0.0001, roughness / aspect);
-        float alpha_y = max(0.0001, roughness * aspect);
+        float alpha_x = anisotropicAlpha.x;
+        float alpha_y = anisotropicAlpha.y;
         
         float TdotH = dot(T, H);
         float BdotH = dot(B, H);
@@ -107,15 +182,17 @@ float Distribution(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, ve
         return 1.0 / denom;
     }
 
+#else
     // Disabled
     return 1.0;
+#endif
 }
 
 // G: Geometry Shadowing Functions (GSF)
 float Geometry(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, vec3 H, vec3 T, vec3 B)
 {
+#if (GSF_TYPE == 0)
     // Kelemen
-    if (gsfType == 0) 
     {
         // G_kelmen = (NdotL * NdotV) / (VdotH^2)
 
@@ -126,8 +203,8 @@ float Geometry(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, vec3 H
         return (NdotL * NdotV) / (VdotH * VdotH);
     }
 
+#elif (GSF_TYPE == 1)
     // Neuman
-    if (gsfType == 1)
     {
         // G_neumann = (NdotL * NdotV) / max(NdotL, NdotV) = min(NdotL, NdotV)
 
@@ -137,8 +214,8 @@ float Geometry(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, vec3 H
         return min(NdotL, NdotV);
     }
 
+#elif (GSF_TYPE == 2)
     // Schlick (Disney) [Direct ligthing, IBL will be handled later]
-    if (gsfType == 2)
     {
         // G_schlick = G_L * G_V
         // G_L = NdotL / (NdotL * (1-k) + k)
@@ -157,8 +234,8 @@ float Geometry(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, vec3 H
         return G_V * G_L;
     }
 
+#elif (GSF_TYPE == 3)
     // Schlick (Epic) [Direct ligthing, IBL will be handled later]
-    if (gsfType == 3)
     {
         // G_schlick = G_L * G_V
         // G_L = NdotL / (NdotL * (1-k) + k)
@@ -177,8 +254,8 @@ float Geometry(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, vec3 H
         return G_V * G_L;
     }
     
+#elif (GSF_TYPE == 4)
     // Smith-Beckmann
-    if (gsfType == 4) 
     {
 
         // G_smith_beckmann = G_L * G_V
@@ -236,8 +313,8 @@ float Geometry(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, vec3 H
         return G1_V * G1_L;
     }
 
+#elif (GSF_TYPE == 5)
     // Smith-GGX
-    if (gsfType == 5) 
     {
         // G_smith_GGX = (Chi(NdotL) * Chi(NdotV)) / (1 + Lambda(NdotL) + Lambda(NdotV))
 
@@ -247,8 +324,7 @@ float Geometry(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, vec3 H
         
         // Chi is the Heaviside function -> simplified to max of num or 0 in rendering
 
-        float alpha = max(roughness, 0.0001); // Prevent division by 0
-        float alpha2 = alpha * alpha;
+        float alpha2 = smithAlpha2; // Clamped on the CPU to prevent division by 0
 
         float NdotL = max(dot(N, L), 0.0001);
         float NdotV = max(dot(N, V), 0.0001);
@@ -271,13 +347,12 @@ float Geometry(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, vec3 H
         return (NdotV * NdotL) / (1.0 + lambdaV + lambdaL);
     }
 
+#elif (GSF_TYPE == 6)
     // Smith-GGX Anisotropic
-    if (gsfType == 6) 
     {
-        // Map scalar roughness + anisotropy to directional roughness
-        float aspect = sqrt(1.0 - anisotropy * 0.75);  // To prevent extreme values
-        float alpha_x = max(0.0001, roughness / aspect);
-        float alpha_y = max(0.0001, roughness * aspect);
+        // Scalar roughness + anisotropy mapped to directional roughness on the CPU
+        float alpha_x = anisotropicAlpha.x;
+        float alpha_y = anisotropicAlpha.y;
 
         float NdotL = max(dot(N, L), 0.0001); // Prevent division by 0
         float NdotV = max(dot(N, V), 0.0001); // Prevent division by 0
@@ -300,31 +375,31 @@ float Geometry(float roughness, float anisotropy, vec3 N, vec3 L, vec3 V, vec3 H
         return (NdotV * NdotL) / (1.0 + lambdaV + lambdaL);
     }
 
+#else
     // Disabled
     return 1.0;
+#endif
 }
 
 // F: Fresnel Functions (FF)
 vec3 Fresnel(float metallic, float ior, vec3 N, vec3 L, vec3 V, vec3 H, vec3 T, vec3 B)
 {
+#if (FRESNEL_TYPE == 0)
     // Schlick approximation
-    if (fresnelType == 0)
     {
         // F_schlick = F0 + (1 - F0) * (1 - VdotH)^5
 
-        // Base reflectivity for dielectrics (non-metals)
-        float reflectivity = pow((1.0 - ior) / (1.0 + ior), 2.0);
-        
-        // Metals use the albedo color as F0, lerp based on metallic value
-        vec3 F0 = mix(vec3(reflectivity), objectColor, metallic);
+        // F0 comes from the CPU: dielectric reflectivity from the IOR, metals use the albedo color
+        // as F0, lerp based on metallic value
+        vec3 F0 = specularF0;
 
         float VdotH = max(dot(V, H), 0.0);
 
         return F0 + (1.0 - F0) * pow(clamp(1.0 - VdotH, 0.0, 1.0), 5.0);
     }
 
+#elif (FRESNEL_TYPE == 1)
     // Full fresnel formula (Dielectrics)
-    if (fresnelType == 1)
     {
         // F_dielectric =
         // 1/2 * [ ((cosθ - η cosθ_t)/(cosθ + η cosθ_t))^2
@@ -367,8 +442,8 @@ vec3 Fresnel(float metallic, float ior, vec3 N, vec3 L, vec3 V, vec3 H, vec3 T,
         return vec3(F);
     }
 
+#elif (FRESNEL_TYPE == 2)
     // Full fresnel formula (Conductors)
-    if (fresnelType == 2)
     {
         // F_conductor = ((η^2 + κ^2 - 2η cosθ + cos^2θ) / (η^2 + κ^2 + 2η cosθ + cos^2θ))
         //
@@ -386,31 +461,32 @@ vec3 Fresnel(float metallic, float ior, vec3 N, vec3 L, vec3 V, vec3 H, vec3 T,
         vec3 eta;
         vec3 kappa;
 
-        if (conductorPresetType == 0)       // Gold
+#if (CONDUCTOR_PRESET == 0)     // Gold
         {
             eta   = vec3(0.17, 0.35, 1.50);
             kappa = vec3(3.10, 2.70, 1.90);
         }
-        else if (conductorPresetType == 1)  // Copper
+#elif (CONDUCTOR_PRESET == 1)   // Copper
         {
             eta   = vec3(0.20, 1.10, 1.30);
             kappa = vec3(3.90, 2.60, 2.30);
         }
-        else if (conductorPresetType == 2)  // Aluminum
+#elif (CONDUCTOR_PRESET == 2)   // Aluminum
         {
             eta   = vec3(1.44, 0.96, 0.61);
             kappa = vec3(7.30, 6.50, 5.40);
         }
-        else if (conductorPresetType == 3)  // Silver
+#elif (CONDUCTOR_PRESET == 3)   // Silver
         {
             eta   = vec3(0.14, 0.16, 0.13);
             kappa = vec3(4.10, 3.10, 2.30);
         }
-        else if (conductorPresetType == 4)  // Iron
+#elif (CONDUCTOR_PRESET == 4)   // Iron
         {
             eta   = vec3(2.90);
             kappa = vec3(3.30);
         }
+#endif
 
         vec3 eta2 = eta * eta;
         vec3 kappa2 = kappa * kappa;
@@ -426,8 +502,83 @@ vec3 Fresnel(float metallic, float ior, vec3 N, vec3 L, vec3 V, vec3 H, vec3 T,
         return F;
     }
         
+#else
     // Disabled
     return vec3(1.0);
+#endif
+}
+
+// Irradiance from the 9 SH coefficients (basis constants and cosine lobe already folded in)
+vec3 IrradianceSH(vec3 n)
+{
+    return shIrradiance[0]
+         + shIrradiance[1] * n.y + shIrradiance[2] * n.z + shIrradiance[3] * n.x
+         + shIrradiance[4] * (n.x * n.y) + shIrradiance[5] * (n.y * n.z)
+         + shIrradiance[6] * (3.0 * n.z * n.z - 1.0)
+         + shIrradiance[7] * (n.x * n.z) + shIrradiance[8] * (n.x * n.x - n.y * n.y);
+}
+
+// First index and light count of the fragment's cluster
+uvec2 GetClusterRange()
+{
+    float depth = max(dot(clusterViewDepth, vec4(fragPosition, 1.0)), 0.0001);
+    ivec2 tile = min(ivec2((gl_FragCoord.xy - clusterOrigin) * clusterScale.xy), clusterCount.xy - 1);
+    int slice = clamp(int(floor(log(depth) * clusterScale.z + clusterScale.w)), 0, clusterCount.z - 1);
+
+    return texelFetch(clusterGrid, (slice * clusterCount.y + tile.y) * clusterCount.x + tile.x).rg;
+}
+
+// Light vector and incoming radiance of one clustered light
+vec3 GetClusterLight(uint index, out vec3 L)
+{
+    int light = int(texelFetch(clusterIndices, int(index)).r);
+    vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+    vec3 color = texelFetch(clusterLights, 2 * light + 1).rgb;
+
+    vec3 toLight = positionRadius.xyz - fragPosition;
+    float distance2 = max(dot(toLight, toLight), 0.0001);
+    L = toLight * inversesqrt(distance2);
+
+    // Windowed inverse square falloff, reaches 0 at the radius so the binning can cut there
+    float ratio2 = distance2 / (positionRadius.w * positionRadius.w);
+    float window = clamp(1.0 - ratio2 * ratio2, 0.0, 1.0);
+
+    return color * (window * window) / (distance2 + 1.0);
+}
+
+// Direct light of one clustered light, the same diffuse, specular and multiscatter terms as the main light in main()
+vec3 PointLight(vec3 N, vec3 V, vec3 L, vec3 radiance, vec3 T, vec3 B, float roughness, float metallic, float anisotropy, float ior)
+{
+    float NdotL = max(dot(N, L), 0.0);
+    if (NdotL <= 0.0) return vec3(0.0);
+
+    vec3 H = normalize(L + V);
+    float NdotV = max(dot(N, V), 0.0);
+    float LdotH = max(dot(L, H), 0.0);
+
+    // Burley diffuse
+    float FD90 = 0.5 + 2.0 * roughness * (LdotH * LdotH);
+    float viewScatter  = 1.0 + (FD90 - 1.0) * pow(1.0 - NdotV, 5.0);
+    float lightScatter = 1.0 + (FD90 - 1.0) * pow(1.0 - NdotL, 5.0);
+    vec3 diffuse = (objectColor / PI) * radiance * NdotL * viewScatter * lightScatter;
+
+    // Cook-Torrance specular
+    float D = Distribution(roughness, anisotropy, N, L, V, H, T, B);
+    float G = Geometry(roughness, anisotropy, N, L, V, H, T, B);
+    vec3  F = Fresnel(metallic, ior, N, L, V, H, T, B);
+    vec3 specular = D * G * F / max(4.0 * NdotL * NdotV, 0.0001) * NdotL * radiance;
+
+#if (MULTISCATTER_TYPE == 0)
+    vec2 dfgV = texture(dfgLut, vec2(NdotV, roughness)).rg;
+    vec2 dfgL = texture(dfgLut, vec2(NdotL, roughness)).rg;
+    specular += ((1.0 - dfgV.r - dfgV.g) * (1.0 - dfgL.r - dfgL.g)) * multiScatterLobe * radiance;
+#elif (MULTISCATTER_TYPE == 1)
+    specular += multiScatterApprox * radiance;
+#endif
+
+    vec3 kD = (1.0 - F) * (1.0 - metallic);
+
+    return kD * diffuse + specular;
 }
 
 void main()
@@ -457,10 +608,11 @@ void main()
     // Get the alpha value (not used in this shader, but could be for transparency)
     float alpha = alphaValue;
 
-    // ==================== Ambient Term (Simple) ====================
+    // ==================== Ambient Term (SH Irradiance) ====================
     
-    float ambientStrength = 0.1;
-    vec3 ambient = ambientStrength * lightColor * objectColor;
+    // Cosine-weighted irradiance of the sky, evaluated from 9 coefficients with ALU only
+    vec3 irradiance = IrradianceSH(N);
+    vec3 ambient = (irradiance / PI) * objectColor * (1.0 - metallic);
 
     // ==================== Diffuse Term (Burley) ====================
     
@@ -494,53 +646,48 @@ void main()
     
     // ==================== Multiscatter Energy Compensation ====================
     
+#if (MULTISCATTER_TYPE == 0)
     // Accurate
-    if (multiScatterType == 0)
     {
-        float r2 = roughness * roughness;
-        
+        // Baked GGX table (tools/dfg_lut), A + B is the single scatter albedo
+        vec2 dfgV = texture(dfgLut, vec2(NdotV, roughness)).rg;
+        vec2 dfgL = texture(dfgLut, vec2(NdotL, roughness)).rg;
+
         // Directional albedo (Probability of escape from V and L)
-        float EssV = 1.0 - (0.15 * r2) / (1.0 + 2.0 * NdotV * (1.0 - r2));
-        float EssL = 1.0 - (0.15 * r2) / (1.0 + 2.0 * NdotL * (1.0 - r2));
+        float EssV = dfgV.r + dfgV.g;
+        float EssL = dfgL.r + dfgL.g;
 
-        // Hemispherical average albedo (Eavg)
-        // This is a common analytic fit for the average of the Ess LUT
-        float Eavg = 1.0 - 0.15 * (roughness * roughness); 
         float EmsV = 1.0 - EssV;
         float EmsL = 1.0 - EssL;
 
-        // average fresnel (Energy return factor)
-        float reflectivity = pow((1.0 - ior) / (1.0 + ior), 2.0);
-        vec3 F0 = mix(vec3(reflectivity), objectColor, metallic);
-        vec3 Favg = F0 + (vec3(1.0) - F0) / 21.0; 
-
-        // The energy return engine (The "Infinite Bounce" formula)
-        vec3 energyTerm = (Favg * Eavg) / (vec3(1.0) - Favg * (1.0 - Eavg));
-
-        // The multi-scatter Lobe (fms)
-        vec3 f_ms = (vec3(EmsV * EmsL) / (PI * max(1.0 - Eavg, 0.001))) * energyTerm;
+        // The multi-scatter Lobe (fms), the energy return of the average Fresnel and albedo (Eavg)
+        // only depends on the material and comes from the CPU
+        vec3 f_ms = (EmsV * EmsL) * multiScatterLobe;
                
         // Add to existing specular (Direct lighting logic) - No NdotL here
         specular += f_ms * lightColor;
     }
 
+#elif (MULTISCATTER_TYPE == 1)
     // Approximate
-    if (multiScatterType == 1)
     {
-        float E_ss = 1.0 - 0.28 * roughness * roughness;
-        float E_ms = 1.0 - E_ss;
-
-        // Average Fresnel
-        float reflectivity = pow((1.0 - ior) / (1.0 + ior), 2.0);
-        vec3 F0 = mix(vec3(reflectivity), objectColor, metallic);
-        
-        vec3 F_avg = F0 + (1.0 - F0)/21;
+        // E_ms = 1 - E_ss with E_ss = 1 - 0.28 * roughness^2, times the average Fresnel, from the CPU
 
         // Not multiplying by NdotL because this is light that alreaedy failed the geomerty term
-        vec3 multiScatter = E_ms * F_avg * lightColor;
+        vec3 multiScatter = multiScatterApprox * lightColor;
 
         specular += multiScatter;
     }
+#endif
+
+    // ==================== Ambient Specular (Prefiltered IBL) ====================
+
+    // Mirror direction, the prefiltered map already holds the GGX lobe around it
+    vec3 R = reflect(-V, N);
+    vec3 prefiltered = textureLod(prefilterMap, R, roughness * prefilterMaxLod).rgb;
+
+    // Specular color at normal incidence (specularF0)
+    vec3 ambientSpecular = prefiltered * EnvironmentBRDF(specularF0, roughness, NdotV);
 
     // ==================== Combine ====================
 
@@ -559,19 +706,19 @@ void main()
     vec3 kD = (1.0 - kS) * (1.0 - metallic);    // Diffuse contribution
 
     // Combine with energy conservation
-    vec3 result = ambient + kD * diffuse + specular;
+    vec3 result = ambient + ambientSpecular + kD * diffuse + specular;
 
-    // In PBR, we usually need much brighter lights (Intensity > 1.0).
-    // For this demo, let's multiply the final result by an "Exposure" factor 
-    // just to see it clearly on our screen.
-    float exposure = 3.0; 
-    result *= exposure; 
+    // ==================== Clustered Point Lights ====================
 
-    // TONE MAPPING (squash infinity to 1.0)
-    //result = ACESFilm(result);
-
-    // GAMMA CORRECTION (fix for human eyes)
-    //result = pow(result, vec3(1.0 / 2.2));
+    // Only the lights binned into this fragment's cluster, no other one reaches it
+    uvec2 cluster = GetClusterRange();
+    for (uint i = cluster.x; i < cluster.x + cluster.y; i++)
+    {
+        vec3 pointL;
+        vec3 radiance = GetClusterLight(i, pointL);
+        result += PointLight(N, V, pointL, radiance, T, B, roughness, metallic, anisotropy, ior);
+    }
 
+    // Linear radiance, kept unclamped by the HDR target, the tone map pass exposes it (common/hdr_target.h)
     finalColor = vec4(result, alpha);
 }
\ No newline at end of file
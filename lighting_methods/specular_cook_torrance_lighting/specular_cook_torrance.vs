@@ -5,9 +5,30 @@ in vec3 vertexPosition;
 in vec3 vertexNormal;
 in vec4 vertexTangent;
 
+// Material grid mode, compiled in by specular_cook_torrance.c: one instance per grid cell, placed and
+// given its swept material through per-instance attributes (see common/material_grid.h)
+#ifndef INSTANCED
+    #define INSTANCED 0
+#endif
+
+#if INSTANCED
+layout(location = 10) in vec4 instancePlacement;            // Offset (xyz), uniform scale (w)
+layout(location = 11) in vec4 instanceParams;               // roughness, metallic, ior, specularAlpha2
+layout(location = 12) in vec4 instanceSpecularF0;           // specularF0, smithAlpha2
+layout(location = 13) in vec4 instanceMultiScatter;         // multiScatterLobe, anisotropicAlpha.x
+layout(location = 14) in vec4 instanceMultiScatterApprox;   // multiScatterApprox, anisotropicAlpha.y
+
+// Passed through unchanged, the same for every pixel of an instance
+flat out vec4 fragInstanceParams;
+flat out vec4 fragInstanceSpecularF0;
+flat out vec4 fragInstanceMultiScatter;
+flat out vec4 fragInstanceMultiScatterApprox;
+#endif
+
 // Uniforms (Global variables sent by Raylib)
 uniform mat4 mvp;       // Projection * View * Model
 uniform mat4 matModel;  // Model Matrix (to get World Space)
+uniform mat4 matNormal; // transpose(inverse(matModel)), computed once per draw by DrawMesh()
 
 // Outputs to the Pixel Shader
 out vec3 fragNormal;
@@ -15,16 +36,31 @@ out vec3 fragPosition;
 out vec3 fragTangent;
 out vec3 fragBitangent;
 
+// The depth pre-pass draws with this shader too, EQUAL depth needs the same position in both programs
+invariant gl_Position;
+
 void main()
 {
+#if INSTANCED
+    // Place the copy in its cell, a uniform scale leaves the normals alone
+    vec3 position = instancePlacement.xyz + instancePlacement.w * vertexPosition;
+
+    fragInstanceParams = instanceParams;
+    fragInstanceSpecularF0 = instanceSpecularF0;
+    fragInstanceMultiScatter = instanceMultiScatter;
+    fragInstanceMultiScatterApprox = instanceMultiScatterApprox;
+#else
+    vec3 position = vertexPosition;
+#endif
+
     // Calculate the final position of the vertex on the screen
-    gl_Position = mvp * vec4(vertexPosition, 1.0);
+    gl_Position = mvp * vec4(position, 1.0);
 
     // Pass the position in world space to the pixel shader
-    fragPosition = vec3(matModel * vec4(vertexPosition, 1.0));
+    fragPosition = vec3(matModel * vec4(position, 1.0));
 
     // Calculate World Space Normal
-    mat3 normalMatrix = transpose(inverse(mat3(matModel)));
+    mat3 normalMatrix = mat3(matNormal);
     fragNormal = normalMatrix * vertexNormal;
 
     // Calculate World Space fragTangents
@@ -3,24 +3,80 @@
 -> Press middle mouse button to move the camera
 -> Use mouse wheel to zoom in and out
 -> Press left mouse button to interact with the GUI
+-> Use the Lights slider to add point lights, binned into view clusters every frame (see common/light_clusters.h),
+   --lights N starts with N of them
+-> Press D to switch between forward and deferred shading (G-buffer, see common/gbuffer.h), --deferred starts deferred
+-> Use the Layers slider to draw more tori behind each other for overdraw, --layers N starts with N of them
+-> Press P to toggle the depth pre-pass of the forward path: the tori go in depth only first, then are shaded once per
+   visible pixel and the sky is drawn last, the GPU time of every pass is shown (see common/depth_prepass.h),
+   --prepass starts with it
+-> The scene renders into a float target, one pass applies the exposure and the tone map curve to all of it
+   (see common/hdr_target.h): --exposure X, --tonemap clamp|reinhard|aces, --hdr-format rgba16f|r11g11b10f,
+   --ldr draws straight to the frame
+-> Press T to toggle the pass timings overlay (CPU and GPU p50/p95/p99 of every pass), --timings file.csv writes
+   the timings of every frame on exit (see common/pass_timer.h)
+-> Run with --headless [--frames N] [--size WxH] [--output file.png] to render offscreen (see common/headless.h)
+-> Run with --bench [--warmup N] [--frames M] [--bench-output file.jsonl] for an uncapped timed run on a fixed camera
+   orbit, printed as a JSON line of frame rate and frame time percentiles (see common/headless.h),
+   --sweep roughness|metallic|ior|alpha|clearcoatWeight|clearcoatRoughness|clearcoatIor|lights|layers moves that slider over the run
+-> The forward program, uniforms, material block and sliders are the shading lab's clearcoat technique (see
+   shading_lab/multi_layer_reflectance.h), the layers, the G-buffer and the pre-pass draw with its state
 */
 
 #define RAYGUI_IMPLEMENTATION
+#define ENV_ASSETS_IMPLEMENTATION
+#define ENV_DFG_IMPLEMENTATION
+#define HEADLESS_IMPLEMENTATION
+#define SHADER_CACHE_IMPLEMENTATION
+#define MATERIAL_BLOCK_IMPLEMENTATION
+#define LIGHT_CLUSTERS_IMPLEMENTATION
+#define GBUFFER_IMPLEMENTATION
+#define DEPTH_PREPASS_IMPLEMENTATION
+#define HDR_TARGET_IMPLEMENTATION
+#define PASS_TIMER_IMPLEMENTATION
+#define TECHNIQUE_IMPLEMENTATION
+#define MULTI_LAYER_REFLECTANCE_IMPLEMENTATION
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "raylib.h"
 #include "raymath.h"
 #include "raygui.h"
 #include "rlgl.h"
-
-int main()
+#include "../../common/env_assets.h"
+#include "../../common/env_dfg.h"
+#include "../../common/headless.h"
+#include "../../common/shader_cache.h"
+#include "../../common/material_block.h"
+#include "../../common/light_clusters.h"
+#include "../../common/gbuffer.h"
+#include "../../common/depth_prepass.h"
+#include "../../common/hdr_target.h"
+#include "../../common/pass_timer.h"
+#include "../../shading_lab/multi_layer_reflectance.h"
+
+// Passes timed every frame
+#define PASS_DEPTH      0
+#define PASS_SHADING    1
+#define PASS_SKY        2
+#define PASS_GBUFFER    3
+#define PASS_LIGHTING   4
+#define PASS_CLUSTERS   5
+#define PASS_TONEMAP    6
+#define PASS_GUI        7
+
+int main(int argc, char *argv[])
 {
     // Set window dimensions
     const int screenWidth = 800;
     const int screenHeight = 800;
 
+    // Read the headless options, --headless renders offscreen into a hidden window
+    HeadlessRun headless = ParseHeadlessArgs(argc, argv, screenWidth, screenHeight);
+
     // Initialize the window
-    InitWindow(screenWidth, screenHeight, "Shading Lab");
+    InitHeadlessWindow(&headless, "Shading Lab");
 
     // Define the camera
     Camera camera = { 0 };
@@ -35,103 +91,130 @@ int main()
     float pitch = 0.0f;
     float radius = 2.5f;
 
-    // Load the panoramic environment map
-    Image img = LoadImage("resources/sky1_2k.jpg");
-    Texture2D panorama = LoadTextureFromImage(img);
-    UnloadImage(img);
+    // Start loading the sky on a worker thread: cubemap for the skybox, 9 SH coefficients for the diffuse
+    // ambient term and the GGX prefiltered cubemap (every mip level holds the reflection for one roughness,
+    // so the shader needs a single fetch). Grey placeholders are bound until the data streams in. Baked on
+    // the first run, mapped back from the caches next to the panorama afterwards, the cold and warm start
+    // times are logged
+    // Headless and bench runs load it in full before the first frame, so every run renders the same sky
+    EnvAssets sky = ((headless.enabled || headless.bench)? LoadEnvAssets : LoadEnvAssetsAsync)("resources/sky1_2k.jpg", ENV_ASSET_ALL);
 
     // Create skybox cube mesh
     Mesh cube = GenMeshCube(100.0f, 100.0f, 100.0f);
     Model skybox = LoadModelFromMesh(cube);
 
-    // Load skybox shader and set panorama texture
-    skybox.materials[0].shader = LoadShader("resources/skybox.vs", "resources/skybox.fs");
-    
-    // The shader converts the panorama to a skybox view
-    skybox.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = panorama;
-    
-    // Generate a torus mesh
-    Mesh mesh = GenMeshTorus(0.4f, 1.0f, 48, 96);
-    Model torus = LoadModelFromMesh(mesh);
-
-    // Generate tangents
-    GenMeshTangents(&mesh);
-
-    // Load and assign the shaders
-    Shader shader = LoadShader("multi_layer_reflectance/clearcoat/clearcoat.vs", "multi_layer_reflectance/clearcoat/clearcoat.fs");
-    torus.materials[0].shader = shader;
-
-    // Assign the uniforms
-    int lightPosLoc    = GetShaderLocation(shader, "lightPos");
-    int lightColorLoc  = GetShaderLocation(shader, "lightColor");
-    int objectColorLoc = GetShaderLocation(shader, "objectColor");
-    int viewPosLoc     = GetShaderLocation(shader, "viewPos");
-    int roughnessValueLoc = GetShaderLocation(shader, "roughnessValue");
-    int metallicValueLoc  = GetShaderLocation(shader, "metallicValue");
-    int iorValueLoc = GetShaderLocation(shader, "iorValue");
-    int alphaLoc       = GetShaderLocation(shader, "alphaValue");
-    int clearcoatWeightValueLoc = GetShaderLocation(shader, "clearcoatWeightValue");
-    int clearcoatRoughnessValueLoc = GetShaderLocation(shader, "clearcoatRoughnessValue");
-    int clearcoatIorValueLoc = GetShaderLocation(shader, "clearcoatIorValue");
-    int clearcoatTintLoc = GetShaderLocation(shader, "clearcoatTint");
-
-    int envLoc = GetShaderLocation(skybox.materials[0].shader, "environmentMap");
-    
-    // Set static uniform values
-    Vector3 lightPos = { 5.0f, 5.0f, 5.0f };
-    Vector3 lightColor = { 1.0f, 1.0f, 1.0f };
-    Vector3 objectColor = { 0.5f, 0.0f, 0.0f };
-    Vector3 clearcoatTint = { 1.0f, 1.0f, 1.0f };
-
-    // Update shader uniform values
-
-    SetShaderValue(shader, lightPosLoc, &lightPos, SHADER_UNIFORM_VEC3);                        // Light position
-    SetShaderValue(shader, lightColorLoc, &lightColor, SHADER_UNIFORM_VEC3);                    // Light color
-    SetShaderValue(shader, objectColorLoc, &objectColor, SHADER_UNIFORM_VEC3);                  // Object color
+    // Load skybox shader and set the cubemap
+    skybox.materials[0].shader = LoadShaderCached("resources/skybox.vs", "resources/skybox.fs");
 
-    float cameraPos[3] = { camera.position.x, camera.position.y, camera.position.z };
-    SetShaderValue(shader, viewPosLoc, cameraPos, SHADER_UNIFORM_VEC3);                         // View position
-
-    float roughnessSliderValue = 0.5f;
-    float roughnessValue = roughnessSliderValue;
-    SetShaderValue(shader, roughnessValueLoc, &roughnessValue, SHADER_UNIFORM_FLOAT);           // Roughness
-
-    float metallicSliderValue = 0.5f;
-    float metallicValue = metallicSliderValue;
-    SetShaderValue(shader, metallicValueLoc, &metallicValue, SHADER_UNIFORM_FLOAT);             // Metallic
-
-    float iorSliderValue = 1.5; // 1 = vaccume
-    float iorValue = iorSliderValue;
-    SetShaderValue(shader, iorValueLoc, &iorValue, SHADER_UNIFORM_FLOAT);                       // IOR
-
-    float alphaSliderValue = 1.0f;
-    float alphaValue = alphaSliderValue;
-    SetShaderValue(shader, alphaLoc, &alphaValue, SHADER_UNIFORM_FLOAT);                        // Alpha - Visibility  
+    // Raylib binds MATERIAL_MAP_CUBEMAP as a cube texture, the shader samples it with the view direction
+    skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = sky.skybox;
+    skybox.materials[0].shader.locs[SHADER_LOC_MAP_CUBEMAP] = GetShaderLocation(skybox.materials[0].shader, "environmentMap");
+    
+    // The lab's technique: program, static uniforms, material block and the dense torus with tangents, with
+    // the split-sum DFG table baked by tools/dfg_lut (environment BRDF and multiscatter albedo)
+    const Technique *technique = &clearcoatTechnique;
+    TechniqueAssets assets = LoadTechniqueAssets(&sky);
+    LayeredState *layered = (LayeredState *)technique->Init(technique, &assets);
+    int envPending = technique->envAssets;
+
+    // Point lights on top of the main one, binned into the clusters of the view every frame, so every fragment
+    // only loops over the lights that reach it. --lights N starts with N of them
+    const int maxLights = 4096;
+    float lightCountValue = 0.0f;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--lights") == 0) lightCountValue = Clamp((float)atoi(argv[i + 1]), 0.0f, (float)maxLights);
+    }
 
-    float clearcoatWeightSliderValue = 0.0f;
-    float clearcoatWeightValue = clearcoatWeightSliderValue;
-    SetShaderValue(shader, clearcoatWeightValueLoc, &clearcoatWeightValue, SHADER_UNIFORM_FLOAT);       // Clearcoat weight
+    ClusterLight *pointLights = (ClusterLight *)RL_CALLOC(maxLights, sizeof(ClusterLight));
+    LightClusters clusters = LoadLightClusters();
+
+    // Deferred path: the tori write their surface into a G-buffer and one full screen pass lights every
+    // visible pixel once, with the same terms as the forward shader. D switches, --deferred starts with it.
+    // The Layers slider draws tori behind each other, far to near, so every one passes the depth test: the
+    // forward shader lights each of them, the deferred one only the front. --layers N starts with N of them
+    const int maxLayers = 8;
+    bool deferred = false;
+    float layerCountValue = 1.0f;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--deferred") == 0) deferred = true;
+        else if ((strcmp(argv[i], "--layers") == 0) && (i + 1 < argc)) layerCountValue = Clamp((float)atoi(argv[i + 1]), 1.0f, (float)maxLayers);
+    }
 
-    float clearcoatRoughnessSliderValue = 0.025f;
-    float clearcoatRoughnessValue = clearcoatRoughnessSliderValue;
-    SetShaderValue(shader, clearcoatRoughnessValueLoc, &clearcoatRoughnessValue, SHADER_UNIFORM_FLOAT); // Clearcoat roughness
+    int renderWidth = headless.enabled? headless.width : GetRenderWidth();
+    int renderHeight = headless.enabled? headless.height : GetRenderHeight();
+    GBuffer gbuffer = LoadGBuffer(renderWidth, renderHeight);
+
+    Shader gbufferShader = LoadShaderCached("multi_layer_reflectance/clearcoat/clearcoat.vs", "multi_layer_reflectance/clearcoat/clearcoat_gbuffer.fs");
+    BindMaterialBlock(gbufferShader);
+
+    Shader deferredShader = LoadShaderCached("multi_layer_reflectance/clearcoat/clearcoat_deferred.vs", "multi_layer_reflectance/clearcoat/clearcoat_deferred.fs");
+    BindMaterialBlock(deferredShader);
+
+    // Same lights as the technique's forward program
+    Vector3 lightPos = TECHNIQUE_LIGHT_POS;
+    Vector3 lightColor = TECHNIQUE_LIGHT_COLOR;
+    float prefilterMaxLod = (float)(ENV_PREFILTER_ROUGHNESS_LEVELS - 1);
+
+    int deferredViewPosLoc = GetShaderLocation(deferredShader, "viewPos");
+    int deferredShIrradianceLoc = GetShaderLocation(deferredShader, "shIrradiance");
+    int invViewProjLoc = GetShaderLocation(deferredShader, "invViewProj");
+    SetShaderValue(deferredShader, GetShaderLocation(deferredShader, "lightPos"), &lightPos, SHADER_UNIFORM_VEC3);
+    SetShaderValue(deferredShader, GetShaderLocation(deferredShader, "lightColor"), &lightColor, SHADER_UNIFORM_VEC3);
+    SetShaderValue(deferredShader, GetShaderLocation(deferredShader, "prefilterMaxLod"), &prefilterMaxLod, SHADER_UNIFORM_FLOAT);
+
+    // The lighting pass binds its maps like DrawMesh(), the G-buffer textures go after them
+    MaterialMap lightingMaps[GBUFFER_MAP_COUNT] = { 0 };
+    Material lighting = { deferredShader, lightingMaps };
+    lighting.maps[MATERIAL_MAP_PREFILTER].texture = sky.prefilter;
+    lighting.maps[MATERIAL_MAP_BRDF].texture = assets.dfgLut;
+    deferredShader.locs[SHADER_LOC_MAP_PREFILTER] = GetShaderLocation(deferredShader, "prefilterMap");
+    deferredShader.locs[SHADER_LOC_MAP_BRDF] = GetShaderLocation(deferredShader, "dfgLut");
+
+    // Forward depth pre-pass, the same vertex shader with an empty fragment shader. P switches, --prepass starts
+    // with it. The deferred path already shades every pixel once and ignores it
+    Shader depthShader = LoadShaderCached("multi_layer_reflectance/clearcoat/clearcoat.vs", DEPTH_PREPASS_FRAGMENT_SHADER);
+
+    bool prepass = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--prepass") == 0) prepass = true;
+    }
 
-    float clearcoatIorSliderValue = 1.5; // 1 = vaccume
-    float clearcoatIorValue = clearcoatIorSliderValue;
-    SetShaderValue(shader, clearcoatIorValueLoc, &clearcoatIorValue, SHADER_UNIFORM_FLOAT);             // Clearcoat IOR
+    // The scene goes to a float target the size of the frame, one pass exposes and tone maps all of it
+    HdrTarget hdr = LoadHdrTarget(headless.enabled? headless.width : GetRenderWidth(), headless.enabled? headless.height : GetRenderHeight(),
+        ParseHdrArgs(argc, argv, technique->exposure));
 
+    const char *passNames[] = { "Depth", "Shading", "Sky", "G-buffer", "Lighting", "Clusters", "Tonemap", "GUI" };
+    PassTimer timer = LoadPassTimer(passNames, 8);
 
-    SetShaderValue(shader, clearcoatTintLoc, &clearcoatTint, SHADER_UNIFORM_VEC3);                      // Clearcoat tint
+    // T shows the timings overlay (off in headless and bench runs), --timings FILE.csv keeps
+    // every sample
+    timer.output = ParsePassTimerArgs(argc, argv);
+    bool showTimings = !headless.enabled && !headless.bench;
 
-    // Passing the environment map to the skybox shader
-    SetShaderValueTexture(skybox.materials[0].shader, envLoc, panorama);
+    // Lock the frames rate, headless and bench runs are not capped
+    if (!headless.enabled && !headless.bench) SetTargetFPS(60);
 
-    // Lock the frames rate
-    SetTargetFPS(60);
+    // Bench runs keep the startup slider values, or the swept one
+    if (headless.bench) GuiLock();
     
     // Main render loop
-    while (!WindowShouldClose())
+    while (!HeadlessShouldClose(&headless))
     {
+        // Upload the environment levels the loader thread finished since the last frame, the technique sends
+        // them on its update
+        envPending |= UpdateEnvAssets(&sky);
+        if (envPending & ENV_ASSET_IRRADIANCE) SetShaderValueSH9(deferredShader, deferredShIrradianceLoc, sky.irradiance);
+
+        if (IsKeyPressed(KEY_D)) deferred = !deferred;
+        if (IsKeyPressed(KEY_P)) prepass = !prepass;
+
+        // Collect the pass times of the frame the GPU finished
+        UpdatePassTimer(&timer);
+        if (IsKeyPressed(KEY_T)) showTimings = !showTimings;
+
         // Camera orbit controls
         if (IsMouseButtonDown(MOUSE_MIDDLE_BUTTON))
         {
@@ -149,6 +232,9 @@ int main()
         radius -= wheel * 0.2f;
         radius = Clamp(radius, 1.0f, 10.0f);
 
+        // Bench runs follow a fixed orbit instead
+        UpdateHeadlessOrbit(&headless, &yaw, &pitch);
+
         // Spherical to cartesian
         camera.position.x = radius * cosf(pitch) * sinf(yaw);
         camera.position.y = radius * sinf(pitch);
@@ -156,114 +242,202 @@ int main()
 
         camera.target = (Vector3){ 0.0f, 0.0f, 0.0f};
 
-        // Update camera position every frame
+        // Update camera position every frame, the technique sends it to its own program
         float cameraPos[3] = { camera.position.x, camera.position.y, camera.position.z };
-        SetShaderValue(shader, viewPosLoc, cameraPos, SHADER_UNIFORM_VEC3);
+        SetShaderValue(deferredShader, deferredViewPosLoc, cameraPos, SHADER_UNIFORM_VEC3);
+
+        // The deferred pass rebuilds the world position with the projection BeginMode3D() sets up
+        Matrix viewProj = MatrixMultiply(GetCameraMatrix(camera), MatrixPerspective(camera.fovy*DEG2RAD, (double)renderWidth/renderHeight, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR));
+        SetShaderValueMatrix(deferredShader, invViewProjLoc, MatrixInvert(viewProj));
+
+        // Bench runs may sweep the light and layer counts over the measured frames (--sweep), the technique
+        // sweeps its sliders
+        lightCountValue = GetHeadlessSweep(&headless, "lights", lightCountValue, 0.0f, (float)maxLights);
+        layerCountValue = GetHeadlessSweep(&headless, "layers", layerCountValue, 1.0f, (float)maxLayers);
 
         // Rotate the torus over time
         static float angle = 0.0f;
         angle += 0.01f;
-        torus.transform = MatrixMultiply(
-            MatrixRotateZ(angle),
-            MatrixRotateX(DEG2RAD * 90.0f)
-        );
-        
-        // Start rendering
-        BeginDrawing();
-
-        // Update roughness from slider
-        roughnessValue = roughnessSliderValue;
-        SetShaderValue(shader, roughnessValueLoc, &roughnessValue, SHADER_UNIFORM_FLOAT);
-
-        // Update metallic from slider
-        metallicValue = metallicSliderValue;
-        SetShaderValue(shader, metallicValueLoc, &metallicValue, SHADER_UNIFORM_FLOAT);
 
-        // Update IOR from slider
-        iorValue = iorSliderValue;
-        SetShaderValue(shader, iorValueLoc, &iorValue, SHADER_UNIFORM_FLOAT);
-
-        // Update alpha from slider
-        alphaValue = alphaSliderValue;
-        SetShaderValue(shader, alphaLoc, &alphaValue, SHADER_UNIFORM_FLOAT);
+        TechniqueFrame frame = { 0 };
+        frame.camera = camera;
+        frame.transform = MatrixMultiply(MatrixRotateZ(angle), MatrixRotateX(DEG2RAD * 90.0f));
+        frame.width = renderWidth;
+        frame.height = renderHeight;
+        frame.envChanged = envPending;
+        frame.run = &headless;
+        frame.clusters = &clusters;
+        envPending = 0;
+
+        // Move the point lights and bin them for this view, the shader reads the lists from buffer textures
+        int lightCount = (int)lightCountValue;
+        BeginPassTimer(&timer, PASS_CLUSTERS);
+        AnimateClusterLights(pointLights, lightCount, angle);
+        BuildLightClusters(&clusters, pointLights, lightCount, camera, renderWidth, renderHeight);
+        UploadLightClusters(&clusters);
+        SetShaderLightClusters(deferredShader, &clusters);
+        EndPassTimer(&timer);
+
+        // Camera position, clusters and the material fields the sliders changed since the last frame
+        technique->Update(layered, &frame);
+
+        // Layers go back along the view direction from the origin, drawn far to near
+        int layerCount = (int)layerCountValue;
+        Vector3 layerStep = Vector3Scale(Vector3Normalize(Vector3Subtract(camera.target, camera.position)), 0.5f);
+        Matrix layerTransforms[maxLayers];
+        for (int i = 0; i < layerCount; i++)
+        {
+            Vector3 offset = Vector3Scale(layerStep, (float)i);
+            layerTransforms[i] = MatrixMultiply(frame.transform, MatrixTranslate(offset.x, offset.y, offset.z));
+        }
 
-        // Update clearcoat weight from slider
-        clearcoatWeightValue = clearcoatWeightSliderValue;
-        SetShaderValue(shader, clearcoatWeightValueLoc, &clearcoatWeightValue, SHADER_UNIFORM_FLOAT);
+        // The G-buffer and the pre-pass draw the technique's torus with their own program
+        Material gbufferMaterial = layered->material;
+        gbufferMaterial.shader = gbufferShader;
+        Material depthMaterial = layered->material;
+        depthMaterial.shader = depthShader;
 
-        // Update clearcoat roughness from slider
-        clearcoatRoughnessValue = clearcoatRoughnessSliderValue;
-        SetShaderValue(shader, clearcoatRoughnessValueLoc, &clearcoatRoughnessValue, SHADER_UNIFORM_FLOAT);
+        // Deferred geometry pass, only the surface goes out. It renders into its own target, so before
+        // the frame starts
+        if (deferred)
+        {
+            BeginPassTimer(&timer, PASS_GBUFFER);
+            BeginGBufferMode(gbuffer);
+            BeginMode3D(camera);
+            for (int i = layerCount - 1; i >= 0; i--) DrawMesh(layered->mesh, gbufferMaterial, layerTransforms[i]);
+            EndMode3D();
+            EndGBufferMode();
+            EndPassTimer(&timer);
+        }
 
-        // Update clearcoat IOR from slider
-        clearcoatIorValue = clearcoatIorSliderValue;
-        SetShaderValue(shader, clearcoatIorValueLoc, &clearcoatIorValue, SHADER_UNIFORM_FLOAT);
+        // With the pre-pass the sky goes last and only fills what the tori left uncovered
+        bool depthPrepass = prepass && !deferred;
+        
+        // Start rendering
+        BeginHeadlessDrawing(&headless);
         
+        // Draw the scene into the float target, the background included
+        BeginHdrMode(&hdr);
+
         // Clear the screen with an off-white background
         ClearBackground((Color){200, 200, 200, 255});
 
         // Switch to 3D rendering using the given camera
         BeginMode3D(camera);
 
-        // Draw skybox (disable depth writing so it's always in background)
-        rlDisableBackfaceCulling();
-        rlDisableDepthMask();
-        DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
-        rlEnableBackfaceCulling();
-        rlEnableDepthMask();
-        
-        // Draw the torus model at given position, scale and color
-        DrawModel(torus, (Vector3){0,0,0}, 1.0f, (Color){objectColor.x * 255, objectColor.y * 255, objectColor.z * 255, 255});
+        if (depthPrepass)
+        {
+            // Depth pre-pass, the same draws with the depth only program
+            BeginPassTimer(&timer, PASS_DEPTH);
+            BeginDepthPrepass();
+            for (int i = layerCount - 1; i >= 0; i--) DrawMesh(layered->mesh, depthMaterial, layerTransforms[i]);
+            EndDepthPrepass();
+            EndPassTimer(&timer);
+        }
+        else
+        {
+            // Draw skybox (disable depth writing so it's always in background)
+            BeginPassTimer(&timer, PASS_SKY);
+            rlDisableBackfaceCulling();
+            rlDisableDepthMask();
+            DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
+            rlEnableBackfaceCulling();
+            rlEnableDepthMask();
+            EndPassTimer(&timer);
+        }
+
+        // Draw the technique's torus at every layer, the deferred path lights the G-buffer instead. After the
+        // pre-pass only the fragments that kept their depth are shaded, the front layer
+        if (!deferred)
+        {
+            BeginPassTimer(&timer, PASS_SHADING);
+            if (depthPrepass) BeginDepthEqualPass();
+            for (int i = layerCount - 1; i >= 0; i--) DrawMesh(layered->mesh, layered->material, layerTransforms[i]);
+            if (depthPrepass) EndDepthEqualPass();
+            EndPassTimer(&timer);
+        }
+
+        // Sky last, it sits on the far plane and the depth test leaves it only the pixels nothing covered
+        if (depthPrepass)
+        {
+            BeginPassTimer(&timer, PASS_SKY);
+            rlDisableBackfaceCulling();
+            rlDisableDepthMask();
+            DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
+            rlEnableBackfaceCulling();
+            rlEnableDepthMask();
+            EndPassTimer(&timer);
+        }
 
         // Exit 3D mode and return to 2D rendering
         EndMode3D();
 
-        // Add information text
-        char infoText[128];
-        snprintf(infoText, sizeof(infoText), "Diffuse Burley + Specular Cook-Torrance Lighting + Clearcoat Layer");
-        DrawText(infoText, 10, 10, 20, BLACK);
+        if (deferred)
+        {
+            BeginPassTimer(&timer, PASS_LIGHTING);
+            DrawGBufferLighting(gbuffer, lighting);
+            EndPassTimer(&timer);
+        }
 
-        DrawText("Main Layer", 10, 40, 20, BLACK);
+        // Back to the frame, the scene exposed and tone mapped into it
+        EndHdrMode(&hdr);
 
-        // Draw roughness slider
-        DrawText("Roughness", 10, 70, 20, BLACK);
-        GuiSlider((Rectangle){ 130, 70, 200, 20 }, "", TextFormat("%.2f", roughnessSliderValue), &roughnessSliderValue, 0.0f, 1.0f);
+        BeginPassTimer(&timer, PASS_TONEMAP);
+        DrawHdrToneMap(&hdr);
+        EndPassTimer(&timer);
 
-        // Draw metallic slider
-        DrawText("Metallic", 10, 100, 20, BLACK);
-        GuiSlider((Rectangle){ 130, 100, 200, 20 }, "", TextFormat("%.2f", metallicSliderValue), &metallicSliderValue, 0.0f, 1.0f);
+        // GUI laid out on the frame size, which --size or a window resize can change
+        const int guiWidth = GetHeadlessScreenWidth(&headless);
+        const int guiHeight = GetHeadlessScreenHeight(&headless);
 
-        // Draw IOR slider
-        DrawText("IOR", 10, 130, 20, BLACK);
-        GuiSlider((Rectangle){ 130, 130, 200, 20 }, "", TextFormat("%.2f", iorSliderValue), &iorSliderValue, 1.0f, 3.5f);
+        // Text and GUI
+        BeginPassTimer(&timer, PASS_GUI);
 
-        // Draw alpha slider
-        DrawText("Alpha", 10, 160, 20, BLACK);
-        GuiSlider((Rectangle){ 130, 160, 200, 20 }, "", TextFormat("%.2f", alphaSliderValue), &alphaSliderValue, 0.0f, 1.0f);
+        // Add information text
+        DrawText(technique->title, 10, 10, 20, BLACK);
 
-        DrawText("Clearcoat Layer", 410, 40, 20, BLACK);
+        // Main and clearcoat layer sliders
+        technique->DrawGui(layered, guiWidth, guiHeight);
 
-        // Draw Clearcoat Weight slider
-        DrawText("Weight", 410, 70, 20, BLACK);
-        GuiSlider((Rectangle){ 550, 70, 200, 20 }, "", TextFormat("%.2f", clearcoatWeightSliderValue), &clearcoatWeightSliderValue, 0.0f, 1.0f);
+        // Draw point light count slider, with the binning time of this frame
+        DrawText("Lights", 10, guiHeight - 60, 20, BLACK);
+        GuiSlider((Rectangle){ 130, guiHeight - 60, 200, 20 }, "", TextFormat("%i", lightCount), &lightCountValue, 0.0f, (float)maxLights);
+        DrawText(TextFormat("Binned in %.2f ms, %i references", clusters.buildTime*1000.0, clusters.indexCount), 410, guiHeight - 60, 20, BLACK);
 
-        // Draw Clearcoat Roughness slider
-        DrawText("Roughness", 410, 100, 20, BLACK);
-        GuiSlider((Rectangle){ 550, 100, 200, 20 }, "", TextFormat("%.3f", clearcoatRoughnessSliderValue), &clearcoatRoughnessSliderValue, 0.0f, 1.0f);
+        // Draw overdraw layer slider, with the shading path
+        DrawText("Layers", 10, guiHeight - 90, 20, BLACK);
+        GuiSlider((Rectangle){ 130, guiHeight - 90, 200, 20 }, "", TextFormat("%i", layerCount), &layerCountValue, 1.0f, (float)maxLayers);
+        DrawText(deferred? "Deferred (D for forward)" : "Forward (D for deferred)", 410, guiHeight - 90, 20, BLACK);
+
+        // GPU time of the passes, averaged over the last frames
+        if (deferred) DrawText(TextFormat("Sky %.2f + G-buffer %.2f + lighting %.2f ms", timer.time[PASS_SKY], timer.time[PASS_GBUFFER], timer.time[PASS_LIGHTING]), 10, guiHeight - 120, 20, BLACK);
+        else if (prepass) DrawText(TextFormat("Pre-pass: depth %.2f + shading %.2f + sky %.2f ms", timer.time[PASS_DEPTH], timer.time[PASS_SHADING], timer.time[PASS_SKY]), 10, guiHeight - 120, 20, BLACK);
+        else DrawText(TextFormat("No pre-pass (P): sky %.2f + shading %.2f ms", timer.time[PASS_SKY], timer.time[PASS_SHADING]), 10, guiHeight - 120, 20, BLACK);
+
+        EndPassTimer(&timer);
+
+        // Percentiles of the pass times over the last frames
+        if (showTimings) DrawPassTimer(&timer, guiWidth - 330, 230);
 
-        // Draw Clearcoat IOR slider
-        DrawText("IOR", 410, 130, 20, BLACK);
-        GuiSlider((Rectangle){ 550, 130, 200, 20 }, "", TextFormat("%.2f", clearcoatIorSliderValue), &clearcoatIorSliderValue, 1.0f, 3.5f);
-        
         // Finish the frame and present it on screen
-        EndDrawing();
+        EndHeadlessDrawing(&headless);
     }
 
     // Cleanup
-    UnloadTexture(panorama);
+    technique->Unload(layered);
+    UnloadEnvAssets(sky);
+    UnloadTechniqueAssets(&assets);
+    skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = (Texture2D){ 0 };    // The sky's, UnloadEnvAssets() deleted it
     UnloadModel(skybox);
-    UnloadModel(torus);
-    UnloadShader(shader);
+    UnloadLightClusters(&clusters);
+    RL_FREE(pointLights);
+    UnloadShader(gbufferShader);
+    UnloadShader(deferredShader);
+    UnloadShader(depthShader);
+    UnloadHdrTarget(hdr);
+    UnloadPassTimer(&timer);
+    UnloadGBuffer(gbuffer);
+    UnloadHeadlessRun(&headless);
     CloseWindow();
 
     return 0;
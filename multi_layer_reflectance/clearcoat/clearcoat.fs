@@ -12,18 +12,58 @@ in vec3 fragBitangent;
 // Uniforms (set from cook_torrance.c)
 uniform vec3 lightPos;
 uniform vec3 lightColor;
-uniform vec3 objectColor;
 uniform vec3 viewPos;
+uniform vec3 shIrradiance[9];      // Sky irradiance as order 2 spherical harmonics
 
-uniform float roughnessValue;
-uniform float metallicValue;
-uniform float iorValue;
-uniform float alphaValue;
-
-uniform float clearcoatWeightValue;
-uniform float clearcoatRoughnessValue;
-uniform float clearcoatIorValue;
-uniform vec3 clearcoatTint;
+// Material parameters and the constants derived from them on the CPU, one std140 uniform buffer
+// shared with the other material shaders (layout in common/material_block.h, keep the three copies in sync)
+layout(std140) uniform MaterialBlock
+{
+    vec3 objectColor;
+    float roughnessValue;
+    vec3 sheenTint;
+    float metallicValue;
+    vec3 clearcoatTint;
+    float alphaValue;
+    float anisotropyValue;
+    float iorValue;
+    float sheenWeightValue;
+    float sheenRoughnessValue;
+    float clearcoatWeightValue;
+    float clearcoatRoughnessValue;
+    float clearcoatIorValue;
+
+    vec3 specularF0;                // mix(F0 of iorValue, objectColor, metallicValue)
+    float specularAlpha2;           // max(roughness^2, 0.0001), NDF
+    vec3 averageFresnel;            // Favg = F0 + (1 - F0)/21
+    float smithAlpha2;              // max(roughness, 0.0001)^2, GSF
+    vec3 multiScatterLobe;          // Kulla-Conty lobe over (1 - EssV)*(1 - EssL)
+    float clearcoatF0;
+    vec3 multiScatterApprox;        // (1 - Ess)*Favg of the approximate multiscatter
+    float clearcoatAlpha2;
+    vec3 clearcoatAttenuation;      // clearcoatTint^2, in and out of the coat
+    float clearcoatSmithAlpha2;
+    vec3 sheenColor;                // sheenWeightValue*sheenTint
+    float sheenExponent;            // Charlie NDF = sheenNorm*pow(sin2h, sheenExponent)
+    vec2 anisotropicAlpha;          // GGX alpha along T and B
+    float sheenNorm;
+    float averageAlbedo;            // Eavg at roughnessValue
+};
+
+uniform samplerCube prefilterMap;   // GGX prefiltered cubemap, one roughness per mip level
+uniform float prefilterMaxLod;      // Mip level holding roughness 1.0
+uniform sampler2D dfgLut;           // Baked GGX table over (NdotV, roughness): rg = split-sum scale/bias, b = Eavg
+
+// Clustered point lights, binned into a froxel grid on the CPU every frame (layout in common/light_clusters.h,
+// keep the four copies in sync). The main light above stays, these add on top
+uniform samplerBuffer clusterLights;    // 2 texels per light: position, radius / color
+uniform usamplerBuffer clusterGrid;     // Per cluster: first index, light count
+uniform usamplerBuffer clusterIndices;  // Light indices grouped by cluster
+uniform vec4 clusterViewDepth;          // View depth = dot(clusterViewDepth, vec4(position, 1))
+uniform vec4 clusterScale;              // Tiles per pixel (xy), slice = log(depth)*z + w
+uniform vec2 clusterOrigin;             // Lower left pixel of the viewport, 0 on a full target
+
+const ivec3 clusterCount = ivec3(16, 16, 24);  // LIGHT_CLUSTERS_X, _Y, _Z
 
 // Output color to the screen
 out vec4 finalColor;
@@ -31,13 +71,20 @@ out vec4 finalColor;
 // Define PI
 const float PI = 3.14159265359;
 
+// Split-sum environment BRDF (scale and bias applied to F0), one fetch of the baked table
+vec3 EnvironmentBRDF(vec3 F0, float roughness, float NdotV)
+{
+    vec2 AB = texture(dfgLut, vec2(NdotV, roughness)).rg;
+
+    return F0 * AB.x + AB.y;
+}
+
 // D: Normal Distribution Functions (NDF) - FIXED TO GGX ONLY
-float Distribution(float roughness, vec3 N, vec3 H)
+// alpha2 is clamped on the CPU (specularAlpha2, clearcoatAlpha2) to prevent division by zero
+float Distribution(float alpha2, vec3 N, vec3 H)
 {
     // D_GGX = alpha^2 / (pi * ((alpha^2-1) * (NdotH^2) + 1)^2)
 
-    float alpha2 = max(roughness * roughness, 0.0001); // Prevent division by zero
-        
     float NdotH = max(dot(N, H), 0.0001); // Prevent division by zero
 
     float NdotH2 = NdotH * NdotH;
@@ -50,7 +97,8 @@ float Distribution(float roughness, vec3 N, vec3 H)
 }
 
 // G: Geometry Shadowing Functions (GSF) - ONLY SMITH-GGX
-float Geometry(float roughness, vec3 N, vec3 L, vec3 V)
+// alpha2 is clamped on the CPU (smithAlpha2, clearcoatSmithAlpha2) to prevent division by zero
+float Geometry(float alpha2, vec3 N, vec3 L, vec3 V)
 {
     // G_smith_GGX = (Chi(NdotL) * Chi(NdotV)) / (1 + Lambda(NdotL) + Lambda(NdotV))
 
@@ -60,9 +108,6 @@ float Geometry(float roughness, vec3 N, vec3 L, vec3 V)
         
     // Chi is the Heaviside function -> simplified to max of num or 0 in rendering
 
-    float alpha = max(roughness, 0.0001); // Prevent division by 0
-    float alpha2 = alpha * alpha;
-
     float NdotL = max(dot(N, L), 0.0001);
     float NdotV = max(dot(N, V), 0.0001);
 
@@ -85,21 +130,101 @@ float Geometry(float roughness, vec3 N, vec3 L, vec3 V)
 }
 
 // F: Fresnel Functions (FF) - ONLY SCHLICK
-vec3 Fresnel(float metallic, float ior, vec3 V, vec3 H)
+vec3 Fresnel(vec3 F0, vec3 V, vec3 H)
 {
     // F_schlick = F0 + (1 - F0) * (1 - VdotH)^5
 
-    // Base reflectivity for dielectrics (non-metals)
-    float reflectivity = pow((1.0 - ior) / (1.0 + ior), 2.0);
-        
-    // Metals use the albedo color as F0, lerp based on metallic value
-    vec3 F0 = mix(vec3(reflectivity), objectColor, metallic);
+    // F0 comes from the CPU: dielectric reflectivity from the IOR, metals use the albedo color
+    // as F0, lerp based on metallic value
 
     float VdotH = max(dot(V, H), 0.0);
 
     return F0 + (1.0 - F0) * pow(clamp(1.0 - VdotH, 0.0, 1.0), 5.0);
 }
 
+// Irradiance from the 9 SH coefficients (basis constants and cosine lobe already folded in)
+vec3 IrradianceSH(vec3 n)
+{
+    return shIrradiance[0]
+         + shIrradiance[1] * n.y + shIrradiance[2] * n.z + shIrradiance[3] * n.x
+         + shIrradiance[4] * (n.x * n.y) + shIrradiance[5] * (n.y * n.z)
+         + shIrradiance[6] * (3.0 * n.z * n.z - 1.0)
+         + shIrradiance[7] * (n.x * n.z) + shIrradiance[8] * (n.x * n.x - n.y * n.y);
+}
+
+// First index and light count of the fragment's cluster
+uvec2 GetClusterRange()
+{
+    float depth = max(dot(clusterViewDepth, vec4(fragPosition, 1.0)), 0.0001);
+    ivec2 tile = min(ivec2((gl_FragCoord.xy - clusterOrigin) * clusterScale.xy), clusterCount.xy - 1);
+    int slice = clamp(int(floor(log(depth) * clusterScale.z + clusterScale.w)), 0, clusterCount.z - 1);
+
+    return texelFetch(clusterGrid, (slice * clusterCount.y + tile.y) * clusterCount.x + tile.x).rg;
+}
+
+// Light vector and incoming radiance of one clustered light
+vec3 GetClusterLight(uint index, out vec3 L)
+{
+    int light = int(texelFetch(clusterIndices, int(index)).r);
+    vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+    vec3 color = texelFetch(clusterLights, 2 * light + 1).rgb;
+
+    vec3 toLight = positionRadius.xyz - fragPosition;
+    float distance2 = max(dot(toLight, toLight), 0.0001);
+    L = toLight * inversesqrt(distance2);
+
+    // Windowed inverse square falloff, reaches 0 at the radius so the binning can cut there
+    float ratio2 = distance2 / (positionRadius.w * positionRadius.w);
+    float window = clamp(1.0 - ratio2 * ratio2, 0.0, 1.0);
+
+    return color * (window * window) / (distance2 + 1.0);
+}
+
+// Base layer of one clustered light, the same diffuse, specular and multiscatter terms as the main light in main()
+vec3 PointLightBase(vec3 N, vec3 V, vec3 L, vec3 H, vec3 radiance, float roughness, float metallic)
+{
+    float NdotL = max(dot(N, L), 0.0);
+    float NdotV = max(dot(N, V), 0.0);
+    float LdotH = max(dot(L, H), 0.0);
+
+    // Burley diffuse
+    float FD90 = 0.5 + 2.0 * roughness * (LdotH * LdotH);
+    float viewScatter  = 1.0 + (FD90 - 1.0) * pow(1.0 - NdotV, 5.0);
+    float lightScatter = 1.0 + (FD90 - 1.0) * pow(1.0 - NdotL, 5.0);
+    vec3 diffuse = (objectColor / PI) * radiance * NdotL * viewScatter * lightScatter;
+
+    // Cook-Torrance specular and its multiscatter energy
+    vec3 F = Fresnel(specularF0, V, H);
+    vec3 specular = Distribution(specularAlpha2, N, H) * Geometry(smithAlpha2, N, L, V) * F / max(4.0 * NdotL * NdotV, 0.0001) * NdotL * radiance;
+
+    vec2 dfgV = texture(dfgLut, vec2(NdotV, roughness)).rg;
+    vec2 dfgL = texture(dfgLut, vec2(NdotL, roughness)).rg;
+    specular += ((1.0 - dfgV.r - dfgV.g) * (1.0 - dfgL.r - dfgL.g)) * multiScatterLobe * radiance;
+
+    vec3 kD = (1.0 - F) * (1.0 - metallic);
+
+    return kD * diffuse + specular;
+}
+
+// One clustered light, the base layer under the clearcoat like the main light in main()
+vec3 PointLight(vec3 N, vec3 V, vec3 L, vec3 radiance, float roughness, float metallic)
+{
+    float NdotL = max(dot(N, L), 0.0);
+    if (NdotL <= 0.0) return vec3(0.0);
+
+    vec3 H = normalize(L + V);
+    float NdotV = max(dot(N, V), 0.0);
+
+    float clearcoatFresnel = clearcoatF0 + (1.0 - clearcoatF0) * pow(1.0 - max(dot(V, H), 0.0), 5.0);
+    float clearcoatBRDF = Distribution(clearcoatAlpha2, N, H) * Geometry(clearcoatSmithAlpha2, N, L, V) * clearcoatFresnel / max(4.0 * NdotL * NdotV, 0.0001);
+    vec3 clearcoatSpecular = vec3(clearcoatBRDF) * NdotL * radiance * clearcoatWeightValue;
+
+    // What the coat reflects the base does not see, and the tint absorbs on the way in and out
+    vec3 baseAttenuation = (1.0 - clearcoatFresnel * clearcoatWeightValue) * clearcoatAttenuation;
+
+    return PointLightBase(N, V, L, H, radiance, roughness, metallic) * baseAttenuation + clearcoatSpecular;
+}
+
 void main()
 {
     // NOTE: We will use the Burley Diffuse Model combined with a Cook-Torrance Specular Model
@@ -118,16 +243,14 @@ void main()
     // Get the PBR metalic (F0)
     float metallic = metallicValue;
 
-    // Get the IOR
-    float ior = iorValue;
-
     // Get the alpha value (not used in this shader, but could be for transparency)
     float alpha = alphaValue;
     
-    // ==================== Ambient Term (Simple) ====================
+    // ==================== Ambient Term (SH Irradiance) ====================
     
-    float ambientStrength = 0.1;
-    vec3 ambient = ambientStrength * lightColor * objectColor;
+    // Cosine-weighted irradiance of the sky, evaluated from 9 coefficients with ALU only
+    vec3 irradiance = IrradianceSH(N);
+    vec3 ambient = (irradiance / PI) * objectColor * (1.0 - metallic);
 
     // ==================== Diffuse Term (Burley) ====================
     
@@ -149,9 +272,9 @@ void main()
 
     // ==================== Specular Term (Cook-Torrance) ====================
     
-    float D = Distribution(roughness, N, H);
-    float G = Geometry(roughness, N, L, V);
-    vec3  F = Fresnel(metallic, ior, V, H);
+    float D = Distribution(specularAlpha2, N, H);
+    float G = Geometry(smithAlpha2, N, L, V);
+    vec3  F = Fresnel(specularF0, V, H);
 
     // The Cook-Torrance Fraction
     vec3 numerator = D * G * F;
@@ -161,51 +284,49 @@ void main()
     
     // ==================== Multiscatter Energy Compensation ====================
     
-    float r2 = roughness * roughness;
-        
+    // Baked GGX table (tools/dfg_lut), A + B is the single scatter albedo
+    vec2 dfgV = texture(dfgLut, vec2(NdotV, roughness)).rg;
+    vec2 dfgL = texture(dfgLut, vec2(NdotL, roughness)).rg;
+
     // Directional albedo (Probability of escape from V and L)
-    float EssV = 1.0 - (0.15 * r2) / (1.0 + 2.0 * NdotV * (1.0 - r2));
-    float EssL = 1.0 - (0.15 * r2) / (1.0 + 2.0 * NdotL * (1.0 - r2));
+    float EssV = dfgV.r + dfgV.g;
+    float EssL = dfgL.r + dfgL.g;
 
-    // Hemispherical average albedo (Eavg)
-    // This is a common analytic fit for the average of the Ess LUT
-    float Eavg = 1.0 - 0.15 * (roughness * roughness); 
     float EmsV = 1.0 - EssV;
     float EmsL = 1.0 - EssL;
 
-    // average fresnel (Energy return factor)
-    float reflectivity = pow((1.0 - ior) / (1.0 + ior), 2.0);
-    vec3 F0 = mix(vec3(reflectivity), objectColor, metallic);
-    vec3 Favg = F0 + (vec3(1.0) - F0) / 21.0; 
-
-    // The energy return engine (The "Infinite Bounce" formula)
-    vec3 energyTerm = (Favg * Eavg) / (vec3(1.0) - Favg * (1.0 - Eavg));
-
-    // The multi-scatter Lobe (fms)
-    vec3 f_ms = (vec3(EmsV * EmsL) / (PI * max(1.0 - Eavg, 0.001))) * energyTerm;
+    // The multi-scatter Lobe (fms), the energy return of the average Fresnel and albedo (Eavg)
+    // only depends on the material and comes from the CPU
+    vec3 f_ms = (EmsV * EmsL) * multiScatterLobe;
                
     // Add to existing specular (Direct lighting logic) - No NdotL here
     specular += f_ms * lightColor;
 
+    // ==================== Ambient Specular (Prefiltered IBL) ====================
+
+    // Mirror direction, the prefiltered map already holds the GGX lobe around it
+    vec3 R = reflect(-V, N);
+    vec3 prefiltered = textureLod(prefilterMap, R, roughness * prefilterMaxLod).rgb;
+
+    vec3 ambientSpecular = prefiltered * EnvironmentBRDF(specularF0, roughness, NdotV);
+
     // ==================== Clearcoat ====================
 
     // Clearcoat parameters
     float clearcoatWeight = clearcoatWeightValue;
     float clearcoatRoughness = clearcoatRoughnessValue;
-    float clearcoatIor = clearcoatIorValue;
 
-    // Calculate clearcoat Fresnel (F0 from IOR)
+    // Clearcoat Fresnel F0 comes from the CPU (clearcoatF0)
     // F0 = ((n1 - n2) / (n1 + n2))^2, assuming air (n1=1.0)
     // Not passed through the metallic workflow, always dielectric
-    float clearcoatF0 = pow((1.0 - clearcoatIor) / (1.0 + clearcoatIor), 2.0);
 
     // Clearcoat Fresnel using Schlick approximation
     float VdotH_clearcoat = max(dot(V, H), 0.0);
     float clearcoatFresnel = clearcoatF0 + (1.0 - clearcoatF0) * pow(1.0 - VdotH_clearcoat, 5.0);
 
     // Clearcoat specular BRDF (Cook-Torrance with its own roughness)
-    float D_clearcoat = Distribution(clearcoatRoughness, N, H);
-    float G_clearcoat = Geometry(clearcoatRoughness, N, L, V);
+    float D_clearcoat = Distribution(clearcoatAlpha2, N, H);
+    float G_clearcoat = Geometry(clearcoatSmithAlpha2, N, L, V);
     float F_clearcoat = clearcoatFresnel;
 
     // Clearcoat specular calculation
@@ -213,11 +334,15 @@ void main()
     float clearcoatDenominator = 4.0 * NdotL * NdotV;
     vec3 clearcoatSpecular = vec3(clearcoatNumerator / max(clearcoatDenominator, 0.0001)) * NdotL * lightColor;
 
+    // Clearcoat reflection of the environment, same prefiltered map at the coat roughness
+    vec3 clearcoatPrefiltered = textureLod(prefilterMap, R, clearcoatRoughness * prefilterMaxLod).rgb;
+    clearcoatSpecular += clearcoatPrefiltered * EnvironmentBRDF(vec3(clearcoatF0), clearcoatRoughness, NdotV);
+
     // Apply clearcoat weight
     clearcoatSpecular *= clearcoatWeight;
 
-    // Attenuation: Light passes through tinted clearcoat twice (in and out)
-    vec3 tintAttenuation = clearcoatTint * clearcoatTint;
+    // Attenuation: Light passes through tinted clearcoat twice (in and out), tint^2 from the CPU
+    vec3 tintAttenuation = clearcoatAttenuation;
 
     // Energy conservation: What the clearcoat reflects, the base doesn't see
     float energyLoss = clearcoatFresnel * clearcoatWeight;
@@ -228,6 +353,7 @@ void main()
     // Apply attenuation to base diffuse and specular
     diffuse *= baseAttenuation;
     specular *= baseAttenuation;
+    ambientSpecular *= baseAttenuation;
     ambient *= tintAttenuation; // Ambient also passes through tint twice
 
     // ==================== Combine ====================
@@ -247,15 +373,22 @@ void main()
     vec3 kD = (1.0 - kS) * (1.0 - metallic);    // Diffuse contribution
 
     // Combine with energy conservation
-    vec3 result = ambient + kD * diffuse + specular;
+    vec3 result = ambient + ambientSpecular + kD * diffuse + specular;
 
     // Add clearcoat specular on top (it sits above everything)
     result += clearcoatSpecular;
 
-    // In PBR, we usually need much brighter lights (Intensity > 1.0).
-    // For this demo, let's multiply the final result by an "Exposure" factor 
-    // just to see it clearly on our screen.
-    float exposure = 3.0; 
-    
-    finalColor = vec4(result * exposure, alpha);
+    // ==================== Clustered Point Lights ====================
+
+    // Only the lights binned into this fragment's cluster, no other one reaches it
+    uvec2 cluster = GetClusterRange();
+    for (uint i = cluster.x; i < cluster.x + cluster.y; i++)
+    {
+        vec3 pointL;
+        vec3 radiance = GetClusterLight(i, pointL);
+        result += PointLight(N, V, pointL, radiance, roughness, metallic);
+    }
+
+    // Linear radiance, kept unclamped by the HDR target, the tone map pass exposes it (common/hdr_target.h)
+    finalColor = vec4(result, alpha);
 }
\ No newline at end of file
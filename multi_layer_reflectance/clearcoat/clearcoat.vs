@@ -8,6 +8,7 @@ in vec4 vertexTangent;
 // Uniforms (Global variables sent by Raylib)
 uniform mat4 mvp;       // Projection * View * Model
 uniform mat4 matModel;  // Model Matrix (to get World Space)
+uniform mat4 matNormal; // transpose(inverse(matModel)), computed once per draw by DrawMesh()
 
 // Outputs to the Pixel Shader
 out vec3 fragNormal;
@@ -15,6 +16,9 @@ out vec3 fragPosition;
 out vec3 fragTangent;
 out vec3 fragBitangent;
 
+// The depth pre-pass draws with this shader too, EQUAL depth needs the same position in both programs
+invariant gl_Position;
+
 void main()
 {
     // Calculate the final position of the vertex on the screen
@@ -24,7 +28,7 @@ void main()
     fragPosition = vec3(matModel * vec4(vertexPosition, 1.0));
 
     // Calculate World Space Normal
-    mat3 normalMatrix = transpose(inverse(mat3(matModel)));
+    mat3 normalMatrix = mat3(matNormal);
     fragNormal = normalMatrix * vertexNormal;
 
     // Calculate World Space fragTangents
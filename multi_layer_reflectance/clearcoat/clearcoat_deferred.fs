@@ -0,0 +1,319 @@
+// Lighting pass of the deferred path: the same terms as clearcoat.fs, evaluated once per visible pixel
+// from the G-buffer clearcoat_gbuffer.fs wrote (layout in common/gbuffer.h)
+
+#version 330
+
+// Uniforms (set from clearcoat.c)
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+uniform vec3 viewPos;
+uniform vec3 shIrradiance[9];      // Sky irradiance as order 2 spherical harmonics
+uniform mat4 invViewProj;          // Clip space back to world space, rebuilds the position from the depth
+
+// Material parameters and the constants derived from them on the CPU, one std140 uniform buffer
+// shared with the other material shaders (layout in common/material_block.h, keep the three copies in sync)
+// The per pixel values come from the G-buffer, only the clearcoat tint is read from here
+layout(std140) uniform MaterialBlock
+{
+    vec3 objectColor;
+    float roughnessValue;
+    vec3 sheenTint;
+    float metallicValue;
+    vec3 clearcoatTint;
+    float alphaValue;
+    float anisotropyValue;
+    float iorValue;
+    float sheenWeightValue;
+    float sheenRoughnessValue;
+    float clearcoatWeightValue;
+    float clearcoatRoughnessValue;
+    float clearcoatIorValue;
+
+    vec3 specularF0;                // mix(F0 of iorValue, objectColor, metallicValue)
+    float specularAlpha2;           // max(roughness^2, 0.0001), NDF
+    vec3 averageFresnel;            // Favg = F0 + (1 - F0)/21
+    float smithAlpha2;              // max(roughness, 0.0001)^2, GSF
+    vec3 multiScatterLobe;          // Kulla-Conty lobe over (1 - EssV)*(1 - EssL)
+    float clearcoatF0;
+    vec3 multiScatterApprox;        // (1 - Ess)*Favg of the approximate multiscatter
+    float clearcoatAlpha2;
+    vec3 clearcoatAttenuation;      // clearcoatTint^2, in and out of the coat
+    float clearcoatSmithAlpha2;
+    vec3 sheenColor;                // sheenWeightValue*sheenTint
+    float sheenExponent;            // Charlie NDF = sheenNorm*pow(sin2h, sheenExponent)
+    vec2 anisotropicAlpha;          // GGX alpha along T and B
+    float sheenNorm;
+    float averageAlbedo;            // Eavg at roughnessValue
+};
+
+uniform samplerCube prefilterMap;   // GGX prefiltered cubemap, one roughness per mip level
+uniform float prefilterMaxLod;      // Mip level holding roughness 1.0
+uniform sampler2D dfgLut;           // Baked GGX table over (NdotV, roughness): rg = split-sum scale/bias, b = Eavg
+
+// G-buffer, read texel by texel at gl_FragCoord
+uniform sampler2D gbufferAlbedo;    // color, metallic
+uniform sampler2D gbufferNormal;    // octahedral normal, roughness, clearcoat roughness
+uniform sampler2D gbufferSurface;   // (ior - 1)/2.5, clearcoat weight, (clearcoat ior - 1)/2.5, alpha
+uniform sampler2D gbufferDepth;
+
+// Clustered point lights, binned into a froxel grid on the CPU every frame (layout in common/light_clusters.h,
+// keep the four copies in sync). The main light above stays, these add on top
+uniform samplerBuffer clusterLights;    // 2 texels per light: position, radius / color
+uniform usamplerBuffer clusterGrid;     // Per cluster: first index, light count
+uniform usamplerBuffer clusterIndices;  // Light indices grouped by cluster
+uniform vec4 clusterViewDepth;          // View depth = dot(clusterViewDepth, vec4(position, 1))
+uniform vec4 clusterScale;              // Tiles per pixel (xy), slice = log(depth)*z + w
+uniform vec2 clusterOrigin;             // Lower left pixel of the viewport, 0 on a full target
+
+const ivec3 clusterCount = ivec3(16, 16, 24);  // LIGHT_CLUSTERS_X, _Y, _Z
+
+// Output color to the screen
+out vec4 finalColor;
+
+// Define PI
+const float PI = 3.14159265359;
+
+// Surface of this pixel, what the forward shader reads from its inputs and the material block
+vec3 fragPosition;
+vec3 surfaceColor;
+vec3 surfaceF0;
+float surfaceAlpha2;
+float surfaceSmithAlpha2;
+vec3 surfaceMultiScatterLobe;
+float coatWeight;
+float coatF0;
+float coatAlpha2;
+float coatSmithAlpha2;
+
+// Split-sum environment BRDF (scale and bias applied to F0), one fetch of the baked table
+vec3 EnvironmentBRDF(vec3 F0, float roughness, float NdotV)
+{
+    vec2 AB = texture(dfgLut, vec2(NdotV, roughness)).rg;
+
+    return F0 * AB.x + AB.y;
+}
+
+// D: GGX, alpha2 clamped like the CPU side (max(roughness^2, 0.0001))
+float Distribution(float alpha2, vec3 N, vec3 H)
+{
+    float NdotH = max(dot(N, H), 0.0001);
+    float NdotH2 = NdotH * NdotH;
+    float denomPart = ((alpha2 - 1.0) * NdotH2 + 1.0);
+
+    return alpha2 / (PI * denomPart * denomPart);
+}
+
+// G: height-correlated Smith-GGX, alpha2 clamped like the CPU side (max(roughness, 0.0001)^2)
+float Geometry(float alpha2, vec3 N, vec3 L, vec3 V)
+{
+    float NdotL = max(dot(N, L), 0.0001);
+    float NdotV = max(dot(N, V), 0.0001);
+
+    float NdotV2 = NdotV * NdotV;
+    float lambdaV = (-1.0 + sqrt(1.0 + alpha2 * (1.0 - NdotV2) / NdotV2)) * 0.5;
+
+    float NdotL2 = NdotL * NdotL;
+    float lambdaL = (-1.0 + sqrt(1.0 + alpha2 * (1.0 - NdotL2) / NdotL2)) * 0.5;
+
+    return (NdotV * NdotL) / (1.0 + lambdaV + lambdaL);
+}
+
+// F: Schlick
+vec3 Fresnel(vec3 F0, vec3 V, vec3 H)
+{
+    float VdotH = max(dot(V, H), 0.0);
+
+    return F0 + (1.0 - F0) * pow(clamp(1.0 - VdotH, 0.0, 1.0), 5.0);
+}
+
+// Irradiance from the 9 SH coefficients (basis constants and cosine lobe already folded in)
+vec3 IrradianceSH(vec3 n)
+{
+    return shIrradiance[0]
+         + shIrradiance[1] * n.y + shIrradiance[2] * n.z + shIrradiance[3] * n.x
+         + shIrradiance[4] * (n.x * n.y) + shIrradiance[5] * (n.y * n.z)
+         + shIrradiance[6] * (3.0 * n.z * n.z - 1.0)
+         + shIrradiance[7] * (n.x * n.z) + shIrradiance[8] * (n.x * n.x - n.y * n.y);
+}
+
+// Inverse of EncodeOctahedral() in clearcoat_gbuffer.fs
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+
+    return normalize(n);
+}
+
+// F0 = ((n1 - n2)/(n1 + n2))^2 against air
+float GetDielectricF0(float ior)
+{
+    float r = (1.0 - ior) / (1.0 + ior);
+
+    return r * r;
+}
+
+// First index and light count of the fragment's cluster
+uvec2 GetClusterRange()
+{
+    float depth = max(dot(clusterViewDepth, vec4(fragPosition, 1.0)), 0.0001);
+    ivec2 tile = min(ivec2((gl_FragCoord.xy - clusterOrigin) * clusterScale.xy), clusterCount.xy - 1);
+    int slice = clamp(int(floor(log(depth) * clusterScale.z + clusterScale.w)), 0, clusterCount.z - 1);
+
+    return texelFetch(clusterGrid, (slice * clusterCount.y + tile.y) * clusterCount.x + tile.x).rg;
+}
+
+// Light vector and incoming radiance of one clustered light
+vec3 GetClusterLight(uint index, out vec3 L)
+{
+    int light = int(texelFetch(clusterIndices, int(index)).r);
+    vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+    vec3 color = texelFetch(clusterLights, 2 * light + 1).rgb;
+
+    vec3 toLight = positionRadius.xyz - fragPosition;
+    float distance2 = max(dot(toLight, toLight), 0.0001);
+    L = toLight * inversesqrt(distance2);
+
+    // Windowed inverse square falloff, reaches 0 at the radius so the binning can cut there
+    float ratio2 = distance2 / (positionRadius.w * positionRadius.w);
+    float window = clamp(1.0 - ratio2 * ratio2, 0.0, 1.0);
+
+    return color * (window * window) / (distance2 + 1.0);
+}
+
+// Base layer of one light: Burley diffuse, Cook-Torrance specular and its multiscatter energy
+vec3 PointLightBase(vec3 N, vec3 V, vec3 L, vec3 H, vec3 radiance, float roughness, float metallic)
+{
+    float NdotL = max(dot(N, L), 0.0);
+    float NdotV = max(dot(N, V), 0.0);
+    float LdotH = max(dot(L, H), 0.0);
+
+    float FD90 = 0.5 + 2.0 * roughness * (LdotH * LdotH);
+    float viewScatter  = 1.0 + (FD90 - 1.0) * pow(1.0 - NdotV, 5.0);
+    float lightScatter = 1.0 + (FD90 - 1.0) * pow(1.0 - NdotL, 5.0);
+    vec3 diffuse = (surfaceColor / PI) * radiance * NdotL * viewScatter * lightScatter;
+
+    vec3 F = Fresnel(surfaceF0, V, H);
+    vec3 specular = Distribution(surfaceAlpha2, N, H) * Geometry(surfaceSmithAlpha2, N, L, V) * F / max(4.0 * NdotL * NdotV, 0.0001) * NdotL * radiance;
+
+    vec2 dfgV = texture(dfgLut, vec2(NdotV, roughness)).rg;
+    vec2 dfgL = texture(dfgLut, vec2(NdotL, roughness)).rg;
+    specular += ((1.0 - dfgV.r - dfgV.g) * (1.0 - dfgL.r - dfgL.g)) * surfaceMultiScatterLobe * radiance;
+
+    vec3 kD = (1.0 - F) * (1.0 - metallic);
+
+    return kD * diffuse + specular;
+}
+
+// One light, the base layer under the clearcoat
+vec3 LayeredLight(vec3 N, vec3 V, vec3 L, vec3 radiance, float roughness, float metallic)
+{
+    float NdotL = max(dot(N, L), 0.0);
+    vec3 H = normalize(L + V);
+    float NdotV = max(dot(N, V), 0.0);
+
+    float clearcoatFresnel = coatF0 + (1.0 - coatF0) * pow(1.0 - max(dot(V, H), 0.0), 5.0);
+    float clearcoatBRDF = Distribution(coatAlpha2, N, H) * Geometry(coatSmithAlpha2, N, L, V) * clearcoatFresnel / max(4.0 * NdotL * NdotV, 0.0001);
+    vec3 clearcoatSpecular = vec3(clearcoatBRDF) * NdotL * radiance * coatWeight;
+
+    // What the coat reflects the base does not see, and the tint absorbs on the way in and out
+    vec3 baseAttenuation = (1.0 - clearcoatFresnel * coatWeight) * clearcoatAttenuation;
+
+    return PointLightBase(N, V, L, H, radiance, roughness, metallic) * baseAttenuation + clearcoatSpecular;
+}
+
+// One clustered light, skipped from behind like in clearcoat.fs. The main light keeps its multiscatter
+// term there even from behind, it calls LayeredLight() directly
+vec3 PointLight(vec3 N, vec3 V, vec3 L, vec3 radiance, float roughness, float metallic)
+{
+    if (dot(N, L) <= 0.0) return vec3(0.0);
+
+    return LayeredLight(N, V, L, radiance, roughness, metallic);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    // Nothing was drawn here, the skybox under the quad stays
+    float depth = texelFetch(gbufferDepth, pixel, 0).r;
+    if (depth >= 1.0) discard;
+
+    vec4 albedo = texelFetch(gbufferAlbedo, pixel, 0);
+    vec4 normal = texelFetch(gbufferNormal, pixel, 0);
+    vec4 surface = texelFetch(gbufferSurface, pixel, 0);
+
+    // World position from the depth
+    vec2 uv = (gl_FragCoord.xy) / vec2(textureSize(gbufferDepth, 0));
+    vec4 position = invViewProj * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    fragPosition = position.xyz / position.w;
+
+    // ==================== Surface ====================
+
+    surfaceColor = albedo.rgb;
+    float metallic = albedo.a;
+    float roughness = normal.z;
+    float ior = surface.x * 2.5 + 1.0;
+    float alpha = surface.w;
+
+    // The constants the forward path gets from the material block, derived per pixel the way
+    // GetMaterialDerived() does (common/material_block.h)
+    surfaceF0 = mix(vec3(GetDielectricF0(ior)), surfaceColor, metallic);
+    surfaceAlpha2 = max(roughness * roughness, 0.0001);
+    surfaceSmithAlpha2 = max(roughness, 0.0001) * max(roughness, 0.0001);
+
+    // Kulla-Conty energy return, Eavg is constant along each row of the table
+    vec3 Favg = surfaceF0 + (1.0 - surfaceF0) / 21.0;
+    float Eavg = texture(dfgLut, vec2(0.5, roughness)).b;
+    surfaceMultiScatterLobe = (Favg * Eavg) / (1.0 - Favg * (1.0 - Eavg)) / (PI * max(1.0 - Eavg, 0.001));
+
+    coatWeight = surface.y;
+    float clearcoatRoughness = normal.w;
+    coatF0 = GetDielectricF0(surface.z * 2.5 + 1.0);
+    coatAlpha2 = max(clearcoatRoughness * clearcoatRoughness, 0.0001);
+    coatSmithAlpha2 = max(clearcoatRoughness, 0.0001) * max(clearcoatRoughness, 0.0001);
+
+    // Setup Vectors
+    vec3 N = DecodeOctahedral(normal.xy);
+    vec3 V = normalize(viewPos - fragPosition);
+    float NdotV = max(dot(N, V), 0.0);
+
+    // ==================== Ambient ====================
+
+    // SH irradiance for the diffuse, prefiltered environment for both specular layers
+    vec3 ambient = (IrradianceSH(N) / PI) * surfaceColor * (1.0 - metallic);
+
+    vec3 R = reflect(-V, N);
+    vec3 prefiltered = textureLod(prefilterMap, R, roughness * prefilterMaxLod).rgb;
+    vec3 ambientSpecular = prefiltered * EnvironmentBRDF(surfaceF0, roughness, NdotV);
+
+    vec3 clearcoatPrefiltered = textureLod(prefilterMap, R, clearcoatRoughness * prefilterMaxLod).rgb;
+    vec3 clearcoatAmbient = clearcoatPrefiltered * EnvironmentBRDF(vec3(coatF0), clearcoatRoughness, NdotV) * coatWeight;
+
+    // The forward shader attenuates the ambient specular with the main light's coat Fresnel,
+    // the same half vector is used here so both paths match
+    vec3 mainL = normalize(lightPos - fragPosition);
+    vec3 mainH = normalize(mainL + V);
+    float mainFresnel = coatF0 + (1.0 - coatF0) * pow(1.0 - max(dot(V, mainH), 0.0), 5.0);
+
+    vec3 result = ambient * clearcoatAttenuation + ambientSpecular * (1.0 - mainFresnel * coatWeight) * clearcoatAttenuation + clearcoatAmbient;
+
+    // ==================== Main Light ====================
+
+    result += LayeredLight(N, V, mainL, lightColor, roughness, metallic);
+
+    // ==================== Clustered Point Lights ====================
+
+    // Only the lights binned into this pixel's cluster, no other one reaches it
+    uvec2 cluster = GetClusterRange();
+    for (uint i = cluster.x; i < cluster.x + cluster.y; i++)
+    {
+        vec3 pointL;
+        vec3 radiance = GetClusterLight(i, pointL);
+        result += PointLight(N, V, pointL, radiance, roughness, metallic);
+    }
+
+    // Linear radiance, kept unclamped by the HDR target, the tone map pass exposes it (common/hdr_target.h)
+    finalColor = vec4(result, alpha);
+}
@@ -0,0 +1,11 @@
+#version 330
+
+// Full screen quad of the deferred lighting pass, rlLoadDrawQuad() sends it in clip space
+
+// Input attributes of the quad
+in vec3 vertexPosition;
+
+void main()
+{
+    gl_Position = vec4(vertexPosition, 1.0);
+}
@@ -0,0 +1,68 @@
+#version 330
+
+// Geometry pass of the deferred path, clearcoat.vs feeds it. Only the surface goes out, the lighting
+// happens once per pixel in clearcoat_deferred.fs (G-buffer layout in common/gbuffer.h)
+
+// Inputs from the Vertex Shader
+in vec3 fragNormal;
+in vec3 fragPosition;
+in vec3 fragTangent;
+in vec3 fragBitangent;
+
+// Material parameters and the constants derived from them on the CPU, one std140 uniform buffer
+// shared with the other material shaders (layout in common/material_block.h, keep the three copies in sync)
+layout(std140) uniform MaterialBlock
+{
+    vec3 objectColor;
+    float roughnessValue;
+    vec3 sheenTint;
+    float metallicValue;
+    vec3 clearcoatTint;
+    float alphaValue;
+    float anisotropyValue;
+    float iorValue;
+    float sheenWeightValue;
+    float sheenRoughnessValue;
+    float clearcoatWeightValue;
+    float clearcoatRoughnessValue;
+    float clearcoatIorValue;
+
+    vec3 specularF0;                // mix(F0 of iorValue, objectColor, metallicValue)
+    float specularAlpha2;           // max(roughness^2, 0.0001), NDF
+    vec3 averageFresnel;            // Favg = F0 + (1 - F0)/21
+    float smithAlpha2;              // max(roughness, 0.0001)^2, GSF
+    vec3 multiScatterLobe;          // Kulla-Conty lobe over (1 - EssV)*(1 - EssL)
+    float clearcoatF0;
+    vec3 multiScatterApprox;        // (1 - Ess)*Favg of the approximate multiscatter
+    float clearcoatAlpha2;
+    vec3 clearcoatAttenuation;      // clearcoatTint^2, in and out of the coat
+    float clearcoatSmithAlpha2;
+    vec3 sheenColor;                // sheenWeightValue*sheenTint
+    float sheenExponent;            // Charlie NDF = sheenNorm*pow(sin2h, sheenExponent)
+    vec2 anisotropicAlpha;          // GGX alpha along T and B
+    float sheenNorm;
+    float averageAlbedo;            // Eavg at roughnessValue
+};
+
+// G-buffer attachments
+layout(location = 0) out vec4 gbufferAlbedo;    // color, metallic
+layout(location = 1) out vec4 gbufferNormal;    // octahedral normal, roughness, clearcoat roughness
+layout(location = 2) out vec4 gbufferSurface;   // (ior - 1)/2.5, clearcoat weight, (clearcoat ior - 1)/2.5, alpha
+
+// Unit vector to the [-1, 1] square, the lower half folded over the diagonals
+vec2 EncodeOctahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+
+    return (n.z >= 0.0) ? n.xy : folded;
+}
+
+void main()
+{
+    vec3 N = normalize(fragNormal);
+
+    gbufferAlbedo = vec4(objectColor, metallicValue);
+    gbufferNormal = vec4(EncodeOctahedral(N), roughnessValue, clearcoatRoughnessValue);
+    gbufferSurface = vec4((iorValue - 1.0) / 2.5, clearcoatWeightValue, (clearcoatIorValue - 1.0) / 2.5, alphaValue);
+}
@@ -4,14 +4,52 @@
 -> Press middle mouse button to move the camera
 -> Use mouse wheel to zoom in and out
 -> Press left mouse button to interact with the GUI
+-> Press C to switch between the GPU and the CPU rasterizer, --cpu starts on the CPU (see common/soft_raster.h)
+-> The GPU path is the shading lab's technique (see shading_lab/polygon_shading_methods.h), the CPU rasterizer gets its
+   mesh, light and color
+-> The scene renders into a float target, one pass applies the exposure and the tone map curve to all of it
+   (see common/hdr_target.h): --exposure X, --tonemap clamp|reinhard|aces, --hdr-format rgba16f|r11g11b10f,
+   --ldr draws straight to the frame
+-> Press T to toggle the pass timings overlay (CPU and GPU p50/p95/p99 of every pass), --timings file.csv writes
+   the timings of every frame on exit (see common/pass_timer.h)
+-> Run with --headless [--frames N] [--size WxH] [--output file.png] to render offscreen (see common/headless.h)
+-> Run with --bench [--warmup N] [--frames M] [--bench-output file.jsonl] for an uncapped timed run on a fixed camera
+   orbit, printed as a JSON line of frame rate and frame time percentiles (see common/headless.h)
 */
 
+#define RAYGUI_IMPLEMENTATION
+#define ENV_ASSETS_IMPLEMENTATION
+#define ENV_DFG_IMPLEMENTATION
+#define HEADLESS_IMPLEMENTATION
+#define SHADER_CACHE_IMPLEMENTATION
+#define MATERIAL_BLOCK_IMPLEMENTATION
+#define LIGHT_CLUSTERS_IMPLEMENTATION
+#define SOFT_RASTER_IMPLEMENTATION
+#define HDR_TARGET_IMPLEMENTATION
+#define PASS_TIMER_IMPLEMENTATION
+#define TECHNIQUE_IMPLEMENTATION
+#define POLYGON_SHADING_METHODS_IMPLEMENTATION
+
 #include <stdio.h>
+#include <string.h>
 #include "raylib.h"
 #include "raymath.h"
 #include "rlgl.h"
-
-int main()
+#include "../../common/env_assets.h"
+#include "../../common/headless.h"
+#include "../../common/shader_cache.h"
+#include "../../common/soft_raster.h"
+#include "../../common/hdr_target.h"
+#include "../../common/pass_timer.h"
+#include "../../shading_lab/polygon_shading_methods.h"
+
+// Passes timed every frame
+#define PASS_SKY       0
+#define PASS_MODEL     1
+#define PASS_TONEMAP   2
+#define PASS_GUI       3
+
+int main(int argc, char *argv[])
 {
     // Set window dimensions
     const int screenWidth = 800;
@@ -20,8 +58,11 @@ int main()
     // Resizable window
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
 
+    // Read the headless options, --headless renders offscreen into a hidden window
+    HeadlessRun headless = ParseHeadlessArgs(argc, argv, screenWidth, screenHeight);
+
     // Initialize the window
-    InitWindow(screenWidth, screenHeight, "Shading Lab");
+    InitHeadlessWindow(&headless, "Shading Lab");
 
     // Define the camera
     Camera camera = { 0 };
@@ -36,65 +77,83 @@ int main()
     float pitch = 0.5f;
     float radius = 2.5f;
 
-    // Load the panoramic environment map
-    Image img = LoadImage("resources/sky1_2k.jpg");
-    Texture2D panorama = LoadTextureFromImage(img);
-    UnloadImage(img);
+    // Start loading the sky as a cubemap for the skybox on a worker thread, a grey placeholder is
+    // bound until the levels stream in. Converted on the first run, mapped back from the cache next
+    // to the panorama afterwards, the cold and warm start times are logged
+    // Headless and bench runs load it in full before the first frame, so every run renders the same sky
+    EnvAssets sky = ((headless.enabled || headless.bench)? LoadEnvAssets : LoadEnvAssetsAsync)("resources/sky1_2k.jpg", ENV_ASSET_SKYBOX);
 
     // Create skybox cube mesh
     Mesh cube = GenMeshCube(100.0f, 100.0f, 100.0f);
     Model skybox = LoadModelFromMesh(cube);
 
-    // Load skybox shader and set panorama texture
-    skybox.materials[0].shader = LoadShader("resources/skybox.vs", "resources/skybox.fs");
-    
-    // The shader converts the panorama to a skybox view
-    skybox.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = panorama;
-    
-    // Generate a torus mesh
-    Mesh mesh = GenMeshTorus(0.4f, 1.0f, 24, 48);
-    Model torus = LoadModelFromMesh(mesh);
+    // Load skybox shader and set the cubemap
+    skybox.materials[0].shader = LoadShaderCached("resources/skybox.vs", "resources/skybox.fs");
 
-    // Change the torus orientation
-    torus.transform = MatrixRotateX(DEG2RAD * 90.0f);
+    // Raylib binds MATERIAL_MAP_CUBEMAP as a cube texture, the shader samples it with the view direction
+    skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = sky.skybox;
+    skybox.materials[0].shader.locs[SHADER_LOC_MAP_CUBEMAP] = GetShaderLocation(skybox.materials[0].shader, "environmentMap");
+    
+    // The lab's technique: program, static uniforms and the object color on the coarse torus
+    const Technique *technique = &shadingFlatTechnique;
+    TechniqueAssets assets = LoadTechniqueAssets(&sky);
+    BasicState *basic = (BasicState *)technique->Init(technique, &assets);
+    int envPending = technique->envAssets;
 
-    // Load and assign the shaders
-    Shader shader = LoadShader("polygon_shading_methods/flat_shading/shading_flat.vs", "polygon_shading_methods/flat_shading/shading_flat.fs");
-    torus.materials[0].shader = shader;
+    // The scene goes to a float target the size of the frame, one pass exposes and tone maps all of it. These
+    // shaders never scaled their output, the technique keeps the exposure at 1
+    HdrTarget hdr = LoadHdrTarget(headless.enabled? headless.width : GetRenderWidth(), headless.enabled? headless.height : GetRenderHeight(),
+        ParseHdrArgs(argc, argv, technique->exposure));
 
-    // Assign the uniforms
-    int lightPosLoc    = GetShaderLocation(shader, "lightPos");
-    int lightColorLoc  = GetShaderLocation(shader, "lightColor");
-    int objectColorLoc = GetShaderLocation(shader, "objectColor");
-    
-    int envLoc = GetShaderLocation(skybox.materials[0].shader, "environmentMap");
+    // Time the passes of every frame, T shows the overlay (off in headless and bench runs) and
+    // --timings FILE.csv keeps every sample
+    const char *passNames[] = { "Sky", "Model", "Tonemap", "GUI" };
+    PassTimer timer = LoadPassTimer(passNames, 4);
+    timer.output = ParsePassTimerArgs(argc, argv);
+    bool showTimings = !headless.enabled && !headless.bench;
 
-    // Set static uniform values
-    Vector3 lightPos = { 5.0f, 5.0f, 5.0f };
-    Vector3 lightColor = { 1.0f, 1.0f, 1.0f };
-    Vector3 objectColor = { 0.5f, 0.0f, 0.0f };
+    // Lock the frames rate, headless and bench runs are not capped
+    if (!headless.enabled && !headless.bench) SetTargetFPS(60);
 
-    // Update shader uniform values
-    
-    SetShaderValue(shader, lightPosLoc, &lightPos, SHADER_UNIFORM_VEC3);                // Light position
-    SetShaderValue(shader, lightColorLoc, &lightColor, SHADER_UNIFORM_VEC3);            // Light color
-    SetShaderValue(shader, objectColorLoc, &objectColor, SHADER_UNIFORM_VEC3);          // Object color
-    
-    // Passing the environment map to the skybox shader
-    SetShaderValueTexture(skybox.materials[0].shader, envLoc, panorama);
+    // CPU rasterizer for the same scene and uniforms, created at the render size on first use
+    bool useCpu = false;
+    for (int i = 1; i < argc; i++) if (strcmp(argv[i], "--cpu") == 0) useCpu = true;
 
-    // Lock the frames rate
-    SetTargetFPS(60);
+    SoftRaster raster = { 0 };
 
     // Main render loop
-    while (!WindowShouldClose())
+    while (!HeadlessShouldClose(&headless))
     {
+        // Collect the pass times of the frame the GPU finished
+        UpdatePassTimer(&timer);
+        if (IsKeyPressed(KEY_T)) showTimings = !showTimings;
+
+        // Upload the environment levels the loader thread finished since the last frame, the technique sends
+        // them on its update
+        envPending |= UpdateEnvAssets(&sky);
+
         // Fullscreen borderless
         if (IsKeyPressed(KEY_F11))
         {
             ToggleBorderlessWindowed();
         }
 
+        // Switch between the GPU and the CPU rasterizer
+        if (IsKeyPressed(KEY_C)) useCpu = !useCpu;
+
+        // Keep the CPU target at the render size
+        if (useCpu)
+        {
+            int width = headless.enabled? headless.width : GetScreenWidth();
+            int height = headless.enabled? headless.height : GetScreenHeight();
+
+            if ((raster.width != width) || (raster.height != height))
+            {
+                UnloadSoftRaster(&raster);
+                raster = LoadSoftRaster(width, height);
+            }
+        }
+
         // Camera orbit controls
         if (IsMouseButtonDown(MOUSE_MIDDLE_BUTTON))
         {
@@ -112,6 +171,9 @@ int main()
         radius -= wheel * 0.2f;
         radius = Clamp(radius, 1.0f, 10.0f);
 
+        // Bench runs follow a fixed orbit instead
+        UpdateHeadlessOrbit(&headless, &yaw, &pitch);
+
         // Spherical to cartesian
         camera.position.x = radius * cosf(pitch) * sinf(yaw);
         camera.position.y = radius * sinf(pitch);
@@ -122,45 +184,100 @@ int main()
         // Rotate the torus over time
         static float angle = 0.0f;
         angle += 0.01f;
-        torus.transform = MatrixMultiply(
-            MatrixRotateZ(angle),
-            MatrixRotateX(DEG2RAD * 90.0f)
-        );
+
+        TechniqueFrame frame = { 0 };
+        frame.camera = camera;
+        frame.transform = MatrixMultiply(MatrixRotateZ(angle), MatrixRotateX(DEG2RAD * 90.0f));
+        frame.width = headless.enabled? headless.width : GetRenderWidth();
+        frame.height = headless.enabled? headless.height : GetRenderHeight();
+        frame.envChanged = envPending;
+        frame.run = &headless;
+        envPending = 0;
+
+        // Camera position to the uniforms, the CPU rasterizer gets the same ones
+        technique->Update(basic, &frame);
+        SoftLight softLight = { TECHNIQUE_LIGHT_POS, TECHNIQUE_LIGHT_COLOR, basic->desc->objectColor, camera.position };
 
         // Start rendering a new frame
-        BeginDrawing();
+        BeginHeadlessDrawing(&headless);
+
+        // Draw the scene into the float target, the background included
+        BeginHdrMode(&hdr);
 
         // Clear the screen with an off-white background
         ClearBackground((Color){200, 200, 200, 255});
 
-        // Switch to 3D rendering using the given camera
-        BeginMode3D(camera);
+        if (useCpu)
+        {
+            // Torus only, the skybox stays a GPU feature
+            BeginPassTimer(&timer, PASS_MODEL);
+            ClearSoftRaster(&raster, (Color){200, 200, 200, 255});
+            DrawSoftMesh(&raster, basic->mesh, frame.transform, camera, SOFT_SHADING_FLAT, softLight);
+            DrawSoftRaster(&raster, 0, 0);
+            EndPassTimer(&timer);
+        }
+        else
+        {
+            // Switch to 3D rendering using the given camera
+            BeginMode3D(camera);
+
+            // Draw skybox (disable depth writing so it's always in background)
+            BeginPassTimer(&timer, PASS_SKY);
+            rlDisableBackfaceCulling();
+            rlDisableDepthMask();
+            DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
+            rlEnableBackfaceCulling();
+            rlEnableDepthMask();
+            EndPassTimer(&timer);
+
+            // Draw the torus with the technique's program and color
+            BeginPassTimer(&timer, PASS_MODEL);
+            technique->Draw(basic, &frame);
+            EndPassTimer(&timer);
+
+            // Exit 3D mode and return to 2D rendering
+            EndMode3D();
+        }
+
+        // Back to the frame, the scene exposed and tone mapped into it
+        EndHdrMode(&hdr);
 
-        // Draw skybox (disable depth writing so it's always in background)
-        rlDisableBackfaceCulling();
-        rlDisableDepthMask();
-        DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
-        rlEnableBackfaceCulling();
-        rlEnableDepthMask();
+        BeginPassTimer(&timer, PASS_TONEMAP);
+        DrawHdrToneMap(&hdr);
+        EndPassTimer(&timer);
 
-        // Draw the torus model at given position, scale and color
-        DrawModel(torus, (Vector3){0,0,0}, 1.0f, (Color){objectColor.x * 255, objectColor.y * 255, objectColor.z * 255, 255});
+        // GUI laid out on the frame width, which --size or a window resize can change
+        const int guiWidth = GetHeadlessScreenWidth(&headless);
 
-        // Exit 3D mode and return to 2D rendering
-        EndMode3D();
+        // Text and GUI
+        BeginPassTimer(&timer, PASS_GUI);
 
         // Add information text
-        DrawText("Flat Shading", 10, 10, 20, BLACK);
+        DrawText(technique->title, 10, 10, 20, BLACK);
+
+        // CPU timings, vertex stage vs setup and pixels
+        if (useCpu) DrawText(TextFormat("CPU %s: vertex %.2f ms, setup %.2f ms, raster %.2f ms", SOFT_RASTER_BACKEND,
+            raster.stats.vertexTime*1000.0, raster.stats.setupTime*1000.0, raster.stats.rasterTime*1000.0), 10, 40, 20, BLACK);
+
+        EndPassTimer(&timer);
+
+        // Percentiles of the pass times over the last frames
+        if (showTimings) DrawPassTimer(&timer, guiWidth - 330, 70);
 
         // Finish the frame and present it on screen
-        EndDrawing();
+        EndHeadlessDrawing(&headless);
     }
 
     // Cleanup
-    UnloadTexture(panorama);
+    technique->Unload(basic);
+    UnloadEnvAssets(sky);
+    UnloadTechniqueAssets(&assets);
+    skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = (Texture2D){ 0 };    // The sky's, UnloadEnvAssets() deleted it
     UnloadModel(skybox);
-    UnloadModel(torus);
-    UnloadShader(shader);
+    UnloadSoftRaster(&raster);
+    UnloadHdrTarget(hdr);
+    UnloadPassTimer(&timer);
+    UnloadHeadlessRun(&headless);
     CloseWindow();
 
     return 0;
@@ -7,6 +7,7 @@ in vec3 vertexNormal;
 // Uniforms (Global variables sent by Raylib)
 uniform mat4 mvp;       // Model-View-Projection Matrix
 uniform mat4 matModel;  // Model Matrix
+uniform mat4 matNormal; // transpose(inverse(matModel)), computed once per draw by DrawMesh()
 
 // Outputs to the Pixel Shader
 // "flat" tells the GPU not to interpolate this value!
@@ -27,6 +28,6 @@ void main()
     the "Provoking Vertex" (the first one) and give it to every
     pixel in the triangle.
     */
-    mat3 normalMatrix = transpose(inverse(mat3(matModel)));
+    mat3 normalMatrix = mat3(matNormal);
     fragNormal = normalMatrix * vertexNormal;
 }
\ No newline at end of file
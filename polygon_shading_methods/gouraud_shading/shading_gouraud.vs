@@ -7,6 +7,7 @@ in vec3 vertexNormal;
 // Uniforms (Global variables sent by Raylib)
 uniform mat4 mvp;       // Model-View-Projection Matrix
 uniform mat4 matModel;  // Model Matrix
+uniform mat4 matNormal; // transpose(inverse(matModel)), computed once per draw by DrawMesh()
 
 // Uniforms (set from gouraud.c)
 uniform vec3 lightPos;
@@ -28,7 +29,7 @@ void main()
     vec3 fragPosition = vec3(matModel * vec4(vertexPosition, 1.0));
     
     // Calculate vectors (At the vertex!)
-    mat3 normalMatrix = transpose(inverse(mat3(matModel)));
+    mat3 normalMatrix = mat3(matNormal);
     vec3 N = normalize(normalMatrix * vertexNormal);                    // Normal
     vec3 L = normalize(lightPos - fragPosition);                        // Light Dir
     vec3 V = normalize(viewPos - fragPosition);                         // View Dir
@@ -7,6 +7,7 @@ in vec3 vertexNormal;
 // Uniforms (Global variables sent by Raylib)
 uniform mat4 mvp;       // Projection * View * Model
 uniform mat4 matModel;  // Model Matrix (to get World Space)
+uniform mat4 matNormal; // transpose(inverse(matModel)), computed once per draw by DrawMesh()
 
 // Outputs to the Pixel Shader
 out vec3 fragNormal;
@@ -25,6 +26,6 @@ void main()
     We just pass this to the fragment shader. 
     The GPU will blend this vector across the triangle.
     */
-    mat3 normalMatrix = transpose(inverse(mat3(matModel)));
+    mat3 normalMatrix = mat3(matNormal);
     fragNormal = normalMatrix * vertexNormal;
 }
\ No newline at end of file
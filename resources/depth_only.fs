@@ -0,0 +1,8 @@
+#version 330
+
+// Depth pre-pass: the vertex shader of the shading program writes the depth, no color goes out
+// (see common/depth_prepass.h)
+
+void main()
+{
+}
@@ -0,0 +1,46 @@
+#version 330
+
+// Exposure and tone mapping of the HDR scene target, once per pixel for every material
+// (see common/hdr_target.h)
+
+// Uniforms
+uniform sampler2D hdrColor;     // Linear radiance, the size of the current target
+uniform sampler2D hdrDepth;     // Depth of the scene, 1.0 where only the sky or the background was drawn
+uniform float exposure;
+uniform int toneMapper;         // HDR_TONEMAP_*: 0 clamp, 1 Reinhard, 2 ACES
+
+// Output color to the screen
+out vec4 finalColor;
+
+// Narkowicz's fit of the ACES filmic curve
+vec3 ACESFilm(vec3 x)
+{
+    float a = 2.51;
+    float b = 0.03;
+    float c = 2.43;
+    float d = 0.59;
+    float e = 0.14;
+    return clamp((x*(a*x+b))/(x*(c*x+d)+e), 0.0, 1.0);
+}
+
+void main()
+{
+    // Same size as the target, one texel per pixel without filtering
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec3 color = texelFetch(hdrColor, texel, 0).rgb;
+
+    // The sky and the background are shown as drawn, exposure 1 and no curve
+    if (texelFetch(hdrDepth, texel, 0).r == 1.0)
+    {
+        finalColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+        return;
+    }
+
+    color *= exposure;
+
+    // The branch is uniform over the quad, every pixel takes the same path
+    if (toneMapper == 1) color = color / (color + vec3(1.0));
+    else if (toneMapper == 2) color = ACESFilm(color);
+
+    finalColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
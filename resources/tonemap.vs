@@ -0,0 +1,11 @@
+#version 330
+
+// Full screen quad of the tone map pass, rlLoadDrawQuad() sends it in clip space (see common/hdr_target.h)
+
+// Input attributes of the quad
+in vec3 vertexPosition;
+
+void main()
+{
+    gl_Position = vec4(vertexPosition, 1.0);
+}
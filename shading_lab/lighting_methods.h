@@ -0,0 +1,354 @@
+/**********************************************************************************************
+*
+*   lighting_methods - The lighting_methods demos as shading lab techniques
+*
+*   Define LIGHTING_METHODS_IMPLEMENTATION in exactly one translation unit before including it
+*
+*   Every demo but Oren-Nayar and Cook-Torrance is a BasicTechnique (see technique.h). Oren-
+*   Nayar extends it to send A and B of the roughness instead of the roughness. Cook-Torrance
+*   keeps its program variants, dropdowns and material block. Its demo draws the material
+*   grid and the depth pre-pass with the state below, the others are technique_demo.h hosting
+*   their technique. The IBL demo keeps its own sky (sky2), the lab uses sky1
+*
+**********************************************************************************************/
+
+#ifndef LIGHTING_METHODS_H
+#define LIGHTING_METHODS_H
+
+#include "technique.h"
+#include "../common/shader_variants.h"
+
+// Cook-Torrance state, D/G/F, multiscatter and conductor selections compiled in as defines
+typedef struct CookTorranceState {
+    const EnvAssets *sky;
+    ShaderVariants variants;
+    Shader shader;                  // Current variant
+    Material material;
+    Mesh mesh;
+    MaterialBlock block;
+    bool instanced;                 // INSTANCED programs, for the material grid of the demo
+
+    int viewPosLoc;
+    int shIrradianceLoc;
+
+    int ndfActive;
+    bool ndfEditMode;
+    int gsfActive;
+    bool gsfEditMode;
+    int fresnelActive;
+    bool fresnelEditMode;
+    int multiScatterActive;
+    bool multiScatterEditMode;
+    int conductorPresetActive;
+    bool conductorPresetEditMode;
+} CookTorranceState;
+
+extern const Technique ambientSimpleTechnique;
+extern const Technique ambientIblTechnique;
+extern const Technique diffuseLambertTechnique;
+extern const Technique diffuseOrenNayarTechnique;
+extern const Technique diffuseBurleyTechnique;
+extern const Technique diffuseAshikhminShirleyTechnique;
+extern const Technique specularPhongTechnique;
+extern const Technique specularBlinnPhongTechnique;
+extern const Technique specularAshikhminShirleyTechnique;
+extern const Technique specularCookTorranceTechnique;
+
+#endif // LIGHTING_METHODS_H
+
+#if defined(LIGHTING_METHODS_IMPLEMENTATION) && !defined(LIGHTING_METHODS_IMPLEMENTED)
+#define LIGHTING_METHODS_IMPLEMENTED
+
+#include "raymath.h"
+#include "raygui.h"
+#include "../common/env_dfg.h"
+
+#define BASIC_LIGHT     (BASIC_LIGHT_POS | BASIC_LIGHT_COLOR | BASIC_OBJECT_COLOR | BASIC_VIEW_POS)
+
+//----------------------------------------------------------------------------------
+// Basic techniques
+//----------------------------------------------------------------------------------
+static const BasicTechnique ambientSimple = {
+    "lighting_methods/ambient_lighting_simple/ambient_simple.vs", "lighting_methods/ambient_lighting_simple/ambient_simple.fs",
+    BASIC_LIGHT_COLOR | BASIC_OBJECT_COLOR, TECHNIQUE_MESH_TORUS, { 0.5f, 0.0f, 0.0f }, 0
+};
+
+static const BasicTechnique ambientIbl = {
+    "lighting_methods/ambient_lighting_ibl/ambient_ibl.vs", "lighting_methods/ambient_lighting_ibl/ambient_ibl.fs",
+    BASIC_LIGHT_COLOR | BASIC_OBJECT_COLOR | BASIC_VIEW_POS | BASIC_IRRADIANCE | BASIC_PREFILTER, TECHNIQUE_MESH_SPHERE, { 1.0f, 1.0f, 1.0f }, 1,
+    { { "Reflectivity", "reflectivityValue", "reflectivity", 0.5f, 0.0f, 1.0f } }
+};
+
+static const BasicTechnique diffuseLambert = {
+    "lighting_methods/diffuse_lambert_lighting/diffuse_lambert.vs", "lighting_methods/diffuse_lambert_lighting/diffuse_lambert.fs",
+    BASIC_LIGHT, TECHNIQUE_MESH_TORUS, { 0.5f, 0.0f, 0.0f }, 0
+};
+
+static const BasicTechnique diffuseOrenNayar = {
+    "lighting_methods/diffuse_oren_nayar_lighting/diffuse_oren_nayar.vs", "lighting_methods/diffuse_oren_nayar_lighting/diffuse_oren_nayar.fs",
+    BASIC_LIGHT | BASIC_IRRADIANCE, TECHNIQUE_MESH_TORUS, { 0.5f, 0.0f, 0.0f }, 1,
+    { { "Roughness", NULL, "roughness", 0.5f, 0.0f, 1.0f } }
+};
+
+static const BasicTechnique diffuseBurley = {
+    "lighting_methods/diffuse_burley_lighting/diffuse_burley.vs", "lighting_methods/diffuse_burley_lighting/diffuse_burley.fs",
+    BASIC_LIGHT | BASIC_IRRADIANCE, TECHNIQUE_MESH_TORUS, { 0.5f, 0.0f, 0.0f }, 1,
+    { { "Roughness", "roughnessValue", "roughness", 0.5f, 0.0f, 1.0f } }
+};
+
+static const BasicTechnique diffuseAshikhminShirley = {
+    "lighting_methods/diffuse_ashikhmin_shirley_lighting/diffuse_ashikhmin_shirley.vs", "lighting_methods/diffuse_ashikhmin_shirley_lighting/diffuse_ashikhmin_shirley.fs",
+    BASIC_LIGHT, TECHNIQUE_MESH_TORUS_FINE, { 0.5f, 0.0f, 0.0f }, 1,
+    { { "Metallic", "metallicValue", "metallic", 0.5f, 0.0f, 1.0f } }
+};
+
+static const BasicTechnique specularPhong = {
+    "lighting_methods/specular_phong_lighting/specular_phong.vs", "lighting_methods/specular_phong_lighting/specular_phong.fs",
+    BASIC_LIGHT, TECHNIQUE_MESH_TORUS, { 0.5f, 0.0f, 0.0f }, 1,
+    { { "Roughness", "roughnessValue", "roughness", 0.5f, 0.0f, 1.0f } }
+};
+
+static const BasicTechnique specularBlinnPhong = {
+    "lighting_methods/specular_blinn_phong_lighting/specular_blinn_phong.vs", "lighting_methods/specular_blinn_phong_lighting/specular_blinn_phong.fs",
+    BASIC_LIGHT, TECHNIQUE_MESH_TORUS, { 0.5f, 0.0f, 0.0f }, 1,
+    { { "Roughness", "roughnessValue", "roughness", 0.5f, 0.0f, 1.0f } }
+};
+
+static const BasicTechnique specularAshikhminShirley = {
+    "lighting_methods/specular_ashikhmin_shirley_lighting/specular_ashikhmin_shirley.vs", "lighting_methods/specular_ashikhmin_shirley_lighting/specular_ashikhmin_shirley.fs",
+    BASIC_LIGHT, TECHNIQUE_MESH_TORUS_FINE, { 0.5f, 0.0f, 0.0f }, 3,
+    {
+        { "Roughness U", "roughnessU", "roughnessU", 0.5f, 0.01f, 1.0f },
+        { "Roughness V", "roughnessV", "roughnessV", 0.5f, 0.01f, 1.0f },
+        { "Metallic", "metallicValue", "metallic", 0.5f, 0.0f, 1.0f }
+    }
+};
+
+//----------------------------------------------------------------------------------
+// Oren-Nayar, the shader only needs A and B of the roughness
+//----------------------------------------------------------------------------------
+typedef struct OrenNayarState {
+    BasicState basic;
+    int orenNayarABLoc;
+    float roughness;                // Value A and B were derived from
+} OrenNayarState;
+
+static void *InitOrenNayar(const Technique *technique, const TechniqueAssets *assets)
+{
+    OrenNayarState *state = (OrenNayarState *)RL_CALLOC(1, sizeof(OrenNayarState));
+    InitBasicState(&state->basic, technique, assets);
+
+    state->orenNayarABLoc = GetShaderLocation(state->basic.shader, "orenNayarAB");
+    state->roughness = -1.0f;
+
+    return state;
+}
+
+static void UpdateOrenNayar(void *state, const TechniqueFrame *frame)
+{
+    OrenNayarState *orenNayar = (OrenNayarState *)state;
+    UpdateBasicTechnique(&orenNayar->basic, frame);
+
+    // Derived and sent when the slider moves
+    if (orenNayar->basic.values[0] != orenNayar->roughness)
+    {
+        orenNayar->roughness = orenNayar->basic.values[0];
+        Vector2 orenNayarAB = GetOrenNayarCoefficients(orenNayar->roughness);
+        SetShaderValue(orenNayar->basic.shader, orenNayar->orenNayarABLoc, &orenNayarAB, SHADER_UNIFORM_VEC2);
+    }
+}
+
+static void UnloadOrenNayar(void *state)
+{
+    UnloadBasicState(&((OrenNayarState *)state)->basic);
+    RL_FREE(state);
+}
+
+//----------------------------------------------------------------------------------
+// Cook-Torrance
+//----------------------------------------------------------------------------------
+static void *InitCookTorrance(const Technique *technique, const TechniqueAssets *assets)
+{
+    CookTorranceState *state = (CookTorranceState *)RL_CALLOC(1, sizeof(CookTorranceState));
+    state->sky = assets->sky;
+    state->mesh = assets->meshes[TECHNIQUE_MESH_TORUS_DENSE];
+
+    // Every combination is built the first time it is picked (see common/shader_variants.h), INSTANCED only
+    // for the demo's material grid
+    const char *variantDefines[] = { "NDF_TYPE", "GSF_TYPE", "FRESNEL_TYPE", "MULTISCATTER_TYPE", "CONDUCTOR_PRESET", "INSTANCED" };
+    state->variants = LoadShaderVariants("lighting_methods/specular_cook_torrance_lighting/specular_cook_torrance.vs", "lighting_methods/specular_cook_torrance_lighting/specular_cook_torrance.fs", variantDefines, 6);
+
+    // Material parameters go through a uniform buffer shared by every variant
+    state->block = LoadMaterialBlock(GetMaterialParamsDefault(), "resources/dfg_lut.bin");
+
+    // Bind the prefiltered environment map for the ambient specular term and the DFG table, a 2D slot
+    state->material = LoadMaterialDefault();
+    state->material.maps[MATERIAL_MAP_PREFILTER].texture = assets->sky->prefilter;
+    state->material.maps[MATERIAL_MAP_BRDF].texture = assets->dfgLut;
+
+    return state;
+}
+
+static void UpdateCookTorrance(void *state, const TechniqueFrame *frame)
+{
+    CookTorranceState *cook = (CookTorranceState *)state;
+
+    // Pick the program for the current selections, the conductor preset only matters for the conductor Fresnel
+    int variantValues[6] = { cook->ndfActive, cook->gsfActive, cook->fresnelActive, cook->multiScatterActive, (cook->fresnelActive == 2)? cook->conductorPresetActive : 0, cook->instanced? 1 : 0 };
+    Shader selected = GetShaderVariant(&cook->variants, variantValues);
+    int envChanged = frame->envChanged;
+
+    if (selected.id != cook->shader.id)
+    {
+        Shader shader = selected;
+        cook->shader = shader;
+        cook->material.shader = shader;
+
+        // Assign the uniforms
+        cook->viewPosLoc      = GetShaderLocation(shader, "viewPos");
+        cook->shIrradianceLoc = GetShaderLocation(shader, "shIrradiance");
+        shader.locs[SHADER_LOC_MAP_PREFILTER] = GetShaderLocation(shader, "prefilterMap");
+        shader.locs[SHADER_LOC_MAP_BRDF] = GetShaderLocation(shader, "dfgLut");
+
+        // Set the uniforms that are not updated every frame, each program keeps its own values
+        Vector3 lightPos = TECHNIQUE_LIGHT_POS;
+        Vector3 lightColor = TECHNIQUE_LIGHT_COLOR;
+        float prefilterMaxLod = (float)(ENV_PREFILTER_ROUGHNESS_LEVELS - 1);
+
+        SetShaderValue(shader, GetShaderLocation(shader, "lightPos"), &lightPos, SHADER_UNIFORM_VEC3);
+        SetShaderValue(shader, GetShaderLocation(shader, "lightColor"), &lightColor, SHADER_UNIFORM_VEC3);
+        SetShaderValue(shader, GetShaderLocation(shader, "prefilterMaxLod"), &prefilterMaxLod, SHADER_UNIFORM_FLOAT);
+        BindMaterialBlock(shader);
+
+        envChanged |= ENV_ASSET_IRRADIANCE;
+    }
+
+    if (envChanged & ENV_ASSET_IRRADIANCE) SetShaderValueSH9(cook->shader, cook->shIrradianceLoc, cook->sky->irradiance);
+
+    // Update camera position every frame
+    float cameraPos[3] = { frame->camera.position.x, frame->camera.position.y, frame->camera.position.z };
+    SetShaderValue(cook->shader, cook->viewPosLoc, cameraPos, SHADER_UNIFORM_VEC3);
+
+    // Bench runs may sweep one slider over the measured frames (--sweep)
+    UpdateMaterialSliders(&cook->block.params, baseLayerSliders, 4, frame->run);
+    cook->block.params.anisotropy = GetHeadlessSweep(frame->run, "anisotropy", cook->block.params.anisotropy, -1.0f, 1.0f);
+
+    if (frame->clusters != NULL) SetShaderLightClusters(cook->shader, frame->clusters);
+
+    // Derive and upload the material fields the sliders changed since the last frame, one call or none
+    UpdateMaterialBlock(&cook->block);
+
+    Vector3 color = cook->block.params.color;
+    cook->material.maps[MATERIAL_MAP_DIFFUSE].color = ColorFromNormalized((Vector4){ color.x, color.y, color.z, 1.0f });
+}
+
+static void DrawCookTorrance(void *state, const TechniqueFrame *frame)
+{
+    CookTorranceState *cook = (CookTorranceState *)state;
+
+    DrawMesh(cook->mesh, cook->material, frame->transform);
+}
+
+static void DrawCookTorranceGui(void *state, int screenWidth, int screenHeight)
+{
+    CookTorranceState *cook = (CookTorranceState *)state;
+
+    // Roughness, metallic, IOR and alpha sliders
+    DrawMaterialSliders(&cook->block.params, baseLayerSliders, 4, 10, 40);
+
+    // NDF Dropdown
+    DrawText("NDF", 10, 160, 20, BLACK);
+    if (GuiDropdownBox((Rectangle){ 10, 190, 180, 20 }, "Beckmann;GGX (Trowbridge-Reitz);GGX (Anisotropic);Disable", &cook->ndfActive, cook->ndfEditMode)) cook->ndfEditMode = !cook->ndfEditMode;
+
+    // GSF Dropdown
+    DrawText("GSF", 200, 160, 20, BLACK);
+    if (GuiDropdownBox((Rectangle){ 200, 190, 180, 20 }, "Kelemen;Neuman;Schlick (Disney);Schlick (Epic);Smith-Beckmann;Smith-GGX;Smith-GGX (Anisotropic);Disable", &cook->gsfActive, cook->gsfEditMode)) cook->gsfEditMode = !cook->gsfEditMode;
+
+    // Fresnel Dropdown
+    DrawText("FF", 390, 160, 20, BLACK);
+    if (GuiDropdownBox((Rectangle){ 390, 190, 180, 20 }, "Schlick;Fresnel (Dielectrics); Fresnel (Conductors);Disable", &cook->fresnelActive, cook->fresnelEditMode)) cook->fresnelEditMode = !cook->fresnelEditMode;
+
+    // Multiscatter Dropdown
+    DrawText("MS", 580, 160, 20, BLACK);
+    if (GuiDropdownBox((Rectangle){ 580, 190, 180, 20 }, "Multi-scatter (Accurate);Multi-scatter (Approx);Disable", &cook->multiScatterActive, cook->multiScatterEditMode)) cook->multiScatterEditMode = !cook->multiScatterEditMode;
+
+    // Draw anisotropy slider (ONLY when GGX Anisotropic is selected)
+    if (cook->ndfActive == 2)
+    {
+        DrawText("Anisotropy", 410, 40, 20, BLACK);
+        GuiSlider((Rectangle){ 530, 40, 200, 20 }, "", TextFormat("%.2f", cook->block.params.anisotropy), &cook->block.params.anisotropy, -1.0f, 1.0f);
+    }
+
+    // Draw preset selector (ONLY when Fresnel Conductor is selected)
+    if (cook->fresnelActive == 2)
+    {
+        DrawText("Presets", 410, 70, 20, BLACK);
+        if (GuiDropdownBox((Rectangle){ 530, 70, 180, 20 }, "Gold;Copper;Aluminium;Silver;Iron", &cook->conductorPresetActive, cook->conductorPresetEditMode)) cook->conductorPresetEditMode = !cook->conductorPresetEditMode;
+    }
+}
+
+static void UnloadCookTorrance(void *state)
+{
+    CookTorranceState *cook = (CookTorranceState *)state;
+
+    // The variants own the programs, the maps hold the lab's textures
+    RL_FREE(cook->material.maps);
+    UnloadMaterialBlock(&cook->block);
+    UnloadShaderVariants(&cook->variants);
+    RL_FREE(state);
+}
+
+//----------------------------------------------------------------------------------
+// Techniques
+//----------------------------------------------------------------------------------
+const Technique ambientSimpleTechnique = {
+    "ambient_simple", "Ambient Lighting - Simple", 0, ENV_ASSET_SKYBOX, 1.0f, &ambientSimple,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+const Technique ambientIblTechnique = {
+    "ambient_ibl", "Ambient Lighting - IBL", 0, ENV_ASSET_ALL, 1.0f, &ambientIbl,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+const Technique diffuseLambertTechnique = {
+    "diffuse_lambert", "Diffuse Lambert Lighting", 0, ENV_ASSET_SKYBOX, HDR_EXPOSURE_DEFAULT, &diffuseLambert,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+const Technique diffuseOrenNayarTechnique = {
+    "diffuse_oren_nayar", "Diffuse Oren-Nayar Lighting", 0, ENV_ASSET_SKYBOX | ENV_ASSET_IRRADIANCE, HDR_EXPOSURE_DEFAULT, &diffuseOrenNayar,
+    InitOrenNayar, UpdateOrenNayar, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadOrenNayar
+};
+
+const Technique diffuseBurleyTechnique = {
+    "diffuse_burley", "Diffuse Burley Lighting", TECHNIQUE_LIGHTS, ENV_ASSET_SKYBOX | ENV_ASSET_IRRADIANCE, HDR_EXPOSURE_DEFAULT, &diffuseBurley,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+const Technique diffuseAshikhminShirleyTechnique = {
+    "diffuse_ashikhmin_shirley", "Diffuse Ashikhmin Shirley Lighting", 0, ENV_ASSET_SKYBOX, HDR_EXPOSURE_DEFAULT, &diffuseAshikhminShirley,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+const Technique specularPhongTechnique = {
+    "specular_phong", "Phong Lighting", 0, ENV_ASSET_SKYBOX, HDR_EXPOSURE_DEFAULT, &specularPhong,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+const Technique specularBlinnPhongTechnique = {
+    "specular_blinn_phong", "Blinn-Phong Lighting", 0, ENV_ASSET_SKYBOX, HDR_EXPOSURE_DEFAULT, &specularBlinnPhong,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+const Technique specularAshikhminShirleyTechnique = {
+    "specular_ashikhmin_shirley", "Diffuse + Specular Ashikhmin Shirley Lighting", 0, ENV_ASSET_SKYBOX, HDR_EXPOSURE_DEFAULT, &specularAshikhminShirley,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+const Technique specularCookTorranceTechnique = {
+    "specular_cook_torrance", "Diffuse Burley + Specular Cook-Torrance Lighting", TECHNIQUE_LIGHTS, ENV_ASSET_ALL, HDR_EXPOSURE_DEFAULT, NULL,
+    InitCookTorrance, UpdateCookTorrance, DrawCookTorrance, DrawCookTorranceGui, UnloadCookTorrance
+};
+
+#endif // LIGHTING_METHODS_IMPLEMENTATION
@@ -0,0 +1,174 @@
+/**********************************************************************************************
+*
+*   multi_layer_reflectance - The multi_layer_reflectance demos as shading lab techniques
+*
+*   Define MULTI_LAYER_REFLECTANCE_IMPLEMENTATION in exactly one translation unit before
+*   including it
+*
+*   Clearcoat and sheen are one layered technique: the Cook-Torrance base layer and a second
+*   layer, the material parameters in a material block (see common/material_block.h) and
+*   their sliders in two columns. The sheen demo is technique_demo.h hosting its technique,
+*   the clearcoat demo draws its deferred path, overdraw layers and depth pre-pass with the
+*   state below, those are not in the lab
+*
+**********************************************************************************************/
+
+#ifndef MULTI_LAYER_REFLECTANCE_H
+#define MULTI_LAYER_REFLECTANCE_H
+
+#include "technique.h"
+
+#define LAYERED_MAX_SLIDERS     3
+
+// Program and the sliders of the second layer
+typedef struct LayeredTechnique {
+    const char *vsFileName;
+    const char *fsFileName;
+    const char *layerName;                          // Heading of the second column
+    int sliderCount;
+    MaterialSlider sliders[LAYERED_MAX_SLIDERS];
+} LayeredTechnique;
+
+typedef struct LayeredState {
+    const LayeredTechnique *desc;
+    const EnvAssets *sky;
+    Shader shader;
+    Material material;
+    Mesh mesh;
+    MaterialBlock block;
+    int viewPosLoc;
+    int shIrradianceLoc;
+} LayeredState;
+
+extern const Technique clearcoatTechnique;
+extern const Technique sheenTechnique;
+
+#endif // MULTI_LAYER_REFLECTANCE_H
+
+#if defined(MULTI_LAYER_REFLECTANCE_IMPLEMENTATION) && !defined(MULTI_LAYER_REFLECTANCE_IMPLEMENTED)
+#define MULTI_LAYER_REFLECTANCE_IMPLEMENTED
+
+#include "raygui.h"
+#include "../common/shader_cache.h"
+
+static void *InitLayered(const Technique *technique, const TechniqueAssets *assets)
+{
+    LayeredState *state = (LayeredState *)RL_CALLOC(1, sizeof(LayeredState));
+    const LayeredTechnique *desc = (const LayeredTechnique *)technique->desc;
+
+    state->desc = desc;
+    state->sky = assets->sky;
+    state->mesh = assets->meshes[TECHNIQUE_MESH_TORUS_DENSE];
+
+    // Load the shaders
+    Shader shader = LoadShaderCached(desc->vsFileName, desc->fsFileName);
+    state->shader = shader;
+    state->material = LoadMaterialDefault();
+    state->material.shader = shader;
+
+    // Set static uniform values
+    Vector3 lightPos = TECHNIQUE_LIGHT_POS;
+    Vector3 lightColor = TECHNIQUE_LIGHT_COLOR;
+    float prefilterMaxLod = (float)(ENV_PREFILTER_ROUGHNESS_LEVELS - 1);
+
+    SetShaderValue(shader, GetShaderLocation(shader, "lightPos"), &lightPos, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, GetShaderLocation(shader, "lightColor"), &lightColor, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, GetShaderLocation(shader, "prefilterMaxLod"), &prefilterMaxLod, SHADER_UNIFORM_FLOAT);
+
+    state->viewPosLoc = GetShaderLocation(shader, "viewPos");
+    state->shIrradianceLoc = GetShaderLocation(shader, "shIrradiance");
+
+    // Material parameters (object color included) go through the uniform buffer, the sliders write
+    // straight into the params
+    state->block = LoadMaterialBlock(GetMaterialParamsDefault(), "resources/dfg_lut.bin");
+    BindMaterialBlock(shader);
+
+    // Bind the prefiltered environment map for the ambient specular term and the DFG table, a 2D slot
+    state->material.maps[MATERIAL_MAP_PREFILTER].texture = assets->sky->prefilter;
+    state->material.maps[MATERIAL_MAP_BRDF].texture = assets->dfgLut;
+    shader.locs[SHADER_LOC_MAP_PREFILTER] = GetShaderLocation(shader, "prefilterMap");
+    shader.locs[SHADER_LOC_MAP_BRDF] = GetShaderLocation(shader, "dfgLut");
+
+    return state;
+}
+
+static void UpdateLayered(void *state, const TechniqueFrame *frame)
+{
+    LayeredState *layered = (LayeredState *)state;
+
+    if (frame->envChanged & ENV_ASSET_IRRADIANCE) SetShaderValueSH9(layered->shader, layered->shIrradianceLoc, layered->sky->irradiance);
+
+    // Update camera position every frame
+    float cameraPos[3] = { frame->camera.position.x, frame->camera.position.y, frame->camera.position.z };
+    SetShaderValue(layered->shader, layered->viewPosLoc, cameraPos, SHADER_UNIFORM_VEC3);
+
+    // Bench runs may sweep one slider over the measured frames (--sweep)
+    UpdateMaterialSliders(&layered->block.params, baseLayerSliders, 4, frame->run);
+    UpdateMaterialSliders(&layered->block.params, layered->desc->sliders, layered->desc->sliderCount, frame->run);
+
+    if (frame->clusters != NULL) SetShaderLightClusters(layered->shader, frame->clusters);
+
+    // Derive and upload the material fields the sliders changed since the last frame, one call or none
+    UpdateMaterialBlock(&layered->block);
+
+    Vector3 color = layered->block.params.color;
+    layered->material.maps[MATERIAL_MAP_DIFFUSE].color = ColorFromNormalized((Vector4){ color.x, color.y, color.z, 1.0f });
+}
+
+static void DrawLayered(void *state, const TechniqueFrame *frame)
+{
+    LayeredState *layered = (LayeredState *)state;
+
+    DrawMesh(layered->mesh, layered->material, frame->transform);
+}
+
+static void DrawLayeredGui(void *state, int screenWidth, int screenHeight)
+{
+    LayeredState *layered = (LayeredState *)state;
+
+    DrawText("Main Layer", 10, 40, 20, BLACK);
+    DrawMaterialSliders(&layered->block.params, baseLayerSliders, 4, 10, 70);
+
+    DrawText(layered->desc->layerName, 410, 40, 20, BLACK);
+    DrawMaterialSliders(&layered->block.params, layered->desc->sliders, layered->desc->sliderCount, 410, 70);
+}
+
+static void UnloadLayered(void *state)
+{
+    LayeredState *layered = (LayeredState *)state;
+
+    // The maps hold the lab's textures, only the array goes
+    RL_FREE(layered->material.maps);
+    UnloadMaterialBlock(&layered->block);
+    UnloadShader(layered->shader);
+    RL_FREE(state);
+}
+
+static const LayeredTechnique clearcoat = {
+    "multi_layer_reflectance/clearcoat/clearcoat.vs", "multi_layer_reflectance/clearcoat/clearcoat.fs", "Clearcoat Layer", 3,
+    {
+        { "Weight", "clearcoatWeight", offsetof(MaterialParams, clearcoatWeight), 0.0f, 1.0f },
+        { "Roughness", "clearcoatRoughness", offsetof(MaterialParams, clearcoatRoughness), 0.0f, 1.0f },
+        { "IOR", "clearcoatIor", offsetof(MaterialParams, clearcoatIor), 1.0f, 3.5f }
+    }
+};
+
+static const LayeredTechnique sheen = {
+    "multi_layer_reflectance/sheen/sheen.vs", "multi_layer_reflectance/sheen/sheen.fs", "Sheen Layer", 2,
+    {
+        { "Weight", "sheenWeight", offsetof(MaterialParams, sheenWeight), 0.0f, 1.0f },
+        { "Roughness", "sheenRoughness", offsetof(MaterialParams, sheenRoughness), 0.0f, 1.0f }
+    }
+};
+
+const Technique clearcoatTechnique = {
+    "clearcoat", "Diffuse Burley + Specular Cook-Torrance Lighting + Clearcoat Layer", TECHNIQUE_LIGHTS, ENV_ASSET_ALL, HDR_EXPOSURE_DEFAULT, &clearcoat,
+    InitLayered, UpdateLayered, DrawLayered, DrawLayeredGui, UnloadLayered
+};
+
+const Technique sheenTechnique = {
+    "sheen", "Diffuse Burley + Specular Cook-Torrance Lighting + Sheen Layer", TECHNIQUE_LIGHTS, ENV_ASSET_ALL, HDR_EXPOSURE_DEFAULT, &sheen,
+    InitLayered, UpdateLayered, DrawLayered, DrawLayeredGui, UnloadLayered
+};
+
+#endif // MULTI_LAYER_REFLECTANCE_IMPLEMENTATION
@@ -0,0 +1,59 @@
+/**********************************************************************************************
+*
+*   polygon_shading_methods - The polygon_shading_methods demos as shading lab techniques
+*
+*   Define POLYGON_SHADING_METHODS_IMPLEMENTATION in exactly one translation unit before
+*   including it
+*
+*   All three are BasicTechniques (see technique.h) on the coarse torus, where the difference
+*   between the methods shows. The demos draw the GPU path with them and feed the CPU
+*   rasterizer (C, --cpu) the same mesh, light and color, it is not in the lab
+*
+**********************************************************************************************/
+
+#ifndef POLYGON_SHADING_METHODS_H
+#define POLYGON_SHADING_METHODS_H
+
+#include "technique.h"
+
+extern const Technique shadingFlatTechnique;
+extern const Technique shadingGouraudTechnique;
+extern const Technique shadingPhongTechnique;
+
+#endif // POLYGON_SHADING_METHODS_H
+
+#if defined(POLYGON_SHADING_METHODS_IMPLEMENTATION) && !defined(POLYGON_SHADING_METHODS_IMPLEMENTED)
+#define POLYGON_SHADING_METHODS_IMPLEMENTED
+
+// Flat shading lights one normal per triangle and has no specular term, so no view position
+static const BasicTechnique shadingFlat = {
+    "polygon_shading_methods/flat_shading/shading_flat.vs", "polygon_shading_methods/flat_shading/shading_flat.fs",
+    BASIC_LIGHT_POS | BASIC_LIGHT_COLOR | BASIC_OBJECT_COLOR, TECHNIQUE_MESH_TORUS, { 0.5f, 0.0f, 0.0f }, 0
+};
+
+static const BasicTechnique shadingGouraud = {
+    "polygon_shading_methods/gouraud_shading/shading_gouraud.vs", "polygon_shading_methods/gouraud_shading/shading_gouraud.fs",
+    BASIC_LIGHT_POS | BASIC_LIGHT_COLOR | BASIC_OBJECT_COLOR | BASIC_VIEW_POS, TECHNIQUE_MESH_TORUS, { 0.5f, 0.0f, 0.0f }, 0
+};
+
+static const BasicTechnique shadingPhong = {
+    "polygon_shading_methods/phong_shading/shading_phong.vs", "polygon_shading_methods/phong_shading/shading_phong.fs",
+    BASIC_LIGHT_POS | BASIC_LIGHT_COLOR | BASIC_OBJECT_COLOR | BASIC_VIEW_POS, TECHNIQUE_MESH_TORUS, { 0.5f, 0.0f, 0.0f }, 0
+};
+
+const Technique shadingFlatTechnique = {
+    "shading_flat", "Flat Shading", 0, ENV_ASSET_SKYBOX, 1.0f, &shadingFlat,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+const Technique shadingGouraudTechnique = {
+    "shading_gouraud", "Gouraud Shading", 0, ENV_ASSET_SKYBOX, 1.0f, &shadingGouraud,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+const Technique shadingPhongTechnique = {
+    "shading_phong", "Phong Shading", 0, ENV_ASSET_SKYBOX, 1.0f, &shadingPhong,
+    InitBasicTechnique, UpdateBasicTechnique, DrawBasicTechnique, DrawBasicTechniqueGui, UnloadBasicTechnique
+};
+
+#endif // POLYGON_SHADING_METHODS_IMPLEMENTATION
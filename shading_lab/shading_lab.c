@@ -0,0 +1,515 @@
+/*
+-> Press F5 to run, from the repository root like the demos
+-> Every demo of lighting_methods, polygon_shading_methods and multi_layer_reflectance in one window: the sky, the skybox,
+   the meshes and the point lights are loaded once and shared, a technique only brings its programs and sliders
+   (see technique.h)
+-> Press LEFT/RIGHT or click the technique box at the bottom to switch, --technique NAME starts with one (the demo's
+   executable name, e.g. diffuse_burley). A technique is loaded the first time it is picked and kept, the switch time
+   is shown and logged
+-> Press V to compare techniques side by side, in a grid of viewports that share the camera, the sky, the meshes and
+   the lights (see viewport_grid.h). It starts with the technique in use and the next three, 1-9 picks the viewport
+   that the technique box, LEFT/RIGHT and the sliders change, UP/DOWN add or drop one (2 to 9).
+   --compare a,b,c starts with those, e.g. --compare diffuse_lambert,diffuse_oren_nayar,diffuse_burley
+-> Press middle mouse button to move the camera
+-> Use mouse wheel to zoom in and out
+-> Press left mouse button to interact with the GUI
+-> Use the Lights slider to add point lights to the techniques that read them, binned into view clusters every frame
+   (see common/light_clusters.h), --lights N starts with N of them
+-> The scene renders into a float target, one pass per viewport applies the exposure of its technique's demo and
+   the tone map curve, the sky stays unexposed (see common/hdr_target.h): --exposure X for every technique,
+   --tonemap clamp|reinhard|aces, --hdr-format rgba16f|r11g11b10f, --ldr draws straight to the frame
+-> Press T to toggle the pass timings overlay (CPU and GPU p50/p95/p99 of every pass), --timings file.csv writes
+   the timings of every frame on exit (see common/pass_timer.h)
+-> Run with --headless [--frames N] [--size WxH] [--output file.png] to render offscreen (see common/headless.h)
+-> Run with --bench [--warmup N] [--frames M] [--bench-output file.jsonl] for an uncapped timed run on a fixed camera
+   orbit, printed as a JSON line of frame rate and frame time percentiles (see common/headless.h), named
+   shading_lab/<technique>, or shading_lab/compare_N for N viewports. --sweep takes the slider names of the technique's
+   demo, and lights. --headless --bench --size 1920x1080 --compare ... times a grid at 1080p
+*/
+
+#define RAYGUI_IMPLEMENTATION
+#define ENV_ASSETS_IMPLEMENTATION
+#define ENV_DFG_IMPLEMENTATION
+#define HEADLESS_IMPLEMENTATION
+#define SHADER_CACHE_IMPLEMENTATION
+#define SHADER_VARIANTS_IMPLEMENTATION
+#define MATERIAL_BLOCK_IMPLEMENTATION
+#define LIGHT_CLUSTERS_IMPLEMENTATION
+#define HDR_TARGET_IMPLEMENTATION
+#define PASS_TIMER_IMPLEMENTATION
+#define TECHNIQUE_IMPLEMENTATION
+#define LIGHTING_METHODS_IMPLEMENTATION
+#define POLYGON_SHADING_METHODS_IMPLEMENTATION
+#define MULTI_LAYER_REFLECTANCE_IMPLEMENTATION
+#define VIEWPORT_GRID_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "raygui.h"
+#include "rlgl.h"
+#include "../common/env_assets.h"
+#include "../common/env_dfg.h"
+#include "../common/headless.h"
+#include "../common/shader_cache.h"
+#include "../common/shader_variants.h"
+#include "../common/material_block.h"
+#include "../common/light_clusters.h"
+#include "../common/hdr_target.h"
+#include "../common/pass_timer.h"
+#include "technique.h"
+#include "lighting_methods.h"
+#include "polygon_shading_methods.h"
+#include "multi_layer_reflectance.h"
+#include "viewport_grid.h"
+
+// Passes timed every frame
+#define PASS_SKY       0
+#define PASS_MODEL     1
+#define PASS_CLUSTERS  2
+#define PASS_TONEMAP   3
+#define PASS_GUI       4
+
+// Every technique of the lab, in the order of the repository
+static const Technique *techniques[] = {
+    &ambientSimpleTechnique,
+    &ambientIblTechnique,
+    &diffuseLambertTechnique,
+    &diffuseOrenNayarTechnique,
+    &diffuseBurleyTechnique,
+    &diffuseAshikhminShirleyTechnique,
+    &specularPhongTechnique,
+    &specularBlinnPhongTechnique,
+    &specularAshikhminShirleyTechnique,
+    &specularCookTorranceTechnique,
+    &shadingFlatTechnique,
+    &shadingGouraudTechnique,
+    &shadingPhongTechnique,
+    &clearcoatTechnique,
+    &sheenTechnique,
+};
+
+#define TECHNIQUE_COUNT     (int)(sizeof(techniques)/sizeof(techniques[0]))
+
+// Index of a technique from its name, -1 when there is none
+static int FindTechnique(const char *name)
+{
+    for (int t = 0; t < TECHNIQUE_COUNT; t++) if (strcmp(name, techniques[t]->name) == 0) return t;
+
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    // Set window dimensions
+    const int screenWidth = 800;
+    const int screenHeight = 800;
+
+    // Read the headless options, --headless renders offscreen into a hidden window
+    HeadlessRun headless = ParseHeadlessArgs(argc, argv, screenWidth, screenHeight);
+
+    // Technique to start with, --technique NAME
+    int active = 0;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--technique") != 0) continue;
+
+        int found = FindTechnique(argv[i + 1]);
+
+        if (found >= 0) active = found;
+        else TraceLog(LOG_WARNING, "LAB: Unknown technique %s, starting with %s", argv[i + 1], techniques[active]->name);
+    }
+
+    // Techniques of the compare grid, one per viewport, --compare a,b,c. The focused viewport always shows the
+    // active technique, the one the GUI edits
+    int views[VIEWPORT_GRID_MAX] = { 0 };
+    int viewCount = 0;
+    int focus = 0;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--compare") != 0) continue;
+
+        char list[512] = { 0 };
+        snprintf(list, sizeof(list), "%s", argv[i + 1]);
+
+        viewCount = 0;
+        for (char *name = strtok(list, ","); (name != NULL) && (viewCount < VIEWPORT_GRID_MAX); name = strtok(NULL, ","))
+        {
+            int found = FindTechnique(name);
+
+            if (found >= 0) views[viewCount++] = found;
+            else TraceLog(LOG_WARNING, "LAB: Unknown technique %s, left out of the comparison", name);
+        }
+    }
+
+    bool comparing = (viewCount > 0);
+    if (comparing) active = views[0];
+
+    // Bench results are named after the technique, not the executable, or after the size of the grid
+    if (comparing) snprintf(headless.name, sizeof(headless.name), "shading_lab/compare_%i", viewCount);
+    else snprintf(headless.name, sizeof(headless.name), "shading_lab/%s", techniques[active]->name);
+
+    // Initialize the window
+    InitHeadlessWindow(&headless, "Shading Lab");
+
+    // Define the camera
+    Camera camera = { 0 };
+    camera.position = (Vector3){2.0f, 1.0f, 0.0f };
+    camera.target = (Vector3){ 0.0f, 0.0f, 0.0f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 45.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    // Variables for camera orbiting
+    float yaw = 0.0f;
+    float pitch = 0.0f;
+    float radius = 2.5f;
+
+    // Start loading the sky on a worker thread, once for every technique: cubemap for the skybox, 9 SH
+    // coefficients for the diffuse ambient term and the GGX prefiltered cubemap. Grey placeholders are bound
+    // until the data streams in. Baked on the first run, mapped back from the caches next to the panorama
+    // afterwards, the cold and warm start times are logged
+    // Headless and bench runs load it in full before the first frame, so every run renders the same sky
+    EnvAssets sky = ((headless.enabled || headless.bench)? LoadEnvAssets : LoadEnvAssetsAsync)("resources/sky1_2k.jpg", ENV_ASSET_ALL);
+
+    // Create skybox cube mesh
+    Mesh cube = GenMeshCube(100.0f, 100.0f, 100.0f);
+    Model skybox = LoadModelFromMesh(cube);
+
+    // Load skybox shader and set the cubemap
+    skybox.materials[0].shader = LoadShaderCached("resources/skybox.vs", "resources/skybox.fs");
+
+    // Raylib binds MATERIAL_MAP_CUBEMAP as a cube texture, the shader samples it with the view direction
+    skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = sky.skybox;
+    skybox.materials[0].shader.locs[SHADER_LOC_MAP_CUBEMAP] = GetShaderLocation(skybox.materials[0].shader, "environmentMap");
+
+    // Shared assets: the DFG table and every mesh a demo generated for itself, uploaded once
+    TechniqueAssets assets = LoadTechniqueAssets(&sky);
+
+    // State of every technique loaded so far, NULL until it is first picked, and the environment levels each one
+    // has not been sent yet: only the techniques on screen are updated
+    void *states[TECHNIQUE_COUNT] = { 0 };
+    int envPending[TECHNIQUE_COUNT] = { 0 };
+    int selected = active;
+    float switchTime = 0.0f;
+
+    // Point lights for the techniques that read them, binned into the clusters of the view every frame, so every
+    // fragment only loops over the lights that reach it. --lights N starts with N of them
+    const int maxLights = 4096;
+    float lightCountValue = 0.0f;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--lights") == 0) lightCountValue = Clamp((float)atoi(argv[i + 1]), 0.0f, (float)maxLights);
+    }
+
+    ClusterLight *pointLights = (ClusterLight *)RL_CALLOC(maxLights, sizeof(ClusterLight));
+    LightClusters clusters = LoadLightClusters();
+
+    // Names for the technique box
+    char techniqueList[1024] = { 0 };
+    for (int t = 0; t < TECHNIQUE_COUNT; t++)
+    {
+        if (t > 0) strcat(techniqueList, ";");
+        strcat(techniqueList, techniques[t]->name);
+    }
+
+    // The scene goes to a float target the size of the frame, one pass per viewport exposes and tone maps it.
+    // Every technique keeps the exposure of its demo unless --exposure sets one for all of them (0 without it)
+    HdrTarget hdr = LoadHdrTarget(headless.enabled? headless.width : GetRenderWidth(), headless.enabled? headless.height : GetRenderHeight(),
+        ParseHdrArgs(argc, argv, 0.0f));
+
+    // Time the passes of every frame, T shows the overlay (off in headless and bench runs) and
+    // --timings FILE.csv keeps every sample
+    const char *passNames[] = { "Sky", "Model", "Clusters", "Tonemap", "GUI" };
+    PassTimer timer = LoadPassTimer(passNames, 5);
+    timer.output = ParsePassTimerArgs(argc, argv);
+    bool showTimings = !headless.enabled && !headless.bench;
+
+    // Lock the frames rate, headless and bench runs are not capped
+    if (!headless.enabled && !headless.bench) SetTargetFPS(60);
+
+    // Bench runs keep the startup slider values, or the swept one
+    if (headless.bench) GuiLock();
+
+    // Main render loop
+    while (!HeadlessShouldClose(&headless))
+    {
+        // Collect the pass times of the frame the GPU finished
+        UpdatePassTimer(&timer);
+        if (IsKeyPressed(KEY_T)) showTimings = !showTimings;
+
+        // Switch techniques, from the keys or the box clicked last frame
+        if (IsKeyPressed(KEY_RIGHT)) selected = (active + 1)%TECHNIQUE_COUNT;
+        if (IsKeyPressed(KEY_LEFT)) selected = (active + TECHNIQUE_COUNT - 1)%TECHNIQUE_COUNT;
+
+        // Compare grid: V toggles it, 1-9 focus a viewport, UP/DOWN add one after the last or drop the last
+        if (IsKeyPressed(KEY_V))
+        {
+            comparing = !comparing;
+
+            if (comparing && (viewCount == 0))
+            {
+                for (int i = 0; i < 4; i++) views[i] = (active + i)%TECHNIQUE_COUNT;
+                viewCount = 4;
+                focus = 0;
+            }
+
+            // The technique picked without the grid goes to the focused viewport
+            if (comparing) views[focus] = active;
+        }
+
+        if (comparing)
+        {
+            if (IsKeyPressed(KEY_UP) && (viewCount < VIEWPORT_GRID_MAX))
+            {
+                views[viewCount] = (views[viewCount - 1] + 1)%TECHNIQUE_COUNT;
+                viewCount++;
+            }
+            if (IsKeyPressed(KEY_DOWN) && (viewCount > 2)) viewCount--;
+            if (focus >= viewCount) focus = viewCount - 1;
+
+            for (int i = 0; i < viewCount; i++) if (IsKeyPressed(KEY_ONE + i)) focus = i;
+
+            // A new focus brings its technique to the GUI, a switch replaces the focused viewport's
+            if (views[focus] != active) active = selected = views[focus];
+        }
+
+        if ((selected != active) || (states[selected] == NULL))
+        {
+            // Loaded on first use only, afterwards a switch just changes the technique the loop calls
+            double switchStart = GetTime();
+            bool loaded = (states[selected] == NULL);
+            if (loaded) states[selected] = techniques[selected]->Init(techniques[selected], &assets);
+            switchTime = (float)((GetTime() - switchStart)*1000.0);
+
+            TraceLog(LOG_INFO, "LAB: Switched to %s in %.2f ms%s", techniques[selected]->name, switchTime, loaded? " (loaded)" : "");
+
+            if (loaded) envPending[selected] = ENV_ASSET_ALL;
+            active = selected;
+            if (comparing) views[focus] = active;
+        }
+
+        // Techniques on screen, one per viewport, the ones a viewport just added are loaded here
+        int shown[VIEWPORT_GRID_MAX] = { active };
+        int shownCount = comparing? viewCount : 1;
+        if (comparing) memcpy(shown, views, viewCount*sizeof(int));
+
+        bool lit = false;
+        for (int i = 0; i < shownCount; i++)
+        {
+            int t = shown[i];
+
+            if (states[t] == NULL)
+            {
+                double loadStart = GetTime();
+                states[t] = techniques[t]->Init(techniques[t], &assets);
+                envPending[t] = ENV_ASSET_ALL;
+
+                TraceLog(LOG_INFO, "LAB: Loaded %s for viewport %i in %.2f ms", techniques[t]->name, i + 1, (GetTime() - loadStart)*1000.0);
+            }
+
+            if (techniques[t]->flags & TECHNIQUE_LIGHTS) lit = true;
+        }
+
+        const Technique *technique = techniques[active];
+        void *state = states[active];
+
+        // Upload the environment levels the loader thread finished since the last frame, every loaded technique
+        // sends them on its next update, so one that was off screen while they arrived catches up
+        int envChanged = UpdateEnvAssets(&sky);
+        for (int t = 0; t < TECHNIQUE_COUNT; t++) if (states[t] != NULL) envPending[t] |= envChanged;
+
+        // Camera orbit controls
+        if (IsMouseButtonDown(MOUSE_MIDDLE_BUTTON))
+        {
+            Vector2 delta = GetMouseDelta();
+
+            yaw   -= delta.x * 0.01f;
+            pitch += delta.y * 0.01f;
+
+            // Clamp pitch so camera doesn't flip
+            pitch = Clamp(pitch, -PI/2 + 0.1f, PI/2 - 0.1f);
+        }
+
+        // Zoom
+        float wheel = GetMouseWheelMove();
+        radius -= wheel * 0.2f;
+        radius = Clamp(radius, 1.0f, 10.0f);
+
+        // Bench runs follow a fixed orbit instead
+        UpdateHeadlessOrbit(&headless, &yaw, &pitch);
+
+        // Spherical to cartesian
+        camera.position.x = radius * cosf(pitch) * sinf(yaw);
+        camera.position.y = radius * sinf(pitch);
+        camera.position.z = radius * cosf(pitch) * cosf(yaw);
+
+        camera.target = (Vector3){ 0.0f, 0.0f, 0.0f};
+
+        // Bench runs may sweep one slider over the measured frames (--sweep), the technique sweeps its own
+        lightCountValue = GetHeadlessSweep(&headless, "lights", lightCountValue, 0.0f, (float)maxLights);
+
+        // Rotate the torus over time
+        static float angle = 0.0f;
+        angle += 0.01f;
+
+        // One viewport filling the target, or the compare grid
+        int renderWidth = headless.enabled? headless.width : GetRenderWidth();
+        int renderHeight = headless.enabled? headless.height : GetRenderHeight();
+        ViewportGrid grid = LayoutViewportGrid(shownCount, renderWidth, renderHeight);
+
+        TechniqueFrame frame = { 0 };
+        frame.camera = camera;
+        frame.transform = MatrixMultiply(MatrixRotateZ(angle), MatrixRotateX(DEG2RAD * 90.0f));
+        frame.width = grid.cellWidth;
+        frame.height = grid.cellHeight;
+        frame.run = &headless;
+
+        // Move the point lights and bin them for this view, the shader reads the lists from buffer textures.
+        // Every viewport has the same size and camera, so one build serves all of them
+        int lightCount = (int)lightCountValue;
+        if (lit)
+        {
+            BeginPassTimer(&timer, PASS_CLUSTERS);
+            AnimateClusterLights(pointLights, lightCount, angle);
+            BuildLightClusters(&clusters, pointLights, lightCount, camera, frame.width, frame.height);
+            UploadLightClusters(&clusters);
+            EndPassTimer(&timer);
+        }
+
+        // Model pass order: the viewports of one technique back to back, so its program and material block
+        // come in once rather than between every other viewport's
+        int order[VIEWPORT_GRID_MAX] = { 0 };
+        for (int i = 0; i < shownCount; i++)
+        {
+            int k = i;
+            for (; (k > 0) && (shown[order[k - 1]] > shown[i]); k--) order[k] = order[k - 1];
+            order[k] = i;
+        }
+
+        // Start rendering
+        BeginHeadlessDrawing(&headless);
+
+        // Draw the scene into the float target, the background included
+        BeginHdrMode(&hdr);
+
+        // Clear the screen with an off-white background
+        ClearBackground((Color){200, 200, 200, 255});
+
+        // Draw skybox into every viewport (disable depth writing so it's always in background), one program and
+        // one cubemap for the whole pass
+        BeginPassTimer(&timer, PASS_SKY);
+        rlDisableBackfaceCulling();
+        rlDisableDepthMask();
+        for (int i = 0; i < shownCount; i++)
+        {
+            BeginViewport3D(&grid, i, camera);
+            DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
+            EndViewport3D(&grid);
+        }
+        rlEnableBackfaceCulling();
+        rlEnableDepthMask();
+        EndPassTimer(&timer);
+
+        // Draw every viewport's model, the uniforms are set right before the draw: the clusters' origin moves
+        // to the viewport and the material block of the technique is bound
+        BeginPassTimer(&timer, PASS_MODEL);
+        for (int k = 0; k < shownCount; k++)
+        {
+            int i = order[k];
+            int t = shown[i];
+
+            frame.envChanged = envPending[t];
+            envPending[t] = 0;
+
+            clusters.origin = GetViewportOrigin(&grid, i);
+            frame.clusters = (techniques[t]->flags & TECHNIQUE_LIGHTS)? &clusters : NULL;
+
+            BeginViewport3D(&grid, i, camera);
+            techniques[t]->Update(states[t], &frame);
+            techniques[t]->Draw(states[t], &frame);
+            EndViewport3D(&grid);
+        }
+        EndPassTimer(&timer);
+
+        // Back to the frame, every viewport exposed and tone mapped into it, the gaps of the grid are cleared
+        EndHdrMode(&hdr);
+
+        BeginPassTimer(&timer, PASS_TONEMAP);
+        if (comparing && (hdr.target.id != 0)) ClearBackground((Color){200, 200, 200, 255});
+        for (int i = 0; i < shownCount; i++)
+        {
+            Vector2 origin = GetViewportOrigin(&grid, i);
+            float exposure = (hdr.settings.exposure > 0.0f)? hdr.settings.exposure : techniques[shown[i]]->exposure;
+
+            DrawHdrToneMapViewport(&hdr, (int)origin.x, (int)origin.y, grid.cellWidth, grid.cellHeight, exposure);
+        }
+        EndPassTimer(&timer);
+
+        // GUI laid out on the frame size, which --size or a window resize can change
+        const int guiWidth = GetHeadlessScreenWidth(&headless);
+        const int guiHeight = GetHeadlessScreenHeight(&headless);
+
+        // Text and GUI
+        BeginPassTimer(&timer, PASS_GUI);
+
+        // Add information text, the title of every viewport when comparing, the focused one outlined
+        if (comparing)
+        {
+            float guiScale = (float)(headless.enabled? headless.width : GetScreenWidth())/(float)renderWidth;
+
+            for (int i = 0; i < shownCount; i++)
+            {
+                Rectangle cell = { grid.cells[i].x*guiScale, grid.cells[i].y*guiScale, grid.cells[i].width*guiScale, grid.cells[i].height*guiScale };
+
+                DrawText(TextFormat("%i: %s", i + 1, techniques[shown[i]]->title), (int)cell.x + 10, (int)cell.y + 10, 20, BLACK);
+                if (i == focus) DrawRectangleLinesEx(cell, 2.0f, MAROON);
+            }
+        }
+        else DrawText(technique->title, 10, 10, 20, BLACK);
+
+        // Sliders and dropdowns of the technique
+        technique->DrawGui(state, guiWidth, guiHeight);
+
+        // Draw point light count slider, with the binning time of this frame
+        if (lit)
+        {
+            DrawText("Lights", 10, guiHeight - 60, 20, BLACK);
+            GuiSlider((Rectangle){ 130, guiHeight - 60, 200, 20 }, "", TextFormat("%i", lightCount), &lightCountValue, 0.0f, (float)maxLights);
+            DrawText(TextFormat("Binned in %.2f ms, %i references", clusters.buildTime*1000.0, clusters.indexCount), 410, guiHeight - 60, 20, BLACK);
+        }
+
+        // Technique box, a click moves to the next one, with the time the last switch took
+        GuiComboBox((Rectangle){ 10, guiHeight - 30, 300, 20 }, techniqueList, &selected);
+        DrawText(TextFormat("%i/%i, switched in %.2f ms", active + 1, TECHNIQUE_COUNT, switchTime), 410, guiHeight - 30, 20, BLACK);
+
+        EndPassTimer(&timer);
+
+        // Percentiles of the pass times over the last frames
+        if (showTimings) DrawPassTimer(&timer, guiWidth - 330, 230);
+
+        // Finish the frame and present it on screen
+        EndHeadlessDrawing(&headless);
+    }
+
+    // Cleanup
+    for (int t = 0; t < TECHNIQUE_COUNT; t++)
+    {
+        if (states[t] != NULL) techniques[t]->Unload(states[t]);
+    }
+
+    UnloadEnvAssets(sky);
+    UnloadTechniqueAssets(&assets);
+    skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = (Texture2D){ 0 };    // The sky's, UnloadEnvAssets() deleted it
+    UnloadModel(skybox);
+    UnloadLightClusters(&clusters);
+    RL_FREE(pointLights);
+    UnloadHdrTarget(hdr);
+    UnloadPassTimer(&timer);
+    UnloadHeadlessRun(&headless);
+    CloseWindow();
+
+    return 0;
+}
@@ -0,0 +1,349 @@
+/**********************************************************************************************
+*
+*   technique - Shading techniques as modules of the shading lab
+*
+*   The lab (shading_lab.c) owns the window, the camera, the sky, the skybox, the meshes and
+*   the point lights, loads them once and hands them to the technique in use. A technique
+*   only brings its programs, uniforms and sliders, through five hooks:
+*
+*       Init()      Load the programs, look the uniforms up and bind the shared textures. Called
+*                   the first time the technique is picked, its state then stays loaded until
+*                   the lab closes, so switching back to it costs nothing
+*       Update()    Right before every Draw(): camera position, sweeps, sliders to uniforms,
+*                   the clusters of the frame, the material block bound
+*       Draw()      The model pass, inside the viewport of the frame (see viewport_grid.h)
+*       DrawGui()   Sliders and dropdowns, below the title the lab draws
+*       Unload()    Programs and buffers, the shared assets stay with the lab
+*
+*   The compare grid draws one technique per viewport, the same one maybe in several, so
+*   Update() runs once per viewport and leaves everything its Draw() reads in place: another
+*   technique's updates come between two frames of it. Only the techniques on screen are
+*   updated, envChanged holds the ENV_ASSET_* flags of the sky data that arrived since a
+*   technique's last Update(), every flag after it is loaded. The modules themselves are in
+*   lighting_methods.h, polygon_shading_methods.h and multi_layer_reflectance.h
+*
+*   The standalone demos run the same modules: most are a main that hands their technique to
+*   technique_demo.h, the ones with pass experiments (material grid, pre-pass, deferred, CPU
+*   raster) keep their own loop around the hooks and reach into the module's state for them
+*
+*   Most demos are one program with the same few uniforms and a couple of float sliders, the
+*   basic technique below runs all of them from a BasicTechnique description. Define
+*   TECHNIQUE_IMPLEMENTATION in exactly one translation unit before including this file
+*
+**********************************************************************************************/
+
+#ifndef TECHNIQUE_H
+#define TECHNIQUE_H
+
+#include <stddef.h>
+#include "raylib.h"
+#include "../common/env_assets.h"
+#include "../common/hdr_target.h"
+#include "../common/headless.h"
+#include "../common/light_clusters.h"
+#include "../common/material_block.h"
+
+// Meshes shared by the techniques, generated once by the lab
+#define TECHNIQUE_MESH_TORUS            0       // 24x48, most demos
+#define TECHNIQUE_MESH_TORUS_DENSE      1       // 48x96 with tangents, Cook-Torrance and the layered materials
+#define TECHNIQUE_MESH_TORUS_FINE       2       // 64x128 with tangents, Ashikhmin-Shirley
+#define TECHNIQUE_MESH_SPHERE           3       // 48x48, ambient IBL
+#define TECHNIQUE_MESH_COUNT            4
+
+// Technique flags
+#define TECHNIQUE_LIGHTS                1       // Reads the clustered point lights, the lab bins them and shows the Lights slider
+
+// Every level of the sky, the lab loads them all
+#define ENV_ASSET_ALL                   (ENV_ASSET_SKYBOX | ENV_ASSET_IRRADIANCE | ENV_ASSET_PREFILTER)
+
+// Main light of every technique, static uniforms
+#define TECHNIQUE_LIGHT_POS             (Vector3){ 5.0f, 5.0f, 5.0f }
+#define TECHNIQUE_LIGHT_COLOR           (Vector3){ 1.0f, 1.0f, 1.0f }
+
+// Assets loaded once by the lab or a demo, shared by every technique
+typedef struct TechniqueAssets {
+    const EnvAssets *sky;                       // Skybox, SH9 irradiance and prefiltered cubemap, may still stream in
+    Texture2D dfgLut;                           // Split-sum DFG table baked by tools/dfg_lut
+    Mesh meshes[TECHNIQUE_MESH_COUNT];
+} TechniqueAssets;
+
+// What changes every frame
+typedef struct TechniqueFrame {
+    Camera camera;
+    Matrix transform;                           // Model rotation of the frame
+    int width;                                  // Viewport size, pixels
+    int height;
+    int envChanged;                             // ENV_ASSET_* flags to send again
+    const HeadlessRun *run;                     // Bench sweeps
+    const LightClusters *clusters;              // Point lights of the frame, TECHNIQUE_LIGHTS only
+} TechniqueFrame;
+
+typedef struct Technique Technique;
+
+struct Technique {
+    const char *name;                           // --technique and the bench results, the demo's executable name
+    const char *title;                          // Info text
+    int flags;                                  // TECHNIQUE_* flags
+    int envAssets;                              // ENV_ASSET_* levels of the sky it reads, its demo loads only those
+    float exposure;                             // Tone map exposure of the demo (see common/hdr_target.h)
+    const void *desc;                           // Module data the hooks read, e.g. the shader files
+
+    void *(*Init)(const Technique *technique, const TechniqueAssets *assets);
+    void (*Update)(void *state, const TechniqueFrame *frame);
+    void (*Draw)(void *state, const TechniqueFrame *frame);
+    void (*DrawGui)(void *state, int screenWidth, int screenHeight);
+    void (*Unload)(void *state);
+};
+
+// Float slider of a technique, drawn in a column from the top left
+typedef struct TechniqueSlider {
+    const char *label;
+    const char *uniform;                        // Float uniform it sets, NULL when the module derives its own
+    const char *sweep;                          // --sweep name
+    float value;                                // Startup value
+    float min;
+    float max;
+} TechniqueSlider;
+
+// Slider over one MaterialParams field, for the techniques with a material block
+typedef struct MaterialSlider {
+    const char *label;
+    const char *sweep;                          // --sweep name
+    size_t offset;                              // offsetof(MaterialParams, field)
+    float min;
+    float max;
+} MaterialSlider;
+
+// Uniforms of the basic technique programs
+#define BASIC_LIGHT_POS                 1
+#define BASIC_LIGHT_COLOR               2
+#define BASIC_OBJECT_COLOR              4
+#define BASIC_VIEW_POS                  8
+#define BASIC_IRRADIANCE                16      // shIrradiance, the sky SH9
+#define BASIC_PREFILTER                 32      // prefilterMap and prefilterMaxLod
+
+#define BASIC_MAX_SLIDERS               4
+
+// One program, the BASIC_* uniforms it declares and its sliders
+typedef struct BasicTechnique {
+    const char *vsFileName;
+    const char *fsFileName;
+    int uniforms;                               // BASIC_* flags
+    int mesh;                                   // TECHNIQUE_MESH_*
+    Vector3 objectColor;
+    int sliderCount;
+    TechniqueSlider sliders[BASIC_MAX_SLIDERS];
+} BasicTechnique;
+
+typedef struct BasicState {
+    const Technique *technique;
+    const BasicTechnique *desc;
+    const EnvAssets *sky;
+    Shader shader;
+    Material material;                          // The shader and the object color, the maps bind the shared textures
+    Mesh mesh;
+    int viewPosLoc;
+    int shIrradianceLoc;
+    int sliderLocs[BASIC_MAX_SLIDERS];
+    float values[BASIC_MAX_SLIDERS];            // Slider values
+} BasicState;
+
+// Roughness, metallic, IOR and alpha of the Cook-Torrance base layer
+extern const MaterialSlider baseLayerSliders[4];
+
+TechniqueAssets LoadTechniqueAssets(const EnvAssets *sky);         // DFG table and every mesh, the sky stays the caller's
+void UnloadTechniqueAssets(TechniqueAssets *assets);
+
+void InitBasicState(BasicState *state, const Technique *technique, const TechniqueAssets *assets);     // Into a caller's struct, for modules that extend it
+void UnloadBasicState(BasicState *state);
+
+void *InitBasicTechnique(const Technique *technique, const TechniqueAssets *assets);
+void UpdateBasicTechnique(void *state, const TechniqueFrame *frame);
+void DrawBasicTechnique(void *state, const TechniqueFrame *frame);
+void DrawBasicTechniqueGui(void *state, int screenWidth, int screenHeight);
+void UnloadBasicTechnique(void *state);
+
+void UpdateMaterialSliders(MaterialParams *params, const MaterialSlider *sliders, int count, const HeadlessRun *run);  // Bench sweeps
+void DrawMaterialSliders(MaterialParams *params, const MaterialSlider *sliders, int count, int x, int y);             // A column from (x, y)
+
+#endif // TECHNIQUE_H
+
+#if defined(TECHNIQUE_IMPLEMENTATION) && !defined(TECHNIQUE_IMPLEMENTED)
+#define TECHNIQUE_IMPLEMENTED
+
+#include "raymath.h"
+#include "raygui.h"
+#include "../common/env_dfg.h"
+#include "../common/shader_cache.h"
+
+const MaterialSlider baseLayerSliders[4] = {
+    { "Roughness", "roughness", offsetof(MaterialParams, roughness), 0.0f, 1.0f },
+    { "Metallic", "metallic", offsetof(MaterialParams, metallic), 0.0f, 1.0f },
+    { "IOR", "ior", offsetof(MaterialParams, ior), 1.0f, 3.5f },
+    { "Alpha", "alpha", offsetof(MaterialParams, alpha), 0.0f, 1.0f },
+};
+
+TechniqueAssets LoadTechniqueAssets(const EnvAssets *sky)
+{
+    TechniqueAssets assets = { 0 };
+
+    assets.sky = sky;
+    assets.dfgLut = LoadTextureDFG("resources/dfg_lut.bin");
+    assets.meshes[TECHNIQUE_MESH_TORUS] = GenMeshTorus(0.4f, 1.0f, 24, 48);
+    assets.meshes[TECHNIQUE_MESH_TORUS_DENSE] = GenMeshTorus(0.4f, 1.0f, 48, 96);
+    assets.meshes[TECHNIQUE_MESH_TORUS_FINE] = GenMeshTorus(0.4f, 1.0f, 64, 128);
+    assets.meshes[TECHNIQUE_MESH_SPHERE] = GenMeshSphere(0.4f, 48, 48);
+
+    // Generate tangents
+    GenMeshTangents(&assets.meshes[TECHNIQUE_MESH_TORUS_DENSE]);
+    GenMeshTangents(&assets.meshes[TECHNIQUE_MESH_TORUS_FINE]);
+
+    return assets;
+}
+
+void UnloadTechniqueAssets(TechniqueAssets *assets)
+{
+    UnloadTexture(assets->dfgLut);
+    for (int m = 0; m < TECHNIQUE_MESH_COUNT; m++) UnloadMesh(assets->meshes[m]);
+}
+
+void InitBasicState(BasicState *state, const Technique *technique, const TechniqueAssets *assets)
+{
+    const BasicTechnique *desc = (const BasicTechnique *)technique->desc;
+
+    state->technique = technique;
+    state->desc = desc;
+    state->sky = assets->sky;
+    state->mesh = assets->meshes[desc->mesh];
+
+    // Load the shaders, the material draws the shared mesh with them. The demos tinted their model with
+    // the object color, so does the diffuse map color here
+    state->shader = LoadShaderCached(desc->vsFileName, desc->fsFileName);
+    state->material = LoadMaterialDefault();
+    state->material.shader = state->shader;
+    state->material.maps[MATERIAL_MAP_DIFFUSE].color = ColorFromNormalized((Vector4){ desc->objectColor.x, desc->objectColor.y, desc->objectColor.z, 1.0f });
+
+    Shader shader = state->shader;
+
+    // Set static uniform values
+    Vector3 lightPos = TECHNIQUE_LIGHT_POS;
+    Vector3 lightColor = TECHNIQUE_LIGHT_COLOR;
+
+    if (desc->uniforms & BASIC_LIGHT_POS) SetShaderValue(shader, GetShaderLocation(shader, "lightPos"), &lightPos, SHADER_UNIFORM_VEC3);
+    if (desc->uniforms & BASIC_LIGHT_COLOR) SetShaderValue(shader, GetShaderLocation(shader, "lightColor"), &lightColor, SHADER_UNIFORM_VEC3);
+    if (desc->uniforms & BASIC_OBJECT_COLOR) SetShaderValue(shader, GetShaderLocation(shader, "objectColor"), &desc->objectColor, SHADER_UNIFORM_VEC3);
+
+    // Sent every frame, or when the sky changes
+    state->viewPosLoc = (desc->uniforms & BASIC_VIEW_POS)? GetShaderLocation(shader, "viewPos") : -1;
+    state->shIrradianceLoc = (desc->uniforms & BASIC_IRRADIANCE)? GetShaderLocation(shader, "shIrradiance") : -1;
+
+    // Bind the prefiltered environment map
+    if (desc->uniforms & BASIC_PREFILTER)
+    {
+        float prefilterMaxLod = (float)(ENV_PREFILTER_ROUGHNESS_LEVELS - 1);
+        SetShaderValue(shader, GetShaderLocation(shader, "prefilterMaxLod"), &prefilterMaxLod, SHADER_UNIFORM_FLOAT);
+        state->material.maps[MATERIAL_MAP_PREFILTER].texture = assets->sky->prefilter;
+        shader.locs[SHADER_LOC_MAP_PREFILTER] = GetShaderLocation(shader, "prefilterMap");
+    }
+
+    // Sliders start at the demos' values
+    for (int i = 0; i < desc->sliderCount; i++)
+    {
+        const TechniqueSlider *slider = &desc->sliders[i];
+
+        state->values[i] = slider->value;
+        state->sliderLocs[i] = (slider->uniform != NULL)? GetShaderLocation(shader, slider->uniform) : -1;
+        if (state->sliderLocs[i] != -1) SetShaderValue(shader, state->sliderLocs[i], &state->values[i], SHADER_UNIFORM_FLOAT);
+    }
+}
+
+void UnloadBasicState(BasicState *state)
+{
+    // The maps hold the lab's textures, only the array goes
+    RL_FREE(state->material.maps);
+    UnloadShader(state->shader);
+}
+
+void *InitBasicTechnique(const Technique *technique, const TechniqueAssets *assets)
+{
+    BasicState *state = (BasicState *)RL_CALLOC(1, sizeof(BasicState));
+    InitBasicState(state, technique, assets);
+
+    return state;
+}
+
+void UpdateBasicTechnique(void *state, const TechniqueFrame *frame)
+{
+    BasicState *basic = (BasicState *)state;
+    const BasicTechnique *desc = basic->desc;
+
+    // Update camera position every frame
+    if (basic->viewPosLoc != -1)
+    {
+        float cameraPos[3] = { frame->camera.position.x, frame->camera.position.y, frame->camera.position.z };
+        SetShaderValue(basic->shader, basic->viewPosLoc, cameraPos, SHADER_UNIFORM_VEC3);
+    }
+
+    if ((frame->envChanged & ENV_ASSET_IRRADIANCE) && (basic->shIrradianceLoc != -1)) SetShaderValueSH9(basic->shader, basic->shIrradianceLoc, basic->sky->irradiance);
+
+    // Bench runs may sweep one slider over the measured frames (--sweep), the uniforms follow the sliders
+    for (int i = 0; i < desc->sliderCount; i++)
+    {
+        const TechniqueSlider *slider = &desc->sliders[i];
+
+        basic->values[i] = GetHeadlessSweep(frame->run, slider->sweep, basic->values[i], slider->min, slider->max);
+        if (basic->sliderLocs[i] != -1) SetShaderValue(basic->shader, basic->sliderLocs[i], &basic->values[i], SHADER_UNIFORM_FLOAT);
+    }
+
+    if ((basic->technique->flags & TECHNIQUE_LIGHTS) && (frame->clusters != NULL)) SetShaderLightClusters(basic->shader, frame->clusters);
+}
+
+void DrawBasicTechnique(void *state, const TechniqueFrame *frame)
+{
+    BasicState *basic = (BasicState *)state;
+
+    DrawMesh(basic->mesh, basic->material, frame->transform);
+}
+
+void DrawBasicTechniqueGui(void *state, int screenWidth, int screenHeight)
+{
+    BasicState *basic = (BasicState *)state;
+    const BasicTechnique *desc = basic->desc;
+
+    for (int i = 0; i < desc->sliderCount; i++)
+    {
+        const TechniqueSlider *slider = &desc->sliders[i];
+        int y = 40 + 30*i;
+
+        DrawText(slider->label, 10, y, 20, BLACK);
+        GuiSlider((Rectangle){ 150, y, 200, 20 }, "", TextFormat("%.2f", basic->values[i]), &basic->values[i], slider->min, slider->max);
+    }
+}
+
+void UnloadBasicTechnique(void *state)
+{
+    UnloadBasicState((BasicState *)state);
+    RL_FREE(state);
+}
+
+void UpdateMaterialSliders(MaterialParams *params, const MaterialSlider *sliders, int count, const HeadlessRun *run)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float *value = (float *)((char *)params + sliders[i].offset);
+        *value = GetHeadlessSweep(run, sliders[i].sweep, *value, sliders[i].min, sliders[i].max);
+    }
+}
+
+void DrawMaterialSliders(MaterialParams *params, const MaterialSlider *sliders, int count, int x, int y)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float *value = (float *)((char *)params + sliders[i].offset);
+
+        DrawText(sliders[i].label, x, y + 30*i, 20, BLACK);
+        GuiSlider((Rectangle){ x + 120, y + 30*i, 200, 20 }, "", TextFormat("%.2f", *value), value, sliders[i].min, sliders[i].max);
+    }
+}
+
+#endif // TECHNIQUE_IMPLEMENTATION
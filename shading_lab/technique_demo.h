@@ -0,0 +1,290 @@
+/**********************************************************************************************
+*
+*   technique_demo - One shading lab technique in a window of its own, the main of its demo
+*
+*   Define TECHNIQUE_DEMO_IMPLEMENTATION in exactly one translation unit before including it
+*
+*   A demo without pass experiments is this host running the technique module the lab runs
+*   (see technique.h), so a program, uniform or slider change reaches both at once:
+*
+*       int main(int argc, char *argv[])
+*       {
+*           return RunTechniqueDemo(argc, argv, &diffuseLambertTechnique, "resources/sky1_2k.jpg", 0);
+*       }
+*
+*   The host brings what the lab brings to one viewport: the window (windowFlags go to
+*   SetConfigFlags(), F11 toggles borderless fullscreen), the orbit camera, the sky with only
+*   the levels the technique reads (Technique.envAssets), the skybox, the meshes, the point
+*   lights of TECHNIQUE_LIGHTS techniques (--lights N, --sweep lights), the float target at the
+*   technique's exposure, the pass timer and the headless and bench options. The demos with
+*   pass experiments keep their own loop and call the hooks themselves
+*
+**********************************************************************************************/
+
+#ifndef TECHNIQUE_DEMO_H
+#define TECHNIQUE_DEMO_H
+
+#include "technique.h"
+
+int RunTechniqueDemo(int argc, char *argv[], const Technique *technique, const char *skyFileName, unsigned int windowFlags);    // Returns the exit code of main()
+
+#endif // TECHNIQUE_DEMO_H
+
+#if defined(TECHNIQUE_DEMO_IMPLEMENTATION) && !defined(TECHNIQUE_DEMO_IMPLEMENTED)
+#define TECHNIQUE_DEMO_IMPLEMENTED
+
+#include <stdlib.h>
+#include <string.h>
+#include "raymath.h"
+#include "raygui.h"
+#include "rlgl.h"
+#include "../common/pass_timer.h"
+#include "../common/shader_cache.h"
+
+// Passes timed every frame, the clusters only for the techniques with point lights
+#define TECHNIQUE_DEMO_PASS_SKY         0
+#define TECHNIQUE_DEMO_PASS_MODEL       1
+#define TECHNIQUE_DEMO_PASS_TONEMAP     2
+#define TECHNIQUE_DEMO_PASS_GUI         3
+#define TECHNIQUE_DEMO_PASS_CLUSTERS    4
+
+int RunTechniqueDemo(int argc, char *argv[], const Technique *technique, const char *skyFileName, unsigned int windowFlags)
+{
+    // Set window dimensions
+    const int screenWidth = 800;
+    const int screenHeight = 800;
+
+    if (windowFlags != 0) SetConfigFlags(windowFlags);
+
+    // Read the headless options, --headless renders offscreen into a hidden window
+    HeadlessRun headless = ParseHeadlessArgs(argc, argv, screenWidth, screenHeight);
+
+    // Initialize the window
+    InitHeadlessWindow(&headless, "Shading Lab");
+
+    // Define the camera
+    Camera camera = { 0 };
+    camera.position = (Vector3){2.0f, 1.0f, 0.0f };
+    camera.target = (Vector3){ 0.0f, 0.0f, 0.0f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 45.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    // Variables for camera orbiting
+    float yaw = 0.0f;
+    float pitch = 0.0f;
+    float radius = 2.5f;
+
+    // Start loading the sky on a worker thread, the levels the technique reads. Grey placeholders are bound
+    // until the data streams in. Baked on the first run, mapped back from the caches next to the panorama
+    // afterwards, the cold and warm start times are logged
+    // Headless and bench runs load it in full before the first frame, so every run renders the same sky
+    EnvAssets sky = ((headless.enabled || headless.bench)? LoadEnvAssets : LoadEnvAssetsAsync)(skyFileName, ENV_ASSET_SKYBOX | technique->envAssets);
+
+    // Create skybox cube mesh
+    Mesh cube = GenMeshCube(100.0f, 100.0f, 100.0f);
+    Model skybox = LoadModelFromMesh(cube);
+
+    // Load skybox shader and set the cubemap
+    skybox.materials[0].shader = LoadShaderCached("resources/skybox.vs", "resources/skybox.fs");
+
+    // Raylib binds MATERIAL_MAP_CUBEMAP as a cube texture, the shader samples it with the view direction
+    skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = sky.skybox;
+    skybox.materials[0].shader.locs[SHADER_LOC_MAP_CUBEMAP] = GetShaderLocation(skybox.materials[0].shader, "environmentMap");
+
+    // The lab's meshes and DFG table, then the technique: programs, uniforms and sliders
+    TechniqueAssets assets = LoadTechniqueAssets(&sky);
+    void *state = technique->Init(technique, &assets);
+    int envPending = technique->envAssets;
+
+    // Point lights on top of the main one, binned into the clusters of the view every frame, so every fragment
+    // only loops over the lights that reach it. --lights N starts with N of them
+    bool lit = (technique->flags & TECHNIQUE_LIGHTS) != 0;
+    const int maxLights = 4096;
+    float lightCountValue = 0.0f;
+    for (int i = 1; lit && (i + 1 < argc); i++)
+    {
+        if (strcmp(argv[i], "--lights") == 0) lightCountValue = Clamp((float)atoi(argv[i + 1]), 0.0f, (float)maxLights);
+    }
+
+    ClusterLight *pointLights = lit? (ClusterLight *)RL_CALLOC(maxLights, sizeof(ClusterLight)) : NULL;
+    LightClusters clusters = lit? LoadLightClusters() : (LightClusters){ 0 };
+
+    // The scene goes to a float target the size of the frame, one pass exposes and tone maps all of it
+    HdrTarget hdr = LoadHdrTarget(headless.enabled? headless.width : GetRenderWidth(), headless.enabled? headless.height : GetRenderHeight(),
+        ParseHdrArgs(argc, argv, technique->exposure));
+
+    // Time the passes of every frame, T shows the overlay (off in headless and bench runs) and
+    // --timings FILE.csv keeps every sample
+    const char *passNames[] = { "Sky", "Model", "Tonemap", "GUI", "Clusters" };
+    PassTimer timer = LoadPassTimer(passNames, lit? 5 : 4);
+    timer.output = ParsePassTimerArgs(argc, argv);
+    bool showTimings = !headless.enabled && !headless.bench;
+
+    // Lock the frames rate, headless and bench runs are not capped
+    if (!headless.enabled && !headless.bench) SetTargetFPS(60);
+
+    // Bench runs keep the startup slider values, or the swept one
+    if (headless.bench) GuiLock();
+
+    // Main render loop
+    while (!HeadlessShouldClose(&headless))
+    {
+        // Collect the pass times of the frame the GPU finished
+        UpdatePassTimer(&timer);
+        if (IsKeyPressed(KEY_T)) showTimings = !showTimings;
+
+        // Upload the environment levels the loader thread finished since the last frame, the technique sends
+        // them on its update
+        envPending |= UpdateEnvAssets(&sky);
+
+        // Fullscreen borderless
+        if (IsKeyPressed(KEY_F11))
+        {
+            ToggleBorderlessWindowed();
+        }
+
+        // Camera orbit controls
+        if (IsMouseButtonDown(MOUSE_MIDDLE_BUTTON))
+        {
+            Vector2 delta = GetMouseDelta();
+
+            yaw   -= delta.x * 0.01f;
+            pitch += delta.y * 0.01f;
+
+            // Clamp pitch so camera doesn't flip
+            pitch = Clamp(pitch, -PI/2 + 0.1f, PI/2 - 0.1f);
+        }
+
+        // Zoom
+        float wheel = GetMouseWheelMove();
+        radius -= wheel * 0.2f;
+        radius = Clamp(radius, 1.0f, 10.0f);
+
+        // Bench runs follow a fixed orbit instead
+        UpdateHeadlessOrbit(&headless, &yaw, &pitch);
+
+        // Spherical to cartesian
+        camera.position.x = radius * cosf(pitch) * sinf(yaw);
+        camera.position.y = radius * sinf(pitch);
+        camera.position.z = radius * cosf(pitch) * cosf(yaw);
+
+        camera.target = (Vector3){ 0.0f, 0.0f, 0.0f};
+
+        // Bench runs may sweep one slider over the measured frames (--sweep), the technique sweeps its own
+        if (lit) lightCountValue = GetHeadlessSweep(&headless, "lights", lightCountValue, 0.0f, (float)maxLights);
+
+        // Rotate the torus over time
+        static float angle = 0.0f;
+        angle += 0.01f;
+
+        TechniqueFrame frame = { 0 };
+        frame.camera = camera;
+        frame.transform = MatrixMultiply(MatrixRotateZ(angle), MatrixRotateX(DEG2RAD * 90.0f));
+        frame.width = headless.enabled? headless.width : GetRenderWidth();
+        frame.height = headless.enabled? headless.height : GetRenderHeight();
+        frame.envChanged = envPending;
+        frame.run = &headless;
+        frame.clusters = lit? &clusters : NULL;
+        envPending = 0;
+
+        // Move the point lights and bin them for this view, the shader reads the lists from buffer textures
+        int lightCount = (int)lightCountValue;
+        if (lit)
+        {
+            BeginPassTimer(&timer, TECHNIQUE_DEMO_PASS_CLUSTERS);
+            AnimateClusterLights(pointLights, lightCount, angle);
+            BuildLightClusters(&clusters, pointLights, lightCount, camera, frame.width, frame.height);
+            UploadLightClusters(&clusters);
+            EndPassTimer(&timer);
+        }
+
+        // Camera position, sweeps, sliders and lights to the uniforms
+        technique->Update(state, &frame);
+
+        // Start rendering a new frame
+        BeginHeadlessDrawing(&headless);
+
+        // Draw the scene into the float target, the background included
+        BeginHdrMode(&hdr);
+
+        // Clear the screen with an off-white background
+        ClearBackground((Color){200, 200, 200, 255});
+
+        // Switch to 3D rendering using the given camera
+        BeginMode3D(camera);
+
+        // Draw skybox (disable depth writing so it's always in background)
+        BeginPassTimer(&timer, TECHNIQUE_DEMO_PASS_SKY);
+        rlDisableBackfaceCulling();
+        rlDisableDepthMask();
+        DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
+        rlEnableBackfaceCulling();
+        rlEnableDepthMask();
+        EndPassTimer(&timer);
+
+        // Draw the technique's model
+        BeginPassTimer(&timer, TECHNIQUE_DEMO_PASS_MODEL);
+        technique->Draw(state, &frame);
+        EndPassTimer(&timer);
+
+        // Exit 3D mode and return to 2D rendering
+        EndMode3D();
+
+        // Back to the frame, the scene exposed and tone mapped into it
+        EndHdrMode(&hdr);
+
+        BeginPassTimer(&timer, TECHNIQUE_DEMO_PASS_TONEMAP);
+        DrawHdrToneMap(&hdr);
+        EndPassTimer(&timer);
+
+        // GUI laid out on the frame size, which --size or a window resize can change
+        const int guiWidth = GetHeadlessScreenWidth(&headless);
+        const int guiHeight = GetHeadlessScreenHeight(&headless);
+
+        // Text and GUI
+        BeginPassTimer(&timer, TECHNIQUE_DEMO_PASS_GUI);
+
+        // Add information text
+        DrawText(technique->title, 10, 10, 20, BLACK);
+
+        // Sliders and dropdowns of the technique
+        technique->DrawGui(state, guiWidth, guiHeight);
+
+        // Draw point light count slider, with the binning time of this frame
+        if (lit)
+        {
+            DrawText("Lights", 10, guiHeight - 60, 20, BLACK);
+            GuiSlider((Rectangle){ 130, guiHeight - 60, 200, 20 }, "", TextFormat("%i", lightCount), &lightCountValue, 0.0f, (float)maxLights);
+            DrawText(TextFormat("Binned in %.2f ms, %i references", clusters.buildTime*1000.0, clusters.indexCount), 410, guiHeight - 60, 20, BLACK);
+        }
+
+        EndPassTimer(&timer);
+
+        // Percentiles of the pass times over the last frames
+        if (showTimings) DrawPassTimer(&timer, guiWidth - 330, 230);
+
+        // Finish the frame and present it on screen
+        EndHeadlessDrawing(&headless);
+    }
+
+    // Cleanup
+    technique->Unload(state);
+    UnloadEnvAssets(sky);
+    UnloadTechniqueAssets(&assets);
+    skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = (Texture2D){ 0 };    // The sky's, UnloadEnvAssets() deleted it
+    UnloadModel(skybox);
+    if (lit)
+    {
+        UnloadLightClusters(&clusters);
+        RL_FREE(pointLights);
+    }
+    UnloadHdrTarget(hdr);
+    UnloadPassTimer(&timer);
+    UnloadHeadlessRun(&headless);
+    CloseWindow();
+
+    return 0;
+}
+
+#endif // TECHNIQUE_DEMO_IMPLEMENTATION
@@ -0,0 +1,131 @@
+/**********************************************************************************************
+*
+*   viewport_grid - Side by side viewports of one render target, for the shading lab's compare
+*                   mode
+*
+*   Define VIEWPORT_GRID_IMPLEMENTATION in exactly one translation unit before including it
+*
+*   N viewports (up to VIEWPORT_GRID_MAX) are laid out in a grid of ceil(sqrt(N)) columns,
+*   every cell the same size, so a 1920x1080 target holds four 959x539 or nine 638x358 cells
+*   with a gap between them. All cells draw into the one target with the same camera:
+*
+*       ViewportGrid grid = LayoutViewportGrid(count, renderWidth, renderHeight);
+*
+*       BeginViewport3D(&grid, i, camera);    // Like BeginMode3D(), with the aspect of the cell
+*           DrawModel(...);
+*       EndViewport3D(&grid);                 // Back to the whole target, for 2D drawing
+*
+*   A cell is a GL viewport, nothing is drawn outside it, one clear covers them all and there
+*   is no extra target or copy: the cells together shade about as many pixels as the target.
+*   Cells sharing size and camera see the same frustum, so one light cluster build serves them
+*   all, each draw only moves the clusters' origin to its cell (GetViewportOrigin())
+*
+**********************************************************************************************/
+
+#ifndef VIEWPORT_GRID_H
+#define VIEWPORT_GRID_H
+
+#include "raylib.h"
+
+#define VIEWPORT_GRID_MAX       9
+#define VIEWPORT_GRID_GAP       2       // Pixels between cells, the clear color shows through
+
+typedef struct ViewportGrid {
+    int count;
+    int columns;
+    int rows;
+    int targetWidth;                    // Render target size, pixels
+    int targetHeight;
+    int cellWidth;                      // Size of every cell, pixels
+    int cellHeight;
+    Rectangle cells[VIEWPORT_GRID_MAX]; // Top left origin, like 2D drawing
+} ViewportGrid;
+
+ViewportGrid LayoutViewportGrid(int count, int width, int height);                  // Cells of count viewports, one fills the target
+Vector2 GetViewportOrigin(const ViewportGrid *grid, int index);                     // Lower left pixel of a cell, GL window coordinates
+void BeginViewport3D(const ViewportGrid *grid, int index, Camera camera);           // 3D mode clipped to a cell, perspective cameras only
+void EndViewport3D(const ViewportGrid *grid);                                       // Back to the whole target
+
+#endif // VIEWPORT_GRID_H
+
+#if defined(VIEWPORT_GRID_IMPLEMENTATION) && !defined(VIEWPORT_GRID_IMPLEMENTED)
+#define VIEWPORT_GRID_IMPLEMENTED
+
+#include <math.h>
+#include "raymath.h"
+#include "rlgl.h"               // RL_CULL_DISTANCE_NEAR/FAR, same planes as BeginMode3D()
+
+ViewportGrid LayoutViewportGrid(int count, int width, int height)
+{
+    ViewportGrid grid = { 0 };
+
+    grid.count = (count < 1)? 1 : (count > VIEWPORT_GRID_MAX)? VIEWPORT_GRID_MAX : count;
+    grid.columns = (int)ceilf(sqrtf((float)grid.count));
+    grid.rows = (grid.count + grid.columns - 1)/grid.columns;
+    grid.targetWidth = width;
+    grid.targetHeight = height;
+    grid.cellWidth = (width - (grid.columns - 1)*VIEWPORT_GRID_GAP)/grid.columns;
+    grid.cellHeight = (height - (grid.rows - 1)*VIEWPORT_GRID_GAP)/grid.rows;
+
+    // Row major from the top left, a short last row leaves its last cells empty
+    for (int i = 0; i < grid.count; i++)
+    {
+        grid.cells[i].x = (float)((i%grid.columns)*(grid.cellWidth + VIEWPORT_GRID_GAP));
+        grid.cells[i].y = (float)((i/grid.columns)*(grid.cellHeight + VIEWPORT_GRID_GAP));
+        grid.cells[i].width = (float)grid.cellWidth;
+        grid.cells[i].height = (float)grid.cellHeight;
+    }
+
+    return grid;
+}
+
+Vector2 GetViewportOrigin(const ViewportGrid *grid, int index)
+{
+    Rectangle cell = grid->cells[index];
+
+    // GL rows go bottom to top
+    return (Vector2){ cell.x, (float)grid->targetHeight - (cell.y + cell.height) };
+}
+
+void BeginViewport3D(const ViewportGrid *grid, int index, Camera camera)
+{
+    Vector2 origin = GetViewportOrigin(grid, index);
+
+    // What the batch still holds was drawn for the previous viewport
+    rlDrawRenderBatchActive();
+    rlViewport((int)origin.x, (int)origin.y, grid->cellWidth, grid->cellHeight);
+
+    // Projection of the cell, BeginMode3D() would take the aspect of the whole target
+    rlMatrixMode(RL_PROJECTION);
+    rlPushMatrix();
+    rlLoadIdentity();
+
+    double aspect = (double)grid->cellWidth/(double)grid->cellHeight;
+    double top = RL_CULL_DISTANCE_NEAR*tan(camera.fovy*0.5*DEG2RAD);
+    double right = top*aspect;
+    rlFrustum(-right, right, -top, top, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+
+    rlMatrixMode(RL_MODELVIEW);
+    rlLoadIdentity();
+
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    rlMultMatrixf(MatrixToFloat(view));
+
+    rlEnableDepthTest();
+}
+
+void EndViewport3D(const ViewportGrid *grid)
+{
+    rlDrawRenderBatchActive();
+
+    rlMatrixMode(RL_PROJECTION);
+    rlPopMatrix();
+
+    rlMatrixMode(RL_MODELVIEW);
+    rlLoadIdentity();
+
+    rlViewport(0, 0, grid->targetWidth, grid->targetHeight);
+    rlDisableDepthTest();
+}
+
+#endif // VIEWPORT_GRID_IMPLEMENTATION
@@ -0,0 +1,184 @@
+/*
+-> Throughput and accuracy check of common/brdf.h, no window is opened
+-> Build it like the demos (F5 on this file), add -mavx2 (or -march=native) to CFLAGS for the AVX2 path
+-> Run it from the repository root (resources/dfg_lut.bin feeds the accurate multiscatter term)
+-> Usage: brdf_bench [samples]
+-> For every model, and every D/G/F/multiscatter variant of Cook-Torrance, it prints the evaluation rate of the
+   scalar reference and of EvalBrdf(), and the largest relative difference between the two
+*/
+
+#define BRDF_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "raylib.h"
+#include "../../common/brdf.h"
+#include "../../common/parallel.h"     // GetMonotonicTime()
+
+#define BENCH_DEFAULT_SAMPLES   (1 << 20)
+#define BENCH_RUNS              3
+#define BENCH_ERROR_FLOOR       1e-3f       // Absolute floor of the relative error, values near 0 are noise
+
+typedef struct BenchCase {
+    const char *name;
+    BrdfMaterial material;
+} BenchCase;
+
+static float RandomFloat(unsigned int *state)
+{
+    *state = *state*1664525u + 1013904223u;
+
+    return (float)(*state >> 8)/16777216.0f;
+}
+
+// Uniform direction on the cap z >= minZ, a third of the light and view samples end up below the horizon
+static void RandomDirection(unsigned int *state, float *x, float *y, float *z, float minZ)
+{
+    float cosTheta = minZ + (1.0f - minZ)*RandomFloat(state);
+    float sinTheta = sqrtf(fmaxf(1.0f - cosTheta*cosTheta, 0.0f));
+    float phi = 2.0f*PI*RandomFloat(state);
+
+    *x = sinTheta*cosf(phi);
+    *y = sinTheta*sinf(phi);
+    *z = cosTheta;
+}
+
+// Best of BENCH_RUNS, in evaluations per second
+static double TimeBrdf(void (*eval)(const BrdfMaterial *, BrdfSamples, BrdfResult), const BrdfMaterial *material, BrdfSamples samples, BrdfResult result)
+{
+    double best = 0.0;
+
+    for (int i = 0; i < BENCH_RUNS; i++)
+    {
+        double startTime = GetMonotonicTime();
+        eval(material, samples, result);
+        double time = GetMonotonicTime() - startTime;
+
+        if ((i == 0) || (time < best)) best = time;
+    }
+
+    return samples.count/best;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = (argc > 1)? atoi(argv[1]) : BENCH_DEFAULT_SAMPLES;
+
+    if (count <= 0)
+    {
+        printf("Usage: brdf_bench [samples]\n");
+        return 1;
+    }
+
+    BrdfDFG dfg = LoadBrdfDFG("resources/dfg_lut.bin");
+    if (dfg.data == NULL) printf("resources/dfg_lut.bin not found, accurate multiscatter is skipped\n");
+
+    // Shading frame is the identity (N = z, T = x, B = y), per sample roughness covers the slider range
+    float *data = (float *)RL_MALLOC((size_t)count*16*sizeof(float));
+    float *zeros = data, *ones = data + count;
+    float *lx = data + 2*count, *ly = data + 3*count, *lz = data + 4*count;
+    float *vx = data + 5*count, *vy = data + 6*count, *vz = data + 7*count;
+    float *roughness = data + 8*count, *metallic = data + 9*count;
+    float *outputs = data + 10*count;
+
+    unsigned int state = 12345u;
+    for (int i = 0; i < count; i++)
+    {
+        zeros[i] = 0.0f;
+        ones[i] = 1.0f;
+        RandomDirection(&state, &lx[i], &ly[i], &lz[i], -0.5f);
+        RandomDirection(&state, &vx[i], &vy[i], &vz[i], -0.5f);
+        roughness[i] = RandomFloat(&state);
+        metallic[i] = RandomFloat(&state);
+    }
+
+    BrdfSamples samples = { 0 };
+    samples.count = count;
+    samples.normal = (BrdfVectors){ zeros, zeros, ones };
+    samples.light = (BrdfVectors){ lx, ly, lz };
+    samples.view = (BrdfVectors){ vx, vy, vz };
+    samples.tangent = (BrdfVectors){ ones, zeros, zeros };
+    samples.bitangent = (BrdfVectors){ zeros, ones, zeros };
+    samples.roughness = roughness;
+    samples.metallic = metallic;
+
+    BrdfResult reference = { outputs, outputs + count, outputs + 2*count };
+    BrdfResult simd = { outputs + 3*count, outputs + 4*count, outputs + 5*count };
+
+    static const char *ndfNames[] = { "Beckmann", "GGX", "GGX aniso", "D off" };
+    static const char *gsfNames[] = { "Kelemen", "Neumann", "Schlick-Disney", "Schlick-Epic", "Smith-Beckmann", "Smith-GGX", "Smith-GGX aniso", "G off" };
+    static const char *fresnelNames[] = { "Schlick", "Dielectric", "Conductor", "F off" };
+    static const char *multiScatterNames[] = { "MS accurate", "MS approx", "MS off" };
+
+    BenchCase cases[32] = { 0 };
+    char names[32][64] = { 0 };
+    int caseCount = 0;
+
+    static const char *modelNames[] = { "Lambert", "Oren-Nayar", "Burley", "Ashikhmin-Shirley diffuse", "Phong", "Blinn-Phong", "Ashikhmin-Shirley" };
+    for (int model = BRDF_MODEL_LAMBERT; model <= BRDF_MODEL_ASHIKHMIN_SHIRLEY; model++)
+    {
+        cases[caseCount].name = modelNames[model];
+        cases[caseCount].material = GetBrdfMaterialDefault((BrdfModel)model);
+        caseCount++;
+    }
+
+    // Cook-Torrance, one varying setting at a time on top of GGX/Smith-GGX/Schlick without multiscatter
+    for (int i = 0; i < 4 + 8 + 4 + 3; i++)
+    {
+        BrdfMaterial material = GetBrdfMaterialDefault(BRDF_MODEL_COOK_TORRANCE);
+        material.ndfType = BRDF_NDF_GGX;
+        material.gsfType = BRDF_GSF_SMITH_GGX;
+        material.fresnelType = BRDF_FRESNEL_SCHLICK;
+        material.multiScatterType = BRDF_MULTISCATTER_DISABLED;
+        material.anisotropy = 0.5f;
+        material.conductorPreset = BRDF_CONDUCTOR_GOLD;
+
+        const char *variant = NULL;
+        if (i < 4) { material.ndfType = i; variant = ndfNames[i]; }
+        else if (i < 12) { material.gsfType = i - 4; variant = gsfNames[i - 4]; }
+        else if (i < 16) { material.fresnelType = i - 12; variant = fresnelNames[i - 12]; }
+        else { material.multiScatterType = i - 16; variant = multiScatterNames[i - 16]; }
+
+        snprintf(names[caseCount], sizeof(names[0]), "Cook-Torrance %s", variant);
+        cases[caseCount].name = names[caseCount];
+        cases[caseCount].material = material;
+        caseCount++;
+    }
+
+    cases[caseCount].name = "Sheen";
+    cases[caseCount].material = GetBrdfMaterialDefault(BRDF_MODEL_SHEEN);
+    cases[caseCount].material.sheenWeight = 1.0f;
+    caseCount++;
+
+    cases[caseCount].name = "Clearcoat";
+    cases[caseCount].material = GetBrdfMaterialDefault(BRDF_MODEL_CLEARCOAT);
+    cases[caseCount].material.clearcoatWeight = 1.0f;
+    caseCount++;
+
+    printf("EvalBrdf: %s, %i threads, %i samples, best of %i runs\n\n", BRDF_BACKEND, GetWorkerCount(), count, BENCH_RUNS);
+    printf("%-36s %14s %14s %9s %12s\n", "model", "scalar (M/s)", "simd (M/s)", "speedup", "max error");
+
+    for (int c = 0; c < caseCount; c++)
+    {
+        BrdfMaterial *material = &cases[c].material;
+        material->dfg = (dfg.data != NULL)? &dfg : NULL;
+
+        double scalarRate = TimeBrdf(EvalBrdfReference, material, samples, reference);
+        double simdRate = TimeBrdf(EvalBrdf, material, samples, simd);
+
+        float maxError = 0.0f;
+        for (int i = 0; i < 3*count; i++)      // r, g and b are consecutive in outputs
+        {
+            float error = fabsf(simd.r[i] - reference.r[i])/fmaxf(fabsf(reference.r[i]), BENCH_ERROR_FLOOR);
+            if (!(error <= maxError)) maxError = error;
+        }
+
+        printf("%-36s %14.1f %14.1f %8.1fx %12.2e\n", cases[c].name, scalarRate*1e-6, simdRate*1e-6, simdRate/scalarRate, maxError);
+    }
+
+    RL_FREE(data);
+    UnloadBrdfDFG(dfg);
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*
+-> Light binning cost of common/light_clusters.h from 1 to 4096 lights, no window is opened
+-> Build it like the demos (F5 on this file), run it from anywhere
+-> Usage: cluster_bench [frames]
+-> Every count is binned for the given number of frames of the demos' animated light field, seen by the demos'
+   startup camera at 800x800. The tool prints the best and the average build time, the light references over
+   all clusters and the most lights any cluster holds
+-> Random probes in the frustum look their cluster up the way the shaders do, every light reaching the probe
+   must be in that cluster's list, the misses column counts those that are not (it should read 0)
+-> Build with -DLIGHT_CLUSTERS_PARALLEL_LIGHTS=65537 to time the single thread path
+-> The shading side scales with the lights per cluster, the demos render it with --headless --frames N --lights K
+   and log the time per frame
+*/
+
+#define LIGHT_CLUSTERS_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "../../common/light_clusters.h"
+
+#define BENCH_DEFAULT_FRAMES    64
+#define BENCH_MAX_LIGHTS        4096
+#define BENCH_PROBES            4096
+#define BENCH_WIDTH             800
+#define BENCH_HEIGHT            800
+
+static float RandomFloat(unsigned int *state)
+{
+    *state = *state*1664525u + 1013904223u;
+
+    return (float)(*state >> 8)/16777216.0f;
+}
+
+// Lights reaching a random point of the frustum that its cluster does not list
+static int CountMisses(const LightClusters *clusters, const ClusterLight *lights, int count, Camera camera, unsigned int *state)
+{
+    Matrix view = GetCameraMatrix(camera);
+    Matrix invView = MatrixInvert(view);
+    float tanY = tanf(camera.fovy*0.5f*DEG2RAD);
+    float tanX = tanY*(float)BENCH_WIDTH/BENCH_HEIGHT;
+    int misses = 0;
+
+    for (int p = 0; p < BENCH_PROBES; p++)
+    {
+        // Pixel center and a view depth between 0.1 and 10, log uniform like the slices
+        float px = floorf(RandomFloat(state)*BENCH_WIDTH) + 0.5f;
+        float py = floorf(RandomFloat(state)*BENCH_HEIGHT) + 0.5f;
+        float depth = 0.1f*powf(100.0f, RandomFloat(state));
+
+        Vector3 viewPosition = { (2.0f*px/BENCH_WIDTH - 1.0f)*tanX*depth, (2.0f*py/BENCH_HEIGHT - 1.0f)*tanY*depth, -depth };
+        Vector3 position = Vector3Transform(viewPosition, invView);
+
+        // Same lookup as the shaders
+        float viewDepth = fmaxf(clusters->viewDepth.x*position.x + clusters->viewDepth.y*position.y + clusters->viewDepth.z*position.z + clusters->viewDepth.w, 0.0001f);
+        int tileX = (int)fminf(px*clusters->scale.x, LIGHT_CLUSTERS_X - 1);
+        int tileY = (int)fminf(py*clusters->scale.y, LIGHT_CLUSTERS_Y - 1);
+        int slice = (int)Clamp(floorf(logf(viewDepth)*clusters->scale.z + clusters->scale.w), 0.0f, LIGHT_CLUSTERS_Z - 1);
+        const unsigned int *cell = clusters->grid + ((slice*LIGHT_CLUSTERS_Y + tileY)*LIGHT_CLUSTERS_X + tileX)*2;
+
+        for (int i = 0; i < count; i++)
+        {
+            if (Vector3Distance(position, lights[i].position) >= lights[i].radius) continue;
+
+            bool listed = false;
+            for (unsigned int j = 0; (j < cell[1]) && !listed; j++) listed = (clusters->indices[cell[0] + j] == i);
+
+            if (!listed) misses++;
+        }
+    }
+
+    return misses;
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = (argc > 1)? atoi(argv[1]) : BENCH_DEFAULT_FRAMES;
+
+    if (frames <= 0)
+    {
+        printf("Usage: cluster_bench [frames]\n");
+        return 1;
+    }
+
+    // The demos' startup view
+    Camera camera = { 0 };
+    camera.position = (Vector3){ 0.0f, 0.0f, 2.5f };
+    camera.target = (Vector3){ 0.0f, 0.0f, 0.0f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 45.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    ClusterLight *lights = (ClusterLight *)RL_MALLOC(BENCH_MAX_LIGHTS*sizeof(ClusterLight));
+    LightClusters clusters = { 0 };     // No buffer textures, only the CPU side is timed
+    unsigned int state = 12345u;
+
+    printf("%ix%ix%i clusters, %ix%i target, %i threads, %i frames per count\n\n", LIGHT_CLUSTERS_X, LIGHT_CLUSTERS_Y, LIGHT_CLUSTERS_Z,
+        BENCH_WIDTH, BENCH_HEIGHT, GetWorkerCount(), frames);
+    printf("%8s %10s %10s %12s %14s %8s\n", "lights", "best ms", "avg ms", "references", "max/cluster", "misses");
+
+    for (int count = 1; count <= BENCH_MAX_LIGHTS; count *= 2)
+    {
+        double best = 0.0;
+        double total = 0.0;
+        int references = 0;
+        int maxCluster = 0;
+        int misses = 0;
+
+        for (int frame = 0; frame < frames; frame++)
+        {
+            AnimateClusterLights(lights, count, frame*0.01f);
+            BuildLightClusters(&clusters, lights, count, camera, BENCH_WIDTH, BENCH_HEIGHT);
+
+            if ((frame == 0) || (clusters.buildTime < best)) best = clusters.buildTime;
+            total += clusters.buildTime;
+            references += clusters.indexCount;
+
+            for (int i = 0; i < LIGHT_CLUSTERS_COUNT; i++)
+            {
+                if ((int)clusters.grid[i*2 + 1] > maxCluster) maxCluster = clusters.grid[i*2 + 1];
+            }
+
+            // The probes are slow, a few frames are enough
+            if (frame < 4) misses += CountMisses(&clusters, lights, count, camera, &state);
+        }
+
+        printf("%8i %10.3f %10.3f %12i %14i %8i\n", count, best*1000.0, total/frames*1000.0, references/frames, maxCluster, misses);
+    }
+
+    UnloadLightClusters(&clusters);
+    RL_FREE(lights);
+
+    return 0;
+}
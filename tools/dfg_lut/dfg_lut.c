@@ -0,0 +1,170 @@
+/*
+-> Offline baker for the split-sum DFG lookup table, no window is opened
+-> Build it like the demos (F5 on this file), run it from the repository root
+-> Usage: dfg_lut [size] [samples]
+-> Writes resources/dfg_lut.bin (RGB16F, loaded by common/env_dfg.h) and resources/dfg_lut.png (preview)
+*/
+
+#define ENV_DFG_IMPLEMENTATION
+#define PARALLEL_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "raylib.h"
+#include "../../common/env_dfg.h"
+#include "../../common/parallel.h"     // GetWorkerCount(), GetMonotonicTime()
+
+#define DFG_DEFAULT_SIZE        128
+#define DFG_DEFAULT_SAMPLES     4096
+
+typedef struct DFGJob {
+    int size;
+    int sampleCount;
+    float *table;           // size*size*3 floats
+} DFGJob;
+
+// Van der Corput radical inverse, second Hammersley coordinate
+static float RadicalInverse(unsigned int bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+    return (float)bits*2.3283064365386963e-10f;
+}
+
+// Height-correlated Smith visibility, G2/(4*NdotL*NdotV) (Heitz 2014)
+static double VisibilitySmithGGXCorrelated(double NdotV, double NdotL, double alpha2)
+{
+    double lambdaV = NdotL*sqrt(NdotV*NdotV*(1.0 - alpha2) + alpha2);
+    double lambdaL = NdotV*sqrt(NdotL*NdotL*(1.0 - alpha2) + alpha2);
+
+    return 0.5/(lambdaV + lambdaL);
+}
+
+// One roughness row: integrate the GGX BRDF over the hemisphere for every NdotV
+static void BakeRow(int y, void *userData)
+{
+    DFGJob *job = (DFGJob *)userData;
+    const int size = job->size;
+
+    double roughness = (y + 0.5)/size;
+    double alpha2 = roughness*roughness;
+    double rowAverage = 0.0;
+
+    for (int x = 0; x < size; x++)
+    {
+        double NdotV = (x + 0.5)/size;
+        double Vx = sqrt(1.0 - NdotV*NdotV);
+        double Vz = NdotV;
+
+        double A = 0.0;
+        double B = 0.0;
+
+        for (int i = 0; i < job->sampleCount; i++)
+        {
+            double xi1 = (double)i/job->sampleCount;
+            double xi2 = RadicalInverse((unsigned int)i);
+
+            // GGX half vector around N = +Z
+            double phi = 2.0*PI*xi1;
+            double cosThetaH = sqrt((1.0 - xi2)/(1.0 + (alpha2 - 1.0)*xi2));
+            double sinThetaH = sqrt(1.0 - cosThetaH*cosThetaH);
+            double Hx = sinThetaH*cos(phi);
+            double Hz = cosThetaH;
+
+            // L = reflect(-V, H), only the z component and VdotH are needed
+            double VdotH = Vx*Hx + Vz*Hz;
+            double NdotL = 2.0*VdotH*Hz - Vz;
+
+            if ((NdotL > 0.0) && (VdotH > 0.0))
+            {
+                // f*NdotL/pdf with pdf = D*NdotH/(4*VdotH), D cancels out
+                double weight = VisibilitySmithGGXCorrelated(NdotV, NdotL, alpha2)*4.0*VdotH*NdotL/Hz;
+                double Fc = pow(1.0 - VdotH, 5.0);
+
+                A += (1.0 - Fc)*weight;
+                B += Fc*weight;
+            }
+        }
+
+        A /= job->sampleCount;
+        B /= job->sampleCount;
+
+        float *texel = job->table + ((size_t)y*size + x)*3;
+        texel[0] = (float)A;
+        texel[1] = (float)B;
+
+        // Eavg = 2*integral(Ess(mu)*mu), midpoint rule over the row
+        rowAverage += 2.0*(A + B)*NdotV/size;
+    }
+
+    for (int x = 0; x < size; x++) job->table[((size_t)y*size + x)*3 + 2] = (float)rowAverage;
+}
+
+int main(int argc, char *argv[])
+{
+    int size = (argc > 1)? atoi(argv[1]) : DFG_DEFAULT_SIZE;
+    int sampleCount = (argc > 2)? atoi(argv[2]) : DFG_DEFAULT_SAMPLES;
+
+    if ((size <= 0) || (sampleCount <= 0))
+    {
+        printf("Usage: dfg_lut [size] [samples]\n");
+        return 1;
+    }
+
+    DFGJob job = { 0 };
+    job.size = size;
+    job.sampleCount = sampleCount;
+    job.table = (float *)RL_MALLOC((size_t)size*size*3*sizeof(float));
+
+    double startTime = GetMonotonicTime();
+    ParallelFor(size, BakeRow, &job);
+    printf("Baked %ix%i DFG LUT with %i samples per texel in %.2f s on %i threads\n", size, size, sampleCount, GetMonotonicTime() - startTime, GetWorkerCount());
+
+    // Raw RGB16F: header + half floats, row 0 is roughness 0
+    DFGLutHeader header = { ENV_DFG_MAGIC, ENV_DFG_VERSION, size, sampleCount };
+    int dataSize = size*size*3*(int)sizeof(unsigned short);
+    unsigned char *fileData = (unsigned char *)RL_MALLOC(sizeof(header) + dataSize);
+    memcpy(fileData, &header, sizeof(header));
+
+    unsigned short *halfs = (unsigned short *)(fileData + sizeof(header));
+    for (int i = 0; i < size*size*3; i++) halfs[i] = FloatToHalf(job.table[i]);
+
+    bool savedRaw = SaveFileData("resources/dfg_lut.bin", fileData, (int)sizeof(header) + dataSize);
+
+    // 8 bit preview, roughness 0 at the bottom like the usual plots
+    Image preview = GenImageColor(size, size, BLACK);
+    ImageFormat(&preview, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+    unsigned char *pixels = (unsigned char *)preview.data;
+
+    for (int y = 0; y < size; y++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            const float *texel = job.table + ((size_t)y*size + x)*3;
+            unsigned char *pixel = pixels + ((size_t)(size - 1 - y)*size + x)*3;
+            for (int c = 0; c < 3; c++) pixel[c] = (unsigned char)(fminf(fmaxf(texel[c], 0.0f), 1.0f)*255.0f + 0.5f);
+        }
+    }
+
+    bool savedPreview = ExportImage(preview, "resources/dfg_lut.png");
+
+    UnloadImage(preview);
+    RL_FREE(fileData);
+    RL_FREE(job.table);
+
+    if (!savedRaw || !savedPreview)
+    {
+        printf("Failed to write resources/dfg_lut.bin or resources/dfg_lut.png, run the tool from the repository root\n");
+        return 1;
+    }
+
+    printf("Wrote resources/dfg_lut.bin and resources/dfg_lut.png\n");
+
+    return 0;
+}
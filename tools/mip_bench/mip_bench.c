@@ -0,0 +1,125 @@
+/*
+-> Benchmark of common/image_mips.h against raylib ImageMipmaps() on the bundled skies, no window is opened
+-> Build it like the demos (F5 on this file), add -mavx2 (or -march=native) to CFLAGS for the AVX2 path
+-> Run it from the repository root
+-> Usage: mip_bench [runs]
+-> For each sky it prints the best time of both generators and how far the 64 texel wide level drifts
+   from the mean linear brightness of the full image (filtering sRGB bytes shows up as darkening)
+*/
+
+#define IMAGE_MIPS_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "raylib.h"
+#include "../../common/image_mips.h"
+#include "../../common/parallel.h"     // GetMonotonicTime()
+
+#define BENCH_DEFAULT_RUNS  5
+#define BENCH_PROBE_WIDTH   64
+
+typedef void (*MipmapsFunc)(Image *image);
+
+static void GenRaylibMipmaps(Image *image)
+{
+    ImageMipmaps(image);
+}
+
+static void GenLinearMipmaps(Image *image)
+{
+    ImageMipmapsLinear(image, IMAGE_MIPS_WRAP_X);
+}
+
+// Mean linear brightness of one level of an RGB8 chain
+static double GetLevelBrightness(Image image, int level)
+{
+    const unsigned char *pixels = (const unsigned char *)image.data;
+    int width = image.width;
+    int height = image.height;
+
+    if (level > image.mipmaps - 1) level = image.mipmaps - 1;
+
+    for (int i = 0; i < level; i++)
+    {
+        pixels += (size_t)width*height*3;
+        width = (width > 1)? width/2 : 1;
+        height = (height > 1)? height/2 : 1;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < width*height*3; i++) sum += SRGBToLinear(pixels[i]);
+
+    return sum/(width*height*3);
+}
+
+// Best of runs, keeps the last chain for the brightness check
+static double TimeMipmaps(Image source, MipmapsFunc generate, int runs, Image *result)
+{
+    double best = 0.0;
+
+    for (int i = 0; i < runs; i++)
+    {
+        Image image = ImageCopy(source);
+
+        double startTime = GetMonotonicTime();
+        generate(&image);
+        double time = GetMonotonicTime() - startTime;
+
+        if ((i == 0) || (time < best)) best = time;
+
+        if (i == runs - 1) *result = image;
+        else UnloadImage(image);
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *skies[] = { "resources/sky1_2k.jpg", "resources/sky2_2k.jpg" };
+    int runs = (argc > 1)? atoi(argv[1]) : BENCH_DEFAULT_RUNS;
+
+    if (runs <= 0)
+    {
+        printf("Usage: mip_bench [runs]\n");
+        return 1;
+    }
+
+    printf("ImageMipmapsLinear: %s, %i threads, best of %i runs\n\n", IMAGE_MIPS_BACKEND, GetWorkerCount(), runs);
+    printf("%-24s %-10s %8s %10s %12s\n", "sky", "generator", "levels", "time (ms)", "brightness");
+
+    for (int i = 0; i < (int)(sizeof(skies)/sizeof(skies[0])); i++)
+    {
+        Image source = LoadImage(skies[i]);
+        if (source.data == NULL)
+        {
+            printf("Failed to load %s, run the tool from the repository root\n", skies[i]);
+            return 1;
+        }
+
+        ImageFormat(&source, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+
+        int probeLevel = 0;
+        while ((source.width >> probeLevel) > BENCH_PROBE_WIDTH) probeLevel++;
+
+        double reference = GetLevelBrightness(source, 0);
+
+        Image raylibChain = { 0 };
+        Image linearChain = { 0 };
+        double raylibTime = TimeMipmaps(source, GenRaylibMipmaps, runs, &raylibChain);
+        double linearTime = TimeMipmaps(source, GenLinearMipmaps, runs, &linearChain);
+
+        // Relative to the full resolution mean, a gamma-correct filter keeps it
+        printf("%-24s %-10s %8i %10.2f %+11.2f%%\n", skies[i], "raylib", raylibChain.mipmaps, raylibTime*1000.0,
+               (GetLevelBrightness(raylibChain, probeLevel)/reference - 1.0)*100.0);
+        printf("%-24s %-10s %8i %10.2f %+11.2f%%\n", "", "linear", linearChain.mipmaps, linearTime*1000.0,
+               (GetLevelBrightness(linearChain, probeLevel)/reference - 1.0)*100.0);
+        printf("%-24s %-10s %8s %9.1fx\n\n", "", "speedup", "", raylibTime/linearTime);
+
+        UnloadImage(raylibChain);
+        UnloadImage(linearChain);
+        UnloadImage(source);
+    }
+
+    return 0;
+}
@@ -0,0 +1,965 @@
+/*
+-> Monte Carlo path tracer for the lighting demo scenes, renders the reference image a demo should converge to, no window is opened
+-> Build it like the demos (F5 on this file), run it from the repository root
+-> Usage: path_trace [model] [--spp N] [--bounces N] [--size WxH] [--sphere R] [--yaw A] [--pitch A] [--radius R]
+                     [--roughness X] [--metallic X] [--weight X] [--sky file] [--output file]
+-> model is one of lambert, oren_nayar, burley, ashikhmin_shirley_diffuse, phong, blinn_phong, ashikhmin_shirley,
+   cook_torrance (default), sheen, clearcoat. Materials start at the demo's slider values (GetBrdfMaterialDefault()),
+   --weight sets the sheen or clearcoat weight
+-> Scene of the demos at startup: the model's GenMeshTorus() tessellation rotated 90 degrees around X (or an analytic
+   sphere of radius R with --sphere), the white point light at (5, 5, 5), the panorama as the environment and the
+   orbit camera (yaw 0, pitch 0, radius 2.5, fovy 45)
+-> Surfaces are shaded with EvalBrdfReference(), the same terms as the .fs files, used as f(l, v)*NdotL for the point
+   light, the sky and the bounces. Point light and sky are both sampled at every hit (sky importance sampling and
+   cosine BRDF sampling combined with the power heuristic), shadows and interreflections are included
+-> Output mimics the demo frame: lit pixels get the shaders' exposure of 3 and no gamma, background pixels show the
+   sky like skybox.fs. A .raw output is float RGB of the same image before clamping, rows top to bottom
+*/
+
+#define BRDF_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "raylib.h"
+#include "../../common/brdf.h"
+#include "../../common/parallel.h"     // GetMonotonicTime()
+
+#define TRACE_DEFAULT_SPP       64
+#define TRACE_DEFAULT_BOUNCES   4
+#define TRACE_TILE_SIZE         16          // Pixels per tile edge, one ParallelFor() task per tile
+#define TRACE_BVH_LEAF_SIZE     4
+#define TRACE_BVH_BINS          12
+#define TRACE_BVH_MAX_DEPTH     64
+#define TRACE_RAY_EPSILON       1e-4f       // Offset of secondary rays along the geometric normal
+#define TRACE_EXPOSURE          3.0f        // Same factor as the .fs files
+
+typedef struct TraceVec {
+    float x, y, z;
+} TraceVec;
+
+typedef struct BvhNode {
+    float boundsMin[3];
+    float boundsMax[3];
+    int start;              // First triangle for leaves, right child for inner nodes (left child is next)
+    int count;              // Triangles in a leaf, 0 for inner nodes
+} BvhNode;
+
+// Triangle mesh with per vertex shading frame, or an analytic sphere when sphereRadius > 0
+typedef struct TraceScene {
+    int vertexCount;
+    TraceVec *positions;
+    TraceVec *normals;
+    TraceVec *tangents;
+    int triangleCount;
+    int *indices;           // 3 per triangle, reordered by the BVH build
+    BvhNode *nodes;
+    int nodeCount;
+    float sphereRadius;
+} TraceScene;
+
+// Panorama with the tables to pick texels proportionally to their share of the sky's power
+typedef struct TraceSky {
+    EnvMap map;
+    float *rowCdf;          // height + 1 entries
+    float *texelCdf;        // height*(width + 1) entries, one table per row
+    float *texelWeight;     // width*height, normalized
+} TraceSky;
+
+typedef struct TraceCamera {
+    TraceVec position;
+    TraceVec forward;
+    TraceVec right;
+    TraceVec up;
+    float tanHalfFovy;
+} TraceCamera;
+
+typedef struct TraceJob {
+    int width;
+    int height;
+    int spp;
+    int maxBounces;
+    int tilesX;
+    const TraceScene *scene;
+    const TraceSky *sky;
+    const BrdfMaterial *material;
+    TraceCamera camera;
+    TraceVec lightPos;
+    TraceVec lightColor;
+    float *image;           // width*height*3, display values before quantization
+    long long rayCount;
+} TraceJob;
+
+typedef struct TraceModelInfo {
+    const char *name;
+    BrdfModel model;
+    int radSeg;             // GenMeshTorus() arguments of the demo
+    int sides;
+} TraceModelInfo;
+
+static const TraceModelInfo traceModels[] = {
+    { "lambert", BRDF_MODEL_LAMBERT, 24, 48 },
+    { "oren_nayar", BRDF_MODEL_OREN_NAYAR, 24, 48 },
+    { "burley", BRDF_MODEL_BURLEY, 24, 48 },
+    { "ashikhmin_shirley_diffuse", BRDF_MODEL_ASHIKHMIN_SHIRLEY_DIFFUSE, 64, 128 },
+    { "phong", BRDF_MODEL_PHONG, 24, 48 },
+    { "blinn_phong", BRDF_MODEL_BLINN_PHONG, 24, 48 },
+    { "ashikhmin_shirley", BRDF_MODEL_ASHIKHMIN_SHIRLEY, 64, 128 },
+    { "cook_torrance", BRDF_MODEL_COOK_TORRANCE, 48, 96 },
+    { "sheen", BRDF_MODEL_SHEEN, 48, 96 },
+    { "clearcoat", BRDF_MODEL_CLEARCOAT, 48, 96 }
+};
+
+//----------------------------------------------------------------------------------
+// Vector helpers
+//----------------------------------------------------------------------------------
+static inline TraceVec VecMake(float x, float y, float z) { return (TraceVec){ x, y, z }; }
+static inline TraceVec VecAdd(TraceVec a, TraceVec b) { return (TraceVec){ a.x + b.x, a.y + b.y, a.z + b.z }; }
+static inline TraceVec VecSub(TraceVec a, TraceVec b) { return (TraceVec){ a.x - b.x, a.y - b.y, a.z - b.z }; }
+static inline TraceVec VecMul(TraceVec a, TraceVec b) { return (TraceVec){ a.x*b.x, a.y*b.y, a.z*b.z }; }
+static inline TraceVec VecScale(TraceVec a, float s) { return (TraceVec){ a.x*s, a.y*s, a.z*s }; }
+static inline float VecDot(TraceVec a, TraceVec b) { return a.x*b.x + a.y*b.y + a.z*b.z; }
+static inline TraceVec VecCross(TraceVec a, TraceVec b) { return (TraceVec){ a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x }; }
+static inline float VecComponent(TraceVec a, int axis) { return (axis == 0)? a.x : (axis == 1)? a.y : a.z; }
+
+static inline TraceVec VecNormalize(TraceVec a)
+{
+    float length = sqrtf(VecDot(a, a));
+    return (length > 0.0f)? VecScale(a, 1.0f/length) : a;
+}
+
+//----------------------------------------------------------------------------------
+// Random numbers, one PCG32 stream per pixel so the image does not depend on the thread count
+//----------------------------------------------------------------------------------
+typedef struct TraceRandom {
+    unsigned long long state;
+    unsigned long long stream;
+} TraceRandom;
+
+static unsigned int RandomNext(TraceRandom *random)
+{
+    unsigned long long old = random->state;
+    random->state = old*6364136223846793005ULL + random->stream;
+    unsigned int xorShifted = (unsigned int)(((old >> 18u) ^ old) >> 27u);
+    unsigned int rot = (unsigned int)(old >> 59u);
+
+    return (xorShifted >> rot) | (xorShifted << ((-rot) & 31u));
+}
+
+static float RandomFloat(TraceRandom *random)
+{
+    return (float)(RandomNext(random) >> 8)/16777216.0f;
+}
+
+static TraceRandom RandomSeed(unsigned int pixel)
+{
+    TraceRandom random = { 0u, ((unsigned long long)pixel << 1u) | 1u };
+    RandomNext(&random);
+    random.state += 0x853c49e6748fea9bULL;
+    RandomNext(&random);
+
+    return random;
+}
+
+//----------------------------------------------------------------------------------
+// Scene
+//----------------------------------------------------------------------------------
+
+// Same surface as raylib's GenMeshTorus() (par_shapes torus scaled by size/2), 'sides' segments around the
+// ring and 'radSeg' around the tube, rotated 90 degrees around X like torus.transform in the demos
+static TraceScene GenTraceTorus(float radius, float size, int radSeg, int sides)
+{
+    TraceScene scene = { 0 };
+    float major = size/2.0f;
+    float minor = radius*size/2.0f;
+
+    scene.vertexCount = (sides + 1)*(radSeg + 1);
+    scene.positions = (TraceVec *)RL_MALLOC(scene.vertexCount*sizeof(TraceVec));
+    scene.normals = (TraceVec *)RL_MALLOC(scene.vertexCount*sizeof(TraceVec));
+    scene.tangents = (TraceVec *)RL_MALLOC(scene.vertexCount*sizeof(TraceVec));
+
+    for (int i = 0; i <= sides; i++)
+    {
+        float theta = 2.0f*PI*i/sides;
+
+        for (int j = 0; j <= radSeg; j++)
+        {
+            float phi = 2.0f*PI*j/radSeg;
+            float ring = major + minor*cosf(phi);
+            int v = i*(radSeg + 1) + j;
+
+            // MatrixRotateX(90 degrees) maps (x, y, z) to (x, -z, y)
+            scene.positions[v] = VecMake(ring*cosf(theta), -minor*sinf(phi), ring*sinf(theta));
+            scene.normals[v] = VecMake(cosf(phi)*cosf(theta), -sinf(phi), cosf(phi)*sinf(theta));
+            scene.tangents[v] = VecMake(-sinf(theta), 0.0f, cosf(theta));
+        }
+    }
+
+    scene.triangleCount = sides*radSeg*2;
+    scene.indices = (int *)RL_MALLOC(scene.triangleCount*3*sizeof(int));
+
+    int *index = scene.indices;
+    for (int i = 0; i < sides; i++)
+    {
+        for (int j = 0; j < radSeg; j++)
+        {
+            int a = i*(radSeg + 1) + j;
+            int b = a + radSeg + 1;
+
+            index[0] = a; index[1] = b; index[2] = b + 1;
+            index[3] = a; index[4] = b + 1; index[5] = a + 1;
+            index += 6;
+        }
+    }
+
+    return scene;
+}
+
+static void GetTriangleBounds(const TraceScene *scene, int triangle, float *boundsMin, float *boundsMax, float *centroid)
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float a = VecComponent(scene->positions[scene->indices[triangle*3 + 0]], axis);
+        float b = VecComponent(scene->positions[scene->indices[triangle*3 + 1]], axis);
+        float c = VecComponent(scene->positions[scene->indices[triangle*3 + 2]], axis);
+
+        boundsMin[axis] = fminf(a, fminf(b, c));
+        boundsMax[axis] = fmaxf(a, fmaxf(b, c));
+        centroid[axis] = (a + b + c)/3.0f;
+    }
+}
+
+static float GetBoundsArea(const float *boundsMin, const float *boundsMax)
+{
+    float dx = boundsMax[0] - boundsMin[0];
+    float dy = boundsMax[1] - boundsMin[1];
+    float dz = boundsMax[2] - boundsMin[2];
+
+    return (dx < 0.0f)? 0.0f : 2.0f*(dx*dy + dy*dz + dz*dx);
+}
+
+static void GrowBounds(float *boundsMin, float *boundsMax, const float *otherMin, const float *otherMax)
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        boundsMin[axis] = fminf(boundsMin[axis], otherMin[axis]);
+        boundsMax[axis] = fmaxf(boundsMax[axis], otherMax[axis]);
+    }
+}
+
+static void SwapTriangles(TraceScene *scene, float *centroids, int a, int b)
+{
+    for (int k = 0; k < 3; k++)
+    {
+        int index = scene->indices[a*3 + k];
+        scene->indices[a*3 + k] = scene->indices[b*3 + k];
+        scene->indices[b*3 + k] = index;
+
+        float centroid = centroids[a*3 + k];
+        centroids[a*3 + k] = centroids[b*3 + k];
+        centroids[b*3 + k] = centroid;
+    }
+}
+
+// Binned SAH split of [start, start + count), returns the node index
+static int BuildBvhNode(TraceScene *scene, float *centroids, int start, int count)
+{
+    int nodeIndex = scene->nodeCount++;
+    BvhNode *node = &scene->nodes[nodeIndex];
+
+    float centroidMin[3] = { INFINITY, INFINITY, INFINITY };
+    float centroidMax[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (int axis = 0; axis < 3; axis++) { node->boundsMin[axis] = INFINITY; node->boundsMax[axis] = -INFINITY; }
+
+    for (int i = start; i < start + count; i++)
+    {
+        float boundsMin[3], boundsMax[3], centroid[3];
+        GetTriangleBounds(scene, i, boundsMin, boundsMax, centroid);
+        GrowBounds(node->boundsMin, node->boundsMax, boundsMin, boundsMax);
+        GrowBounds(centroidMin, centroidMax, centroid, centroid);
+    }
+
+    node->start = start;
+    node->count = count;
+    if (count <= TRACE_BVH_LEAF_SIZE) return nodeIndex;
+
+    // Cheapest split over every axis, cost in units of triangle tests
+    int bestAxis = -1;
+    int bestBin = 0;
+    float bestCost = count*GetBoundsArea(node->boundsMin, node->boundsMax);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f) continue;
+
+        int binCount[TRACE_BVH_BINS] = { 0 };
+        float binMin[TRACE_BVH_BINS][3], binMax[TRACE_BVH_BINS][3];
+        for (int b = 0; b < TRACE_BVH_BINS; b++) for (int k = 0; k < 3; k++) { binMin[b][k] = INFINITY; binMax[b][k] = -INFINITY; }
+
+        for (int i = start; i < start + count; i++)
+        {
+            float boundsMin[3], boundsMax[3], centroid[3];
+            GetTriangleBounds(scene, i, boundsMin, boundsMax, centroid);
+
+            int b = (int)((centroid[axis] - centroidMin[axis])/extent*TRACE_BVH_BINS);
+            if (b > TRACE_BVH_BINS - 1) b = TRACE_BVH_BINS - 1;
+
+            binCount[b]++;
+            GrowBounds(binMin[b], binMax[b], boundsMin, boundsMax);
+        }
+
+        // Sweep from the right for the suffix areas, then from the left
+        float rightArea[TRACE_BVH_BINS] = { 0 };
+        int rightCount[TRACE_BVH_BINS] = { 0 };
+        float sweepMin[3] = { INFINITY, INFINITY, INFINITY }, sweepMax[3] = { -INFINITY, -INFINITY, -INFINITY };
+        int sweepCount = 0;
+
+        for (int b = TRACE_BVH_BINS - 1; b > 0; b--)
+        {
+            GrowBounds(sweepMin, sweepMax, binMin[b], binMax[b]);
+            sweepCount += binCount[b];
+            rightArea[b] = GetBoundsArea(sweepMin, sweepMax);
+            rightCount[b] = sweepCount;
+        }
+
+        for (int k = 0; k < 3; k++) { sweepMin[k] = INFINITY; sweepMax[k] = -INFINITY; }
+        sweepCount = 0;
+
+        for (int b = 0; b < TRACE_BVH_BINS - 1; b++)
+        {
+            GrowBounds(sweepMin, sweepMax, binMin[b], binMax[b]);
+            sweepCount += binCount[b];
+
+            float cost = sweepCount*GetBoundsArea(sweepMin, sweepMax) + rightCount[b + 1]*rightArea[b + 1];
+            if ((sweepCount > 0) && (rightCount[b + 1] > 0) && (cost < bestCost))
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+
+    if (bestAxis < 0) return nodeIndex;
+
+    // Partition by bin, triangles and their centroids move together
+    float extent = centroidMax[bestAxis] - centroidMin[bestAxis];
+    int middle = start;
+    for (int i = start; i < start + count; i++)
+    {
+        int b = (int)((centroids[i*3 + bestAxis] - centroidMin[bestAxis])/extent*TRACE_BVH_BINS);
+        if (b > TRACE_BVH_BINS - 1) b = TRACE_BVH_BINS - 1;
+
+        if (b <= bestBin) SwapTriangles(scene, centroids, i, middle++);
+    }
+
+    BuildBvhNode(scene, centroids, start, middle - start);
+    int right = BuildBvhNode(scene, centroids, middle, start + count - middle);
+
+    node = &scene->nodes[nodeIndex];
+    node->start = right;
+    node->count = 0;
+
+    return nodeIndex;
+}
+
+static void BuildTraceBvh(TraceScene *scene)
+{
+    float *centroids = (float *)RL_MALLOC(scene->triangleCount*3*sizeof(float));
+    for (int i = 0; i < scene->triangleCount; i++)
+    {
+        float boundsMin[3], boundsMax[3];
+        GetTriangleBounds(scene, i, boundsMin, boundsMax, centroids + i*3);
+    }
+
+    scene->nodes = (BvhNode *)RL_MALLOC(2*scene->triangleCount*sizeof(BvhNode));
+    scene->nodeCount = 0;
+    BuildBvhNode(scene, centroids, 0, scene->triangleCount);
+
+    RL_FREE(centroids);
+}
+
+static void UnloadTraceScene(TraceScene scene)
+{
+    RL_FREE(scene.positions);
+    RL_FREE(scene.normals);
+    RL_FREE(scene.tangents);
+    RL_FREE(scene.indices);
+    RL_FREE(scene.nodes);
+}
+
+//----------------------------------------------------------------------------------
+// Ray queries
+//----------------------------------------------------------------------------------
+typedef struct TraceHit {
+    float distance;
+    int triangle;
+    float u, v;             // Barycentrics of vertices 1 and 2
+} TraceHit;
+
+static inline bool IntersectBounds(const BvhNode *node, TraceVec origin, TraceVec invDir, float maxDistance)
+{
+    float t0 = (node->boundsMin[0] - origin.x)*invDir.x, t1 = (node->boundsMax[0] - origin.x)*invDir.x;
+    float nearT = fminf(t0, t1), farT = fmaxf(t0, t1);
+
+    t0 = (node->boundsMin[1] - origin.y)*invDir.y; t1 = (node->boundsMax[1] - origin.y)*invDir.y;
+    nearT = fmaxf(nearT, fminf(t0, t1)); farT = fminf(farT, fmaxf(t0, t1));
+
+    t0 = (node->boundsMin[2] - origin.z)*invDir.z; t1 = (node->boundsMax[2] - origin.z)*invDir.z;
+    nearT = fmaxf(nearT, fminf(t0, t1)); farT = fminf(farT, fmaxf(t0, t1));
+
+    return (nearT <= farT) && (farT > 0.0f) && (nearT < maxDistance);
+}
+
+// Moller-Trumbore, double sided
+static inline bool IntersectTriangle(const TraceScene *scene, int triangle, TraceVec origin, TraceVec dir, TraceHit *hit)
+{
+    TraceVec p0 = scene->positions[scene->indices[triangle*3 + 0]];
+    TraceVec e1 = VecSub(scene->positions[scene->indices[triangle*3 + 1]], p0);
+    TraceVec e2 = VecSub(scene->positions[scene->indices[triangle*3 + 2]], p0);
+
+    TraceVec p = VecCross(dir, e2);
+    float det = VecDot(e1, p);
+    if (fabsf(det) < 1e-12f) return false;
+
+    float invDet = 1.0f/det;
+    TraceVec s = VecSub(origin, p0);
+    float u = VecDot(s, p)*invDet;
+    if ((u < 0.0f) || (u > 1.0f)) return false;
+
+    TraceVec q = VecCross(s, e1);
+    float v = VecDot(dir, q)*invDet;
+    if ((v < 0.0f) || (u + v > 1.0f)) return false;
+
+    float t = VecDot(e2, q)*invDet;
+    if ((t <= 0.0f) || (t >= hit->distance)) return false;
+
+    hit->distance = t;
+    hit->triangle = triangle;
+    hit->u = u;
+    hit->v = v;
+
+    return true;
+}
+
+// Closest hit within hit->distance, or the first one when anyHit is set (shadow rays)
+static bool IntersectScene(const TraceScene *scene, TraceVec origin, TraceVec dir, TraceHit *hit, bool anyHit)
+{
+    if (scene->sphereRadius > 0.0f)
+    {
+        float b = VecDot(origin, dir);
+        float c = VecDot(origin, origin) - scene->sphereRadius*scene->sphereRadius;
+        float discriminant = b*b - c;
+        if (discriminant < 0.0f) return false;
+
+        float root = sqrtf(discriminant);
+        float t = (-b - root > 0.0f)? -b - root : -b + root;
+        if ((t <= 0.0f) || (t >= hit->distance)) return false;
+
+        hit->distance = t;
+        hit->triangle = -1;
+        return true;
+    }
+
+    TraceVec invDir = VecMake(1.0f/dir.x, 1.0f/dir.y, 1.0f/dir.z);
+    int stack[TRACE_BVH_MAX_DEPTH];
+    int stackSize = 0;
+    int nodeIndex = 0;
+    bool found = false;
+
+    while (true)
+    {
+        const BvhNode *node = &scene->nodes[nodeIndex];
+
+        if (IntersectBounds(node, origin, invDir, hit->distance))
+        {
+            if (node->count > 0)
+            {
+                for (int i = node->start; i < node->start + node->count; i++)
+                {
+                    if (IntersectTriangle(scene, i, origin, dir, hit))
+                    {
+                        found = true;
+                        if (anyHit) return true;
+                    }
+                }
+            }
+            else if (stackSize < TRACE_BVH_MAX_DEPTH)
+            {
+                // Near child first along the ray
+                int left = nodeIndex + 1;
+                int right = node->start;
+                int axis = (fabsf(dir.x) > fabsf(dir.y))? ((fabsf(dir.x) > fabsf(dir.z))? 0 : 2) : ((fabsf(dir.y) > fabsf(dir.z))? 1 : 2);
+                bool leftFirst = (VecComponent(dir, axis) >= 0.0f);
+
+                stack[stackSize++] = leftFirst? right : left;
+                nodeIndex = leftFirst? left : right;
+                continue;
+            }
+        }
+
+        if (stackSize == 0) break;
+        nodeIndex = stack[--stackSize];
+    }
+
+    return found;
+}
+
+// Shading frame at a hit: geometric normal, interpolated normal and tangent
+static void GetHitFrame(const TraceScene *scene, const TraceHit *hit, TraceVec position, TraceVec *geometric, TraceVec *normal, TraceVec *tangent)
+{
+    if (hit->triangle < 0)
+    {
+        *geometric = VecNormalize(position);
+        *normal = *geometric;
+
+        // Around the y axis like the torus tangents, any direction at the poles
+        *tangent = VecNormalize(VecCross(VecMake(0.0f, 1.0f, 0.0f), *normal));
+        if (VecDot(*tangent, *tangent) < 0.5f) *tangent = VecMake(1.0f, 0.0f, 0.0f);
+        return;
+    }
+
+    int i0 = scene->indices[hit->triangle*3 + 0];
+    int i1 = scene->indices[hit->triangle*3 + 1];
+    int i2 = scene->indices[hit->triangle*3 + 2];
+    float w = 1.0f - hit->u - hit->v;
+
+    *geometric = VecNormalize(VecCross(VecSub(scene->positions[i1], scene->positions[i0]), VecSub(scene->positions[i2], scene->positions[i0])));
+    *normal = VecNormalize(VecAdd(VecAdd(VecScale(scene->normals[i0], w), VecScale(scene->normals[i1], hit->u)), VecScale(scene->normals[i2], hit->v)));
+    *tangent = VecAdd(VecAdd(VecScale(scene->tangents[i0], w), VecScale(scene->tangents[i1], hit->u)), VecScale(scene->tangents[i2], hit->v));
+}
+
+//----------------------------------------------------------------------------------
+// Sky
+//----------------------------------------------------------------------------------
+
+// Texel weights are luminance times the solid angle of the texel row
+static TraceSky LoadTraceSky(const char *fileName)
+{
+    TraceSky sky = { 0 };
+
+    Image image = LoadImage(fileName);
+    if (image.data == NULL) return sky;
+
+    sky.map = LoadEnvMapFromImage(image, 0);
+    UnloadImage(image);
+
+    int width = sky.map.width, height = sky.map.height;
+    sky.rowCdf = (float *)RL_MALLOC((height + 1)*sizeof(float));
+    sky.texelCdf = (float *)RL_MALLOC((size_t)height*(width + 1)*sizeof(float));
+    sky.texelWeight = (float *)RL_MALLOC((size_t)width*height*sizeof(float));
+
+    double total = 0.0;
+    for (int y = 0; y < height; y++)
+    {
+        float solidAngle = cosf(((y + 0.5f)/height - 0.5f)*PI);
+        float *cdf = sky.texelCdf + (size_t)y*(width + 1);
+        double row = 0.0;
+
+        cdf[0] = 0.0f;
+        for (int x = 0; x < width; x++)
+        {
+            const float *texel = sky.map.data + ((size_t)y*width + x)*3;
+            float weight = (0.2126f*texel[0] + 0.7152f*texel[1] + 0.0722f*texel[2])*solidAngle;
+
+            sky.texelWeight[(size_t)y*width + x] = weight;
+            row += weight;
+            cdf[x + 1] = (float)row;
+        }
+
+        for (int x = 1; x <= width; x++) cdf[x] = (row > 0.0)? (float)(cdf[x]/row) : (float)x/width;
+
+        sky.rowCdf[y] = (float)total;
+        total += row;
+    }
+
+    sky.rowCdf[height] = (float)total;
+    for (int y = 0; y <= height; y++) sky.rowCdf[y] = (float)(sky.rowCdf[y]/total);
+    for (size_t i = 0; i < (size_t)width*height; i++) sky.texelWeight[i] = (float)(sky.texelWeight[i]/total);
+
+    return sky;
+}
+
+static void UnloadTraceSky(TraceSky sky)
+{
+    UnloadEnvMap(sky.map);
+    RL_FREE(sky.rowCdf);
+    RL_FREE(sky.texelCdf);
+    RL_FREE(sky.texelWeight);
+}
+
+// First index with cdf[index + 1] > value
+static int SearchCdf(const float *cdf, int count, float value)
+{
+    int low = 0, high = count - 1;
+
+    while (low < high)
+    {
+        int middle = (low + high)/2;
+        if (cdf[middle + 1] <= value) low = middle + 1;
+        else high = middle;
+    }
+
+    return low;
+}
+
+// Nearest texel, the radiance is piecewise constant like the sampling density
+static void GetSkyTexel(const TraceSky *sky, TraceVec dir, int *x, int *y)
+{
+    Vector2 uv = DirectionToEquirect((Vector3){ dir.x, dir.y, dir.z });
+
+    *x = (int)(uv.x*sky->map.width);
+    *y = (int)(uv.y*sky->map.height);
+    if (*x > sky->map.width - 1) *x = sky->map.width - 1;
+    if (*y > sky->map.height - 1) *y = sky->map.height - 1;
+}
+
+static TraceVec GetSkyRadiance(const TraceSky *sky, TraceVec dir)
+{
+    int x, y;
+    GetSkyTexel(sky, dir, &x, &y);
+    const float *texel = sky->map.data + ((size_t)y*sky->map.width + x)*3;
+
+    return VecMake(texel[0], texel[1], texel[2]);
+}
+
+// Solid angle density of SampleSky() for a direction
+static float GetSkyPdf(const TraceSky *sky, TraceVec dir)
+{
+    int x, y;
+    GetSkyTexel(sky, dir, &x, &y);
+
+    float cosLatitude = sqrtf(fmaxf(1.0f - dir.y*dir.y, 1e-8f));
+    float texelCount = (float)sky->map.width*sky->map.height;
+
+    return sky->texelWeight[(size_t)y*sky->map.width + x]*texelCount/(2.0f*PI*PI*cosLatitude);
+}
+
+static TraceVec SampleSky(const TraceSky *sky, TraceRandom *random, float *pdf)
+{
+    int y = SearchCdf(sky->rowCdf, sky->map.height, RandomFloat(random));
+    int x = SearchCdf(sky->texelCdf + (size_t)y*(sky->map.width + 1), sky->map.width, RandomFloat(random));
+
+    float u = (x + RandomFloat(random))/sky->map.width;
+    float v = (y + RandomFloat(random))/sky->map.height;
+    Vector3 dir = EquirectToDirection(u, v);
+
+    TraceVec result = VecMake(dir.x, dir.y, dir.z);
+    *pdf = GetSkyPdf(sky, result);
+
+    return result;
+}
+
+//----------------------------------------------------------------------------------
+// Integrator
+//----------------------------------------------------------------------------------
+
+static inline float PowerHeuristic(float pdf, float otherPdf)
+{
+    return (pdf*pdf)/(pdf*pdf + otherPdf*otherPdf);
+}
+
+// f(l, v)*NdotL of the shader for up to three light directions at once
+static void EvalHitBrdf(const TraceJob *job, TraceVec normal, TraceVec tangent, TraceVec bitangent, TraceVec view, const TraceVec *lights, int count, TraceVec *result)
+{
+    float nx[3], ny[3], nz[3], lx[3], ly[3], lz[3], vx[3], vy[3], vz[3];
+    float tx[3], ty[3], tz[3], bx[3], by[3], bz[3], r[3], g[3], b[3];
+
+    for (int i = 0; i < count; i++)
+    {
+        nx[i] = normal.x; ny[i] = normal.y; nz[i] = normal.z;
+        vx[i] = view.x; vy[i] = view.y; vz[i] = view.z;
+        tx[i] = tangent.x; ty[i] = tangent.y; tz[i] = tangent.z;
+        bx[i] = bitangent.x; by[i] = bitangent.y; bz[i] = bitangent.z;
+        lx[i] = lights[i].x; ly[i] = lights[i].y; lz[i] = lights[i].z;
+    }
+
+    BrdfSamples samples = { 0 };
+    samples.count = count;
+    samples.normal = (BrdfVectors){ nx, ny, nz };
+    samples.light = (BrdfVectors){ lx, ly, lz };
+    samples.view = (BrdfVectors){ vx, vy, vz };
+    samples.tangent = (BrdfVectors){ tx, ty, tz };
+    samples.bitangent = (BrdfVectors){ bx, by, bz };
+
+    EvalBrdfReference(job->material, samples, (BrdfResult){ r, g, b });
+
+    for (int i = 0; i < count; i++) result[i] = VecMake(r[i], g[i], b[i]);
+}
+
+static bool IsOccluded(const TraceJob *job, TraceVec origin, TraceVec dir, float distance)
+{
+    TraceHit hit = { distance, -1, 0.0f, 0.0f };
+    return IntersectScene(job->scene, origin, dir, &hit, true);
+}
+
+// Radiance along a camera ray that hit the surface, rayCount counts every traced ray
+static TraceVec TracePath(const TraceJob *job, TraceVec origin, TraceVec dir, TraceHit hit, TraceRandom *random, int *rayCount)
+{
+    TraceVec radiance = VecMake(0.0f, 0.0f, 0.0f);
+    TraceVec throughput = VecMake(1.0f, 1.0f, 1.0f);
+
+    for (int bounce = 0; ; bounce++)
+    {
+        TraceVec position = VecAdd(origin, VecScale(dir, hit.distance));
+        TraceVec view = VecScale(dir, -1.0f);
+        TraceVec geometric, normal, tangent;
+        GetHitFrame(job->scene, &hit, position, &geometric, &normal, &tangent);
+
+        // Face the viewer, the interpolated normal stays on the side of the geometric one
+        if (VecDot(geometric, view) < 0.0f) geometric = VecScale(geometric, -1.0f);
+        if (VecDot(normal, geometric) < 0.0f) normal = VecScale(normal, -1.0f);
+        tangent = VecNormalize(VecSub(tangent, VecScale(normal, VecDot(normal, tangent))));
+        TraceVec bitangent = VecCross(normal, tangent);
+        TraceVec offset = VecAdd(position, VecScale(geometric, TRACE_RAY_EPSILON));
+
+        // Point light, sky sample and the cosine distributed continuation, evaluated in one batch
+        TraceVec toLight = VecSub(job->lightPos, position);
+        float lightDistance = sqrtf(VecDot(toLight, toLight));
+        TraceVec lights[3];
+        lights[0] = VecScale(toLight, 1.0f/lightDistance);
+
+        float skyPdf = 0.0f;
+        lights[1] = SampleSky(job->sky, random, &skyPdf);
+
+        float r1 = RandomFloat(random), r2 = RandomFloat(random);
+        float cosTheta = sqrtf(1.0f - r1);
+        float sinTheta = sqrtf(r1);
+        float phi = 2.0f*PI*r2;
+        lights[2] = VecAdd(VecAdd(VecScale(tangent, sinTheta*cosf(phi)), VecScale(bitangent, sinTheta*sinf(phi))), VecScale(normal, cosTheta));
+
+        TraceVec brdf[3];
+        EvalHitBrdf(job, normal, tangent, bitangent, view, lights, 3, brdf);
+
+        if ((VecDot(lights[0], geometric) > 0.0f) && !IsOccluded(job, offset, lights[0], lightDistance))
+        {
+            radiance = VecAdd(radiance, VecMul(throughput, VecMul(brdf[0], job->lightColor)));
+        }
+        (*rayCount)++;
+
+        float cosSky = VecDot(lights[1], normal);
+        if ((skyPdf > 0.0f) && (cosSky > 0.0f) && (VecDot(lights[1], geometric) > 0.0f))
+        {
+            (*rayCount)++;
+            if (!IsOccluded(job, offset, lights[1], INFINITY))
+            {
+                float weight = PowerHeuristic(skyPdf, cosSky/PI)/skyPdf;
+                radiance = VecAdd(radiance, VecScale(VecMul(throughput, VecMul(brdf[1], GetSkyRadiance(job->sky, lights[1]))), weight));
+            }
+        }
+
+        if ((bounce == job->maxBounces) || (VecDot(lights[2], geometric) <= 0.0f)) break;
+
+        float bsdfPdf = cosTheta/PI;
+        if (bsdfPdf <= 0.0f) break;
+        throughput = VecMul(throughput, VecScale(brdf[2], 1.0f/bsdfPdf));
+
+        // Russian roulette past the first bounces
+        if (bounce >= 2)
+        {
+            float survival = fminf(fmaxf(throughput.x, fmaxf(throughput.y, throughput.z)), 0.95f);
+            if (RandomFloat(random) >= survival) break;
+            throughput = VecScale(throughput, 1.0f/survival);
+        }
+
+        origin = offset;
+        dir = lights[2];
+        hit = (TraceHit){ INFINITY, -1, 0.0f, 0.0f };
+        (*rayCount)++;
+
+        if (!IntersectScene(job->scene, origin, dir, &hit, false))
+        {
+            float weight = PowerHeuristic(bsdfPdf, GetSkyPdf(job->sky, dir));
+            radiance = VecAdd(radiance, VecScale(VecMul(throughput, GetSkyRadiance(job->sky, dir)), weight));
+            break;
+        }
+    }
+
+    return radiance;
+}
+
+static void RenderTile(int index, void *userData)
+{
+    TraceJob *job = (TraceJob *)userData;
+    const TraceCamera *camera = &job->camera;
+
+    int tileX = (index%job->tilesX)*TRACE_TILE_SIZE;
+    int tileY = (index/job->tilesX)*TRACE_TILE_SIZE;
+    float aspect = (float)job->width/job->height;
+    int rayCount = 0;
+
+    for (int y = tileY; (y < tileY + TRACE_TILE_SIZE) && (y < job->height); y++)
+    {
+        for (int x = tileX; (x < tileX + TRACE_TILE_SIZE) && (x < job->width); x++)
+        {
+            TraceRandom random = RandomSeed((unsigned int)(y*job->width + x));
+            TraceVec surface = VecMake(0.0f, 0.0f, 0.0f);
+            TraceVec background = VecMake(0.0f, 0.0f, 0.0f);
+
+            for (int s = 0; s < job->spp; s++)
+            {
+                float px = (2.0f*(x + RandomFloat(&random))/job->width - 1.0f)*camera->tanHalfFovy*aspect;
+                float py = (1.0f - 2.0f*(y + RandomFloat(&random))/job->height)*camera->tanHalfFovy;
+                TraceVec dir = VecNormalize(VecAdd(camera->forward, VecAdd(VecScale(camera->right, px), VecScale(camera->up, py))));
+
+                TraceHit hit = { INFINITY, -1, 0.0f, 0.0f };
+                rayCount++;
+
+                if (IntersectScene(job->scene, camera->position, dir, &hit, false))
+                {
+                    surface = VecAdd(surface, TracePath(job, camera->position, dir, hit, &random, &rayCount));
+                }
+                else
+                {
+                    // The skybox shows the sRGB texels as they are
+                    TraceVec sky = GetSkyRadiance(job->sky, dir);
+                    background = VecAdd(background, VecMake(LinearToSRGBFloat(sky.x), LinearToSRGBFloat(sky.y), LinearToSRGBFloat(sky.z)));
+                }
+            }
+
+            // Exposure applies to the lit samples only, silhouettes blend by coverage
+            float *pixel = job->image + ((size_t)y*job->width + x)*3;
+            pixel[0] = (TRACE_EXPOSURE*surface.x + background.x)/job->spp;
+            pixel[1] = (TRACE_EXPOSURE*surface.y + background.y)/job->spp;
+            pixel[2] = (TRACE_EXPOSURE*surface.z + background.z)/job->spp;
+        }
+    }
+
+    __sync_fetch_and_add(&job->rayCount, (long long)rayCount);
+}
+
+int main(int argc, char *argv[])
+{
+    const TraceModelInfo *info = &traceModels[BRDF_MODEL_COOK_TORRANCE];
+    int width = 800, height = 800;
+    int spp = TRACE_DEFAULT_SPP;
+    int maxBounces = TRACE_DEFAULT_BOUNCES;
+    float sphereRadius = 0.0f;
+    float yaw = 0.0f, pitch = 0.0f, radius = 2.5f;
+    float roughness = -1.0f, metallic = -1.0f, weight = -1.0f;
+    const char *skyFile = "resources/sky1_2k.jpg";
+    const char *output = "path_trace.png";
+    bool valid = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = (i + 1 < argc)? argv[i + 1] : NULL;
+        bool known = true;
+
+        if (strncmp(argv[i], "--", 2) != 0)
+        {
+            known = false;
+            for (int m = 0; m < (int)(sizeof(traceModels)/sizeof(traceModels[0])); m++)
+            {
+                if (strcmp(argv[i], traceModels[m].name) == 0) { info = &traceModels[m]; known = true; }
+            }
+            if (!known) valid = false;
+            continue;
+        }
+
+        if (value == NULL) { valid = false; break; }
+
+        if (strcmp(argv[i], "--spp") == 0) spp = atoi(value);
+        else if (strcmp(argv[i], "--bounces") == 0) maxBounces = atoi(value);
+        else if (strcmp(argv[i], "--size") == 0) { if (sscanf(value, "%ix%i", &width, &height) != 2) valid = false; }
+        else if (strcmp(argv[i], "--sphere") == 0) sphereRadius = (float)atof(value);
+        else if (strcmp(argv[i], "--yaw") == 0) yaw = (float)atof(value);
+        else if (strcmp(argv[i], "--pitch") == 0) pitch = (float)atof(value);
+        else if (strcmp(argv[i], "--radius") == 0) radius = (float)atof(value);
+        else if (strcmp(argv[i], "--roughness") == 0) roughness = (float)atof(value);
+        else if (strcmp(argv[i], "--metallic") == 0) metallic = (float)atof(value);
+        else if (strcmp(argv[i], "--weight") == 0) weight = (float)atof(value);
+        else if (strcmp(argv[i], "--sky") == 0) skyFile = value;
+        else if (strcmp(argv[i], "--output") == 0) output = value;
+        else valid = false;
+        i++;
+    }
+
+    if (!valid || (spp <= 0) || (maxBounces < 0) || (width <= 0) || (height <= 0) || (sphereRadius < 0.0f))
+    {
+        printf("Usage: path_trace [model] [--spp N] [--bounces N] [--size WxH] [--sphere R] [--yaw A] [--pitch A] [--radius R]\n"
+               "                  [--roughness X] [--metallic X] [--weight X] [--sky file] [--output file]\n");
+        return 1;
+    }
+
+    BrdfMaterial material = GetBrdfMaterialDefault(info->model);
+    if (roughness >= 0.0f) material.roughness = material.roughnessU = material.roughnessV = roughness;
+    if (metallic >= 0.0f) material.metallic = metallic;
+    if (weight >= 0.0f) material.sheenWeight = material.clearcoatWeight = weight;
+
+    BrdfDFG dfg = LoadBrdfDFG("resources/dfg_lut.bin");
+    material.dfg = (dfg.data != NULL)? &dfg : NULL;
+    if (dfg.data == NULL) printf("resources/dfg_lut.bin not found, rendering without the accurate multiscatter term\n");
+
+    TraceSky sky = LoadTraceSky(skyFile);
+    if (sky.map.data == NULL)
+    {
+        printf("Failed to load the sky [%s], run the tool from the repository root\n", skyFile);
+        UnloadBrdfDFG(dfg);
+        return 1;
+    }
+
+    double startTime = GetMonotonicTime();
+    TraceScene scene = { 0 };
+    if (sphereRadius > 0.0f) scene.sphereRadius = sphereRadius;
+    else
+    {
+        scene = GenTraceTorus(0.4f, 1.0f, info->radSeg, info->sides);
+        BuildTraceBvh(&scene);
+    }
+    double buildTime = GetMonotonicTime() - startTime;
+
+    // Orbit camera of the demos, perspective with fovy 45 degrees
+    TraceJob job = { 0 };
+    job.width = width;
+    job.height = height;
+    job.spp = spp;
+    job.maxBounces = maxBounces;
+    job.tilesX = (width + TRACE_TILE_SIZE - 1)/TRACE_TILE_SIZE;
+    job.scene = &scene;
+    job.sky = &sky;
+    job.material = &material;
+    job.camera.position = VecMake(radius*cosf(pitch)*sinf(yaw), radius*sinf(pitch), radius*cosf(pitch)*cosf(yaw));
+    job.camera.forward = VecNormalize(VecScale(job.camera.position, -1.0f));
+    job.camera.right = VecNormalize(VecCross(job.camera.forward, VecMake(0.0f, 1.0f, 0.0f)));
+    job.camera.up = VecCross(job.camera.right, job.camera.forward);
+    job.camera.tanHalfFovy = tanf(45.0f*DEG2RAD*0.5f);
+    job.lightPos = VecMake(5.0f, 5.0f, 5.0f);
+    job.lightColor = VecMake(1.0f, 1.0f, 1.0f);
+    job.image = (float *)RL_CALLOC((size_t)width*height*3, sizeof(float));
+
+    int tileCount = job.tilesX*((height + TRACE_TILE_SIZE - 1)/TRACE_TILE_SIZE);
+
+    startTime = GetMonotonicTime();
+    ParallelFor(tileCount, RenderTile, &job);
+    double renderTime = GetMonotonicTime() - startTime;
+
+    printf("%s, %s: %i triangles (BVH %i nodes, %.1f ms), %ix%i at %i spp, %i bounces\n", info->name, (sphereRadius > 0.0f)? "sphere" : "torus",
+        scene.triangleCount, scene.nodeCount, buildTime*1000.0, width, height, spp, maxBounces);
+    printf("Rendered in %.2f s on %i threads, %.2f Mrays/s\n", renderTime, GetWorkerCount(), job.rayCount/renderTime*1e-6);
+
+    bool success = false;
+    if (IsFileExtension(output, ".raw")) success = SaveFileData(output, job.image, width*height*3*(int)sizeof(float));
+    else
+    {
+        Image image = GenImageColor(width, height, BLACK);
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+        unsigned char *pixels = (unsigned char *)image.data;
+        for (int i = 0; i < width*height*3; i++) pixels[i] = (unsigned char)(fminf(fmaxf(job.image[i], 0.0f), 1.0f)*255.0f + 0.5f);
+
+        success = ExportImage(image, output);
+        UnloadImage(image);
+    }
+
+    if (success) printf("Wrote %s\n", output);
+    else printf("Failed to write %s\n", output);
+
+    RL_FREE(job.image);
+    UnloadTraceScene(scene);
+    UnloadTraceSky(sky);
+    UnloadBrdfDFG(dfg);
+
+    return success? 0 : 1;
+}
@@ -0,0 +1,207 @@
+/*
+-> Vertex throughput of the demo vertex shaders on a heavily tessellated torus, opens a hidden window
+-> Build it like the demos (F5 on this file), run it from the repository root
+-> Usage: vertex_bench [rings] [sides] [frames]
+-> The default torus is 512x1024 segments (3M vertices, GenMeshTorus() does not index them). 1024x2048 works
+   too but needs about 1GB between the CPU copy and the vertex buffers
+-> Each demo's .vs is drawn twice. The shipped one reads matNormal, which DrawMesh() computes once per draw.
+   A twin recomputes transpose(inverse(mat3(matModel))) for every vertex. The tool prints the best time per draw
+   and the vertex rate of both
+-> The demo's own .fs is linked, so the normals stay live, but the target is only BENCH_TARGET_SIZE pixels wide
+   and the vertex work dominates the time
+*/
+
+#define MATERIAL_BLOCK_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"               // rlGetShaderIdDefault(), to hand the material back its default shader
+#include "external/glad.h"      // glFinish(), a draw is only timed once the GPU is done with it
+#include "../../common/material_block.h"
+
+#define BENCH_DEFAULT_RINGS     512
+#define BENCH_DEFAULT_SIDES     1024
+#define BENCH_DEFAULT_FRAMES    20
+#define BENCH_RUNS              3
+#define BENCH_TARGET_SIZE       32
+
+#define BENCH_NORMAL_MATRIX     "mat3(matNormal)"
+#define BENCH_INVERSE_MATRIX    "transpose(inverse(mat3(matModel)))"
+
+typedef struct BenchCase {
+    const char *name;
+    const char *path;               // Shader path without the extension
+    bool environment;               // Fragment shader reads MaterialBlock, prefilterMap and dfgLut
+} BenchCase;
+
+static const BenchCase benchCases[] = {
+    { "ambient_simple", "lighting_methods/ambient_lighting_simple/ambient_simple", false },
+    { "ambient_ibl", "lighting_methods/ambient_lighting_ibl/ambient_ibl", false },
+    { "diffuse_lambert", "lighting_methods/diffuse_lambert_lighting/diffuse_lambert", false },
+    { "diffuse_oren_nayar", "lighting_methods/diffuse_oren_nayar_lighting/diffuse_oren_nayar", false },
+    { "diffuse_burley", "lighting_methods/diffuse_burley_lighting/diffuse_burley", false },
+    { "diffuse_ashikhmin_shirley", "lighting_methods/diffuse_ashikhmin_shirley_lighting/diffuse_ashikhmin_shirley", false },
+    { "specular_phong", "lighting_methods/specular_phong_lighting/specular_phong", false },
+    { "specular_blinn_phong", "lighting_methods/specular_blinn_phong_lighting/specular_blinn_phong", false },
+    { "specular_ashikhmin_shirley", "lighting_methods/specular_ashikhmin_shirley_lighting/specular_ashikhmin_shirley", false },
+    { "specular_cook_torrance", "lighting_methods/specular_cook_torrance_lighting/specular_cook_torrance", true },
+    { "sheen", "multi_layer_reflectance/sheen/sheen", true },
+    { "clearcoat", "multi_layer_reflectance/clearcoat/clearcoat", true },
+    { "shading_flat", "polygon_shading_methods/flat_shading/shading_flat", false },
+    { "shading_gouraud", "polygon_shading_methods/gouraud_shading/shading_gouraud", false },
+    { "shading_phong", "polygon_shading_methods/phong_shading/shading_phong", false },
+};
+
+// Copy of the shipped source with the per-draw normal matrix swapped for the per-vertex one, NULL if not found
+static char *GetInverseTwin(const char *vsCode)
+{
+    const char *match = strstr(vsCode, BENCH_NORMAL_MATRIX);
+    if (match == NULL) return NULL;
+
+    size_t head = match - vsCode;
+    size_t tail = strlen(match + strlen(BENCH_NORMAL_MATRIX));
+    char *twin = (char *)RL_MALLOC(head + strlen(BENCH_INVERSE_MATRIX) + tail + 1);
+
+    memcpy(twin, vsCode, head);
+    memcpy(twin + head, BENCH_INVERSE_MATRIX, strlen(BENCH_INVERSE_MATRIX));
+    memcpy(twin + head + strlen(BENCH_INVERSE_MATRIX), match + strlen(BENCH_NORMAL_MATRIX), tail + 1);
+
+    return twin;
+}
+
+// No textures are bound, but a samplerCube and a sampler2D both left on unit 0 fail the draw
+static void SetBenchEnvironment(Shader shader)
+{
+    int prefilterUnit = 1;
+    int dfgUnit = 2;
+
+    BindMaterialBlock(shader);
+    SetShaderValue(shader, GetShaderLocation(shader, "prefilterMap"), &prefilterUnit, SHADER_UNIFORM_INT);
+    SetShaderValue(shader, GetShaderLocation(shader, "dfgLut"), &dfgUnit, SHADER_UNIFORM_INT);
+}
+
+// Best of BENCH_RUNS, in seconds per draw
+static double TimeDraw(Mesh mesh, Material material, Camera camera, RenderTexture2D target, int frames)
+{
+    // Rotated and stretched, the inverse is not the transpose
+    Matrix transform = MatrixMultiply(MatrixScale(1.0f, 0.6f, 1.3f), MatrixRotateXYZ((Vector3){ 1.1f, 0.4f, 0.2f }));
+    double best = 0.0;
+
+    for (int i = 0; i <= BENCH_RUNS; i++)
+    {
+        glFinish();
+        double startTime = GetTime();
+
+        for (int j = 0; j < frames; j++)
+        {
+            BeginTextureMode(target);
+                ClearBackground(BLACK);
+                BeginMode3D(camera);
+                    DrawMesh(mesh, material, transform);
+                EndMode3D();
+            EndTextureMode();
+        }
+
+        glFinish();
+        double time = (GetTime() - startTime)/frames;
+
+        // First pass only warms the driver up, some compile the program on its first draw
+        if (i == 0) continue;
+        if ((i == 1) || (time < best)) best = time;
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    int rings = (argc > 1)? atoi(argv[1]) : BENCH_DEFAULT_RINGS;
+    int sides = (argc > 2)? atoi(argv[2]) : BENCH_DEFAULT_SIDES;
+    int frames = (argc > 3)? atoi(argv[3]) : BENCH_DEFAULT_FRAMES;
+
+    if ((rings <= 0) || (sides <= 0) || (frames <= 0))
+    {
+        printf("Usage: vertex_bench [rings] [sides] [frames]\n");
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(BENCH_TARGET_SIZE, BENCH_TARGET_SIZE, "vertex_bench");
+
+    RenderTexture2D target = LoadRenderTexture(BENCH_TARGET_SIZE, BENCH_TARGET_SIZE);
+
+    Mesh mesh = GenMeshTorus(0.4f, 1.0f, rings, sides);
+    GenMeshTangents(&mesh);
+
+    Camera camera = { 0 };
+    camera.position = (Vector3){ 0.0f, 0.0f, 2.5f };
+    camera.target = (Vector3){ 0.0f, 0.0f, 0.0f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 45.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    MaterialBlock block = LoadMaterialBlock(GetMaterialParamsDefault(), "resources/dfg_lut.bin");
+    UpdateMaterialBlock(&block);
+
+    Material material = LoadMaterialDefault();
+
+    printf("Torus %ix%i, %i vertices, %i draws per run, best of %i\n\n", rings, sides, mesh.vertexCount, frames, BENCH_RUNS);
+    printf("%-28s %12s %12s %12s %12s %8s\n", "shader", "inverse ms", "Mvert/s", "matNormal ms", "Mvert/s", "speedup");
+
+    for (int i = 0; i < (int)(sizeof(benchCases)/sizeof(benchCases[0])); i++)
+    {
+        const BenchCase *bench = &benchCases[i];
+
+        char *vsCode = LoadFileText(TextFormat("%s.vs", bench->path));
+        char *fsCode = LoadFileText(TextFormat("%s.fs", bench->path));
+        char *twinCode = (vsCode != NULL)? GetInverseTwin(vsCode) : NULL;
+
+        if ((fsCode == NULL) || (twinCode == NULL))
+        {
+            printf("%-28s skipped, no %s in the vertex shader\n", bench->name, BENCH_NORMAL_MATRIX);
+            UnloadFileText(vsCode);
+            UnloadFileText(fsCode);
+            RL_FREE(twinCode);
+            continue;
+        }
+
+        Shader normalShader = LoadShaderFromMemory(vsCode, fsCode);
+        Shader inverseShader = LoadShaderFromMemory(twinCode, fsCode);
+
+        if (bench->environment)
+        {
+            SetBenchEnvironment(normalShader);
+            SetBenchEnvironment(inverseShader);
+        }
+
+        material.shader = inverseShader;
+        double inverseTime = TimeDraw(mesh, material, camera, target, frames);
+
+        material.shader = normalShader;
+        double normalTime = TimeDraw(mesh, material, camera, target, frames);
+
+        printf("%-28s %12.3f %12.1f %12.3f %12.1f %7.2fx\n", bench->name, inverseTime*1000.0, mesh.vertexCount/inverseTime*1e-6,
+            normalTime*1000.0, mesh.vertexCount/normalTime*1e-6, inverseTime/normalTime);
+
+        UnloadShader(normalShader);
+        UnloadShader(inverseShader);
+        UnloadFileText(vsCode);
+        UnloadFileText(fsCode);
+        RL_FREE(twinCode);
+    }
+
+    // Default shader back before the material goes, UnloadMaterial() leaves it alone
+    material.shader = (Shader){ rlGetShaderIdDefault(), rlGetShaderLocsDefault() };
+    UnloadMaterial(material);
+    UnloadMaterialBlock(&block);
+    UnloadMesh(mesh);
+    UnloadRenderTexture(target);
+
+    CloseWindow();
+
+    return 0;
+}